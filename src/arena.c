@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "vacation.h"
+
+/*
+ * Arena (bump) allocator.
+ *
+ * Memory is handed out from large blocks by advancing an offset and is only
+ * given back all at once. arena_reset rewinds the arena but keeps its
+ * blocks, so a bulk run that resets per chunk settles at the size of its
+ * largest chunk and makes no further calls to malloc.
+ */
+
+struct arena_block {
+	struct arena_block *next;
+	size_t size;		/* Usable bytes after the header */
+	size_t used;
+};
+
+/* Block header size, rounded so the data is aligned */
+#define ARENA_HEADER_SIZE \
+	((sizeof(struct arena_block) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static unsigned char *block_data(struct arena_block *block)
+{
+	return (unsigned char *)block + ARENA_HEADER_SIZE;
+}
+
+void arena_init(struct arena *arena, size_t block_size)
+{
+	arena->first = NULL;
+	arena->current = NULL;
+	arena->block_size = block_size;
+	arena->bytes = 0;
+	arena->allocations = 0;
+	arena->reserved = 0;
+}
+
+/* Allocate a block of at least size bytes and link it after the current one */
+static struct arena_block *add_arena_block(struct arena *arena, size_t size)
+{
+	struct arena_block *block;
+
+	if (size < arena->block_size)
+		size = arena->block_size;
+
+	block = malloc(ARENA_HEADER_SIZE + size);
+	if (!block)
+		return NULL;
+	block->size = size;
+	block->used = 0;
+
+	if (arena->current) {
+		block->next = arena->current->next;
+		arena->current->next = block;
+	} else {
+		block->next = arena->first;
+		arena->first = block;
+	}
+	arena->reserved += size;
+	return block;
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	struct arena_block *block = arena->current;
+	void *ptr;
+
+	if (size > (size_t)-1 - ARENA_HEADER_SIZE - ARENA_ALIGN)
+		return NULL;
+	size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+	if (!block || block->size - block->used < size) {
+		/* Blocks after the current one are unused: reuse or add one */
+		if (block && block->next && block->next->size >= size)
+			block = block->next;
+		else
+			block = add_arena_block(arena, size);
+		if (!block)
+			return NULL;
+		arena->current = block;
+	}
+
+	ptr = block_data(block) + block->used;
+	block->used += size;
+	arena->bytes += size;
+	arena->allocations++;
+	return ptr;
+}
+
+void arena_reset(struct arena *arena)
+{
+	struct arena_block *block;
+
+	for (block = arena->first; block; block = block->next)
+		block->used = 0;
+	arena->current = arena->first;
+}
+
+void arena_release(struct arena *arena)
+{
+	struct arena_block *block = arena->first;
+
+	while (block) {
+		struct arena_block *next = block->next;
+
+		free(block);
+		block = next;
+	}
+
+	arena->first = NULL;
+	arena->current = NULL;
+	arena->reserved = 0;
+}
+
+void print_arena_stats(const struct arena *arena)
+{
+	fprintf(stderr, "Memory: %lu bytes in %lu allocations, %lu bytes reserved.\n",
+		(unsigned long)arena->bytes, (unsigned long)arena->allocations,
+		(unsigned long)arena->reserved);
+}
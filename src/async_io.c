@@ -0,0 +1,593 @@
+#ifdef __linux__
+#define _GNU_SOURCE	/* syscall */
+#elif !defined(_WIN32)
+#define _XOPEN_SOURCE 700	/* pread, pwrite */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "vacation.h"
+
+/*
+ * Block I/O for batch files (--io).
+ *
+ * A file is read or written in blocks of ASYNC_IO_BLOCK_SIZE at explicit
+ * offsets, so with io_uring several blocks can be in flight at once: a
+ * reader keeps the blocks after the one the caller works on in flight, and
+ * a writer submits each block as it fills up and only waits when it needs
+ * the buffer again. Blocks complete in any order but are returned and
+ * reused in submission order. The pread backend runs the same requests
+ * synchronously. io_uring is driven through its system calls and shared
+ * rings directly, without liburing.
+ */
+
+int parse_io_backend(const char *str, int *backend)
+{
+	if (strcmp(str, "stdio") == 0)
+		*backend = IO_BACKEND_STDIO;
+	else if (strcmp(str, "pread") == 0)
+		*backend = IO_BACKEND_PREAD;
+	else if (strcmp(str, "uring") == 0)
+		*backend = IO_BACKEND_URING;
+	else
+		return 1;
+
+	return 0;
+}
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#if defined(__linux__) && defined(HAVE_IO_URING) && defined(__GNUC__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define USE_IO_URING 1
+#endif
+#endif
+
+struct async_buffer {
+	char *data;
+	size_t len;		/* Bytes to transfer, or filled */
+	off_t offset;		/* In the file, unless sequential */
+	ssize_t result;		/* Bytes transferred, or -errno */
+	int busy;		/* Submitted and not completed */
+	struct iovec iov;	/* Request of the buffer */
+};
+
+#ifdef USE_IO_URING
+/* Submission and completion rings shared with the kernel */
+struct uring {
+	int fd;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ring;
+	void *cq_ring;
+	size_t sq_ring_size;
+	size_t cq_ring_size;
+	size_t sqes_size;
+};
+#endif
+
+struct async_file {
+	int fd;
+	int backend;		/* IO_BACKEND_* in use */
+	int writing;
+	int sequential;		/* No offsets: one block in flight */
+	off_t offset;		/* Of the next block submitted */
+	size_t head;		/* Oldest block, returned or in flight */
+	size_t tail;		/* Next block to submit */
+	size_t in_flight;
+	int end;		/* A read reached the end of the file */
+	int failed;
+	int broken;		/* Lost track of requests in flight */
+	struct async_buffer buffers[ASYNC_IO_DEPTH];
+#ifdef USE_IO_URING
+	struct uring ring;
+#endif
+};
+
+#ifdef USE_IO_URING
+
+static int uring_enter(int fd, unsigned int to_submit,
+		       unsigned int min_complete, unsigned int flags)
+{
+	long ret;
+
+	do {
+		ret = syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+			      flags, NULL, 0);
+	} while (ret < 0 && errno == EINTR);
+
+	return (int)ret;
+}
+
+static void uring_destroy(struct uring *ring)
+{
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_ring && ring->cq_ring != ring->sq_ring)
+		munmap(ring->cq_ring, ring->cq_ring_size);
+	if (ring->sq_ring)
+		munmap(ring->sq_ring, ring->sq_ring_size);
+	close(ring->fd);
+}
+
+static void *uring_map(int fd, size_t size, off_t offset)
+{
+	void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, fd, offset);
+
+	return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+/*
+ * Set up a ring for ASYNC_IO_DEPTH requests. Sequential files need reads
+ * and writes at the current position (Linux 5.6).
+ * Returns: 0 on success, non-zero if io_uring is not available
+ */
+static int uring_init(struct uring *ring, int sequential)
+{
+	struct io_uring_params params;
+	unsigned char *sq;
+	unsigned char *cq;
+
+	memset(ring, 0, sizeof(*ring));
+	memset(&params, 0, sizeof(params));
+	ring->fd = (int)syscall(__NR_io_uring_setup, ASYNC_IO_DEPTH, &params);
+	if (ring->fd < 0)
+		return 1;
+
+	if (sequential && !(params.features & IORING_FEAT_RW_CUR_POS)) {
+		close(ring->fd);
+		return 1;
+	}
+
+	ring->sq_ring_size = params.sq_off.array +
+			     params.sq_entries * sizeof(unsigned int);
+	ring->cq_ring_size = params.cq_off.cqes +
+			     params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_ring_size > ring->sq_ring_size)
+			ring->sq_ring_size = ring->cq_ring_size;
+		ring->cq_ring_size = ring->sq_ring_size;
+	}
+
+	ring->sq_ring = uring_map(ring->fd, ring->sq_ring_size,
+				  IORING_OFF_SQ_RING);
+	if (!ring->sq_ring) {
+		uring_destroy(ring);
+		return 1;
+	}
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		ring->cq_ring = ring->sq_ring;
+	else
+		ring->cq_ring = uring_map(ring->fd, ring->cq_ring_size,
+					  IORING_OFF_CQ_RING);
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = uring_map(ring->fd, ring->sqes_size, IORING_OFF_SQES);
+	if (!ring->cq_ring || !ring->sqes) {
+		uring_destroy(ring);
+		return 1;
+	}
+
+	sq = ring->sq_ring;
+	cq = ring->cq_ring;
+	ring->sq_tail = (unsigned int *)(sq + params.sq_off.tail);
+	ring->sq_mask = (unsigned int *)(sq + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned int *)(sq + params.sq_off.array);
+	ring->cq_head = (unsigned int *)(cq + params.cq_off.head);
+	ring->cq_tail = (unsigned int *)(cq + params.cq_off.tail);
+	ring->cq_mask = (unsigned int *)(cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+	return 0;
+}
+
+/* Queue one readv or writev of a buffer and hand it to the kernel */
+static int uring_submit(struct async_file *file, size_t index)
+{
+	struct uring *ring = &file->ring;
+	struct async_buffer *buf = &file->buffers[index];
+	unsigned int tail = *ring->sq_tail;
+	unsigned int slot = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[slot];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = file->writing ? IORING_OP_WRITEV : IORING_OP_READV;
+	sqe->fd = file->fd;
+	sqe->addr = (uint64_t)(uintptr_t)&buf->iov;
+	sqe->len = 1;
+	sqe->off = file->sequential ? (uint64_t)-1 : (uint64_t)buf->offset;
+	sqe->user_data = index;
+	ring->sq_array[slot] = slot;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	/* An entry the kernel did not take may still be submitted later */
+	if (uring_enter(ring->fd, 1, 0, 0) != 1) {
+		file->broken = 1;
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Record the results of all completed requests */
+static void uring_reap(struct async_file *file)
+{
+	struct uring *ring = &file->ring;
+	unsigned int head = *ring->cq_head;
+	unsigned int tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+	while (head != tail) {
+		struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+		struct async_buffer *buf = &file->buffers[cqe->user_data];
+
+		buf->result = cqe->res;
+		buf->busy = 0;
+		head++;
+	}
+
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+#endif /* USE_IO_URING */
+
+/* Transfer a buffer at once, as pread/pwrite, or read/write if sequential */
+static ssize_t transfer(const struct async_file *file, char *data,
+			size_t len, off_t offset)
+{
+	ssize_t n;
+
+	do {
+		if (file->writing)
+			n = file->sequential ? write(file->fd, data, len) :
+					       pwrite(file->fd, data, len, offset);
+		else
+			n = file->sequential ? read(file->fd, data, len) :
+					       pread(file->fd, data, len, offset);
+	} while (n < 0 && errno == EINTR);
+
+	return n < 0 ? -errno : n;
+}
+
+/* Start the request of the buffer at the tail */
+static int submit_block(struct async_file *file)
+{
+	size_t index = file->tail % ASYNC_IO_DEPTH;
+	struct async_buffer *buf = &file->buffers[index];
+
+	buf->offset = file->offset;
+	buf->iov.iov_base = buf->data;
+	buf->iov.iov_len = buf->len;
+	buf->busy = 1;
+	file->offset += buf->len;
+	file->tail++;
+	file->in_flight++;
+
+#ifdef USE_IO_URING
+	if (file->backend == IO_BACKEND_URING)
+		return uring_submit(file, index);
+#endif
+
+	buf->result = transfer(file, buf->data, buf->len, buf->offset);
+	buf->busy = 0;
+	return 0;
+}
+
+/* Wait for the request of the buffer at the head */
+static int wait_block(struct async_file *file)
+{
+#ifdef USE_IO_URING
+	struct async_buffer *buf = &file->buffers[file->head % ASYNC_IO_DEPTH];
+
+	while (buf->busy) {
+		uring_reap(file);
+		if (buf->busy &&
+		    uring_enter(file->ring.fd, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+			file->broken = 1;
+			return 1;
+		}
+	}
+#endif
+
+	file->in_flight--;
+	return 0;
+}
+
+/*
+ * Finish a short transfer synchronously, so the blocks stay contiguous.
+ * Returns: the bytes transferred, or -errno
+ */
+static ssize_t complete_block(const struct async_file *file,
+			      struct async_buffer *buf)
+{
+	size_t done = (size_t)buf->result;
+
+	while (done < buf->len) {
+		ssize_t n = transfer(file, buf->data + done, buf->len - done,
+				     buf->offset + (off_t)done);
+
+		if (n < 0)
+			return n;
+		if (n == 0)
+			break;
+		done += (size_t)n;
+	}
+
+	return (ssize_t)done;
+}
+
+/* Free the block last returned by async_file_read, if any */
+static void release_block(struct async_file *file)
+{
+	if (file->tail - file->head > file->in_flight)
+		file->head++;
+}
+
+/* Keep reads in flight, in buffers the caller is not working on */
+static int submit_reads(struct async_file *file)
+{
+	size_t limit = file->sequential ? 1 : ASYNC_IO_DEPTH;
+
+	while (!file->end && file->in_flight < limit &&
+	       file->tail - file->head < ASYNC_IO_DEPTH) {
+		file->buffers[file->tail % ASYNC_IO_DEPTH].len =
+			ASYNC_IO_BLOCK_SIZE;
+		if (submit_block(file) != 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+struct async_file *async_file_open(FILE *stream, int backend, int writing)
+{
+	struct async_file *file;
+	off_t offset;
+	int i;
+
+	file = calloc(1, sizeof(*file));
+	if (!file)
+		return NULL;
+
+	file->fd = fileno(stream);
+	file->backend = backend;
+	file->writing = writing;
+
+	offset = lseek(file->fd, 0, SEEK_CUR);
+	if (offset < 0 ||
+	    (writing && (fcntl(file->fd, F_GETFL) & O_APPEND)))
+		file->sequential = 1;
+	else
+		file->offset = offset;
+
+	for (i = 0; i < ASYNC_IO_DEPTH; i++) {
+		file->buffers[i].data = malloc(ASYNC_IO_BLOCK_SIZE);
+		if (!file->buffers[i].data) {
+			async_file_close(file);
+			return NULL;
+		}
+	}
+
+#ifdef USE_IO_URING
+	if (backend == IO_BACKEND_URING &&
+	    uring_init(&file->ring, file->sequential) != 0)
+		file->backend = IO_BACKEND_PREAD;
+#else
+	file->backend = IO_BACKEND_PREAD;
+#endif
+
+	if (!writing && submit_reads(file) != 0)
+		file->failed = 1;
+
+	return file;
+}
+
+int async_file_backend(const struct async_file *file)
+{
+	return file->backend;
+}
+
+int async_file_read(struct async_file *file, char **data, size_t *len)
+{
+	struct async_buffer *buf;
+	ssize_t n;
+
+	if (file->failed)
+		return -1;
+
+	release_block(file);
+	if (submit_reads(file) != 0) {
+		file->failed = 1;
+		return -1;
+	}
+	if (file->head == file->tail)
+		return 0;
+
+	buf = &file->buffers[file->head % ASYNC_IO_DEPTH];
+	if (wait_block(file) != 0) {
+		file->failed = 1;
+		return -1;
+	}
+
+	n = buf->result;
+	if (n > 0 && !file->sequential)
+		n = complete_block(file, buf);
+	if (n < 0) {
+		file->failed = 1;
+		return -1;
+	}
+
+	/* Only a full block can be followed by more data */
+	if (file->sequential ? n == 0 : (size_t)n < buf->len)
+		file->end = 1;
+	if (n == 0) {
+		file->head++;
+		return 0;
+	}
+
+	/* Read ahead while the caller works on this block */
+	if (submit_reads(file) != 0) {
+		file->failed = 1;
+		return -1;
+	}
+
+	*data = buf->data;
+	*len = (size_t)n;
+	return 1;
+}
+
+/* Wait for the oldest write and finish it if it was short */
+static int finish_write(struct async_file *file)
+{
+	struct async_buffer *buf = &file->buffers[file->head % ASYNC_IO_DEPTH];
+	ssize_t n;
+
+	if (wait_block(file) != 0)
+		return 1;
+
+	n = buf->result;
+	if (n > 0)
+		n = complete_block(file, buf);
+	file->head++;
+	if (n < 0 || (size_t)n != buf->len)
+		return 1;
+
+	buf->len = 0;
+	return 0;
+}
+
+/* Submit the block being filled and make sure the next buffer is free */
+static int submit_write(struct async_file *file)
+{
+	if (file->sequential && file->in_flight > 0 &&
+	    finish_write(file) != 0)
+		return 1;
+	if (submit_block(file) != 0)
+		return 1;
+	if (file->tail - file->head == ASYNC_IO_DEPTH &&
+	    finish_write(file) != 0)
+		return 1;
+
+	return 0;
+}
+
+int async_file_write(struct async_file *file, const char *data, size_t len)
+{
+	while (len > 0 && !file->failed) {
+		struct async_buffer *buf =
+			&file->buffers[file->tail % ASYNC_IO_DEPTH];
+		size_t n = ASYNC_IO_BLOCK_SIZE - buf->len;
+
+		if (n > len)
+			n = len;
+		memcpy(buf->data + buf->len, data, n);
+		buf->len += n;
+		data += n;
+		len -= n;
+
+		if (buf->len == ASYNC_IO_BLOCK_SIZE && submit_write(file) != 0)
+			file->failed = 1;
+	}
+
+	return file->failed;
+}
+
+int async_file_close(struct async_file *file)
+{
+	int ret;
+	int i;
+
+	if (file->writing && !file->failed &&
+	    file->buffers[file->tail % ASYNC_IO_DEPTH].len > 0 &&
+	    submit_write(file) != 0)
+		file->failed = 1;
+
+	/* The kernel may still fill or read the buffers in flight */
+	if (!file->writing)
+		release_block(file);
+	while (file->in_flight > 0 && !file->broken) {
+		if (file->writing) {
+			if (finish_write(file) != 0)
+				file->failed = 1;
+		} else if (wait_block(file) == 0) {
+			file->head++;
+		}
+	}
+
+	/* Leave the descriptor after the data, as a stream write would */
+	if (file->writing && !file->sequential &&
+	    lseek(file->fd, file->offset, SEEK_SET) < 0)
+		file->failed = 1;
+
+#ifdef USE_IO_URING
+	if (file->backend == IO_BACKEND_URING)
+		uring_destroy(&file->ring);
+#endif
+
+	/* Buffers of lost requests are left to the kernel */
+	for (i = 0; i < ASYNC_IO_DEPTH && !file->broken; i++)
+		free(file->buffers[i].data);
+	ret = file->failed || file->broken;
+	free(file);
+	return ret;
+}
+
+#else /* _WIN32 */
+
+struct async_file *async_file_open(FILE *stream, int backend, int writing)
+{
+	(void)stream;	/* No pread/pwrite: only stdio is supported */
+	(void)backend;
+	(void)writing;
+
+	return NULL;
+}
+
+int async_file_backend(const struct async_file *file)
+{
+	(void)file;
+
+	return IO_BACKEND_STDIO;
+}
+
+int async_file_read(struct async_file *file, char **data, size_t *len)
+{
+	(void)file;
+	(void)data;
+	(void)len;
+
+	return -1;
+}
+
+int async_file_write(struct async_file *file, const char *data, size_t len)
+{
+	(void)file;
+	(void)data;
+	(void)len;
+
+	return 1;
+}
+
+int async_file_close(struct async_file *file)
+{
+	(void)file;
+
+	return 1;
+}
+
+#endif /* _WIN32 */
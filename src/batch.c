@@ -0,0 +1,1953 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "vacation.h"
+
+/* Batch record field positions */
+enum batch_field {
+	FIELD_ID,
+	FIELD_ANNUAL_DAYS,
+	FIELD_ANNUAL_HOURS,
+	FIELD_CURRENT_HOURS,
+	FIELD_VACATION_EXTRA,
+	FIELD_WEEK_START,
+	FIELD_SPECIAL_ACCUM,
+	FIELD_POLICY
+};
+
+/* Minimum number of fields in a record (up to and including current hours) */
+#define BATCH_MIN_FIELDS	(FIELD_CURRENT_HOURS + 1)
+
+/* Output buffer size for batch results */
+#define BATCH_OUTPUT_BUFFER	(64 * 1024)
+
+/* Room for the fixed text and line number of a rendered batch error */
+#define BATCH_ERROR_EXTRA	64
+
+/*
+ * Parsing helper functions
+ */
+
+static char *trim_field(char *field)
+{
+	char *end;
+
+	while (isspace((unsigned char)*field))
+		field++;
+
+	end = field + strlen(field);
+	while (end > field && isspace((unsigned char)end[-1]))
+		end--;
+	*end = '\0';
+
+	return field;
+}
+
+static int parse_week_start(const char *str, int *week_start)
+{
+	int value;
+
+	if (strcmp(str, "sunday") == 0 || strcmp(str, "Sunday") == 0) {
+		*week_start = WEEK_START_SUNDAY;
+		return 0;
+	}
+
+	if (strcmp(str, "monday") == 0 || strcmp(str, "Monday") == 0) {
+		*week_start = WEEK_START_MONDAY;
+		return 0;
+	}
+
+	if (parse_integer(str, &value) != 0)
+		return 1;
+
+	if (value != WEEK_START_SUNDAY && value != WEEK_START_MONDAY)
+		return 1;
+
+	*week_start = value;
+	return 0;
+}
+
+/*
+ * Split a record on commas into trimmed fields; missing trailing fields
+ * are empty strings.
+ * Returns: VALIDATION_OK, or the code stored in error
+ */
+static int split_record_fields(char *line, char **fields, int max_fields,
+			       int min_fields, struct validation_error *error)
+{
+	int num_fields = 0;
+	char *p = line;
+
+	for (;;) {
+		char *comma = strchr(p, ',');
+
+		if (num_fields == max_fields)
+			return set_validation_error(error,
+						    VALIDATION_TOO_MANY_FIELDS,
+						    0, max_fields);
+
+		if (comma)
+			*comma = '\0';
+		fields[num_fields++] = trim_field(p);
+
+		if (!comma)
+			break;
+		p = comma + 1;
+	}
+
+	if (num_fields < min_fields)
+		return set_validation_error(error, VALIDATION_TOO_FEW_FIELDS,
+					    0, min_fields);
+
+	for (; num_fields < max_fields; num_fields++)
+		fields[num_fields] = "";
+
+	return VALIDATION_OK;
+}
+
+int parse_batch_record(char *line, struct batch_record *record)
+{
+	char *fields[BATCH_NUM_FIELDS];
+	int int_value;
+	double double_value;
+
+	if (split_record_fields(line, fields, BATCH_NUM_FIELDS,
+				BATCH_MIN_FIELDS,
+				&record->error) != VALIDATION_OK)
+		return record->error.code;
+
+	record->id = fields[FIELD_ID];
+
+	/* The policy comes first: annual hours are converted with it */
+	if (*fields[FIELD_POLICY] != '\0') {
+		const struct vacation_policy *policy = NULL;
+
+		if (parse_integer(fields[FIELD_POLICY], &int_value) == 0)
+			policy = find_policy(record->args.policies, int_value);
+		if (!policy)
+			return set_validation_text(&record->error,
+						   VALIDATION_POLICY,
+						   fields[FIELD_POLICY]);
+		record->args.policy_id = int_value;
+		record->args.policy = policy;
+	}
+
+	/* Record annual allowance overrides the command-line default */
+	if (*fields[FIELD_ANNUAL_DAYS] != '\0' ||
+	    *fields[FIELD_ANNUAL_HOURS] != '\0') {
+		record->args.annual_days_set = 0;
+		record->args.annual_hours_set = 0;
+	}
+
+	if (*fields[FIELD_ANNUAL_DAYS] != '\0') {
+		if (parse_integer(fields[FIELD_ANNUAL_DAYS], &int_value) != 0)
+			return set_validation_text(&record->error,
+						   VALIDATION_ANNUAL_DAYS_FORMAT,
+						   fields[FIELD_ANNUAL_DAYS]);
+		record->args.annual_days = int_value;
+		record->args.annual_days_set = 1;
+	}
+
+	if (*fields[FIELD_ANNUAL_HOURS] != '\0') {
+		if (parse_integer(fields[FIELD_ANNUAL_HOURS], &int_value) != 0)
+			return set_validation_text(&record->error,
+						   VALIDATION_ANNUAL_HOURS_FORMAT,
+						   fields[FIELD_ANNUAL_HOURS]);
+		record->args.annual_hours = int_value;
+		record->args.annual_hours_set = 1;
+	}
+
+	/* Hours inherited from the command line follow the record's policy */
+	if (record->args.annual_hours_set &&
+	    !policy_is_valid_annual_hours(record->args.policy,
+					  record->args.annual_hours,
+					  &record->args.annual_days))
+		return set_validation_error(&record->error,
+					    VALIDATION_ANNUAL_HOURS,
+					    record->args.annual_hours, 0);
+
+	if (*fields[FIELD_CURRENT_HOURS] == '\0' ||
+	    parse_number(fields[FIELD_CURRENT_HOURS], &double_value) != 0)
+		return set_validation_text(&record->error,
+					   VALIDATION_CURRENT_HOURS_FORMAT,
+					   fields[FIELD_CURRENT_HOURS]);
+	record->args.current_hours = double_value;
+	record->args.current_hours_set = 1;
+
+	if (*fields[FIELD_VACATION_EXTRA] != '\0') {
+		if (parse_number(fields[FIELD_VACATION_EXTRA], &double_value) != 0)
+			return set_validation_text(&record->error,
+						   VALIDATION_EXTRA_FORMAT,
+						   fields[FIELD_VACATION_EXTRA]);
+		record->args.vacation_extra = double_value;
+		record->args.vacation_extra_set = 1;
+	}
+
+	if (*fields[FIELD_WEEK_START] != '\0' &&
+	    parse_week_start(fields[FIELD_WEEK_START],
+			     &record->args.week_start) != 0)
+		return set_validation_text(&record->error,
+					   VALIDATION_WEEK_START_FORMAT,
+					   fields[FIELD_WEEK_START]);
+
+	if (*fields[FIELD_SPECIAL_ACCUM] != '\0') {
+		if (parse_integer(fields[FIELD_SPECIAL_ACCUM], &int_value) != 0 ||
+		    (int_value != 0 && int_value != 1))
+			return set_validation_text(&record->error,
+						   VALIDATION_SPECIAL_ACCUM_FORMAT,
+						   fields[FIELD_SPECIAL_ACCUM]);
+		record->args.special_accum = int_value;
+	}
+
+	return 0;
+}
+
+int parse_journal_record(char *line, struct journal_record *record)
+{
+	char *fields[JOURNAL_NUM_FIELDS];
+
+	if (split_record_fields(line, fields, JOURNAL_NUM_FIELDS,
+				JOURNAL_NUM_FIELDS - 1,
+				&record->error) != VALIDATION_OK)
+		return record->error.code;
+
+	record->id = fields[JOURNAL_FIELD_ID];
+	if (strlen(record->id) > BATCH_MAX_ID)
+		return set_validation_error(&record->error,
+					    VALIDATION_ID_LENGTH, 0,
+					    BATCH_MAX_ID);
+
+	if (*fields[JOURNAL_FIELD_CURRENT_HOURS] == '\0' ||
+	    parse_number(fields[JOURNAL_FIELD_CURRENT_HOURS],
+			 &record->current_hours) != 0)
+		return set_validation_text(&record->error,
+					   VALIDATION_CURRENT_HOURS_FORMAT,
+					   fields[JOURNAL_FIELD_CURRENT_HOURS]);
+
+	record->vacation_extra = 0.0;
+	record->vacation_extra_set = 0;
+	if (*fields[JOURNAL_FIELD_VACATION_EXTRA] != '\0') {
+		if (parse_number(fields[JOURNAL_FIELD_VACATION_EXTRA],
+				 &record->vacation_extra) != 0)
+			return set_validation_text(&record->error,
+						   VALIDATION_EXTRA_FORMAT,
+						   fields[JOURNAL_FIELD_VACATION_EXTRA]);
+		if (record->vacation_extra < 0)
+			return set_validation_error(&record->error,
+						    VALIDATION_EXTRA_NEGATIVE,
+						    0, 0);
+		record->vacation_extra_set = 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Output functions
+ */
+
+void print_batch_header(FILE *stream, int first_year, int num_years)
+{
+	int y;
+
+	fputs("id,annual_days,max_accum_days,current_hours,vacation_extra,"
+	      "week_start,working_days_remaining,additional_hours,"
+	      "additional_days,total_hours,total_days,excess_hours,"
+	      "excess_days", stream);
+	for (y = 1; y < num_years; y++)
+		fprintf(stream, ",total_days_%d,excess_days_%d",
+			first_year + y, first_year + y);
+	fputc('\n', stream);
+}
+
+/* Append ",<value>" to the row */
+static size_t append_double_field(char *buf, size_t len, double value)
+{
+	int n;
+
+	buf[len++] = ',';
+	n = format_double_value(buf + len, BATCH_MAX_ROW - len, value);
+
+	return (n > 0) ? len + n : len;
+}
+
+size_t format_batch_result(char *buf, const char *id,
+			   const struct vacation_input *input,
+			   const struct vacation_result *result)
+{
+	size_t id_len = strlen(id);
+	size_t len;
+
+	/* BATCH_MAX_ROW bounds the columns after the ID */
+	memcpy(buf, id, id_len);
+	buf += id_len;
+	len = sprintf(buf, ",%d,%d", input->annual_days,
+		      input->max_accum_days);
+	len = append_double_field(buf, len, input->current_hours);
+	len = append_double_field(buf, len, input->vacation_extra);
+	len += sprintf(buf + len, ",%d,%d", input->week_start,
+		       result->working_days_remaining);
+	len = append_double_field(buf, len, result->additional_hours);
+	len = append_double_field(buf, len, result->additional_days);
+	len = append_double_field(buf, len, result->total_hours);
+	len = append_double_field(buf, len, result->total_days);
+	len = append_double_field(buf, len, days_to_hours(result->excess_days));
+	len = append_double_field(buf, len, result->excess_days);
+	buf[len++] = '\n';
+	buf[len] = '\0';
+
+	return id_len + len;
+}
+
+/* Append ",<value>" to the row, value in hundredths */
+static size_t append_centi_field(char *buf, size_t len, int64_t value)
+{
+	int n;
+
+	buf[len++] = ',';
+	n = format_centi_value(buf + len, BATCH_MAX_ROW - len, value);
+
+	return (n > 0) ? len + n : len;
+}
+
+/* Fixed-point version of format_batch_result, same columns */
+static size_t format_batch_result_fixed(char *buf, const char *id,
+					const struct vacation_fixed_input *input,
+					const struct vacation_fixed_result *result)
+{
+	size_t id_len = strlen(id);
+	size_t len;
+
+	memcpy(buf, id, id_len);
+	buf += id_len;
+	len = sprintf(buf, ",%d,%d", input->annual_days,
+		      input->max_accum_days);
+	len = append_centi_field(buf, len, input->current_centi_hours);
+	len = append_centi_field(buf, len, centi_hours_to_centi_days(
+		input->vacation_extra_centi_hours));
+	len += sprintf(buf + len, ",%d,%d", input->week_start,
+		       result->working_days_remaining);
+	len = append_centi_field(buf, len, result->additional_centi_hours);
+	len = append_centi_field(buf, len, centi_hours_to_centi_days(
+		result->additional_centi_hours));
+	len = append_centi_field(buf, len, result->total_centi_hours);
+	len = append_centi_field(buf, len, centi_hours_to_centi_days(
+		result->total_centi_hours));
+	len = append_centi_field(buf, len, result->excess_centi_hours);
+	len = append_centi_field(buf, len, centi_hours_to_centi_days(
+		result->excess_centi_hours));
+	buf[len++] = '\n';
+	buf[len] = '\0';
+
+	return id_len + len;
+}
+
+/*
+ * Batch driver
+ */
+
+/* Growable output text */
+struct text_buffer {
+	char *data;
+	size_t len;
+	size_t size;
+	int failed;	/* Set when an allocation failed */
+};
+
+/* Calendar-dependent values shared by all records of a run */
+struct batch_context {
+	const struct vacation_args *defaults;
+	const char *path;
+	int month;
+	int year;
+	int max_working_days[2];	/* Extra vacation limit per week start */
+	int working_days_remaining[2];	/* Per week start */
+	int fixed_point;		/* Calculate in centi-hours */
+	int output_format;		/* OUTPUT_FORMAT_* */
+	int num_years;			/* Projected years */
+};
+
+/*
+ * Room for the IDs of a block: a full block of IDs that fit a binary record,
+ * and one more of any length that an input line can hold.
+ */
+#define BATCH_ID_TEXT_SIZE \
+	(BATCH_BLOCK_SIZE * (BATCH_MAX_ID + 1) + BATCH_MAX_LINE + 1)
+
+/* A block of records in structure-of-arrays layout */
+struct batch_block {
+	size_t count;
+	size_t id_used;		/* Bytes of id_text in use */
+	size_t id_offset[BATCH_BLOCK_SIZE];	/* NUL-terminated, in id_text */
+	size_t id_length[BATCH_BLOCK_SIZE];
+	char id_text[BATCH_ID_TEXT_SIZE];
+	int annual_days[BATCH_BLOCK_SIZE];
+	int max_accum_days[BATCH_BLOCK_SIZE];
+	double current_hours[BATCH_BLOCK_SIZE];
+	double vacation_extra[BATCH_BLOCK_SIZE];
+	int current_month[BATCH_BLOCK_SIZE];
+	int week_start[BATCH_BLOCK_SIZE];
+	const struct vacation_policy *policy[BATCH_BLOCK_SIZE];
+	double monthly_hours[BATCH_BLOCK_SIZE];
+	double additional_hours[BATCH_BLOCK_SIZE];
+	double additional_days[BATCH_BLOCK_SIZE];
+	double total_hours[BATCH_BLOCK_SIZE];
+	double total_days[BATCH_BLOCK_SIZE];
+	double excess_days[BATCH_BLOCK_SIZE];
+
+	/* Fixed-point mode */
+	int64_t current_centi_hours[BATCH_BLOCK_SIZE];
+	int64_t vacation_extra_centi_hours[BATCH_BLOCK_SIZE];
+	int64_t monthly_centi_hours[BATCH_BLOCK_SIZE];
+	int64_t additional_centi_hours[BATCH_BLOCK_SIZE];
+	int64_t total_centi_hours[BATCH_BLOCK_SIZE];
+	int64_t excess_centi_hours[BATCH_BLOCK_SIZE];
+};
+
+/* Input bytes per --threads chunk, and chunks per thread in the window */
+#define THREADED_CHUNK_SIZE		(32 * 1024)
+#define THREADED_CHUNKS_PER_THREAD	8
+
+/* Lines of the input processed as one thread pool task */
+struct batch_chunk {
+	char *start;
+	char *end;
+	unsigned long first_line;
+	unsigned long num_rejected;
+	struct text_buffer out;
+	struct text_buffer errors;	/* Rendered messages of rejected lines */
+};
+
+/* Threaded run state */
+struct batch_job {
+	const struct batch_context *ctx;
+	struct batch_chunk *chunks;	/* Chunk slots of the window */
+	struct arena *arenas;	/* Chunk scratch memory, per worker */
+	unsigned long num_rejected;
+	int failed;
+};
+
+static char *text_buffer_reserve(struct text_buffer *buf, size_t len)
+{
+	if (buf->failed)
+		return NULL;
+
+	if (buf->len + len > buf->size) {
+		size_t size = buf->size ? buf->size : BATCH_OUTPUT_BUFFER;
+		char *data;
+
+		while (size < buf->len + len)
+			size *= 2;
+
+		data = realloc(buf->data, size);
+		if (!data) {
+			buf->failed = 1;
+			return NULL;
+		}
+		buf->data = data;
+		buf->size = size;
+	}
+
+	return buf->data + buf->len;
+}
+
+static int is_header_record(const char *line)
+{
+	return strncmp(line, "id,", 3) == 0;
+}
+
+int is_batch_skipped_line(const char *line, unsigned long line_number)
+{
+	const char *p = line;
+
+	while (isspace((unsigned char)*p))
+		p++;
+
+	return *p == '\0' || *p == '#' ||
+	       (line_number == 1 && is_header_record(line));
+}
+
+static void init_batch_context(struct batch_context *ctx,
+			       const struct vacation_args *defaults,
+			       int month, int year)
+{
+	int ws;
+
+	ctx->defaults = defaults;
+	ctx->path = defaults->batch_file;
+	ctx->month = month;
+	ctx->year = year;
+	ctx->fixed_point = defaults->fixed_point;
+	ctx->output_format = defaults->output_format;
+	ctx->num_years = defaults->num_years;
+
+	/* Calendar work only depends on the week start within a run */
+	for (ws = WEEK_START_SUNDAY; ws <= WEEK_START_MONDAY; ws++) {
+		ctx->max_working_days[ws] = calendar_working_days_from_prev_month(
+			defaults->holidays, month, year, ws);
+		ctx->working_days_remaining[ws] = calendar_remaining_working_days(
+			defaults->holidays, month, year, ws);
+	}
+}
+
+/*
+ * Check a parsed record against the run, without printing.
+ * Returns: VALIDATION_OK, or the code stored in record->error
+ */
+static int check_batch_record(struct batch_record *record,
+			      const struct batch_context *ctx)
+{
+	const struct vacation_args *args = &record->args;
+	struct validation_error *error = &record->error;
+	int64_t centi_hours;
+
+	if (check_arguments(args, error) != VALIDATION_OK ||
+	    check_annual_days(args->policy, args->annual_days,
+			      error) != VALIDATION_OK)
+		return error->code;
+
+	if (args->vacation_extra_set &&
+	    check_vacation_days(args->vacation_extra,
+				ctx->max_working_days[args->week_start],
+				error) != VALIDATION_OK)
+		return error->code;
+
+	/* Binary records have a fixed-width ID; text and JSON take any */
+	if (ctx->output_format == OUTPUT_FORMAT_BIN &&
+	    strlen(record->id) > BATCH_MAX_ID)
+		return set_validation_error(error, VALIDATION_ID_LENGTH, 0,
+					    BATCH_MAX_ID);
+
+	if (ctx->fixed_point &&
+	    hours_to_centi_hours(args->current_hours, &centi_hours) != 0)
+		return set_validation_error(error, VALIDATION_FIXED_RANGE, 0, 0);
+
+	return VALIDATION_OK;
+}
+
+static void clear_batch_block(struct batch_block *block)
+{
+	block->count = 0;
+	block->id_used = 0;
+}
+
+/* No room for another record, or for an ID as long as an input line */
+static int is_batch_block_full(const struct batch_block *block)
+{
+	return block->count == BATCH_BLOCK_SIZE ||
+	       block->id_used + BATCH_MAX_LINE + 1 > sizeof(block->id_text);
+}
+
+static const char *batch_block_id(const struct batch_block *block, size_t i)
+{
+	return block->id_text + block->id_offset[i];
+}
+
+/* Append a valid record to the block, which must not be full */
+static void add_batch_record(struct batch_block *block,
+			     const struct batch_record *record,
+			     const struct batch_context *ctx)
+{
+	const struct vacation_args *args = &record->args;
+	size_t i = block->count;
+	size_t id_len = strlen(record->id);
+
+	block->id_offset[i] = block->id_used;
+	block->id_length[i] = id_len;
+	memcpy(block->id_text + block->id_used, record->id, id_len + 1);
+	block->id_used += id_len + 1;
+	block->annual_days[i] = args->annual_days;
+	block->max_accum_days[i] = policy_max_accum(args->policy,
+						    args->annual_days,
+						    args->special_accum);
+	block->policy[i] = args->policy;
+	block->current_hours[i] = args->current_hours;
+	block->vacation_extra[i] = args->vacation_extra;
+	block->current_month[i] = ctx->month;
+	block->week_start[i] = args->week_start;
+	if (ctx->fixed_point) {
+		/*
+		 * Both conversions succeed: check_batch_record range-checks
+		 * the hours and any set extra days, and an extra that is
+		 * neither in the record nor given with -v keeps the 0 of
+		 * init_vacation_args.
+		 */
+		hours_to_centi_hours(args->current_hours,
+				     &block->current_centi_hours[i]);
+		days_to_centi_hours(args->vacation_extra,
+				    &block->vacation_extra_centi_hours[i]);
+	}
+	block->count++;
+}
+
+/* Worst-case length of the projection columns of one row */
+#define BATCH_MAX_PROJECTION \
+	((MAX_PROJECTION_YEARS - 1) * 2 * RESULT_MAX_VALUE)
+
+/* Worst-case JSON line for an ID of id_len bytes, all of them escaped */
+#define BATCH_MAX_JSON(id_len)	(RESULT_MAX_JSON + 6 * (id_len))
+
+/*
+ * Append the later years of a projection: total and excess days columns
+ * before the row's newline, or one JSON line per year (the first included).
+ */
+static void append_projection(struct text_buffer *out,
+			      const struct batch_context *ctx, const char *id,
+			      size_t id_len, const struct vacation_input *input,
+			      const struct vacation_result *result)
+{
+	struct vacation_year_result years[MAX_PROJECTION_YEARS];
+	char *row;
+	int y;
+
+	calculate_vacation_projection(input, result, ctx->num_years, years);
+
+	if (ctx->output_format == OUTPUT_FORMAT_JSONL) {
+		for (y = 0; y < ctx->num_years; y++) {
+			row = text_buffer_reserve(out, BATCH_MAX_JSON(id_len));
+			if (!row)
+				return;
+			out->len += format_projection_json(row, id, &years[y]);
+		}
+		return;
+	}
+
+	out->len--;	/* Drop the newline */
+	row = out->data + out->len;
+	for (y = 1; y < ctx->num_years; y++) {
+		int n;
+
+		*row++ = ',';
+		n = format_double_value(row, RESULT_MAX_VALUE - 1,
+					years[y].total_days);
+		row += (n > 0) ? n : 0;
+		*row++ = ',';
+		n = format_double_value(row, RESULT_MAX_VALUE - 1,
+					years[y].excess_days);
+		row += (n > 0) ? n : 0;
+	}
+	*row++ = '\n';
+	out->len = row - out->data;
+}
+
+/* Append one result as a JSON line or a binary record */
+static void append_result_format(struct text_buffer *out,
+				 const struct batch_context *ctx, const char *id,
+				 size_t id_len,
+				 const struct vacation_input *input,
+				 const struct vacation_result *result)
+{
+	char *row;
+
+	if (ctx->output_format == OUTPUT_FORMAT_JSONL) {
+		row = text_buffer_reserve(out, BATCH_MAX_JSON(id_len));
+		if (row)
+			out->len += format_result_json(row, id, input, result);
+	} else {
+		row = text_buffer_reserve(out, RESULT_RECORD_SIZE);
+		if (row) {
+			encode_result_record((unsigned char *)row, id, input,
+					     result);
+			out->len += RESULT_RECORD_SIZE;
+		}
+	}
+}
+
+/* Fixed-point version of compute_batch_block */
+static void compute_batch_block_fixed(struct batch_block *block)
+{
+	struct vacation_batch_fixed_input in;
+	struct vacation_batch_fixed_result res;
+
+	in.annual_days = block->annual_days;
+	in.max_accum_days = block->max_accum_days;
+	in.current_centi_hours = block->current_centi_hours;
+	in.vacation_extra_centi_hours = block->vacation_extra_centi_hours;
+	in.current_month = block->current_month;
+	res.monthly_centi_hours = block->monthly_centi_hours;
+	res.additional_centi_hours = block->additional_centi_hours;
+	res.total_centi_hours = block->total_centi_hours;
+	res.excess_centi_hours = block->excess_centi_hours;
+
+	calculate_vacation_batch_fixed(&in, &res, block->count);
+}
+
+/* Fixed-point version of format_batch_block */
+static void format_batch_block_fixed(const struct batch_block *block,
+				     const struct batch_context *ctx,
+				     struct text_buffer *out)
+{
+	struct vacation_fixed_input input;
+	struct vacation_fixed_result result;
+	char *row;
+	size_t i;
+
+	for (i = 0; i < block->count; i++) {
+		input.annual_days = block->annual_days[i];
+		input.max_accum_days = block->max_accum_days[i];
+		input.current_centi_hours = block->current_centi_hours[i];
+		input.current_month = block->current_month[i];
+		input.current_year = ctx->year;
+		input.vacation_extra_centi_hours =
+			block->vacation_extra_centi_hours[i];
+		input.week_start = block->week_start[i];
+		input.holidays = ctx->defaults->holidays;
+		input.policy = block->policy[i];
+
+		result.remaining_months = calculate_remaining_months(ctx->month);
+		result.monthly_centi_hours = block->monthly_centi_hours[i];
+		result.additional_centi_hours = block->additional_centi_hours[i];
+		result.total_centi_hours = block->total_centi_hours[i];
+		result.excess_centi_hours = block->excess_centi_hours[i];
+		result.working_days_remaining =
+			ctx->working_days_remaining[block->week_start[i]];
+
+		if (ctx->output_format != OUTPUT_FORMAT_TEXT) {
+			struct vacation_input output_input;
+			struct vacation_result output_result;
+
+			fixed_to_vacation_result(&input, &result, &output_input,
+						 &output_result);
+			append_result_format(out, ctx, batch_block_id(block, i),
+					     block->id_length[i], &output_input,
+					     &output_result);
+			continue;
+		}
+
+		row = text_buffer_reserve(out, BATCH_MAX_ROW +
+					  block->id_length[i]);
+		if (!row)
+			break;
+		out->len += format_batch_result_fixed(row,
+						      batch_block_id(block, i),
+						      &input, &result);
+	}
+}
+
+/*
+ * Append the result row of one record in the output format of the run.
+ * Returns: 0 on success, non-zero if the output buffer cannot grow
+ */
+static int append_batch_row(struct text_buffer *out,
+			    const struct batch_context *ctx, const char *id,
+			    size_t id_len, const struct vacation_input *input,
+			    const struct vacation_result *result)
+{
+	char *row;
+
+	if (ctx->num_years > 1 && ctx->output_format == OUTPUT_FORMAT_JSONL) {
+		append_projection(out, ctx, id, id_len, input, result);
+		return 0;
+	}
+
+	if (ctx->output_format != OUTPUT_FORMAT_TEXT) {
+		append_result_format(out, ctx, id, id_len, input, result);
+		return 0;
+	}
+
+	row = text_buffer_reserve(out, BATCH_MAX_ROW + BATCH_MAX_PROJECTION +
+				  id_len);
+	if (!row)
+		return 1;
+	out->len += format_batch_result(row, id, input, result);
+	if (ctx->num_years > 1)
+		append_projection(out, ctx, id, id_len, input, result);
+	return 0;
+}
+
+/* Run the batch kernel over all records of the block */
+static void compute_batch_block(struct batch_block *block,
+				const struct batch_context *ctx)
+{
+	struct vacation_batch_input in;
+	struct vacation_batch_result res;
+
+	if (ctx->fixed_point) {
+		compute_batch_block_fixed(block);
+		return;
+	}
+
+	in.annual_days = block->annual_days;
+	in.max_accum_days = block->max_accum_days;
+	in.current_hours = block->current_hours;
+	in.vacation_extra = block->vacation_extra;
+	in.current_month = block->current_month;
+	res.monthly_hours = block->monthly_hours;
+	res.additional_hours = block->additional_hours;
+	res.additional_days = block->additional_days;
+	res.total_hours = block->total_hours;
+	res.total_days = block->total_days;
+	res.excess_days = block->excess_days;
+
+	calculate_vacation_batch(&in, &res, block->count);
+}
+
+/* Append the result rows of a computed block */
+static void format_batch_block(const struct batch_block *block,
+			       const struct batch_context *ctx,
+			       struct text_buffer *out)
+{
+	struct vacation_input input;
+	struct vacation_result result;
+	size_t i;
+
+	if (ctx->fixed_point) {
+		format_batch_block_fixed(block, ctx, out);
+		return;
+	}
+
+	for (i = 0; i < block->count; i++) {
+		input.annual_days = block->annual_days[i];
+		input.max_accum_days = block->max_accum_days[i];
+		input.current_hours = block->current_hours[i];
+		input.current_month = block->current_month[i];
+		input.current_year = ctx->year;
+		input.vacation_extra = block->vacation_extra[i];
+		input.week_start = block->week_start[i];
+		input.holidays = ctx->defaults->holidays;
+		input.policy = block->policy[i];
+
+		result.remaining_months = calculate_remaining_months(ctx->month);
+		result.monthly_hours = block->monthly_hours[i];
+		result.additional_hours = block->additional_hours[i];
+		result.additional_days = block->additional_days[i];
+		result.total_hours = block->total_hours[i];
+		result.total_days = block->total_days[i];
+		result.excess_days = block->excess_days[i];
+		result.working_days_remaining =
+			ctx->working_days_remaining[block->week_start[i]];
+
+		if (append_batch_row(out, ctx, batch_block_id(block, i),
+				     block->id_length[i], &input, &result) != 0)
+			break;
+	}
+}
+
+/* Compute all records of the block and append their result rows */
+static void flush_batch_block(struct batch_block *block,
+			      const struct batch_context *ctx,
+			      struct text_buffer *out)
+{
+	compute_batch_block(block, ctx);
+	format_batch_block(block, ctx, out);
+	clear_batch_block(block);
+}
+
+/* Render a rejected record's error, tagged with its line number */
+static void append_batch_error(struct text_buffer *errors,
+			       const struct batch_context *ctx,
+			       unsigned long line_number,
+			       const struct validation_error *error)
+{
+	char message[VALIDATION_MAX_MESSAGE];
+	char *row;
+
+	format_validation_error(message, sizeof(message), error);
+	row = text_buffer_reserve(errors, strlen(ctx->path) +
+				  sizeof(message) + BATCH_ERROR_EXTRA);
+	if (!row)
+		return;
+	errors->len += sprintf(row, "Error: %s:%lu: %s. Record skipped.\n",
+			       ctx->path, line_number, message);
+}
+
+/*
+ * Parse one input line (NUL-terminated, newline included or not) and add
+ * its record to the block, which must have room for it. Errors are
+ * rendered into errors instead of being printed.
+ * Returns: 0 if the line was accepted or skipped, non-zero if rejected
+ */
+static int parse_batch_line(char *line, unsigned long line_number,
+			    const struct batch_context *ctx,
+			    struct batch_block *block,
+			    struct text_buffer *errors)
+{
+	struct batch_record record;
+
+	if (is_batch_skipped_line(line, line_number))
+		return 0;
+
+	record.args = *ctx->defaults;
+	if (parse_batch_record(line, &record) != 0 ||
+	    check_batch_record(&record, ctx) != VALIDATION_OK) {
+		append_batch_error(errors, ctx, line_number, &record.error);
+		return 1;
+	}
+
+	add_batch_record(block, &record, ctx);
+	return 0;
+}
+
+/*
+ * Process one input line, flushing the block once it is full.
+ * Returns: 0 if the line was accepted or skipped, non-zero if rejected
+ */
+static int process_batch_line(char *line, unsigned long line_number,
+			      const struct batch_context *ctx,
+			      struct batch_block *block,
+			      struct text_buffer *out,
+			      struct text_buffer *errors)
+{
+	if (parse_batch_line(line, line_number, ctx, block, errors) != 0)
+		return 1;
+
+	if (is_batch_block_full(block))
+		flush_batch_block(block, ctx, out);
+
+	return 0;
+}
+
+/* Reject a line longer than BATCH_MAX_LINE */
+static void append_length_error(struct text_buffer *errors,
+				const struct batch_context *ctx,
+				unsigned long line_number)
+{
+	struct validation_error error;
+
+	set_validation_error(&error, VALIDATION_RECORD_LENGTH, 0,
+			     BATCH_MAX_LINE);
+	append_batch_error(errors, ctx, line_number, &error);
+}
+
+static int write_text_buffer(struct text_buffer *buf, FILE *stream)
+{
+	if (buf->failed) {
+		fprintf(stderr, "Error: Out of memory.\n");
+		return 1;
+	}
+
+	if (buf->len > 0 && fwrite(buf->data, 1, buf->len, stream) != buf->len)
+		return 1;
+
+	buf->len = 0;
+	return 0;
+}
+
+/*
+ * Read the next line of a stream; a line longer than BATCH_MAX_LINE is
+ * skipped up to its newline.
+ * line: buffer of BATCH_MAX_LINE + 2 bytes
+ * Returns: 1 if a line was read, -1 if it was too long, 0 at end of input
+ */
+static int read_batch_line(FILE *in, char *line)
+{
+	size_t len;
+
+	if (fgets(line, BATCH_MAX_LINE + 2, in) == NULL)
+		return 0;
+
+	len = strlen(line);
+	if (len > 0 && line[len - 1] != '\n' && !feof(in)) {
+		int c;
+
+		while ((c = fgetc(in)) != EOF && c != '\n')
+			;
+		return -1;
+	}
+
+	return 1;
+}
+
+/* Stream the input one line at a time on the calling thread */
+static int run_batch_serial(FILE *in, const struct batch_context *ctx,
+			    struct arena *arena, unsigned long *num_rejected)
+{
+	struct batch_block *block;
+	char line[BATCH_MAX_LINE + 2];	/* Room for newline and NUL */
+	struct text_buffer out = { NULL, 0, 0, 0 };
+	struct text_buffer errors = { NULL, 0, 0, 0 };
+	unsigned long line_number = 0;
+	int ret = 0;
+	int status;
+
+	block = arena_alloc(arena, sizeof(*block));
+	if (!block) {
+		fprintf(stderr, "Error: Out of memory.\n");
+		return 1;
+	}
+	clear_batch_block(block);
+
+	while ((status = read_batch_line(in, line)) != 0) {
+		line_number++;
+
+		if (status < 0) {
+			append_length_error(&errors, ctx, line_number);
+			(*num_rejected)++;
+		} else {
+			*num_rejected += process_batch_line(line, line_number,
+							    ctx, block, &out,
+							    &errors);
+		}
+
+		if (block->count == 0 && write_text_buffer(&out, stdout) != 0) {
+			ret = 1;
+			break;
+		}
+
+		/* Errors are written in blocks too, not one line at a time */
+		if (errors.len >= BATCH_OUTPUT_BUFFER &&
+		    write_text_buffer(&errors, stderr) != 0) {
+			ret = 1;
+			break;
+		}
+	}
+
+	flush_batch_block(block, ctx, &out);
+	if (write_text_buffer(&out, stdout) != 0 ||
+	    write_text_buffer(&errors, stderr) != 0)
+		ret = 1;
+
+	free(out.data);
+	free(errors.data);
+	return ret;
+}
+
+/* Lines of an input read in blocks (--io) */
+struct block_lines {
+	struct async_file *file;
+	char *data;	/* Unread part of the current block */
+	char *end;
+	int done;	/* End of input or read error */
+	int failed;
+	char line[BATCH_MAX_LINE + 1];	/* A line split across two blocks */
+};
+
+/*
+ * Return the next line of a block-read input without its newline. A line
+ * within one block is terminated in place; one split across blocks is
+ * copied. A line longer than BATCH_MAX_LINE is skipped.
+ * Returns: 1 if a line was read, -1 if it was too long, 0 at end of input
+ */
+static int read_block_line(struct block_lines *lines, char **line)
+{
+	size_t len = 0;
+	int too_long = 0;
+
+	for (;;) {
+		char *newline;
+		size_t n;
+
+		if (lines->data == lines->end) {
+			size_t size;
+			int status = lines->done ? 0 :
+				async_file_read(lines->file, &lines->data, &size);
+
+			if (status <= 0) {
+				lines->failed |= status < 0;
+				lines->done = 1;
+				lines->data = lines->end = NULL;
+				if (len == 0 && !too_long)
+					return 0;
+				break;	/* The last line has no newline */
+			}
+			lines->end = lines->data + size;
+		}
+
+		newline = memchr(lines->data, '\n', lines->end - lines->data);
+		n = (size_t)((newline ? newline : lines->end) - lines->data);
+
+		if (newline && len == 0 && !too_long) {
+			*newline = '\0';
+			*line = lines->data;
+			lines->data = newline + 1;
+			return n > BATCH_MAX_LINE ? -1 : 1;
+		}
+
+		if (len + n > BATCH_MAX_LINE) {
+			too_long = 1;
+		} else {
+			memcpy(lines->line + len, lines->data, n);
+			len += n;
+		}
+
+		lines->data += n;
+		if (newline) {
+			lines->data++;
+			break;
+		}
+	}
+
+	lines->line[len] = '\0';
+	*line = lines->line;
+	return too_long ? -1 : 1;
+}
+
+static int write_text_buffer_async(struct text_buffer *buf,
+				   struct async_file *file)
+{
+	if (buf->failed) {
+		fprintf(stderr, "Error: Out of memory.\n");
+		return 1;
+	}
+
+	if (buf->len > 0 && async_file_write(file, buf->data, buf->len) != 0)
+		return 1;
+
+	buf->len = 0;
+	return 0;
+}
+
+/*
+ * Stream the input and the results in large blocks (--io) on the calling
+ * thread: reads ahead and writes behind stay in flight while the records
+ * of the current block are calculated.
+ */
+static int run_batch_async(FILE *in, const struct batch_context *ctx,
+			   int backend, struct arena *arena,
+			   unsigned long *num_rejected)
+{
+	struct block_lines lines;
+	struct async_file *output;
+	struct batch_block *block;
+	struct text_buffer out = { NULL, 0, 0, 0 };
+	struct text_buffer errors = { NULL, 0, 0, 0 };
+	unsigned long line_number = 0;
+	char *line;
+	int ret = 0;
+	int status;
+
+	block = arena_alloc(arena, sizeof(*block));
+	if (!block) {
+		fprintf(stderr, "Error: Out of memory.\n");
+		return 1;
+	}
+	clear_batch_block(block);
+
+	/* The results follow the header on the file descriptor */
+	if (fflush(stdout) != 0)
+		return 1;
+
+	memset(&lines, 0, sizeof(lines));
+	lines.file = async_file_open(in, backend, 0);
+	output = async_file_open(stdout, backend, 1);
+	if (!lines.file || !output) {
+		fprintf(stderr, "Error: Cannot set up block I/O for --io.\n");
+		ret = 1;
+		goto out;
+	}
+
+	if (async_file_backend(lines.file) != backend ||
+	    async_file_backend(output) != backend)
+		fprintf(stderr,
+			"Warning: io_uring is not available, using pread/pwrite.\n");
+
+	while ((status = read_block_line(&lines, &line)) != 0) {
+		line_number++;
+
+		if (status < 0) {
+			append_length_error(&errors, ctx, line_number);
+			(*num_rejected)++;
+		} else {
+			*num_rejected += process_batch_line(line, line_number,
+							    ctx, block, &out,
+							    &errors);
+		}
+
+		if (block->count == 0 &&
+		    write_text_buffer_async(&out, output) != 0) {
+			ret = 1;
+			break;
+		}
+
+		if (errors.len >= BATCH_OUTPUT_BUFFER &&
+		    write_text_buffer(&errors, stderr) != 0) {
+			ret = 1;
+			break;
+		}
+	}
+
+	flush_batch_block(block, ctx, &out);
+	if (write_text_buffer_async(&out, output) != 0 ||
+	    write_text_buffer(&errors, stderr) != 0)
+		ret = 1;
+
+	if (lines.failed) {
+		fprintf(stderr, "Error: Failed to read batch file: %s\n",
+			ctx->path);
+		ret = 1;
+	}
+
+out:
+	if (output && async_file_close(output) != 0)
+		ret = 1;
+	if (lines.file)
+		async_file_close(lines.file);
+	free(out.data);
+	free(errors.data);
+	return ret;
+}
+
+/* Thread pool task: process the lines of one chunk */
+static void run_batch_chunk(void *arg, size_t task, int worker)
+{
+	struct batch_job *job = arg;
+	struct batch_chunk *chunk = &job->chunks[task];
+	struct arena *arena = &job->arenas[worker];
+	struct batch_block *block;
+	unsigned long line_number = chunk->first_line;
+	char *line = chunk->start;
+
+	/* The worker's previous chunk is done with its scratch memory */
+	arena_reset(arena);
+	block = arena_alloc(arena, sizeof(*block));
+	if (!block) {
+		chunk->out.failed = 1;
+		return;
+	}
+	clear_batch_block(block);
+
+	while (line < chunk->end) {
+		char *newline = memchr(line, '\n', chunk->end - line);
+		char *next = newline ? newline + 1 : chunk->end;
+
+		/* The last line of the input is already NUL-terminated */
+		if (newline)
+			*newline = '\0';
+
+		if (strlen(line) > BATCH_MAX_LINE) {
+			append_length_error(&chunk->errors, job->ctx,
+					    line_number);
+			chunk->num_rejected++;
+		} else {
+			chunk->num_rejected += process_batch_line(
+				line, line_number, job->ctx, block, &chunk->out,
+				&chunk->errors);
+		}
+
+		line = next;
+		line_number++;
+	}
+
+	flush_batch_block(block, job->ctx, &chunk->out);
+}
+
+/* Thread pool completion: write chunk output and errors in input order */
+static void consume_batch_chunk(void *arg, size_t task)
+{
+	struct batch_job *job = arg;
+	struct batch_chunk *chunk = &job->chunks[task];
+
+	/* The buffers stay with the chunk slot for the next window */
+	if (write_text_buffer(&chunk->errors, stderr) != 0 ||
+	    write_text_buffer(&chunk->out, stdout) != 0)
+		job->failed = 1;
+	job->num_rejected += chunk->num_rejected;
+}
+
+/*
+ * Fill the input window after the bytes carried over from the previous one,
+ * dropping the rest of an over-long line whose start was carried over.
+ * data: window of size bytes
+ * len: bytes carried over
+ * skipping: set while the rest of an over-long line is dropped
+ * eof: set at the end of the input
+ * Returns: the number of bytes in the window
+ */
+static size_t fill_batch_window(FILE *in, char *data, size_t len, size_t size,
+				int *skipping, int *eof)
+{
+	while (len < size) {
+		size_t n = fread(data + len, 1, size - len, in);
+		char *newline;
+
+		if (n == 0) {
+			*eof = 1;
+			break;
+		}
+
+		if (*skipping) {
+			newline = memchr(data + len, '\n', n);
+			if (!newline)
+				continue;
+			n -= (size_t)(newline - (data + len));
+			memmove(data + len, newline, n);
+			*skipping = 0;
+		}
+		len += n;
+	}
+
+	return len;
+}
+
+/*
+ * Split complete lines into chunks of about THREADED_CHUNK_SIZE bytes.
+ * line_number: number of the first line, advanced past the chunks
+ * Returns: the number of chunks
+ */
+static size_t split_batch_chunks(struct batch_chunk *chunks, char *data,
+				 size_t len, unsigned long *line_number)
+{
+	char *p = data, *end = data + len;
+	size_t num_chunks = 0;
+
+	while (p < end) {
+		struct batch_chunk *chunk = &chunks[num_chunks++];
+		char *q;
+
+		chunk->start = p;
+		chunk->first_line = *line_number;
+		chunk->num_rejected = 0;
+
+		p = (size_t)(end - p) > THREADED_CHUNK_SIZE ?
+			p + THREADED_CHUNK_SIZE : end;
+		if (p < end) {
+			q = memchr(p, '\n', end - p);
+			p = q ? q + 1 : end;
+		}
+		chunk->end = p;
+
+		for (q = chunk->start;
+		     q < p && (q = memchr(q, '\n', p - q)) != NULL; q++)
+			(*line_number)++;
+	}
+
+	return num_chunks;
+}
+
+/* Length of the complete lines at the start of a window */
+static size_t complete_lines_length(const char *data, size_t len)
+{
+	while (len > 0 && data[len - 1] != '\n')
+		len--;
+	return len;
+}
+
+/* Count a chunk slot's buffer in the run's memory and free it */
+static void release_chunk_buffer(struct arena *arena, struct text_buffer *buf)
+{
+	if (!buf->data)
+		return;
+
+	arena->bytes += buf->size;
+	arena->allocations++;
+	arena->reserved += buf->size;
+	free(buf->data);
+}
+
+/*
+ * Stream the input through a window of line chunks processed by a thread
+ * pool. Each window holds THREADED_CHUNKS_PER_THREAD chunks per thread; an
+ * unfinished line at its end is carried over to the next one, so the input
+ * and the buffered output stay bounded by the window.
+ */
+static int run_batch_threaded(FILE *in, const struct batch_context *ctx,
+			      int num_threads, struct arena *arena,
+			      unsigned long *num_rejected)
+{
+	struct batch_job job;
+	size_t num_slots = (size_t)num_threads * THREADED_CHUNKS_PER_THREAD;
+	size_t size = num_slots * THREADED_CHUNK_SIZE;
+	size_t len = 0, i;
+	unsigned long line_number = 1;
+	int skipping = 0, eof = 0;
+	char *data;
+	int ret = 0;
+	int w;
+
+	data = arena_alloc(arena, size + 1);
+	job.chunks = arena_alloc(arena, num_slots * sizeof(*job.chunks));
+	job.arenas = arena_alloc(arena, num_threads * sizeof(*job.arenas));
+	if (!data || !job.chunks || !job.arenas) {
+		fprintf(stderr, "Error: Out of memory.\n");
+		return 1;
+	}
+	memset(job.chunks, 0, num_slots * sizeof(*job.chunks));
+	for (w = 0; w < num_threads; w++)
+		arena_init(&job.arenas[w], ARENA_BLOCK_SIZE);
+
+	job.ctx = ctx;
+	job.num_rejected = 0;
+	job.failed = 0;
+
+	do {
+		size_t complete, num_chunks;
+
+		len = fill_batch_window(in, data, len, size, &skipping, &eof);
+		data[len] = '\0';	/* Ends the last line of the input */
+
+		complete = eof ? len : complete_lines_length(data, len);
+		num_chunks = split_batch_chunks(job.chunks, data, complete,
+						&line_number);
+		ret = run_parallel_ordered(num_chunks, num_threads,
+					   run_batch_chunk, consume_batch_chunk,
+					   &job);
+
+		/* Carry an unfinished line over; of an over-long one, enough to
+		 * reject it */
+		len -= complete;
+		if (len > BATCH_MAX_LINE) {
+			len = BATCH_MAX_LINE + 1;
+			skipping = 1;
+		}
+		memmove(data, data + complete, len);
+	} while (!eof && ret == 0 && !job.failed);
+
+	/* Count the workers' memory and the chunk buffers as the run's */
+	for (w = 0; w < num_threads; w++) {
+		arena->bytes += job.arenas[w].bytes;
+		arena->allocations += job.arenas[w].allocations;
+		arena->reserved += job.arenas[w].reserved;
+		arena_release(&job.arenas[w]);
+	}
+	for (i = 0; i < num_slots; i++) {
+		release_chunk_buffer(arena, &job.chunks[i].out);
+		release_chunk_buffer(arena, &job.chunks[i].errors);
+	}
+
+	*num_rejected += job.num_rejected;
+	return ret || job.failed;
+}
+
+/*
+ * Pipelined run (--pipeline).
+ *
+ * A reader thread parses the stream into blocks of records, compute threads
+ * run the kernel over them and the calling thread formats and writes them,
+ * so reading, computing and writing overlap. Block i goes to compute thread
+ * i % N and comes back to the writer in the same round-robin order, which
+ * preserves the input order. Every queue is a lock-free spsc_ring; a fixed
+ * pool of blocks circulates from the writer back to the reader, which bounds
+ * memory and throttles the reader to the writer's pace.
+ */
+
+/* The stop flag uses the GCC/Clang atomic builtins, as the rings do */
+#if defined(HAVE_PTHREAD) && defined(__GNUC__)
+
+#include <pthread.h>
+#include <sched.h>
+
+/* Blocks in flight per compute thread */
+#define PIPELINE_BLOCKS_PER_THREAD	4
+
+/* Polls of an empty or full ring before yielding the processor */
+#define PIPELINE_SPINS			64
+
+/* A block and the rejected lines read along with it */
+struct pipeline_block {
+	struct batch_block block;
+	struct text_buffer errors;
+	unsigned long num_rejected;
+};
+
+struct batch_pipeline {
+	FILE *in;
+	const struct batch_context *ctx;
+	int num_workers;
+	struct spsc_ring free_blocks;	/* Writer to reader */
+	struct spsc_ring *to_compute;	/* Reader to worker, per worker */
+	struct spsc_ring *to_writer;	/* Worker to writer, per worker */
+	int failed;	/* Set by the writer to stop the reader */
+	char stop;	/* Its address marks the end of the input */
+};
+
+struct pipeline_worker {
+	struct batch_pipeline *pipeline;
+	int index;
+};
+
+/* Pop an item, spinning briefly and then yielding while the ring is empty */
+static void *pipeline_take(struct spsc_ring *ring)
+{
+	unsigned int spins = 0;
+	void *item;
+
+	while ((item = spsc_ring_pop(ring)) == NULL) {
+		if (++spins > PIPELINE_SPINS)
+			sched_yield();
+	}
+
+	return item;
+}
+
+static void pipeline_put(struct spsc_ring *ring, void *item)
+{
+	while (spsc_ring_push(ring, item) != 0)
+		sched_yield();
+}
+
+/* Reader stage: parse the stream into blocks, handed out round-robin */
+static void *pipeline_reader(void *arg)
+{
+	struct batch_pipeline *p = arg;
+	char line[BATCH_MAX_LINE + 2];	/* Room for newline and NUL */
+	struct pipeline_block *pb;
+	unsigned long line_number = 0;
+	size_t seq = 0;
+	int status;
+	int i;
+
+	pb = pipeline_take(&p->free_blocks);
+	while (!__atomic_load_n(&p->failed, __ATOMIC_RELAXED) &&
+	       (status = read_batch_line(p->in, line)) != 0) {
+		line_number++;
+
+		if (status < 0) {
+			append_length_error(&pb->errors, p->ctx, line_number);
+			pb->num_rejected++;
+		} else {
+			pb->num_rejected += parse_batch_line(line, line_number,
+							     p->ctx, &pb->block,
+							     &pb->errors);
+		}
+
+		if (is_batch_block_full(&pb->block)) {
+			pipeline_put(&p->to_compute[seq++ % p->num_workers], pb);
+			pb = pipeline_take(&p->free_blocks);
+		}
+	}
+
+	/* The last, partial block, then one end mark per worker */
+	pipeline_put(&p->to_compute[seq++ % p->num_workers], pb);
+	for (i = 0; i < p->num_workers; i++)
+		pipeline_put(&p->to_compute[seq++ % p->num_workers], &p->stop);
+
+	return NULL;
+}
+
+/* Compute stage: run the kernel over each block of one worker's queue */
+static void *pipeline_worker_main(void *arg)
+{
+	struct pipeline_worker *worker = arg;
+	struct batch_pipeline *p = worker->pipeline;
+	void *item;
+
+	do {
+		item = pipeline_take(&p->to_compute[worker->index]);
+		if (item != &p->stop)
+			compute_batch_block(&((struct pipeline_block *)item)->block,
+					    p->ctx);
+		pipeline_put(&p->to_writer[worker->index], item);
+	} while (item != &p->stop);
+
+	return NULL;
+}
+
+/*
+ * Writer stage, on the calling thread: format and write the blocks in input
+ * order and return them to the reader. After a write error the remaining
+ * blocks are drained without writing, so the other stages can finish.
+ */
+static int pipeline_writer(struct batch_pipeline *p,
+			   unsigned long *num_rejected)
+{
+	struct text_buffer out = { NULL, 0, 0, 0 };
+	size_t seq;
+	int ret = 0;
+
+	for (seq = 0;; seq++) {
+		void *item = pipeline_take(&p->to_writer[seq % p->num_workers]);
+		struct pipeline_block *pb = item;
+
+		if (item == &p->stop)
+			break;
+
+		*num_rejected += pb->num_rejected;
+		if (ret == 0) {
+			format_batch_block(&pb->block, p->ctx, &out);
+			if (write_text_buffer(&pb->errors, stderr) != 0 ||
+			    (out.len >= BATCH_OUTPUT_BUFFER &&
+			     write_text_buffer(&out, stdout) != 0)) {
+				__atomic_store_n(&p->failed, 1, __ATOMIC_RELAXED);
+				ret = 1;
+			}
+		}
+
+		clear_batch_block(&pb->block);
+		pb->errors.len = 0;
+		pb->num_rejected = 0;
+		pipeline_put(&p->free_blocks, pb);
+	}
+
+	if (ret == 0 && write_text_buffer(&out, stdout) != 0)
+		ret = 1;
+
+	free(out.data);
+	return ret;
+}
+
+/* Allocate the queues and the circulating blocks */
+static int init_batch_pipeline(struct batch_pipeline *p,
+			       struct pipeline_block **blocks,
+			       size_t num_blocks, struct arena *arena)
+{
+	size_t i;
+	int w;
+
+	/* Every queue can hold all blocks and end marks: pushes never wait */
+	if (spsc_ring_init(&p->free_blocks, num_blocks) != 0)
+		return 1;
+	for (w = 0; w < p->num_workers; w++) {
+		if (spsc_ring_init(&p->to_compute[w], num_blocks + 1) != 0 ||
+		    spsc_ring_init(&p->to_writer[w], num_blocks + 1) != 0)
+			return 1;
+	}
+
+	for (i = 0; i < num_blocks; i++) {
+		blocks[i] = arena_alloc(arena, sizeof(*blocks[i]));
+		if (!blocks[i])
+			return 1;
+		memset(blocks[i], 0, sizeof(*blocks[i]));
+		spsc_ring_push(&p->free_blocks, blocks[i]);
+	}
+
+	return 0;
+}
+
+static void destroy_batch_pipeline(struct batch_pipeline *p,
+				   struct pipeline_block **blocks,
+				   size_t num_blocks)
+{
+	size_t i;
+	int w;
+
+	for (i = 0; i < num_blocks; i++) {
+		if (blocks[i])
+			free(blocks[i]->errors.data);
+	}
+
+	for (w = 0; w < p->num_workers; w++) {
+		spsc_ring_destroy(&p->to_compute[w]);
+		spsc_ring_destroy(&p->to_writer[w]);
+	}
+	spsc_ring_destroy(&p->free_blocks);
+}
+
+/* Stream the input through reader, compute and writer threads */
+static int run_batch_pipeline(FILE *in, const struct batch_context *ctx,
+			      int num_threads, struct arena *arena,
+			      unsigned long *num_rejected)
+{
+	struct batch_pipeline p;
+	struct pipeline_block **blocks;
+	struct pipeline_worker *workers;
+	pthread_t *threads;
+	pthread_t reader;
+	size_t num_blocks;
+	int num_started = 0;
+	int ret = 1;
+	int w;
+
+	memset(&p, 0, sizeof(p));
+	p.in = in;
+	p.ctx = ctx;
+	p.num_workers = num_threads;
+	num_blocks = (size_t)num_threads * PIPELINE_BLOCKS_PER_THREAD;
+
+	blocks = calloc(num_blocks, sizeof(*blocks));
+	workers = calloc(num_threads, sizeof(*workers));
+	threads = calloc(num_threads, sizeof(*threads));
+	p.to_compute = calloc(num_threads, sizeof(*p.to_compute));
+	p.to_writer = calloc(num_threads, sizeof(*p.to_writer));
+	if (!blocks || !workers || !threads || !p.to_compute || !p.to_writer ||
+	    init_batch_pipeline(&p, blocks, num_blocks, arena) != 0) {
+		fprintf(stderr, "Error: Out of memory.\n");
+		goto out;
+	}
+
+	for (w = 0; w < num_threads; w++) {
+		workers[w].pipeline = &p;
+		workers[w].index = w;
+		if (pthread_create(&threads[w], NULL, pipeline_worker_main,
+				   &workers[w]) != 0)
+			break;
+		num_started++;
+	}
+
+	/* Blocks are only handed to the workers that are running */
+	p.num_workers = num_started;
+	if (num_started == 0 ||
+	    pthread_create(&reader, NULL, pipeline_reader, &p) != 0) {
+		for (w = 0; w < num_started; w++)
+			pipeline_put(&p.to_compute[w], &p.stop);
+		for (w = 0; w < num_started; w++)
+			pthread_join(threads[w], NULL);
+		p.num_workers = num_threads;
+
+		/* Nothing has been read yet */
+		ret = run_batch_serial(in, ctx, arena, num_rejected);
+		goto out;
+	}
+
+	if (num_started < num_threads)
+		fprintf(stderr, "Warning: Started only %d of %d threads.\n",
+			num_started, num_threads);
+
+	ret = pipeline_writer(&p, num_rejected);
+
+	pthread_join(reader, NULL);
+	for (w = 0; w < num_started; w++)
+		pthread_join(threads[w], NULL);
+	p.num_workers = num_threads;
+
+out:
+	if (p.to_compute && p.to_writer)
+		destroy_batch_pipeline(&p, blocks, blocks ? num_blocks : 0);
+	free(p.to_writer);
+	free(p.to_compute);
+	free(threads);
+	free(workers);
+	free(blocks);
+	return ret;
+}
+
+#else /* !HAVE_PTHREAD || !__GNUC__ */
+
+static int run_batch_pipeline(FILE *in, const struct batch_context *ctx,
+			      int num_threads, struct arena *arena,
+			      unsigned long *num_rejected)
+{
+	(void)num_threads;	/* No thread support: stream on this thread */
+
+	return run_batch_serial(in, ctx, arena, num_rejected);
+}
+
+#endif /* HAVE_PTHREAD && __GNUC__ */
+
+/* Write the header of the output format, if it has one */
+static int write_batch_header(const struct batch_context *ctx)
+{
+	if (ctx->output_format == OUTPUT_FORMAT_BIN) {
+		unsigned char header[RESULT_HEADER_SIZE];
+
+		if (set_binary_output(stdout) != 0) {
+			fprintf(stderr, "Error: Cannot write binary output.\n");
+			return 1;
+		}
+		encode_result_header(header);
+		fwrite(header, 1, sizeof(header), stdout);
+	} else if (ctx->output_format == OUTPUT_FORMAT_TEXT) {
+		print_batch_header(stdout, ctx->year, ctx->num_years);
+	}
+
+	return 0;
+}
+
+int run_batch(const struct vacation_args *defaults, int month, int year)
+{
+	struct batch_context ctx;
+	struct arena arena;
+	unsigned long num_rejected = 0;
+	FILE *in;
+	int ret;
+
+	if (strcmp(defaults->batch_file, "-") == 0) {
+		in = stdin;
+	} else {
+		in = fopen(defaults->batch_file, "r");
+		if (!in) {
+			fprintf(stderr, "Error: Cannot open batch file: %s\n",
+				defaults->batch_file);
+			return 1;
+		}
+	}
+
+	init_batch_context(&ctx, defaults, month, year);
+
+	if (write_batch_header(&ctx) != 0) {
+		if (in != stdin)
+			fclose(in);
+		return 1;
+	}
+
+	/* Blocks of records come from the run's arena, not from malloc */
+	arena_init(&arena, ARENA_BLOCK_SIZE);
+	if (defaults->io_backend != IO_BACKEND_STDIO)
+		ret = run_batch_async(in, &ctx, defaults->io_backend, &arena,
+				      &num_rejected);
+	else if (defaults->pipeline)
+		ret = run_batch_pipeline(in, &ctx, defaults->num_threads,
+					 &arena, &num_rejected);
+	else if (defaults->num_threads > 1)
+		ret = run_batch_threaded(in, &ctx, defaults->num_threads,
+					 &arena, &num_rejected);
+	else
+		ret = run_batch_serial(in, &ctx, &arena, &num_rejected);
+
+	if (defaults->memory_stats)
+		print_arena_stats(&arena);
+	arena_release(&arena);
+
+	if (ferror(in)) {
+		fprintf(stderr, "Error: Failed to read batch file: %s\n",
+			ctx.path);
+		ret = 1;
+	}
+
+	if (in != stdin)
+		fclose(in);
+
+	if (num_rejected > 0) {
+		fprintf(stderr, "Error: %lu record(s) rejected.\n", num_rejected);
+		ret = 1;
+	}
+
+	if (fflush(stdout) != 0)
+		ret = 1;
+	return ret;
+}
+
+/*
+ * Snapshot driver
+ */
+
+/* Check the date-dependent fields of a snapshot record */
+static int check_snapshot_row(const struct vacation_snapshot *snapshot,
+			      size_t r, const struct batch_context *ctx,
+			      struct validation_error *error)
+{
+	int week_start = snapshot->week_start[r];
+
+	if (snapshot->id[r][BATCH_MAX_ID] != '\0')
+		return set_validation_error(error, VALIDATION_ID_LENGTH, 0,
+					    BATCH_MAX_ID);
+
+	if (week_start != WEEK_START_SUNDAY && week_start != WEEK_START_MONDAY) {
+		char text[16];
+
+		sprintf(text, "%d", week_start);
+		return set_validation_text(error, VALIDATION_WEEK_START_FORMAT,
+					   text);
+	}
+
+	return check_vacation_days(snapshot->vacation_extra[r],
+				   ctx->max_working_days[week_start], error);
+}
+
+/* Compute count records from first, reading the mapped columns in place */
+static unsigned long flush_snapshot_block(
+	const struct vacation_snapshot *snapshot, size_t first, size_t count,
+	const struct batch_context *ctx, struct text_buffer *out,
+	struct text_buffer *errors)
+{
+	int current_month[BATCH_BLOCK_SIZE];
+	double monthly_hours[BATCH_BLOCK_SIZE];
+	double additional_hours[BATCH_BLOCK_SIZE];
+	double additional_days[BATCH_BLOCK_SIZE];
+	double total_hours[BATCH_BLOCK_SIZE];
+	double total_days[BATCH_BLOCK_SIZE];
+	double excess_days[BATCH_BLOCK_SIZE];
+	struct vacation_batch_input in;
+	struct vacation_batch_result res;
+	struct vacation_input input;
+	struct vacation_result result;
+	struct validation_error error;
+	unsigned long num_rejected = 0;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+		current_month[i] = ctx->month;
+
+	in.annual_days = snapshot->annual_days + first;
+	in.max_accum_days = snapshot->max_accum_days + first;
+	in.current_hours = snapshot->current_hours + first;
+	in.vacation_extra = snapshot->vacation_extra + first;
+	in.current_month = current_month;
+	res.monthly_hours = monthly_hours;
+	res.additional_hours = additional_hours;
+	res.additional_days = additional_days;
+	res.total_hours = total_hours;
+	res.total_days = total_days;
+	res.excess_days = excess_days;
+
+	calculate_vacation_batch(&in, &res, count);
+
+	for (i = 0; i < count; i++) {
+		size_t r = first + i;
+
+		/* Records are numbered from 1 in error messages */
+		if (check_snapshot_row(snapshot, r, ctx, &error) != VALIDATION_OK) {
+			append_batch_error(errors, ctx, (unsigned long)r + 1,
+					   &error);
+			num_rejected++;
+			continue;
+		}
+
+		input.annual_days = snapshot->annual_days[r];
+		input.max_accum_days = snapshot->max_accum_days[r];
+		input.current_hours = snapshot->current_hours[r];
+		input.current_month = ctx->month;
+		input.current_year = ctx->year;
+		input.vacation_extra = snapshot->vacation_extra[r];
+		input.week_start = snapshot->week_start[r];
+		input.holidays = ctx->defaults->holidays;
+		input.policy = ctx->defaults->policy;
+
+		result.remaining_months = calculate_remaining_months(ctx->month);
+		result.monthly_hours = monthly_hours[i];
+		result.additional_hours = additional_hours[i];
+		result.additional_days = additional_days[i];
+		result.total_hours = total_hours[i];
+		result.total_days = total_days[i];
+		result.excess_days = excess_days[i];
+		result.working_days_remaining =
+			ctx->working_days_remaining[input.week_start];
+
+		if (append_batch_row(out, ctx, snapshot->id[r],
+				     strlen(snapshot->id[r]), &input,
+				     &result) != 0)
+			break;
+	}
+
+	return num_rejected;
+}
+
+int run_snapshot(const struct vacation_args *defaults, int month, int year)
+{
+	struct vacation_snapshot snapshot;
+	struct batch_context ctx;
+	struct text_buffer out = { NULL, 0, 0, 0 };
+	struct text_buffer errors = { NULL, 0, 0, 0 };
+	unsigned long num_rejected = 0;
+	size_t first;
+	int ret = 0;
+
+	if (open_snapshot(defaults->snapshot_file, &snapshot) != 0)
+		return 1;
+
+	init_batch_context(&ctx, defaults, month, year);
+	ctx.path = defaults->snapshot_file;
+
+	if (write_batch_header(&ctx) != 0) {
+		close_snapshot(&snapshot);
+		return 1;
+	}
+
+	for (first = 0; first < snapshot.count; first += BATCH_BLOCK_SIZE) {
+		size_t count = snapshot.count - first;
+
+		if (count > BATCH_BLOCK_SIZE)
+			count = BATCH_BLOCK_SIZE;
+		num_rejected += flush_snapshot_block(&snapshot, first, count,
+						     &ctx, &out, &errors);
+
+		if (out.len >= BATCH_OUTPUT_BUFFER &&
+		    write_text_buffer(&out, stdout) != 0) {
+			ret = 1;
+			break;
+		}
+		if (errors.len >= BATCH_OUTPUT_BUFFER &&
+		    write_text_buffer(&errors, stderr) != 0) {
+			ret = 1;
+			break;
+		}
+	}
+
+	if (write_text_buffer(&out, stdout) != 0 ||
+	    write_text_buffer(&errors, stderr) != 0)
+		ret = 1;
+
+	free(out.data);
+	free(errors.data);
+	close_snapshot(&snapshot);
+
+	if (num_rejected > 0) {
+		fprintf(stderr, "Error: %lu record(s) rejected.\n", num_rejected);
+		ret = 1;
+	}
+
+	if (fflush(stdout) != 0)
+		ret = 1;
+	return ret;
+}
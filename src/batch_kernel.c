@@ -0,0 +1,200 @@
+#include <stddef.h>
+
+#include "vacation.h"
+
+/*
+ * Structure-of-arrays kernel for calculate_vacation.
+ *
+ * Every path performs the same IEEE operations in the same order as
+ * calculate_vacation (multiply, divide, add, subtract, compare), so results
+ * are bit-identical across the scalar, SSE2 and AVX2 implementations.
+ * Floating-point contraction is disabled in CMakeLists.txt to keep it so.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(HAVE_SSE2) && defined(__GNUC__) && \
+	(defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+static void batch_scalar(const struct vacation_batch_input *in,
+			 struct vacation_batch_result *out,
+			 size_t start, size_t count)
+{
+	size_t i;
+
+	for (i = start; i < count; i++) {
+		int month = in->current_month[i];
+		int remaining = (month >= 1 && month <= 12) ?
+			MONTHS_PER_YEAR - month + 1 : 0;
+		double monthly = days_to_hours((double)in->annual_days[i]) /
+			MONTHS_PER_YEAR;
+		double additional = remaining * monthly;
+		double total = in->current_hours[i] + additional;
+		double total_days;
+		double excess;
+
+		total -= days_to_hours(in->vacation_extra[i]);
+		total_days = hours_to_days(total);
+		excess = total_days - (double)in->max_accum_days[i];
+
+		out->monthly_hours[i] = monthly;
+		out->additional_hours[i] = additional;
+		out->additional_days[i] = hours_to_days(additional);
+		out->total_hours[i] = total;
+		out->total_days[i] = total_days;
+		out->excess_days[i] = (excess > 0) ? excess : 0.0;
+	}
+}
+
+#ifdef HAVE_SSE2
+static size_t batch_sse2(const struct vacation_batch_input *in,
+			 struct vacation_batch_result *out, size_t count)
+{
+	const __m128d hours = _mm_set1_pd(WORK_DAY_HOURS);
+	const __m128d months = _mm_set1_pd(MONTHS_PER_YEAR);
+	const __m128d zero = _mm_setzero_pd();
+	const __m128i after_last = _mm_set1_epi32(MONTHS_PER_YEAR + 1);
+	size_t i;
+
+	for (i = 0; i + 2 <= count; i += 2) {
+		__m128i month = _mm_loadl_epi64((const __m128i *)&in->current_month[i]);
+		__m128i valid = _mm_and_si128(
+			_mm_cmpgt_epi32(month, _mm_setzero_si128()),
+			_mm_cmpgt_epi32(after_last, month));
+		__m128d remaining = _mm_cvtepi32_pd(
+			_mm_and_si128(_mm_sub_epi32(after_last, month), valid));
+		__m128d annual = _mm_cvtepi32_pd(
+			_mm_loadl_epi64((const __m128i *)&in->annual_days[i]));
+		__m128d max_accum = _mm_cvtepi32_pd(
+			_mm_loadl_epi64((const __m128i *)&in->max_accum_days[i]));
+		__m128d monthly = _mm_div_pd(_mm_mul_pd(annual, hours), months);
+		__m128d additional = _mm_mul_pd(remaining, monthly);
+		__m128d total = _mm_add_pd(_mm_loadu_pd(&in->current_hours[i]),
+					   additional);
+		__m128d total_days;
+
+		total = _mm_sub_pd(total, _mm_mul_pd(
+			_mm_loadu_pd(&in->vacation_extra[i]), hours));
+		total_days = _mm_div_pd(total, hours);
+
+		_mm_storeu_pd(&out->monthly_hours[i], monthly);
+		_mm_storeu_pd(&out->additional_hours[i], additional);
+		_mm_storeu_pd(&out->additional_days[i], _mm_div_pd(additional, hours));
+		_mm_storeu_pd(&out->total_hours[i], total);
+		_mm_storeu_pd(&out->total_days[i], total_days);
+		/* max(x, 0) yields 0 for NaN and -0, like (x > 0) ? x : 0 */
+		_mm_storeu_pd(&out->excess_days[i],
+			      _mm_max_pd(_mm_sub_pd(total_days, max_accum), zero));
+	}
+
+	return i;
+}
+#endif /* HAVE_SSE2 */
+
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static size_t batch_avx2(const struct vacation_batch_input *in,
+			 struct vacation_batch_result *out, size_t count)
+{
+	const __m256d hours = _mm256_set1_pd(WORK_DAY_HOURS);
+	const __m256d months = _mm256_set1_pd(MONTHS_PER_YEAR);
+	const __m256d zero = _mm256_setzero_pd();
+	const __m128i after_last = _mm_set1_epi32(MONTHS_PER_YEAR + 1);
+	size_t i;
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		__m128i month = _mm_loadu_si128((const __m128i *)&in->current_month[i]);
+		__m128i valid = _mm_and_si128(
+			_mm_cmpgt_epi32(month, _mm_setzero_si128()),
+			_mm_cmpgt_epi32(after_last, month));
+		__m256d remaining = _mm256_cvtepi32_pd(
+			_mm_and_si128(_mm_sub_epi32(after_last, month), valid));
+		__m256d annual = _mm256_cvtepi32_pd(
+			_mm_loadu_si128((const __m128i *)&in->annual_days[i]));
+		__m256d max_accum = _mm256_cvtepi32_pd(
+			_mm_loadu_si128((const __m128i *)&in->max_accum_days[i]));
+		__m256d monthly = _mm256_div_pd(_mm256_mul_pd(annual, hours), months);
+		__m256d additional = _mm256_mul_pd(remaining, monthly);
+		__m256d total = _mm256_add_pd(_mm256_loadu_pd(&in->current_hours[i]),
+					      additional);
+		__m256d total_days;
+
+		total = _mm256_sub_pd(total, _mm256_mul_pd(
+			_mm256_loadu_pd(&in->vacation_extra[i]), hours));
+		total_days = _mm256_div_pd(total, hours);
+
+		_mm256_storeu_pd(&out->monthly_hours[i], monthly);
+		_mm256_storeu_pd(&out->additional_hours[i], additional);
+		_mm256_storeu_pd(&out->additional_days[i],
+				 _mm256_div_pd(additional, hours));
+		_mm256_storeu_pd(&out->total_hours[i], total);
+		_mm256_storeu_pd(&out->total_days[i], total_days);
+		_mm256_storeu_pd(&out->excess_days[i],
+				 _mm256_max_pd(_mm256_sub_pd(total_days, max_accum), zero));
+	}
+
+	return i;
+}
+#endif /* HAVE_AVX2 */
+
+void calculate_vacation_batch_scalar(const struct vacation_batch_input *in,
+				     struct vacation_batch_result *out,
+				     size_t count)
+{
+	batch_scalar(in, out, 0, count);
+}
+
+void calculate_vacation_batch(const struct vacation_batch_input *in,
+			      struct vacation_batch_result *out,
+			      size_t count)
+{
+	size_t done = 0;
+
+#ifdef HAVE_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		done = batch_avx2(in, out, count);
+	else
+		done = batch_sse2(in, out, count);
+#elif defined(HAVE_SSE2)
+	done = batch_sse2(in, out, count);
+#endif
+
+	batch_scalar(in, out, done, count);
+}
+
+/*
+ * Fixed-point kernel. Integer arithmetic is exact, so there is no operation
+ * order to preserve: the loop is written branch-free and left to the
+ * compiler's vectorizer, which packs several employees per vector register.
+ */
+void calculate_vacation_batch_fixed(const struct vacation_batch_fixed_input *in,
+				    struct vacation_batch_fixed_result *out,
+				    size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		int month = in->current_month[i];
+		int64_t remaining = (month >= 1 && month <= 12) ?
+			MONTHS_PER_YEAR - month + 1 : 0;
+		int64_t monthly = (int64_t)in->annual_days[i] *
+			(WORK_DAY_CENTI_HOURS / MONTHS_PER_YEAR);
+		int64_t additional = remaining * monthly;
+		int64_t total = in->current_centi_hours[i] + additional -
+			in->vacation_extra_centi_hours[i];
+		int64_t excess = total -
+			(int64_t)in->max_accum_days[i] * WORK_DAY_CENTI_HOURS;
+
+		out->monthly_centi_hours[i] = monthly;
+		out->additional_centi_hours[i] = additional;
+		out->total_centi_hours[i] = total;
+		out->excess_centi_hours[i] = (excess > 0) ? excess : 0;
+	}
+}
@@ -0,0 +1,561 @@
+/*
+ * Microbenchmarks for the vacation calculator engine.
+ *
+ * Every benchmark is warmed up, calibrated to run for at least the minimum
+ * repetition time, and then repeated. Results are written to stdout as JSON
+ * (ns/op and ops/sec of the fastest and the median repetition); output of
+ * the printing functions goes to the null device.
+ *
+ * Usage: bench_vacation [--repetitions N] [--min-time-ms MS] [--filter TEXT]
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L	/* clock_gettime, dup, fdopen */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#define NULL_DEVICE	"NUL"
+#else
+#include <time.h>
+#include <unistd.h>
+#define NULL_DEVICE	"/dev/null"
+#endif
+
+#include "vacation.h"
+
+#define DEFAULT_REPETITIONS	10
+#define DEFAULT_MIN_TIME_MS	20
+#define MAX_REPETITIONS		1000
+#define NUM_SAMPLES		256	/* Power of two, inputs are cycled */
+#define BENCH_BATCH_SIZE	BATCH_BLOCK_SIZE
+
+/* Keeps results alive so the compiler cannot drop the measured work */
+static volatile double sink;
+
+struct bench {
+	const char *name;
+	void (*run)(size_t iterations);
+};
+
+/*
+ * Benchmark inputs
+ */
+
+static char number_strings[NUM_SAMPLES][16];
+static char integer_strings[NUM_SAMPLES][16];
+static struct date sample_dates[NUM_SAMPLES];
+static struct vacation_input sample_inputs[NUM_SAMPLES];
+static struct vacation_fixed_input sample_fixed_inputs[NUM_SAMPLES];
+static struct holiday_calendar sample_holidays;	/* 12 per year, 1900-2199 */
+
+static struct {
+	int annual_days[BENCH_BATCH_SIZE];
+	int max_accum_days[BENCH_BATCH_SIZE];
+	double current_hours[BENCH_BATCH_SIZE];
+	double vacation_extra[BENCH_BATCH_SIZE];
+	int current_month[BENCH_BATCH_SIZE];
+	int64_t current_centi_hours[BENCH_BATCH_SIZE];
+	int64_t vacation_extra_centi_hours[BENCH_BATCH_SIZE];
+	double results[6][BENCH_BATCH_SIZE];
+	int64_t fixed_results[4][BENCH_BATCH_SIZE];
+} batch;
+
+static unsigned int bench_rand_state = 12345;
+
+static unsigned int bench_rand(void)
+{
+	bench_rand_state = bench_rand_state * 1103515245u + 12345u;
+	return (bench_rand_state >> 16) & 0x7fff;
+}
+
+static void init_samples(void)
+{
+	int i;
+
+	for (i = 0; i < NUM_SAMPLES; i++) {
+		struct vacation_input *input = &sample_inputs[i];
+		struct vacation_fixed_input *fixed = &sample_fixed_inputs[i];
+
+		snprintf(number_strings[i], sizeof(number_strings[i]), "%u.%02u",
+			 bench_rand() % 400, bench_rand() % 100);
+		snprintf(integer_strings[i], sizeof(integer_strings[i]), "%u",
+			 bench_rand() % 1000);
+
+		sample_dates[i].year = 1900 + (int)(bench_rand() % 300);
+		sample_dates[i].month = 1 + (int)(bench_rand() % 12);
+		sample_dates[i].day = 1 + (int)(bench_rand() % 28);
+
+		input->annual_days = MIN_ANNUAL_DAYS + (int)(bench_rand() % 10);
+		input->max_accum_days = calculate_max_accum(input->annual_days, i % 2);
+		input->current_hours = (double)(bench_rand() % 40000) / 100.0;
+		input->current_month = sample_dates[i].month;
+		input->current_year = sample_dates[i].year;
+		input->vacation_extra = (double)(bench_rand() % 20) / 2.0;
+		input->week_start = i % 2;
+		input->holidays = NULL;
+		input->policy = NULL;
+
+		fixed->annual_days = input->annual_days;
+		fixed->max_accum_days = input->max_accum_days;
+		hours_to_centi_hours(input->current_hours, &fixed->current_centi_hours);
+		fixed->current_month = input->current_month;
+		fixed->current_year = input->current_year;
+		days_to_centi_hours(input->vacation_extra,
+				    &fixed->vacation_extra_centi_hours);
+		fixed->week_start = input->week_start;
+		fixed->holidays = NULL;
+		fixed->policy = NULL;
+	}
+
+	{
+		static struct date holidays[300 * 12];
+
+		for (i = 0; i < 300 * 12; i++) {
+			holidays[i].year = 1900 + i / 12;
+			holidays[i].month = 1 + i % 12;
+			holidays[i].day = 1 + (int)(bench_rand() % 28);
+		}
+		init_holiday_calendar(&sample_holidays, holidays, 300 * 12);
+	}
+
+	for (i = 0; i < BENCH_BATCH_SIZE; i++) {
+		const struct vacation_input *input = &sample_inputs[i % NUM_SAMPLES];
+		const struct vacation_fixed_input *fixed =
+			&sample_fixed_inputs[i % NUM_SAMPLES];
+
+		batch.annual_days[i] = input->annual_days;
+		batch.max_accum_days[i] = input->max_accum_days;
+		batch.current_hours[i] = input->current_hours;
+		batch.vacation_extra[i] = input->vacation_extra;
+		batch.current_month[i] = input->current_month;
+		batch.current_centi_hours[i] = fixed->current_centi_hours;
+		batch.vacation_extra_centi_hours[i] =
+			fixed->vacation_extra_centi_hours;
+	}
+}
+
+/*
+ * Benchmarked operations
+ */
+
+static void bench_parse_number(size_t iterations)
+{
+	double value, sum = 0.0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++) {
+		parse_number(number_strings[i % NUM_SAMPLES], &value);
+		sum += value;
+	}
+	sink = sum;
+}
+
+static void bench_strtod(size_t iterations)
+{
+	double sum = 0.0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++)
+		sum += strtod(number_strings[i % NUM_SAMPLES], NULL);
+	sink = sum;
+}
+
+static void bench_parse_integer(size_t iterations)
+{
+	int value, sum = 0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++) {
+		parse_integer(integer_strings[i % NUM_SAMPLES], &value);
+		sum += value;
+	}
+	sink = sum;
+}
+
+static void bench_day_of_week(size_t iterations)
+{
+	int sum = 0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++) {
+		const struct date *d = &sample_dates[i % NUM_SAMPLES];
+
+		sum += day_of_week(d->day, d->month, d->year);
+	}
+	sink = sum;
+}
+
+static void bench_calculate_working_days(size_t iterations)
+{
+	int sum = 0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++) {
+		const struct date *d = &sample_dates[i % NUM_SAMPLES];
+
+		sum += calculate_working_days(d->month, d->year, (int)(i & 1));
+	}
+	sink = sum;
+}
+
+static void bench_calculate_remaining_working_days(size_t iterations)
+{
+	int sum = 0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++) {
+		const struct date *d = &sample_dates[i % NUM_SAMPLES];
+
+		sum += calculate_remaining_working_days(d->month, d->year,
+							(int)(i & 1));
+	}
+	sink = sum;
+}
+
+static void bench_calendar_remaining_working_days(size_t iterations)
+{
+	int sum = 0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++) {
+		const struct date *d = &sample_dates[i % NUM_SAMPLES];
+
+		sum += calendar_remaining_working_days(&sample_holidays, d->month,
+						       d->year, (int)(i & 1));
+	}
+	sink = sum;
+}
+
+static void bench_working_days_between(size_t iterations)
+{
+	int sum = 0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++) {
+		struct date a = sample_dates[i % NUM_SAMPLES];
+		struct date b = sample_dates[(i + 1) % NUM_SAMPLES];
+
+		b.year = a.year + 1;
+		sum += working_days_between(a, b, (int)(i & 1));
+	}
+	sink = sum;
+}
+
+static void bench_calculate_vacation(size_t iterations)
+{
+	struct vacation_result result;
+	double sum = 0.0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++) {
+		calculate_vacation(&sample_inputs[i % NUM_SAMPLES], &result);
+		sum += result.total_days;
+	}
+	sink = sum;
+}
+
+static void bench_calculate_vacation_fixed(size_t iterations)
+{
+	struct vacation_fixed_result result;
+	int64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++) {
+		calculate_vacation_fixed(&sample_fixed_inputs[i % NUM_SAMPLES],
+					 &result);
+		sum += result.total_centi_hours;
+	}
+	sink = (double)sum;
+}
+
+/* Batch kernels: one operation is one employee */
+static void bench_calculate_vacation_batch(size_t iterations)
+{
+	struct vacation_batch_input in;
+	struct vacation_batch_result out;
+	size_t done;
+
+	in.annual_days = batch.annual_days;
+	in.max_accum_days = batch.max_accum_days;
+	in.current_hours = batch.current_hours;
+	in.vacation_extra = batch.vacation_extra;
+	in.current_month = batch.current_month;
+	out.monthly_hours = batch.results[0];
+	out.additional_hours = batch.results[1];
+	out.additional_days = batch.results[2];
+	out.total_hours = batch.results[3];
+	out.total_days = batch.results[4];
+	out.excess_days = batch.results[5];
+
+	for (done = 0; done < iterations; done += BENCH_BATCH_SIZE) {
+		size_t count = iterations - done;
+
+		if (count > BENCH_BATCH_SIZE)
+			count = BENCH_BATCH_SIZE;
+		calculate_vacation_batch(&in, &out, count);
+	}
+	sink = batch.results[4][0];
+}
+
+static void bench_calculate_vacation_batch_fixed(size_t iterations)
+{
+	struct vacation_batch_fixed_input in;
+	struct vacation_batch_fixed_result out;
+	size_t done;
+
+	in.annual_days = batch.annual_days;
+	in.max_accum_days = batch.max_accum_days;
+	in.current_centi_hours = batch.current_centi_hours;
+	in.vacation_extra_centi_hours = batch.vacation_extra_centi_hours;
+	in.current_month = batch.current_month;
+	out.monthly_centi_hours = batch.fixed_results[0];
+	out.additional_centi_hours = batch.fixed_results[1];
+	out.total_centi_hours = batch.fixed_results[2];
+	out.excess_centi_hours = batch.fixed_results[3];
+
+	for (done = 0; done < iterations; done += BENCH_BATCH_SIZE) {
+		size_t count = iterations - done;
+
+		if (count > BENCH_BATCH_SIZE)
+			count = BENCH_BATCH_SIZE;
+		calculate_vacation_batch_fixed(&in, &out, count);
+	}
+	sink = (double)batch.fixed_results[2][0];
+}
+
+/* A 1000-point sweep (100 extras x 10 months); one operation is one point */
+static void bench_calculate_vacation_sweep(size_t iterations)
+{
+	static struct vacation_result results[1000];
+	struct vacation_sweep sweep = { 0.0, 9.9, 0.1, 1, 10 };
+	size_t done;
+
+	for (done = 0; done < iterations; done += 1000)
+		calculate_vacation_sweep(&sample_inputs[done % NUM_SAMPLES], &sweep,
+					 results);
+	sink = results[999].total_days;
+}
+
+static void bench_format_double_value(size_t iterations)
+{
+	char buf[32];
+	int sum = 0;
+	size_t i;
+
+	for (i = 0; i < iterations; i++)
+		sum += format_double_value(buf, sizeof(buf),
+					   sample_inputs[i % NUM_SAMPLES].current_hours);
+	sink = sum;
+}
+
+static void bench_print_results(size_t iterations)
+{
+	struct vacation_result results[NUM_SAMPLES];
+	size_t i;
+
+	for (i = 0; i < NUM_SAMPLES; i++)
+		calculate_vacation(&sample_inputs[i], &results[i]);
+
+	for (i = 0; i < iterations; i++)
+		print_results(&sample_inputs[i % NUM_SAMPLES],
+			      &results[i % NUM_SAMPLES]);
+	fflush(stdout);
+}
+
+static const struct bench benches[] = {
+	{ "parse_number", bench_parse_number },
+	{ "strtod", bench_strtod },
+	{ "parse_integer", bench_parse_integer },
+	{ "day_of_week", bench_day_of_week },
+	{ "calculate_working_days", bench_calculate_working_days },
+	{ "calculate_remaining_working_days", bench_calculate_remaining_working_days },
+	{ "calendar_remaining_working_days", bench_calendar_remaining_working_days },
+	{ "working_days_between", bench_working_days_between },
+	{ "calculate_vacation", bench_calculate_vacation },
+	{ "calculate_vacation_fixed", bench_calculate_vacation_fixed },
+	{ "calculate_vacation_batch", bench_calculate_vacation_batch },
+	{ "calculate_vacation_batch_fixed", bench_calculate_vacation_batch_fixed },
+	{ "calculate_vacation_sweep", bench_calculate_vacation_sweep },
+	{ "format_double_value", bench_format_double_value },
+	{ "print_results", bench_print_results },
+};
+
+#define NUM_BENCHES	(sizeof(benches) / sizeof(benches[0]))
+
+/*
+ * Timing
+ */
+
+static double now_ns(void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+
+	return (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+#endif
+}
+
+static double time_run(const struct bench *bench, size_t iterations)
+{
+	double start = now_ns();
+
+	bench->run(iterations);
+
+	return now_ns() - start;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Warm up, then find an iteration count that runs for at least min_ns */
+static size_t calibrate(const struct bench *bench, double min_ns)
+{
+	size_t iterations = 1;
+
+	time_run(bench, 1000);
+
+	for (;;) {
+		double elapsed = time_run(bench, iterations);
+
+		if (elapsed >= min_ns || iterations >= ((size_t)1 << 40))
+			return iterations;
+
+		if (elapsed < min_ns / 100)
+			iterations *= 10;
+		else
+			iterations = (size_t)(iterations * (min_ns * 1.2 / elapsed)) + 1;
+	}
+}
+
+static void run_bench(FILE *out, const struct bench *bench, int repetitions,
+		      double min_ns, int first)
+{
+	double ns_per_op[MAX_REPETITIONS];
+	size_t iterations = calibrate(bench, min_ns);
+	double best, median;
+	int i;
+
+	for (i = 0; i < repetitions; i++)
+		ns_per_op[i] = time_run(bench, iterations) / (double)iterations;
+
+	qsort(ns_per_op, repetitions, sizeof(ns_per_op[0]), compare_doubles);
+	best = ns_per_op[0];
+	median = ns_per_op[repetitions / 2];
+
+	fprintf(out, "%s    {\"name\": \"%s\", \"iterations\": %lu, "
+		"\"ns_per_op_min\": %.3f, \"ns_per_op_median\": %.3f, "
+		"\"ops_per_sec\": %.0f}",
+		first ? "" : ",\n", bench->name, (unsigned long)iterations,
+		best, median, 1e9 / median);
+	fflush(out);
+}
+
+/* JSON goes to the original stdout, which is then pointed at a null sink */
+static FILE *open_json_output(void)
+{
+	FILE *out;
+
+	fflush(stdout);
+#ifdef _WIN32
+	out = _fdopen(_dup(_fileno(stdout)), "w");
+#else
+	out = fdopen(dup(fileno(stdout)), "w");
+#endif
+	if (!out)
+		return NULL;
+
+	if (!freopen(NULL_DEVICE, "w", stdout)) {
+		fclose(out);
+		return NULL;
+	}
+
+	return out;
+}
+
+static void print_bench_usage(const char *program_name)
+{
+	fprintf(stderr,
+		"Usage: %s [--repetitions N] [--min-time-ms MS] [--filter TEXT]\n",
+		program_name);
+}
+
+int main(int argc, char *argv[])
+{
+	int repetitions = DEFAULT_REPETITIONS;
+	int min_time_ms = DEFAULT_MIN_TIME_MS;
+	const char *filter = NULL;
+	FILE *out;
+	size_t i;
+	int first = 1;
+	int arg;
+
+	for (arg = 1; arg < argc; arg++) {
+		if (strcmp(argv[arg], "--repetitions") == 0 && arg + 1 < argc) {
+			if (parse_integer(argv[++arg], &repetitions) != 0 ||
+			    repetitions < 1 || repetitions > MAX_REPETITIONS) {
+				fprintf(stderr,
+					"Error: Repetitions must be between 1 and %d.\n",
+					MAX_REPETITIONS);
+				return 1;
+			}
+		} else if (strcmp(argv[arg], "--min-time-ms") == 0 && arg + 1 < argc) {
+			if (parse_integer(argv[++arg], &min_time_ms) != 0 ||
+			    min_time_ms < 1) {
+				fprintf(stderr,
+					"Error: Minimum time must be a positive integer.\n");
+				return 1;
+			}
+		} else if (strcmp(argv[arg], "--filter") == 0 && arg + 1 < argc) {
+			filter = argv[++arg];
+		} else {
+			print_bench_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	out = open_json_output();
+	if (!out) {
+		fprintf(stderr, "Error: Cannot redirect output to %s.\n",
+			NULL_DEVICE);
+		return 1;
+	}
+
+	init_samples();
+
+	fprintf(out, "{\n  \"benchmark\": \"vacation\",\n");
+	fprintf(out, "  \"repetitions\": %d,\n  \"min_time_ms\": %d,\n",
+		repetitions, min_time_ms);
+	fprintf(out, "  \"results\": [\n");
+	for (i = 0; i < NUM_BENCHES; i++) {
+		if (filter && !strstr(benches[i].name, filter))
+			continue;
+		run_bench(out, &benches[i], repetitions, min_time_ms * 1e6, first);
+		first = 0;
+	}
+	fprintf(out, "\n  ]\n}\n");
+
+	free_holiday_calendar(&sample_holidays);
+	return fclose(out) != 0;
+}
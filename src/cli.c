@@ -0,0 +1,90 @@
+#include <stdio.h>
+
+#include "vacation.h"
+
+/*
+ * Command-line front end: main() on top of the vacation library.
+ */
+
+/* Run the mode selected by prepared arguments; returns the exit status */
+static int run_mode(struct vacation_args *args)
+{
+	struct date today;
+
+	/* One clock snapshot for the whole run */
+	if (args->as_of_set) {
+		today = args->as_of;
+	} else if (get_current_date(&today) != 0) {
+		fprintf(stderr, "Error: Cannot read the current date.\n");
+		return 1;
+	}
+
+	/* Daemon mode: every request carries its own allowance and balance */
+	if (args->serve_socket)
+		return run_server(args->serve_socket, args);
+
+	/* Delta mode: only journal changes are recalculated */
+	if (args->previous_file)
+		return run_delta(args, today.month, today.year);
+
+	/* Snapshot conversion: the batch file is written, not calculated */
+	if (args->snapshot_output)
+		return write_snapshot(args, args->snapshot_output);
+
+	/* Snapshot mode: every record of the mapped snapshot, as in batch mode */
+	if (args->snapshot_file)
+		return run_snapshot(args, today.month, today.year);
+
+	/* Batch mode: every record carries its own allowance and balance */
+	if (args->batch_file)
+		return run_batch(args, today.month, today.year);
+
+	/* Stdin lines mode: every line carries its own arguments */
+	if (args->stdin_lines)
+		return run_stdin_lines(args, &today, stdin);
+
+	return run_vacation(args, &today);
+}
+
+int main(int argc, char *argv[])
+{
+	struct vacation_args args;
+	struct holiday_calendar holidays;
+	struct policy_set policies;
+	int status;
+
+	/* Initialize and parse arguments */
+	init_vacation_args(&args);
+	if (parse_arguments(argc, argv, &args) != 0)
+		return 1;
+
+	if (args.help) {
+		print_usage(argv[0]);
+		return 0;
+	}
+
+	/* Load public holidays (released before returning) */
+	if (args.holidays_file) {
+		if (load_holiday_calendar(args.holidays_file, &holidays) != 0)
+			return 1;
+		args.holidays = &holidays;
+	}
+
+	/* Load accrual policies (released before returning) */
+	if (args.policy_file) {
+		if (load_policy_file(args.policy_file, &policies) != 0) {
+			status = 1;
+			goto out;
+		}
+		args.policies = &policies;
+	}
+
+	status = prepare_arguments(&args) != 0 ? 1 : run_mode(&args);
+
+out:
+	if (args.policies)
+		free_policy_set(&policies);
+	if (args.holidays)
+		free_holiday_calendar(&holidays);
+	return status;
+}
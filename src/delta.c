@@ -0,0 +1,423 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vacation.h"
+
+/*
+ * Delta reprojection (--previous, --journal).
+ *
+ * A binary result file holds every input of its records, so a refresh only
+ * has to recalculate the employees named in the change journal; all other
+ * records are copied as they are. The journal is small and indexed by ID in
+ * a hash table, so merging costs one lookup per prior record. When the date
+ * moved to another month every record is recalculated, as all balances
+ * depend on it. Journal entries, their IDs and the record buffer come from
+ * one arena per run.
+ */
+
+/* Prior records read, merged and written per block */
+#define DELTA_BLOCK_RECORDS	512
+
+struct journal_entry {
+	struct journal_entry *next;	/* In journal order */
+	char *id;
+	double current_hours;
+	double vacation_extra;
+	int vacation_extra_set;
+	unsigned long line_number;	/* In the journal, for messages */
+	int applied;	/* Merged, or replaced by a later line */
+};
+
+struct change_journal {
+	const char *path;
+	struct arena *arena;
+	struct journal_entry *first;
+	struct journal_entry *last;
+	size_t count;
+	struct journal_entry **index;	/* Open addressing, NULL if empty */
+	size_t index_mask;	/* Slots - 1, a power of two */
+};
+
+/* Calendar-dependent values shared by all records of a run */
+struct delta_context {
+	const struct vacation_args *defaults;
+	int month;
+	int year;
+	int max_working_days[2];	/* Extra vacation limit per week start */
+};
+
+/* FNV-1a */
+static size_t hash_id(const char *id)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	while (*id) {
+		hash ^= (unsigned char)*id++;
+		hash *= 1099511628211ULL;
+	}
+
+	return (size_t)hash;
+}
+
+static void report_record_error(const char *path, unsigned long number,
+				const struct validation_error *error)
+{
+	char message[VALIDATION_MAX_MESSAGE];
+
+	format_validation_error(message, sizeof(message), error);
+	fprintf(stderr, "Error: %s:%lu: %s. Record skipped.\n", path, number,
+		message);
+}
+
+static int add_journal_entry(struct change_journal *journal,
+			     const struct journal_record *record,
+			     unsigned long line_number)
+{
+	size_t id_len = strlen(record->id);
+	struct journal_entry *entry;
+
+	entry = arena_alloc(journal->arena, sizeof(*entry));
+	if (!entry)
+		return 1;
+	entry->id = arena_alloc(journal->arena, id_len + 1);
+	if (!entry->id)
+		return 1;
+
+	memcpy(entry->id, record->id, id_len + 1);
+	entry->current_hours = record->current_hours;
+	entry->vacation_extra = record->vacation_extra;
+	entry->vacation_extra_set = record->vacation_extra_set;
+	entry->line_number = line_number;
+	entry->applied = 0;
+	entry->next = NULL;
+
+	if (journal->last)
+		journal->last->next = entry;
+	else
+		journal->first = entry;
+	journal->last = entry;
+	journal->count++;
+	return 0;
+}
+
+/* Index the entries by ID; a later line for an ID replaces earlier ones */
+static int index_change_journal(struct change_journal *journal)
+{
+	struct journal_entry *entry;
+	size_t slots = 1;
+
+	while (slots < journal->count * 2)
+		slots *= 2;
+
+	journal->index = arena_alloc(journal->arena,
+				     slots * sizeof(*journal->index));
+	if (!journal->index)
+		return 1;
+	memset(journal->index, 0, slots * sizeof(*journal->index));
+	journal->index_mask = slots - 1;
+
+	for (entry = journal->first; entry; entry = entry->next) {
+		size_t slot = hash_id(entry->id) & journal->index_mask;
+
+		while (journal->index[slot] &&
+		       strcmp(journal->index[slot]->id, entry->id) != 0)
+			slot = (slot + 1) & journal->index_mask;
+
+		if (journal->index[slot])
+			journal->index[slot]->applied = 1;
+		journal->index[slot] = entry;
+	}
+
+	return 0;
+}
+
+static struct journal_entry *find_journal_entry(
+	const struct change_journal *journal, const char *id)
+{
+	size_t slot;
+
+	if (journal->count == 0)
+		return NULL;
+
+	slot = hash_id(id) & journal->index_mask;
+	while (journal->index[slot]) {
+		if (strcmp(journal->index[slot]->id, id) == 0)
+			return journal->index[slot];
+		slot = (slot + 1) & journal->index_mask;
+	}
+
+	return NULL;
+}
+
+/*
+ * Read and index the journal. Invalid records are reported and skipped.
+ * Returns: 0 on success, non-zero if the file cannot be read
+ */
+static int load_change_journal(const char *path,
+			       struct change_journal *journal,
+			       unsigned long *num_rejected)
+{
+	char line[BATCH_MAX_LINE + 2];	/* Room for newline and NUL */
+	unsigned long line_number = 0;
+	struct journal_record record;
+	FILE *in;
+	int ret = 0;
+
+	in = fopen(path, "r");
+	if (!in) {
+		fprintf(stderr, "Error: Cannot open journal file: %s\n", path);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), in) != NULL) {
+		size_t len = strlen(line);
+
+		line_number++;
+
+		/* Reject over-long records and skip the rest of the line */
+		if (len > 0 && line[len - 1] != '\n' && !feof(in)) {
+			int c;
+
+			while ((c = fgetc(in)) != EOF && c != '\n')
+				;
+			set_validation_error(&record.error,
+					     VALIDATION_RECORD_LENGTH, 0,
+					     BATCH_MAX_LINE);
+			report_record_error(path, line_number, &record.error);
+			(*num_rejected)++;
+			continue;
+		}
+
+		if (is_batch_skipped_line(line, line_number))
+			continue;
+
+		if (parse_journal_record(line, &record) != 0) {
+			report_record_error(path, line_number, &record.error);
+			(*num_rejected)++;
+			continue;
+		}
+
+		if (add_journal_entry(journal, &record, line_number) != 0) {
+			fprintf(stderr, "Error: Out of memory.\n");
+			ret = 1;
+			break;
+		}
+	}
+
+	if (ret == 0 && ferror(in)) {
+		fprintf(stderr, "Error: Failed to read journal file: %s\n", path);
+		ret = 1;
+	}
+	fclose(in);
+
+	if (ret == 0 && journal->count > 0 &&
+	    index_change_journal(journal) != 0) {
+		fprintf(stderr, "Error: Out of memory.\n");
+		ret = 1;
+	}
+
+	return ret;
+}
+
+/*
+ * Merge one prior record with its journal entry, if any, and recalculate
+ * it when it changed or the month moved on.
+ * buf: encoded record, rewritten in place
+ * Returns: the number of rejected journal and prior records (0 to 2)
+ */
+static unsigned long refresh_result_record(unsigned char *buf,
+					   unsigned long record_number,
+					   const struct delta_context *ctx,
+					   const struct change_journal *journal)
+{
+	const struct vacation_args *defaults = ctx->defaults;
+	struct journal_entry *entry;
+	struct result_record record;
+	struct validation_error error;
+	struct vacation_input input;
+	struct vacation_result result;
+	unsigned long num_rejected = 0;
+	int extra_changed = 0;
+
+	decode_result_record(buf, &record);
+	entry = find_journal_entry(journal, record.id);
+	if (!entry && record.current_month == ctx->month &&
+	    record.current_year == ctx->year)
+		return 0;
+
+	if (record.week_start != WEEK_START_SUNDAY &&
+	    record.week_start != WEEK_START_MONDAY) {
+		char text[16];
+
+		sprintf(text, "%d", (int)record.week_start);
+		set_validation_text(&error, VALIDATION_WEEK_START_FORMAT, text);
+		report_record_error(defaults->previous_file, record_number,
+				    &error);
+		if (entry)
+			entry->applied = 1;
+		return 1;
+	}
+
+	if (entry) {
+		entry->applied = 1;
+		if (entry->vacation_extra_set &&
+		    check_vacation_days(entry->vacation_extra,
+					ctx->max_working_days[record.week_start],
+					&error) != VALIDATION_OK) {
+			/* The employee keeps the prior inputs */
+			report_record_error(journal->path, entry->line_number,
+					    &error);
+			num_rejected++;
+		} else {
+			record.current_hours = entry->current_hours;
+			if (entry->vacation_extra_set) {
+				record.vacation_extra = entry->vacation_extra;
+				extra_changed = 1;
+			}
+		}
+	}
+
+	/* A carried-over extra may exceed the working days of a later month */
+	if (!extra_changed &&
+	    check_vacation_days(record.vacation_extra,
+				ctx->max_working_days[record.week_start],
+				&error) != VALIDATION_OK) {
+		/* The prior record is copied unchanged */
+		report_record_error(defaults->previous_file, record_number,
+				    &error);
+		return num_rejected + 1;
+	}
+
+	input.annual_days = record.annual_days;
+	input.max_accum_days = record.max_accum_days;
+	input.current_hours = record.current_hours;
+	input.current_month = ctx->month;
+	input.current_year = ctx->year;
+	input.vacation_extra = record.vacation_extra;
+	input.week_start = record.week_start;
+	input.holidays = defaults->holidays;
+	input.policy = defaults->policy;
+
+	calculate_vacation(&input, &result);
+	encode_result_record(buf, record.id, &input, &result);
+
+	return num_rejected;
+}
+
+int run_delta(const struct vacation_args *defaults, int month, int year)
+{
+	struct change_journal journal;
+	struct delta_context ctx;
+	struct arena arena;
+	struct journal_entry *entry;
+	unsigned char header[RESULT_HEADER_SIZE];
+	unsigned char *block;
+	unsigned long record_number = 0;
+	unsigned long num_rejected = 0;
+	size_t len;
+	size_t i;
+	FILE *in;
+	int ret = 0;
+	int ws;
+
+	arena_init(&arena, ARENA_BLOCK_SIZE);
+	memset(&journal, 0, sizeof(journal));
+	journal.path = defaults->journal_file;
+	journal.arena = &arena;
+	if (defaults->journal_file &&
+	    load_change_journal(defaults->journal_file, &journal,
+				&num_rejected) != 0) {
+		arena_release(&arena);
+		return 1;
+	}
+
+	ctx.defaults = defaults;
+	ctx.month = month;
+	ctx.year = year;
+	for (ws = WEEK_START_SUNDAY; ws <= WEEK_START_MONDAY; ws++)
+		ctx.max_working_days[ws] = calendar_working_days_from_prev_month(
+			defaults->holidays, month, year, ws);
+
+	in = fopen(defaults->previous_file, "rb");
+	if (!in) {
+		fprintf(stderr, "Error: Cannot open result file: %s\n",
+			defaults->previous_file);
+		arena_release(&arena);
+		return 1;
+	}
+
+	block = arena_alloc(&arena, DELTA_BLOCK_RECORDS * RESULT_RECORD_SIZE);
+	if (!block) {
+		fprintf(stderr, "Error: Out of memory.\n");
+		fclose(in);
+		arena_release(&arena);
+		return 1;
+	}
+
+	if (fread(header, 1, sizeof(header), in) != sizeof(header) ||
+	    decode_result_header(header) != 0) {
+		fprintf(stderr, "Error: Invalid result file: %s\n",
+			defaults->previous_file);
+		ret = 1;
+		goto out;
+	}
+
+	if (set_binary_output(stdout) != 0) {
+		fprintf(stderr, "Error: Cannot write binary output.\n");
+		ret = 1;
+		goto out;
+	}
+	fwrite(header, 1, sizeof(header), stdout);
+
+	while ((len = fread(block, 1, DELTA_BLOCK_RECORDS * RESULT_RECORD_SIZE,
+			    in)) > 0) {
+		if (len % RESULT_RECORD_SIZE != 0) {
+			fprintf(stderr, "Error: Truncated result file: %s\n",
+				defaults->previous_file);
+			ret = 1;
+			break;
+		}
+
+		for (i = 0; i < len; i += RESULT_RECORD_SIZE)
+			num_rejected += refresh_result_record(block + i,
+							      ++record_number,
+							      &ctx, &journal);
+
+		if (fwrite(block, 1, len, stdout) != len) {
+			ret = 1;
+			break;
+		}
+	}
+
+	if (ferror(in)) {
+		fprintf(stderr, "Error: Failed to read result file: %s\n",
+			defaults->previous_file);
+		ret = 1;
+	}
+
+	/* Journal records of employees missing from the prior results */
+	for (entry = journal.first; ret == 0 && entry; entry = entry->next) {
+		struct validation_error error;
+
+		if (entry->applied)
+			continue;
+		set_validation_text(&error, VALIDATION_UNKNOWN_ID, entry->id);
+		report_record_error(journal.path, entry->line_number, &error);
+		num_rejected++;
+	}
+
+	if (num_rejected > 0) {
+		fprintf(stderr, "Error: %lu record(s) rejected.\n", num_rejected);
+		ret = 1;
+	}
+
+out:
+	fclose(in);
+	if (defaults->memory_stats)
+		print_arena_stats(&arena);
+	arena_release(&arena);
+
+	if (fflush(stdout) != 0)
+		ret = 1;
+	return ret;
+}
@@ -0,0 +1,100 @@
+/*
+ * Build-time generator for the Gregorian working days table.
+ *
+ * The Gregorian calendar repeats every 400 years (146097 days, an exact
+ * number of weeks), so the number of working days in a month depends only on
+ * (year mod 400, month, week start). This program walks one full cycle day by
+ * day and writes the table as a C header.
+ *
+ * Usage: gen_calendar <output.h>
+ */
+
+#include <stdio.h>
+
+#define CYCLE_YEARS	400
+#define CYCLE_BASE_YEAR	2000	/* 2000 mod 400 == 0 */
+#define CYCLE_BASE_DOW	6	/* January 1, 2000 was a Saturday */
+
+static int is_leap_year(int year)
+{
+	return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+}
+
+static int days_in_month(int month, int year)
+{
+	static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+	if (month == 2 && is_leap_year(year))
+		return 29;
+
+	return days[month - 1];
+}
+
+int main(int argc, char *argv[])
+{
+	int table[CYCLE_YEARS][2][12];
+	int dow = CYCLE_BASE_DOW;
+	int y, month, day, ws;
+	FILE *out;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <output.h>\n", argv[0]);
+		return 1;
+	}
+
+	for (y = 0; y < CYCLE_YEARS; y++) {
+		for (month = 1; month <= 12; month++) {
+			int days = days_in_month(month, CYCLE_BASE_YEAR + y);
+
+			table[y][0][month - 1] = 0;
+			table[y][1][month - 1] = 0;
+			for (day = 1; day <= days; day++) {
+				/* Sunday start: Sun(0) - Thu(4) */
+				if (dow <= 4)
+					table[y][0][month - 1]++;
+				/* Monday start: Mon(1) - Fri(5) */
+				if (dow >= 1 && dow <= 5)
+					table[y][1][month - 1]++;
+				dow = (dow + 1) % 7;
+			}
+		}
+	}
+
+	/* The cycle must close on the day of week it started on */
+	if (dow != CYCLE_BASE_DOW) {
+		fprintf(stderr, "Error: 400-year cycle does not close.\n");
+		return 1;
+	}
+
+	out = fopen(argv[1], "w");
+	if (!out) {
+		fprintf(stderr, "Error: Cannot open output file: %s\n", argv[1]);
+		return 1;
+	}
+
+	fprintf(out, "/* Generated by gen_calendar. Do not edit. */\n\n");
+	fprintf(out, "#ifndef CALENDAR_TABLE_H\n#define CALENDAR_TABLE_H\n\n");
+	fprintf(out, "#define CALENDAR_CYCLE_YEARS %d\n\n", CYCLE_YEARS);
+	fprintf(out, "/* Working days per [year mod 400][week start][month - 1] */\n");
+	fprintf(out, "static const unsigned char working_days_table[%d][2][12] = {\n",
+		CYCLE_YEARS);
+	for (y = 0; y < CYCLE_YEARS; y++) {
+		fprintf(out, "\t{ /* %d */\n", y);
+		for (ws = 0; ws < 2; ws++) {
+			fprintf(out, "\t\t{");
+			for (month = 0; month < 12; month++)
+				fprintf(out, "%s%d", month ? ", " : "",
+					table[y][ws][month]);
+			fprintf(out, "}%s\n", ws == 0 ? "," : "");
+		}
+		fprintf(out, "\t}%s\n", y < CYCLE_YEARS - 1 ? "," : "");
+	}
+	fprintf(out, "};\n\n#endif /* CALENDAR_TABLE_H */\n");
+
+	if (fclose(out) != 0) {
+		fprintf(stderr, "Error: Failed to write output file: %s\n", argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vacation.h"
+
+/*
+ * Public holiday calendars.
+ *
+ * Every covered year is a HOLIDAY_YEAR_BITS-bit set indexed by day of the
+ * year (bit 0 is January 1). For each week start the calendar also keeps the
+ * set of working days of the year, weekdays with the holidays masked out, so
+ * the working days of any date range within a year are one popcount over the
+ * range's bits.
+ */
+
+#define MAX_HOLIDAY_YEARS	1000	/* Longest span of years in a calendar */
+#define HOLIDAY_LINE		256
+
+static const int days_before_month[] = {
+	0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
+
+static int day_of_year(struct date d)
+{
+	return days_before_month[d.month - 1] + d.day - 1 +
+	       (d.month > 2 && is_leap_year(d.year));
+}
+
+static int popcount64(uint64_t word)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(word);
+#else
+	int count = 0;
+
+	while (word) {
+		word &= word - 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+/* Number of set bits in [first, last] (inclusive) */
+static int popcount_range(const uint64_t *bits, int first, int last)
+{
+	int first_word = first / 64;
+	int last_word = last / 64;
+	int count = 0;
+	int w;
+
+	for (w = first_word; w <= last_word; w++) {
+		uint64_t word = bits[w];
+
+		if (w == first_word)
+			word &= ~(uint64_t)0 << (first % 64);
+		if (w == last_word && last % 64 != 63)
+			word &= ((uint64_t)1 << (last % 64 + 1)) - 1;
+		count += popcount64(word);
+	}
+
+	return count;
+}
+
+static int is_valid_date(struct date d)
+{
+	return d.month >= 1 && d.month <= 12 &&
+	       d.day >= 1 && d.day <= days_in_month(d.month, d.year);
+}
+
+/* Working days of one year: weekdays that are not holidays */
+static void build_working_days(struct holiday_calendar *calendar, int index)
+{
+	int year = calendar->first_year + index;
+	int num_days = is_leap_year(year) ? 366 : 365;
+	int dow = day_of_week(1, 1, year);
+	int n, ws;
+
+	for (ws = WEEK_START_SUNDAY; ws <= WEEK_START_MONDAY; ws++) {
+		uint64_t *working = calendar->working_days[index][ws];
+		const uint64_t *holidays = calendar->holidays[index];
+		int first_working_dow = (ws == WEEK_START_SUNDAY) ? 0 : 1;
+		int w;
+
+		memset(working, 0, HOLIDAY_WORDS * sizeof(uint64_t));
+		for (n = 0; n < num_days; n++) {
+			if ((dow + n - first_working_dow + 7) % 7 <
+			    WORKING_DAYS_PER_WEEK)
+				working[n / 64] |= (uint64_t)1 << (n % 64);
+		}
+
+		for (w = 0; w < HOLIDAY_WORDS; w++)
+			working[w] &= ~holidays[w];
+	}
+}
+
+int init_holiday_calendar(struct holiday_calendar *calendar,
+			  const struct date *dates, size_t count)
+{
+	int first_year = 0, last_year = 0;
+	size_t i;
+
+	calendar->first_year = 0;
+	calendar->num_years = 0;
+	calendar->holidays = NULL;
+	calendar->working_days = NULL;
+
+	for (i = 0; i < count; i++) {
+		if (!is_valid_date(dates[i]))
+			return HOLIDAY_ERR_DATE;
+		if (i == 0 || dates[i].year < first_year)
+			first_year = dates[i].year;
+		if (i == 0 || dates[i].year > last_year)
+			last_year = dates[i].year;
+	}
+
+	if (count == 0)
+		return 0;
+
+	if (last_year - first_year >= MAX_HOLIDAY_YEARS)
+		return HOLIDAY_ERR_SPAN;
+
+	calendar->num_years = last_year - first_year + 1;
+	calendar->first_year = first_year;
+	calendar->holidays = calloc(calendar->num_years,
+				    sizeof(*calendar->holidays));
+	calendar->working_days = calloc(calendar->num_years,
+					sizeof(*calendar->working_days));
+	if (!calendar->holidays || !calendar->working_days) {
+		free_holiday_calendar(calendar);
+		return HOLIDAY_ERR_MEMORY;
+	}
+
+	for (i = 0; i < count; i++) {
+		int n = day_of_year(dates[i]);
+
+		calendar->holidays[dates[i].year - first_year][n / 64] |=
+			(uint64_t)1 << (n % 64);
+	}
+
+	for (i = 0; i < (size_t)calendar->num_years; i++)
+		build_working_days(calendar, (int)i);
+
+	return 0;
+}
+
+void free_holiday_calendar(struct holiday_calendar *calendar)
+{
+	free(calendar->holidays);
+	free(calendar->working_days);
+	calendar->holidays = NULL;
+	calendar->working_days = NULL;
+	calendar->num_years = 0;
+}
+
+/* Parse "YYYY-MM-DD" at the start of a line; anything after it is ignored */
+static int parse_holiday_line(const char *line, struct date *d)
+{
+	char rest;
+	int n;
+
+	n = sscanf(line, "%4d-%2d-%2d%c", &d->year, &d->month, &d->day, &rest);
+	if (n < 3)
+		return 1;
+
+	if (n == 4 && rest != ' ' && rest != '\t' && rest != ',' &&
+	    rest != '\n' && rest != '\r')
+		return 1;
+
+	return !is_valid_date(*d);
+}
+
+int load_holiday_calendar(const char *path, struct holiday_calendar *calendar)
+{
+	char line[HOLIDAY_LINE];
+	struct date *dates = NULL;
+	size_t count = 0, size = 0;
+	unsigned long line_number = 0;
+	FILE *in;
+	int ret = 0;
+
+	in = fopen(path, "r");
+	if (!in) {
+		fprintf(stderr, "Error: Cannot open holidays file: %s\n", path);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), in) != NULL) {
+		const char *p = line;
+
+		line_number++;
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == '\0' || *p == '\n' || *p == '\r' || *p == '#')
+			continue;
+
+		if (count == size) {
+			size_t new_size = size ? size * 2 : 64;
+			struct date *grown = realloc(dates, new_size * sizeof(*dates));
+
+			if (!grown) {
+				fprintf(stderr, "Error: Out of memory.\n");
+				ret = 1;
+				break;
+			}
+			dates = grown;
+			size = new_size;
+		}
+
+		if (parse_holiday_line(p, &dates[count]) != 0) {
+			fprintf(stderr, "Error: %s:%lu: Invalid holiday date (expected YYYY-MM-DD).\n",
+				path, line_number);
+			ret = 1;
+			break;
+		}
+		count++;
+	}
+
+	fclose(in);
+
+	if (ret == 0) {
+		int status = init_holiday_calendar(calendar, dates, count);
+
+		if (status == HOLIDAY_ERR_MEMORY)
+			fprintf(stderr, "Error: Out of memory.\n");
+		else if (status != 0)
+			fprintf(stderr, "Error: %s: Holidays must span at most %d years.\n",
+				path, MAX_HOLIDAY_YEARS);
+		ret = status != 0;
+	}
+
+	free(dates);
+	return ret;
+}
+
+int calendar_working_days_between(const struct holiday_calendar *calendar,
+				  struct date a, struct date b, int week_start)
+{
+	int count = 0;
+	int year;
+
+	if (!calendar || calendar->num_years == 0)
+		return working_days_between(a, b, week_start);
+
+	if (b.year < a.year ||
+	    (b.year == a.year && day_of_year(b) < day_of_year(a)))
+		return 0;
+
+	for (year = a.year; year <= b.year; year++) {
+		struct date first = { 0, 1, 1 };
+		struct date last = { 0, 12, 31 };
+		int index = year - calendar->first_year;
+		int ws = (week_start == WEEK_START_SUNDAY) ?
+			WEEK_START_SUNDAY : WEEK_START_MONDAY;
+
+		first.year = year;
+		last.year = year;
+		if (year == a.year)
+			first = a;
+		if (year == b.year)
+			last = b;
+
+		if (index < 0 || index >= calendar->num_years)
+			count += working_days_between(first, last, week_start);
+		else
+			count += popcount_range(calendar->working_days[index][ws],
+						day_of_year(first),
+						day_of_year(last));
+	}
+
+	return count;
+}
+
+int calendar_working_days(const struct holiday_calendar *calendar,
+			  int month, int year, int week_start)
+{
+	struct date first = { 0, 0, 1 };
+	struct date last = { 0, 0, 0 };
+
+	if (month < 1 || month > 12)
+		return 0;
+
+	first.year = year;
+	first.month = month;
+	last.year = year;
+	last.month = month;
+	last.day = days_in_month(month, year);
+
+	if (!calendar || calendar->num_years == 0)
+		return calculate_working_days(month, year, week_start);
+
+	return calendar_working_days_between(calendar, first, last, week_start);
+}
@@ -0,0 +1,132 @@
+#include <math.h>
+#include <string.h>
+
+#include "vacation.h"
+
+/*
+ * Library entry points (libvacation).
+ *
+ * Requests are validated and answered with status codes; nothing is
+ * printed and no state is kept, so callers may share one context between
+ * threads. The daemon answers its socket requests through the same path.
+ */
+
+/* Latest year accepted in a context, as in --as-of */
+#define VACATION_MAX_YEAR	9999
+
+static const char *const status_messages[VACATION_NUM_STATUS] = {
+	"Success",
+	"Exactly one of annual days and annual hours must be set",
+	"Invalid annual vacation days",
+	"Invalid annual vacation hours",
+	"Extra vacation days out of range",
+	"Invalid week start",
+	"Unknown policy ID",
+	"Current hours must be a finite number",
+	"Invalid calculation date"
+};
+
+int vacation_abi_version(void)
+{
+	return VACATION_ABI_VERSION;
+}
+
+const char *vacation_strerror(int status)
+{
+	if (status < 0 || status >= VACATION_NUM_STATUS)
+		return "Unknown status";
+
+	return status_messages[status];
+}
+
+/* Check a request and fill in its calculation inputs */
+static int prepare_request_input(const struct vacation_context *context,
+				 const struct vacation_request *request,
+				 struct vacation_input *input)
+{
+	const struct vacation_policy *policy = context->policy;
+	int month = context->month;
+	int year = context->year;
+	int annual_days = request->annual_days;
+	int week_start = request->week_start;
+
+	if (month < 1 || month > MONTHS_PER_YEAR || year < 1 ||
+	    year > VACATION_MAX_YEAR)
+		return VACATION_ERR_DATE;
+
+	if ((request->annual_days != 0) == (request->annual_hours != 0))
+		return VACATION_ERR_ANNUAL_OPTION;
+
+	if (request->policy_id != 0) {
+		policy = find_policy(context->policies, request->policy_id);
+		if (!policy)
+			return VACATION_ERR_POLICY;
+	}
+
+	if (request->annual_hours != 0 &&
+	    !policy_is_valid_annual_hours(policy, request->annual_hours,
+					  &annual_days))
+		return VACATION_ERR_ANNUAL_HOURS;
+
+	if (!policy_is_valid_annual_days(policy, annual_days))
+		return VACATION_ERR_ANNUAL_DAYS;
+
+	if (week_start != WEEK_START_SUNDAY && week_start != WEEK_START_MONDAY)
+		return VACATION_ERR_WEEK_START;
+
+	if (!isfinite(request->current_hours))
+		return VACATION_ERR_CURRENT_HOURS;
+
+	/* Negated, so NaN is rejected too */
+	if (!(request->vacation_extra >= 0 &&
+	      request->vacation_extra <=
+	      calendar_working_days_from_prev_month(context->holidays, month,
+						    year, week_start)))
+		return VACATION_ERR_VACATION_EXTRA;
+
+	input->annual_days = annual_days;
+	input->max_accum_days = policy_max_accum(policy, annual_days,
+						 request->special_accum != 0);
+	input->current_hours = request->current_hours;
+	input->current_month = month;
+	input->current_year = year;
+	input->vacation_extra = request->vacation_extra;
+	input->week_start = week_start;
+	input->holidays = context->holidays;
+	input->policy = policy;
+
+	return VACATION_OK;
+}
+
+int vacation_evaluate(const struct vacation_context *context,
+		      const struct vacation_request *request,
+		      struct vacation_response *response)
+{
+	struct vacation_input input;
+	struct vacation_result result;
+	int status;
+
+	memset(response, 0, sizeof(*response));
+	response->current_month = context->month;
+	response->current_year = context->year;
+
+	status = prepare_request_input(context, request, &input);
+	response->status = status;
+	if (status != VACATION_OK)
+		return status;
+
+	calculate_vacation(&input, &result);
+
+	response->annual_days = input.annual_days;
+	response->max_accum_days = input.max_accum_days;
+	response->remaining_months = result.remaining_months;
+	response->working_days_remaining = result.working_days_remaining;
+	response->monthly_hours = result.monthly_hours;
+	response->additional_hours = result.additional_hours;
+	response->additional_days = result.additional_days;
+	response->total_hours = result.total_hours;
+	response->total_days = result.total_days;
+	response->excess_days = result.excess_days;
+
+	return VACATION_OK;
+}
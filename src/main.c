@@ -1,11 +1,23 @@
+#if defined(__linux__)
+#define _GNU_SOURCE	/* strtod_l */
+#endif
+
+#include <float.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <math.h>
+#include <locale.h>
 #include <ctype.h>
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <xlocale.h>
+#endif
 
 #include "vacation.h"
+#include "calendar_table.h"
 
 /* Month names for output */
 static const char *month_names[] = {
@@ -36,80 +48,347 @@ double days_to_hours(double days)
 	return days * WORK_DAY_HOURS;
 }
 
+int hours_to_centi_hours(double hours, int64_t *centi_hours)
+{
+	/* Also rejects NaN */
+	if (!(fabs(hours) <= MAX_FIXED_HOURS))
+		return 1;
+
+	*centi_hours = llround(hours * CENTI_PER_UNIT);
+	return 0;
+}
+
+int days_to_centi_hours(double days, int64_t *centi_hours)
+{
+	if (!(fabs(days) * WORK_DAY_HOURS <= MAX_FIXED_HOURS))
+		return 1;
+
+	*centi_hours = llround(days * WORK_DAY_CENTI_HOURS);
+	return 0;
+}
+
+int64_t centi_hours_to_centi_days(int64_t centi_hours)
+{
+	int64_t scaled = centi_hours * CENTI_PER_UNIT;
+
+	if (scaled < 0)
+		return -((-scaled + WORK_DAY_CENTI_HOURS / 2) /
+			 WORK_DAY_CENTI_HOURS);
+
+	return (scaled + WORK_DAY_CENTI_HOURS / 2) / WORK_DAY_CENTI_HOURS;
+}
+
 /*
  * Parsing helper functions
  */
 
-int parse_integer(const char *str, int *value)
+/* Whitespace as in the "C" locale, independent of the current locale */
+static int is_space_char(char c)
 {
-	char *endptr;
-	long result;
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' ||
+	       c == '\f' || c == '\r';
+}
+
+/* Strip leading and trailing whitespace from a span */
+static void trim_span(const char **str, size_t *len)
+{
+	while (*len > 0 && is_space_char(**str)) {
+		(*str)++;
+		(*len)--;
+	}
 
-	/* Skip leading whitespace */
-	while (isspace((unsigned char)*str))
+	while (*len > 0 && is_space_char((*str)[*len - 1]))
+		(*len)--;
+}
+
+int parse_integer_span(const char *str, size_t len, int *value)
+{
+	const char *end;
+	unsigned long result = 0;
+	int negative = 0;
+
+	trim_span(&str, &len);
+	end = str + len;
+
+	if (str < end && (*str == '-' || *str == '+')) {
+		negative = (*str == '-');
 		str++;
+	}
 
-	if (*str == '\0')
+	if (str == end)
 		return 1;
 
-	result = strtol(str, &endptr, 10);
+	for (; str < end; str++) {
+		unsigned int digit = (unsigned char)*str - '0';
 
-	/* Check for trailing non-whitespace characters */
-	while (isspace((unsigned char)*endptr))
-		endptr++;
+		if (digit > 9)
+			return 1;
 
-	if (*endptr != '\0')
-		return 1;
+		result = result * 10 + digit;
 
-	/* Check for overflow */
-	if (result < -2147483647 || result > 2147483647)
-		return 1;
+		/* Check for overflow */
+		if (result > 2147483647UL)
+			return 1;
+	}
 
-	*value = (int)result;
+	*value = negative ? -(int)result : (int)result;
 	return 0;
 }
 
-int parse_number(const char *str, double *value)
+int parse_integer(const char *str, int *value)
+{
+	return parse_integer_span(str, strlen(str), value);
+}
+
+/* Powers of ten that are exactly representable as doubles */
+static const double exact_powers_of_ten[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAX_EXACT_POWER_OF_TEN	22
+#define MAX_EXACT_MANTISSA	(1ULL << 53)
+#define MAX_MANTISSA_DIGITS	19	/* Always fits in 64 bits */
+#define MAX_NUMBER_LENGTH	64	/* Longer spans are copied to the heap */
+
+#if defined(_WIN32)
+typedef _locale_t number_locale_t;
+#define HAVE_NUMBER_LOCALE
+#elif defined(HAVE_STRTOD_L) && defined(__GNUC__)
+typedef locale_t number_locale_t;
+#define HAVE_NUMBER_LOCALE
+#endif
+
+#ifdef HAVE_NUMBER_LOCALE
+/*
+ * The "C" locale for strtod, created on first use and kept for the life of
+ * the process. A thread that loses the race to publish it frees its own.
+ * Returns: the locale, or a null locale if it cannot be created
+ */
+static number_locale_t c_number_locale(void)
+{
+	static number_locale_t c_locale;
+	number_locale_t loc;
+
+#if defined(_WIN32)
+	loc = (number_locale_t)InterlockedCompareExchangePointer(
+		(PVOID volatile *)&c_locale, NULL, NULL);
+	if (loc)
+		return loc;
+
+	loc = _create_locale(LC_NUMERIC, "C");
+	if (loc && InterlockedCompareExchangePointer(
+			(PVOID volatile *)&c_locale, loc, NULL) != NULL) {
+		_free_locale(loc);
+		loc = c_locale;
+	}
+#else
+	number_locale_t expected = (locale_t)0;
+
+	loc = __atomic_load_n(&c_locale, __ATOMIC_ACQUIRE);
+	if (loc)
+		return loc;
+
+	loc = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+	if (loc && !__atomic_compare_exchange_n(&c_locale, &expected, loc, 0,
+						__ATOMIC_ACQ_REL,
+						__ATOMIC_ACQUIRE)) {
+		freelocale(loc);
+		loc = expected;
+	}
+#endif
+	return loc;
+}
+#endif
+
+/*
+ * Convert a validated [sign]digits[.digits] span that is beyond the exact
+ * fast path with strtod in the "C" locale, so the result neither depends on
+ * nor races with setlocale. Spans of any length are accepted.
+ */
+static int parse_number_slow(const char *str, size_t len, double *value)
 {
+	char small[MAX_NUMBER_LENGTH];
+	char *buf = small;
 	char *endptr;
+	int ret;
+#ifdef HAVE_NUMBER_LOCALE
+	number_locale_t loc = c_number_locale();
+
+	if (!loc)
+		return 1;
+
+	if (len >= sizeof(small)) {
+		buf = malloc(len + 1);
+		if (!buf)
+			return 1;
+	}
+	memcpy(buf, str, len);
+	buf[len] = '\0';
+#if defined(_WIN32)
+	*value = _strtod_l(buf, &endptr, loc);
+#else
+	*value = strtod_l(buf, &endptr, loc);
+#endif
+#else
+	/* No strtod_l: spell the decimal point the way strtod expects it */
+	const char *point = localeconv()->decimal_point;
+	size_t point_len = strlen(point);
+	size_t i, n = 0;
+
+	if (len * point_len >= sizeof(small)) {
+		buf = malloc(len * point_len + 1);
+		if (!buf)
+			return 1;
+	}
+
+	for (i = 0; i < len; i++) {
+		if (str[i] == '.') {
+			memcpy(buf + n, point, point_len);
+			n += point_len;
+		} else {
+			buf[n++] = str[i];
+		}
+	}
+	buf[n] = '\0';
+	*value = strtod(buf, &endptr);
+#endif
+
+	ret = (*endptr != '\0');
+	if (buf != small)
+		free(buf);
+	return ret;
+}
 
-	/* Skip leading whitespace */
-	while (isspace((unsigned char)*str))
+int parse_number_span(const char *str, size_t len, double *value)
+{
+	const char *start, *end;
+	unsigned long long mantissa = 0;
+	int num_digits = 0;		/* Significant digits in mantissa */
+	int exponent = 0;		/* Decimal exponent of mantissa */
+	int seen_digit = 0;
+	int seen_point = 0;
+	int exact = 1;
+	int negative = 0;
+	double result;
+
+	trim_span(&str, &len);
+	start = str;
+	end = str + len;
+
+	if (str < end && (*str == '-' || *str == '+')) {
+		negative = (*str == '-');
 		str++;
+	}
+
+	for (; str < end; str++) {
+		unsigned int digit = (unsigned char)*str - '0';
+
+		if (*str == '.' && !seen_point) {
+			seen_point = 1;
+			continue;
+		}
+
+		if (digit > 9)
+			return 1;
 
-	if (*str == '\0')
+		seen_digit = 1;
+		if (mantissa == 0 && digit == 0) {
+			/* Leading zeros only move the decimal point */
+			if (seen_point)
+				exponent--;
+			continue;
+		}
+
+		if (num_digits < MAX_MANTISSA_DIGITS) {
+			mantissa = mantissa * 10 + digit;
+			num_digits++;
+			if (seen_point)
+				exponent--;
+		} else {
+			/* Digits beyond the mantissa need the slow path */
+			exact = 0;
+		}
+	}
+
+	if (!seen_digit)
 		return 1;
 
-	*value = strtod(str, &endptr);
+	/* Fast path: mantissa and 10^|exponent| are exact, one rounding */
+	if (exact && mantissa <= MAX_EXACT_MANTISSA &&
+	    exponent >= -MAX_EXACT_POWER_OF_TEN) {
+		result = (double)mantissa / exact_powers_of_ten[-exponent];
+		*value = negative ? -result : result;
+		return 0;
+	}
+
+	return parse_number_slow(start, len, value);
+}
+
+int parse_number(const char *str, double *value)
+{
+	return parse_number_span(str, strlen(str), value);
+}
+
+int parse_date(const char *str, struct date *d)
+{
+	int i;
+
+	if (strlen(str) != 10 || str[4] != '-' || str[7] != '-')
+		return 1;
 
-	/* Check for trailing non-whitespace characters */
-	while (isspace((unsigned char)*endptr))
-		endptr++;
+	for (i = 0; i < 10; i++) {
+		if (i != 4 && i != 7 && !isdigit((unsigned char)str[i]))
+			return 1;
+	}
 
-	if (*endptr != '\0')
+	if (parse_integer_span(str, 4, &d->year) != 0 ||
+	    parse_integer_span(str + 5, 2, &d->month) != 0 ||
+	    parse_integer_span(str + 8, 2, &d->day) != 0)
 		return 1;
 
-	return 0;
+	return d->year < 1 || d->month < 1 || d->month > 12 ||
+	       d->day < 1 || d->day > days_in_month(d->month, d->year);
 }
 
 /*
  * Time functions
  */
 
-int get_current_month(void)
+int get_current_date(struct date *today)
 {
 	time_t now = time(NULL);
-	struct tm *local_time = localtime(&now);
+	struct tm local_time;
+
+	/* Reentrant: no shared static buffer */
+#ifdef _WIN32
+	if (localtime_s(&local_time, &now) != 0)
+		return 1;
+#else
+	if (!localtime_r(&now, &local_time))
+		return 1;
+#endif
+
+	today->year = local_time.tm_year + 1900;	/* Years since 1900 */
+	today->month = local_time.tm_mon + 1;	/* tm_mon is 0-11, we want 1-12 */
+	today->day = local_time.tm_mday;
+	return 0;
+}
+
+int get_current_month(void)
+{
+	struct date today = { 1970, 1, 1 };
 
-	return local_time->tm_mon + 1;	/* tm_mon is 0-11, we want 1-12 */
+	get_current_date(&today);
+	return today.month;
 }
 
 int get_current_year(void)
 {
-	time_t now = time(NULL);
-	struct tm *local_time = localtime(&now);
+	struct date today = { 1970, 1, 1 };
 
-	return local_time->tm_year + 1900;	/* tm_year is years since 1900 */
+	get_current_date(&today);
+	return today.year;
 }
 
 int is_leap_year(int year)
@@ -153,67 +432,121 @@ int day_of_week(int day, int month, int year)
 	return ((h + 6) % 7);
 }
 
-int calculate_working_days(int month, int year, int week_start)
+/* Index of a year within the 400-year Gregorian cycle */
+static int calendar_cycle_year(int year)
 {
-	int total_days;
-	int working_days = 0;
-	int day;
-	int dow;
-	int is_working;
+	int y = year % CALENDAR_CYCLE_YEARS;
+
+	return (y < 0) ? y + CALENDAR_CYCLE_YEARS : y;
+}
 
-	total_days = days_in_month(month, year);
-	if (total_days == 0)
+int calculate_working_days(int month, int year, int week_start)
+{
+	if (month < 1 || month > 12)
 		return 0;
 
-	for (day = 1; day <= total_days; day++) {
-		dow = day_of_week(day, month, year);
+	/*
+	 * Working days: Sun(0) - Thu(4) for Sunday start,
+	 * Mon(1) - Fri(5) otherwise (see gen_calendar.c)
+	 */
+	return working_days_table[calendar_cycle_year(year)]
+		[week_start == WEEK_START_SUNDAY ? 0 : 1][month - 1];
+}
 
-		if (week_start == WEEK_START_SUNDAY) {
-			/* Working days: Sun(0) - Thu(4) */
-			is_working = (dow >= 0 && dow <= 4);
-		} else {
-			/* Working days: Mon(1) - Fri(5) */
-			is_working = (dow >= 1 && dow <= 5);
-		}
+/*
+ * Days since January 1, 1970 in the proleptic Gregorian calendar.
+ * Counts whole 400-year eras and the days within the era, with March as the
+ * first month of the year so that leap days fall at the end of it.
+ */
+static long days_from_civil(struct date d)
+{
+	long y = d.year - (d.month <= 2);
+	long era = (y >= 0 ? y : y - 399) / 400;
+	long yoe = y - era * 400;					/* [0, 399] */
+	long doy = (153 * (d.month + (d.month > 2 ? -3 : 9)) + 2) / 5 +
+		   d.day - 1;						/* [0, 365] */
+	long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;		/* [0, 146096] */
+
+	return era * 146097 + doe - 719468;
+}
 
-		if (is_working)
-			working_days++;
-	}
+/*
+ * Number of working days among the first n days of a week laid out from the
+ * first working day (5 working days followed by 2 weekend days).
+ */
+static long working_days_in_prefix(long n)
+{
+	long rest = n % 7;
 
-	return working_days;
+	return (n / 7) * WORKING_DAYS_PER_WEEK +
+	       (rest < WORKING_DAYS_PER_WEEK ? rest : WORKING_DAYS_PER_WEEK);
 }
 
-int calculate_remaining_working_days(int current_month, int year, int week_start)
+int working_days_between(struct date a, struct date b, int week_start)
 {
-	int total_working_days = 0;
-	int month;
+	long days = days_from_civil(b) - days_from_civil(a) + 1;
+	int first_working_dow = (week_start == WEEK_START_SUNDAY) ? 0 : 1;
+	int offset;
+
+	if (days <= 0)
+		return 0;
+
+	/* Position of the first date within its working week (0-4 working) */
+	offset = (day_of_week(a.day, a.month, a.year) - first_working_dow + 7) % 7;
 
-	for (month = current_month; month <= 12; month++)
-		total_working_days += calculate_working_days(month, year, week_start);
+	return (int)(working_days_in_prefix(offset + days) -
+		     working_days_in_prefix(offset));
+}
 
-	return total_working_days;
+int calculate_remaining_working_days(int current_month, int year, int week_start)
+{
+	return calendar_remaining_working_days(NULL, current_month, year,
+					       week_start);
 }
 
 int calculate_working_days_from_prev_month(int current_month, int year, int week_start)
 {
-	int total_working_days = 0;
-	int start_month;
-	int month;
+	return calendar_working_days_from_prev_month(NULL, current_month, year,
+						     week_start);
+}
+
+int calendar_remaining_working_days(const struct holiday_calendar *calendar,
+				    int current_month, int year, int week_start)
+{
+	struct date first = { 0, 1, 1 };
+	struct date last = { 0, 12, 31 };
+
+	if (current_month > 12)
+		return 0;
+
+	first.year = year;
+	first.month = (current_month < 1) ? 1 : current_month;
+	last.year = year;
+
+	return calendar_working_days_between(calendar, first, last, week_start);
+}
+
+int calendar_working_days_from_prev_month(const struct holiday_calendar *calendar,
+					  int current_month, int year,
+					  int week_start)
+{
+	struct date first = { 0, 1, 1 };
+	struct date last = { 0, 12, 31 };
+
+	if (current_month > 13)
+		return 0;
 
-	/* Previous month (handle January wrapping to December of previous year) */
+	/* Previous month (January wraps to December of previous year) */
 	if (current_month == 1) {
-		/* Add December of previous year */
-		total_working_days += calculate_working_days(12, year - 1, week_start);
-		start_month = 1;
+		first.year = year - 1;
+		first.month = 12;
 	} else {
-		start_month = current_month - 1;
+		first.year = year;
+		first.month = (current_month < 2) ? 1 : current_month - 1;
 	}
+	last.year = year;
 
-	/* Add working days from start_month to end of year */
-	for (month = start_month; month <= 12; month++)
-		total_working_days += calculate_working_days(month, year, week_start);
-
-	return total_working_days;
+	return calendar_working_days_between(calendar, first, last, week_start);
 }
 
 /*
@@ -273,8 +606,34 @@ void calculate_vacation(const struct vacation_input *input,
 						    input->max_accum_days);
 
 	/* Calculate remaining working days this year */
-	result->working_days_remaining = calculate_remaining_working_days(
-		input->current_month, input->current_year, input->week_start);
+	result->working_days_remaining = calendar_remaining_working_days(
+		input->holidays, input->current_month, input->current_year,
+		input->week_start);
+}
+
+void calculate_vacation_fixed(const struct vacation_fixed_input *input,
+			      struct vacation_fixed_result *result)
+{
+	int64_t excess;
+
+	result->remaining_months = calculate_remaining_months(input->current_month);
+
+	/* WORK_DAY_CENTI_HOURS is a multiple of 12: exactly annual_days * 70 */
+	result->monthly_centi_hours = (int64_t)input->annual_days *
+		WORK_DAY_CENTI_HOURS / MONTHS_PER_YEAR;
+	result->additional_centi_hours = result->remaining_months *
+		result->monthly_centi_hours;
+	result->total_centi_hours = input->current_centi_hours +
+		result->additional_centi_hours -
+		input->vacation_extra_centi_hours;
+
+	excess = result->total_centi_hours -
+		(int64_t)input->max_accum_days * WORK_DAY_CENTI_HOURS;
+	result->excess_centi_hours = (excess > 0) ? excess : 0;
+
+	result->working_days_remaining = calendar_remaining_working_days(
+		input->holidays, input->current_month, input->current_year,
+		input->week_start);
 }
 
 /*
@@ -292,20 +651,45 @@ void init_vacation_args(struct vacation_args *args)
 	args->vacation_extra_set = 0;
 	args->week_start = WEEK_START_SUNDAY;
 	args->special_accum = 0;
+	args->batch_file = NULL;
+	args->num_threads = 1;
+	args->pipeline = 0;
+	args->memory_stats = 0;
+	args->io_backend = IO_BACKEND_STDIO;
+	args->serve_socket = NULL;
+	args->snapshot_file = NULL;
+	args->snapshot_output = NULL;
+	args->previous_file = NULL;
+	args->journal_file = NULL;
+	args->fixed_point = 0;
+	args->holidays_file = NULL;
+	args->holidays = NULL;
+	args->output_format = OUTPUT_FORMAT_TEXT;
+	args->sweep_set = 0;
+	memset(&args->sweep, 0, sizeof(args->sweep));
+	args->timeline = 0;
+	args->plan_set = 0;
+	memset(args->planned_days, 0, sizeof(args->planned_days));
+	args->num_years = 1;
+	args->annual_hours = 0;
+	args->policy_file = NULL;
+	args->policy_id = 0;
+	args->policies = NULL;
+	args->policy = NULL;
+	args->as_of_set = 0;
+	memset(&args->as_of, 0, sizeof(args->as_of));
+	args->stdin_lines = 0;
+	args->help = 0;
 }
 
 int validate_arguments(const struct vacation_args *args)
 {
-	if (!args->annual_days_set && !args->annual_hours_set) {
-		fprintf(stderr,
-			"Error: Annual vacation days (-d) or hours (-A) must be specified.\n");
-		return 1;
-	}
+	struct validation_error error;
 
-	if (args->annual_days_set && args->annual_hours_set) {
-		fprintf(stderr,
-			"Error: --annual-days (-d) and --annual-hours (-A) are mutually exclusive.\n");
-		fprintf(stderr, "Please specify only one of these options.\n");
+	if (check_arguments(args, &error) != VALIDATION_OK) {
+		print_validation_error(&error);
+		if (error.code == VALIDATION_ANNUAL_BOTH)
+			fprintf(stderr, "Please specify only one of these options.\n");
 		return 1;
 	}
 	return 0;
@@ -313,90 +697,41 @@ int validate_arguments(const struct vacation_args *args)
 
 void print_valid_annual_options(void)
 {
-	int i;
-
-	fprintf(stderr, "\nValid annual vacation options:\n");
-	for (i = 0; i < NUM_VALID_ANNUAL_OPTIONS; i++) {
-		fprintf(stderr, "  %d days or %d hours\n",
-			VALID_ANNUAL_DAYS[i], VALID_ANNUAL_HOURS[i]);
-	}
-	fprintf(stderr, "\nPlease consult your pay slip for your annual vacation allowance.\n");
+	print_policy_options(NULL);
 }
 
 int is_valid_annual_hours(int hours, int *days_out)
 {
-	int i;
-
-	for (i = 0; i < NUM_VALID_ANNUAL_OPTIONS; i++) {
-		if (VALID_ANNUAL_HOURS[i] == hours) {
-			if (days_out)
-				*days_out = VALID_ANNUAL_DAYS[i];
-			return 1;
-		}
-	}
-	return 0;
+	return policy_is_valid_annual_hours(NULL, hours, days_out);
 }
 
 int get_annual_hours_for_days(int days)
 {
-	int i;
+	return policy_annual_hours_for_days(NULL, days);
+}
 
-	for (i = 0; i < NUM_VALID_ANNUAL_OPTIONS; i++) {
-		if (VALID_ANNUAL_DAYS[i] == days)
-			return VALID_ANNUAL_HOURS[i];
-	}
-	/* Fallback: calculate from WORK_DAY_HOURS */
-	return (int)(days * WORK_DAY_HOURS);
+int is_valid_annual_days(int annual_days)
+{
+	return policy_is_valid_annual_days(NULL, annual_days);
 }
 
 int validate_annual_days(int annual_days)
 {
-	int i;
-	int valid = 0;
-
-	for (i = 0; i < NUM_VALID_ANNUAL_OPTIONS; i++) {
-		if (VALID_ANNUAL_DAYS[i] == annual_days) {
-			valid = 1;
-			break;
-		}
-	}
-
-	if (!valid) {
-		fprintf(stderr,
-			"Error: Invalid annual vacation days (%d).\n",
-			annual_days);
-		print_valid_annual_options();
-		return 1;
-	}
-
-	return 0;
+	return policy_validate_annual_days(NULL, annual_days);
 }
 
 int calculate_max_accum(int annual_days, int special_accum)
 {
-	/* Normal case: always 36 */
-	if (!special_accum)
-		return MIN_MAX_ACCUM_DAYS;
-
-	/* Special accum: 12-17 days -> 36, 18-24 days -> annual_days * 2 */
-	if (annual_days < 18)
-		return MIN_MAX_ACCUM_DAYS;
-
-	return annual_days * 2;
+	return policy_max_accum(NULL, annual_days, special_accum);
 }
 
 int validate_vacation_days(double vacation_days, int max_working_days)
 {
-	if (vacation_days < 0) {
-		fprintf(stderr,
-			"Error: Extra vacation days consumption cannot be negative.\n");
-		return 1;
-	}
+	struct validation_error error;
 
-	if (vacation_days > max_working_days) {
-		fprintf(stderr,
-			"Error: Extra vacation days consumption (%.1f) cannot exceed working days from start of previous month (%d).\n",
-			vacation_days, max_working_days);
+	if (check_vacation_days(vacation_days, max_working_days,
+				&error) != VALIDATION_OK) {
+		print_validation_error(&error);
 		return 1;
 	}
 
@@ -423,6 +758,41 @@ void print_usage(const char *program_name)
 	printf("  -v, --vacation-extra <days> Extra vacation days consumption\n");
 	printf("  -M, --monday-start          Use Monday as first working day of week\n");
 	printf("                              (default: Sunday)\n");
+	printf("  -b, --batch <file.csv>      Process an employee file, one result row per\n");
+	printf("                              record (\"-\" reads from stdin)\n");
+	printf("  -T, --threads <N>           Worker threads for batch mode (default: 1)\n");
+	printf("  -Q, --pipeline              Stream batch mode through reader, compute\n");
+	printf("                              (--threads) and writer threads\n");
+	printf("  -G, --memory-stats          Report the arena memory of batch and delta runs\n");
+	printf("  -U, --io <backend>          Batch file I/O: stdio (default), pread or\n");
+	printf("                              uring (io_uring, Linux)\n");
+	printf("  -S, --serve <socket>        Serve requests on a Unix domain socket (Linux)\n");
+	printf("  -F, --fixed-point           Calculate exactly in hundredths of an hour\n");
+	printf("  -H, --holidays <file>       Public holidays (one YYYY-MM-DD per line),\n");
+	printf("                              excluded from working days\n");
+	printf("  -f, --format <format>       Output format: text (default), jsonl or bin\n");
+	printf("  -w, --sweep <first:last[:step]>\n");
+	printf("                              Project over a range of extra vacation days\n");
+	printf("                              (step default: 1)\n");
+	printf("  -m, --sweep-months <first[-last]>\n");
+	printf("                              Months of the sweep (default: current month\n");
+	printf("                              to December)\n");
+	printf("  -t, --timeline              Project the balance at the end of every month\n");
+	printf("  -p, --plan <month:days[,...]>\n");
+	printf("                              Planned vacation days per month (--timeline)\n");
+	printf("  -y, --years <N>             Project N year-ends with capped carry-over\n");
+	printf("                              (default: 1, at most %d)\n",
+	       MAX_PROJECTION_YEARS);
+	printf("  -P, --policy-file <file>    Accrual policies ([policy <id>] sections)\n");
+	printf("  -I, --policy-id <id>        Policy of the calculation (default: 0, the\n");
+	printf("                              built-in policy below)\n");
+	printf("  -D, --as-of <YYYY-MM-DD>    Calculate as of this date (default: today)\n");
+	printf("  -L, --stdin-lines           Read one set of options per line from stdin\n");
+	printf("  -W, --write-snapshot <file> Convert the --batch file to a columnar snapshot\n");
+	printf("  -Z, --snapshot <file>       Process a snapshot, one result row per record\n");
+	printf("  -R, --previous <file.bin>   Refresh a prior bin result file (--format bin)\n");
+	printf("  -J, --journal <file.csv>    Changed records for --previous\n");
+	printf("                              (id,current_hours[,vacation_extra])\n");
 	printf("  -h, --help                  Display this help message\n");
 	printf("\n");
 	printf("Valid annual vacation options:\n");
@@ -433,6 +803,10 @@ void print_usage(const char *program_name)
 	printf("\n");
 	printf("Either -d/--annual-days or -A/--annual-hours must be specified.\n");
 	printf("If --current-hours is not provided, the program will prompt for input.\n");
+	printf("\n");
+	printf("Batch records (CSV, one employee per line):\n");
+	printf("  id,annual_days,annual_hours,current_hours,vacation_extra,week_start,special_accum,policy\n");
+	printf("Empty fields take the values given on the command line.\n");
 }
 
 int parse_arguments(int argc, char *argv[], struct vacation_args *args)
@@ -444,8 +818,8 @@ int parse_arguments(int argc, char *argv[], struct vacation_args *args)
 	for (i = 1; i < argc; i++) {
 		if (strcmp(argv[i], "-h") == 0 ||
 		    strcmp(argv[i], "--help") == 0) {
-			print_usage(argv[0]);
-			exit(0);
+			args->help = 1;
+			return 0;
 		} else if (strcmp(argv[i], "-d") == 0 ||
 			   strcmp(argv[i], "--annual-days") == 0) {
 			if (i + 1 >= argc) {
@@ -476,14 +850,8 @@ int parse_arguments(int argc, char *argv[], struct vacation_args *args)
 					argv[i]);
 				return 1;
 			}
-			/* Validate against specific valid hour values */
-			if (!is_valid_annual_hours(int_value, &args->annual_days)) {
-				fprintf(stderr,
-					"Error: Invalid annual vacation hours (%d).\n",
-					int_value);
-				print_valid_annual_options();
-				return 1;
-			}
+			/* Converted once the policy is known */
+			args->annual_hours = int_value;
 			args->annual_hours_set = 1;
 		} else if (strcmp(argv[i], "-s") == 0 ||
 			   strcmp(argv[i], "--special-accum") == 0) {
@@ -523,164 +891,853 @@ int parse_arguments(int argc, char *argv[], struct vacation_args *args)
 		} else if (strcmp(argv[i], "-M") == 0 ||
 			   strcmp(argv[i], "--monday-start") == 0) {
 			args->week_start = WEEK_START_MONDAY;
-		} else {
-			fprintf(stderr, "Error: Unknown option: %s\n", argv[i]);
-			fprintf(stderr, "Use -h or --help for usage information.\n");
-			return 1;
-		}
-	}
-	return 0;
-}
-
-int prompt_current_hours(double *hours)
-{
-	char input_buffer[256];
-	double value;
-
-	printf("Enter current accumulated vacation hours: ");
-	fflush(stdout);
-	if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
-		fprintf(stderr, "Error: Failed to read input.\n");
-		return 1;
-	}
-
-	if (parse_number(input_buffer, &value) != 0) {
-		fprintf(stderr,
-			"Error: Invalid number format for current hours.\n");
-		return 1;
-	}
-
-	*hours = value;
-	return 0;
-}
-
-/*
- * Output functions
- */
-
-static void print_double_value(double value)
-{
-	char buf[32];
-	int len;
-
-	/* Format with 2 decimal places */
-	snprintf(buf, sizeof(buf), "%.2f", value);
-	len = strlen(buf);
-
-	/* Remove trailing zeros after decimal point */
-	while (len > 0 && buf[len - 1] == '0')
-		buf[--len] = '\0';
-
-	/* Remove trailing decimal point if no decimals remain */
-	if (len > 0 && buf[len - 1] == '.')
-		buf[--len] = '\0';
-
-	printf("%s", buf);
-}
-
-void print_results(const struct vacation_input *input,
-		   const struct vacation_result *result)
-{
-	int annual_hours = get_annual_hours_for_days(input->annual_days);
-	double max_accum_hours = days_to_hours(input->max_accum_days);
-	double excess_hours = days_to_hours(result->excess_days);
-
-	printf("=== Vacation Days Calculator ===\n\n");
-	printf("Annual vacation: %d hours (%d days)\n",
-	       annual_hours, input->annual_days);
-	printf("Maximum accumulation: ");
-	print_double_value(max_accum_hours);
-	printf(" hours (%d days)\n", input->max_accum_days);
-	printf("Current accumulated hours: ");
-	print_double_value(input->current_hours);
-	printf("\n");
-	printf("\n");
-	printf("Current month: %s (%d)\n",
-	       month_names[input->current_month - 1], input->current_month);
-	printf("Remaining working days in %d: %d\n",
-	       input->current_year, result->working_days_remaining);
-	if (input->vacation_extra > 0) {
-		printf("Extra vacation days consumption: ");
-		print_double_value(input->vacation_extra);
-		printf("\n");
-	}
-	printf("\n");
-	printf("Additional vacation expected by the end of %d: ", input->current_year);
-	print_double_value(result->additional_days);
-	printf(" days (");
-	print_double_value(result->additional_hours);
-	printf(" hours)\n");
-	printf("Total accumulated vacation expected by the end of %d: ", input->current_year);
-	print_double_value(result->total_hours);
-	printf(" hours (");
-	print_double_value(result->total_days);
-	printf(" days)\n");
-	printf("Vacation to be deducted at the end of %d (exceeding max): ", input->current_year);
-	print_double_value(excess_hours);
-	printf(" hours (");
-	print_double_value(result->excess_days);
-	printf(" days)\n");
-}
-
-/*
- * Main function
- */
-
-#ifndef TEST_BUILD
-int main(int argc, char *argv[])
-{
-	struct vacation_args args;
-	struct vacation_input input;
-	struct vacation_result result;
-	int remaining_working_days;
-	int max_accum_days;
+		} else if (strcmp(argv[i], "-b") == 0 ||
+			   strcmp(argv[i], "--batch") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			args->batch_file = argv[i];
+		} else if (strcmp(argv[i], "-T") == 0 ||
+			   strcmp(argv[i], "--threads") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			if (parse_integer(argv[i], &int_value) != 0 ||
+			    int_value < 1 || int_value > MAX_THREADS) {
+				fprintf(stderr,
+					"Error: Threads must be an integer between 1 and %d: %s\n",
+					MAX_THREADS, argv[i]);
+				return 1;
+			}
+			args->num_threads = int_value;
+		} else if (strcmp(argv[i], "-Q") == 0 ||
+			   strcmp(argv[i], "--pipeline") == 0) {
+			args->pipeline = 1;
+		} else if (strcmp(argv[i], "-G") == 0 ||
+			   strcmp(argv[i], "--memory-stats") == 0) {
+			args->memory_stats = 1;
+		} else if (strcmp(argv[i], "-U") == 0 ||
+			   strcmp(argv[i], "--io") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			if (parse_io_backend(argv[i], &args->io_backend) != 0) {
+				fprintf(stderr,
+					"Error: Invalid I/O backend (stdio, pread or uring): %s\n",
+					argv[i]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-S") == 0 ||
+			   strcmp(argv[i], "--serve") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			args->serve_socket = argv[i];
+		} else if (strcmp(argv[i], "-F") == 0 ||
+			   strcmp(argv[i], "--fixed-point") == 0) {
+			args->fixed_point = 1;
+		} else if (strcmp(argv[i], "-H") == 0 ||
+			   strcmp(argv[i], "--holidays") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			args->holidays_file = argv[i];
+		} else if (strcmp(argv[i], "-f") == 0 ||
+			   strcmp(argv[i], "--format") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			if (parse_output_format(argv[i], &args->output_format) != 0) {
+				fprintf(stderr,
+					"Error: Invalid output format (text, jsonl or bin): %s\n",
+					argv[i]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-w") == 0 ||
+			   strcmp(argv[i], "--sweep") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			if (parse_sweep_extra(argv[i], &args->sweep) != 0) {
+				fprintf(stderr,
+					"Error: Invalid sweep range (first:last[:step], at most %d values): %s\n",
+					MAX_SWEEP_POINTS, argv[i]);
+				return 1;
+			}
+			args->sweep_set = 1;
+		} else if (strcmp(argv[i], "-m") == 0 ||
+			   strcmp(argv[i], "--sweep-months") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			if (parse_sweep_months(argv[i], &args->sweep) != 0) {
+				fprintf(stderr,
+					"Error: Invalid sweep months (1-12): %s\n",
+					argv[i]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-t") == 0 ||
+			   strcmp(argv[i], "--timeline") == 0) {
+			args->timeline = 1;
+		} else if (strcmp(argv[i], "-p") == 0 ||
+			   strcmp(argv[i], "--plan") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			if (parse_vacation_plan(argv[i], args->planned_days) != 0) {
+				fprintf(stderr,
+					"Error: Invalid vacation plan (month:days[,month:days...]): %s\n",
+					argv[i]);
+				return 1;
+			}
+			args->plan_set = 1;
+		} else if (strcmp(argv[i], "-y") == 0 ||
+			   strcmp(argv[i], "--years") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			if (parse_integer(argv[i], &int_value) != 0 ||
+			    int_value < 1 || int_value > MAX_PROJECTION_YEARS) {
+				fprintf(stderr,
+					"Error: Years must be an integer between 1 and %d: %s\n",
+					MAX_PROJECTION_YEARS, argv[i]);
+				return 1;
+			}
+			args->num_years = int_value;
+		} else if (strcmp(argv[i], "-P") == 0 ||
+			   strcmp(argv[i], "--policy-file") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			args->policy_file = argv[i];
+		} else if (strcmp(argv[i], "-I") == 0 ||
+			   strcmp(argv[i], "--policy-id") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			if (parse_integer(argv[i], &int_value) != 0 ||
+			    int_value < 0 || int_value > POLICY_MAX_ID) {
+				fprintf(stderr,
+					"Error: Policy ID must be an integer between 0 and %d: %s\n",
+					POLICY_MAX_ID, argv[i]);
+				return 1;
+			}
+			args->policy_id = int_value;
+		} else if (strcmp(argv[i], "-L") == 0 ||
+			   strcmp(argv[i], "--stdin-lines") == 0) {
+			args->stdin_lines = 1;
+		} else if (strcmp(argv[i], "-D") == 0 ||
+			   strcmp(argv[i], "--as-of") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			if (parse_date(argv[i], &args->as_of) != 0) {
+				fprintf(stderr,
+					"Error: Invalid date (expected YYYY-MM-DD): %s\n",
+					argv[i]);
+				return 1;
+			}
+			args->as_of_set = 1;
+		} else if (strcmp(argv[i], "-W") == 0 ||
+			   strcmp(argv[i], "--write-snapshot") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			args->snapshot_output = argv[i];
+		} else if (strcmp(argv[i], "-Z") == 0 ||
+			   strcmp(argv[i], "--snapshot") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			args->snapshot_file = argv[i];
+		} else if (strcmp(argv[i], "-R") == 0 ||
+			   strcmp(argv[i], "--previous") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			args->previous_file = argv[i];
+		} else if (strcmp(argv[i], "-J") == 0 ||
+			   strcmp(argv[i], "--journal") == 0) {
+			if (i + 1 >= argc) {
+				fprintf(stderr, "Error: %s requires a value.\n",
+					argv[i]);
+				return 1;
+			}
+			i++;
+			args->journal_file = argv[i];
+		} else {
+			fprintf(stderr, "Error: Unknown option: %s\n", argv[i]);
+			fprintf(stderr, "Use -h or --help for usage information.\n");
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int prompt_current_hours(double *hours)
+{
+	char input_buffer[256];
+	double value;
+
+	printf("Enter current accumulated vacation hours: ");
+	fflush(stdout);
+	if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+		fprintf(stderr, "Error: Failed to read input.\n");
+		return 1;
+	}
 
-	/* Initialize and parse arguments */
-	init_vacation_args(&args);
-	if (parse_arguments(argc, argv, &args) != 0)
+	if (parse_number(input_buffer, &value) != 0) {
+		fprintf(stderr,
+			"Error: Invalid number format for current hours.\n");
 		return 1;
+	}
+
+	*hours = value;
+	return 0;
+}
+
+/*
+ * Output functions
+ */
+
+/*
+ * Exact two-decimal formatting.
+ *
+ * value * 100 is computed as an unevaluated sum product + error (Dekker's
+ * exact product), so rounding it to an integer number of hundredths gives
+ * exactly what printf's "%.2f" produces: the exact binary value rounded to
+ * nearest, ties to even. Values too large for the fast path, infinities and
+ * NaN go through snprintf. The fast path needs double evaluation without
+ * extended precision (FLT_EVAL_METHOD 0) and without contraction into fused
+ * multiply-add, which CMakeLists.txt disables.
+ */
+
+#define FAST_FORMAT_LIMIT	1e13	/* value * 100 stays far below 2^52 */
+#define VALUE_TEXT_SIZE		32	/* Formatted fast-path value and NUL */
+
+/*
+ * Round a non-negative value to hundredths.
+ * Returns: 0 on success, non-zero if the value needs snprintf
+ */
+static int round_hundredths(double magnitude, uint64_t *hundredths)
+{
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+	const double split = 134217729.0;	/* 2^27 + 1 */
+	double product, error, t, hi, lo, whole, below_half;
+
+	if (!(magnitude < FAST_FORMAT_LIMIT))
+		return 1;
+
+	/* magnitude * 100 == product + error exactly (100 needs no split) */
+	product = magnitude * 100.0;
+	t = split * magnitude;
+	hi = t - (t - magnitude);
+	lo = magnitude - hi;
+	error = (hi * 100.0 - product) + lo * 100.0;
+
+	/* Exact fraction is (product - whole) + error; compare it with 0.5 */
+	whole = floor(product);
+	below_half = (product - whole) - 0.5;
+	*hundredths = (uint64_t)whole;
+	if (error > -below_half ||
+	    (error == -below_half && (*hundredths & 1)))
+		(*hundredths)++;
+
+	return 0;
+#else
+	(void)magnitude;
+	(void)hundredths;
+	return 1;
+#endif
+}
+
+static char *put_uint64(char *p, uint64_t value)
+{
+	char digits[20];
+	int n = 0;
+
+	do {
+		digits[n++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value);
+
+	while (n > 0)
+		*p++ = digits[--n];
+
+	return p;
+}
+
+/* Write hundredths as a decimal number, trailing zeros removed */
+static char *put_hundredths(char *p, int negative, uint64_t hundredths)
+{
+	unsigned int cents = (unsigned int)(hundredths % CENTI_PER_UNIT);
+
+	if (negative)
+		*p++ = '-';
+	p = put_uint64(p, hundredths / CENTI_PER_UNIT);
+
+	if (cents != 0) {
+		*p++ = '.';
+		*p++ = (char)('0' + cents / 10);
+		if (cents % 10 != 0)
+			*p++ = (char)('0' + cents % 10);
+	}
+
+	return p;
+}
+
+static int format_double_value_slow(char *buf, size_t size, double value)
+{
+	int len;
+
+	/* Format with 2 decimal places */
+	len = snprintf(buf, size, "%.2f", value);
+	if (len < 0 || (size_t)len >= size)
+		return -1;
+
+	/* Remove trailing zeros after decimal point */
+	while (len > 0 && buf[len - 1] == '0')
+		buf[--len] = '\0';
+
+	/* Remove trailing decimal point if no decimals remain */
+	if (len > 0 && buf[len - 1] == '.')
+		buf[--len] = '\0';
+
+	return len;
+}
+
+int format_double_value(char *buf, size_t size, double value)
+{
+	char text[VALUE_TEXT_SIZE];
+	uint64_t hundredths;
+	size_t len;
+
+	if (round_hundredths(fabs(value), &hundredths) != 0)
+		return format_double_value_slow(buf, size, value);
+
+	/* "%.2f" keeps the sign of negative values that round to zero */
+	len = put_hundredths(text, signbit(value) != 0, hundredths) - text;
+	if (len >= size)
+		return -1;
+
+	memcpy(buf, text, len);
+	buf[len] = '\0';
+	return (int)len;
+}
+
+void fprint_double_value(FILE *stream, double value)
+{
+	char buf[32];
+
+	if (format_double_value(buf, sizeof(buf), value) >= 0)
+		fputs(buf, stream);
+}
+
+int format_centi_value(char *buf, size_t size, int64_t value)
+{
+	uint64_t magnitude = (value < 0) ? -(uint64_t)value : (uint64_t)value;
+	char text[VALUE_TEXT_SIZE];
+	size_t len;
+
+	len = put_hundredths(text, value < 0, magnitude) - text;
+	if (len >= size)
+		return -1;
+
+	memcpy(buf, text, len);
+	buf[len] = '\0';
+	return (int)len;
+}
+
+/*
+ * Result rendering: every line is appended to one buffer, which is written
+ * with a single call.
+ */
+
+static char *put_str(char *p, const char *str)
+{
+	size_t len = strlen(str);
+
+	memcpy(p, str, len);
+	return p + len;
+}
+
+static char *put_int(char *p, int value)
+{
+	if (value < 0) {
+		*p++ = '-';
+		return put_uint64(p, -(uint64_t)value);
+	}
+
+	return put_uint64(p, (uint64_t)value);
+}
+
+static char *put_double(char *p, double value)
+{
+	uint64_t hundredths;
+	int len;
+
+	if (round_hundredths(fabs(value), &hundredths) == 0)
+		return put_hundredths(p, signbit(value) != 0, hundredths);
+
+	/* Up to DBL_MAX_10_EXP + 1 digits, sign, point, two decimals, NUL */
+	len = format_double_value_slow(p, DBL_MAX_10_EXP + 6, value);
+	return (len > 0) ? p + len : p;
+}
+
+static char *put_centi(char *p, int64_t value)
+{
+	uint64_t magnitude = (value < 0) ? -(uint64_t)value : (uint64_t)value;
+
+	return put_hundredths(p, value < 0, magnitude);
+}
+
+/* Title and annual allowance, shared by both result formats */
+static char *put_results_title(char *p, const struct vacation_policy *policy,
+			       int annual_days)
+{
+	p = put_str(p, "=== Vacation Days Calculator ===\n\nAnnual vacation: ");
+	p = put_int(p, policy_annual_hours_for_days(policy, annual_days));
+	p = put_str(p, " hours (");
+	p = put_int(p, annual_days);
+	return put_str(p, " days)\nMaximum accumulation: ");
+}
+
+size_t format_results(char *buf, const struct vacation_input *input,
+		      const struct vacation_result *result)
+{
+	char *p = buf;
+
+	p = put_results_title(p, input->policy, input->annual_days);
+	p = put_double(p, days_to_hours(input->max_accum_days));
+	p = put_str(p, " hours (");
+	p = put_int(p, input->max_accum_days);
+	p = put_str(p, " days)\nCurrent accumulated hours: ");
+	p = put_double(p, input->current_hours);
+	p = put_str(p, "\n\nCurrent month: ");
+	p = put_str(p, month_names[input->current_month - 1]);
+	p = put_str(p, " (");
+	p = put_int(p, input->current_month);
+	p = put_str(p, ")\nRemaining working days in ");
+	p = put_int(p, input->current_year);
+	p = put_str(p, ": ");
+	p = put_int(p, result->working_days_remaining);
+	p = put_str(p, "\n");
+	if (input->vacation_extra > 0) {
+		p = put_str(p, "Extra vacation days consumption: ");
+		p = put_double(p, input->vacation_extra);
+		p = put_str(p, "\n");
+	}
+	p = put_str(p, "\nAdditional vacation expected by the end of ");
+	p = put_int(p, input->current_year);
+	p = put_str(p, ": ");
+	p = put_double(p, result->additional_days);
+	p = put_str(p, " days (");
+	p = put_double(p, result->additional_hours);
+	p = put_str(p, " hours)\nTotal accumulated vacation expected by the end of ");
+	p = put_int(p, input->current_year);
+	p = put_str(p, ": ");
+	p = put_double(p, result->total_hours);
+	p = put_str(p, " hours (");
+	p = put_double(p, result->total_days);
+	p = put_str(p, " days)\nVacation to be deducted at the end of ");
+	p = put_int(p, input->current_year);
+	p = put_str(p, " (exceeding max): ");
+	p = put_double(p, days_to_hours(result->excess_days));
+	p = put_str(p, " hours (");
+	p = put_double(p, result->excess_days);
+	p = put_str(p, " days)\n");
+	*p = '\0';
+
+	return p - buf;
+}
+
+size_t format_results_fixed(char *buf, const struct vacation_fixed_input *input,
+			    const struct vacation_fixed_result *result)
+{
+	char *p = buf;
+
+	p = put_results_title(p, input->policy, input->annual_days);
+	p = put_centi(p, (int64_t)input->max_accum_days * WORK_DAY_CENTI_HOURS);
+	p = put_str(p, " hours (");
+	p = put_int(p, input->max_accum_days);
+	p = put_str(p, " days)\nCurrent accumulated hours: ");
+	p = put_centi(p, input->current_centi_hours);
+	p = put_str(p, "\n\nCurrent month: ");
+	p = put_str(p, month_names[input->current_month - 1]);
+	p = put_str(p, " (");
+	p = put_int(p, input->current_month);
+	p = put_str(p, ")\nRemaining working days in ");
+	p = put_int(p, input->current_year);
+	p = put_str(p, ": ");
+	p = put_int(p, result->working_days_remaining);
+	p = put_str(p, "\n");
+	if (input->vacation_extra_centi_hours > 0) {
+		p = put_str(p, "Extra vacation days consumption: ");
+		p = put_centi(p, centi_hours_to_centi_days(
+			input->vacation_extra_centi_hours));
+		p = put_str(p, "\n");
+	}
+	p = put_str(p, "\nAdditional vacation expected by the end of ");
+	p = put_int(p, input->current_year);
+	p = put_str(p, ": ");
+	p = put_centi(p, centi_hours_to_centi_days(result->additional_centi_hours));
+	p = put_str(p, " days (");
+	p = put_centi(p, result->additional_centi_hours);
+	p = put_str(p, " hours)\nTotal accumulated vacation expected by the end of ");
+	p = put_int(p, input->current_year);
+	p = put_str(p, ": ");
+	p = put_centi(p, result->total_centi_hours);
+	p = put_str(p, " hours (");
+	p = put_centi(p, centi_hours_to_centi_days(result->total_centi_hours));
+	p = put_str(p, " days)\nVacation to be deducted at the end of ");
+	p = put_int(p, input->current_year);
+	p = put_str(p, " (exceeding max): ");
+	p = put_centi(p, result->excess_centi_hours);
+	p = put_str(p, " hours (");
+	p = put_centi(p, centi_hours_to_centi_days(result->excess_centi_hours));
+	p = put_str(p, " days)\n");
+	*p = '\0';
+
+	return p - buf;
+}
+
+void print_results(const struct vacation_input *input,
+		   const struct vacation_result *result)
+{
+	char buf[RESULTS_MAX_TEXT];
+
+	fwrite(buf, 1, format_results(buf, input, result), stdout);
+}
+
+void print_results_fixed(const struct vacation_fixed_input *input,
+			 const struct vacation_fixed_result *result)
+{
+	char buf[RESULTS_MAX_TEXT];
+
+	fwrite(buf, 1, format_results_fixed(buf, input, result), stdout);
+}
+
+/*
+ * Run functions
+ */
+
+/* Machine-readable output of a single result: one JSON line or one record */
+static int print_results_format(int format, const struct vacation_input *input,
+				const struct vacation_result *result)
+{
+	unsigned char header[RESULT_HEADER_SIZE];
+	unsigned char record[RESULT_RECORD_SIZE];
+	char buf[RESULT_MAX_JSON];
+
+	if (format == OUTPUT_FORMAT_JSONL) {
+		fwrite(buf, 1, format_result_json(buf, NULL, input, result),
+		       stdout);
+		return 0;
+	}
+
+	if (set_binary_output(stdout) != 0) {
+		fprintf(stderr, "Error: Cannot write binary output.\n");
+		return 1;
+	}
+	encode_result_header(header);
+	encode_result_record(record, NULL, input, result);
+	fwrite(header, 1, sizeof(header), stdout);
+	fwrite(record, 1, sizeof(record), stdout);
+	return 0;
+}
+
+static int run_fixed_point(const struct vacation_input *input, int format)
+{
+	struct vacation_fixed_input fixed_input;
+	struct vacation_fixed_result fixed_result;
+
+	if (hours_to_centi_hours(input->current_hours,
+				 &fixed_input.current_centi_hours) != 0) {
+		fprintf(stderr,
+			"Error: Current hours out of range for fixed-point mode.\n");
+		return 1;
+	}
+
+	if (days_to_centi_hours(input->vacation_extra,
+				&fixed_input.vacation_extra_centi_hours) != 0) {
+		fprintf(stderr,
+			"Error: Extra vacation days out of range for fixed-point mode.\n");
+		return 1;
+	}
+
+	fixed_input.annual_days = input->annual_days;
+	fixed_input.max_accum_days = input->max_accum_days;
+	fixed_input.current_month = input->current_month;
+	fixed_input.current_year = input->current_year;
+	fixed_input.week_start = input->week_start;
+	fixed_input.holidays = input->holidays;
+	fixed_input.policy = input->policy;
+
+	calculate_vacation_fixed(&fixed_input, &fixed_result);
+
+	if (format != OUTPUT_FORMAT_TEXT) {
+		struct vacation_input output_input;
+		struct vacation_result output_result;
+
+		fixed_to_vacation_result(&fixed_input, &fixed_result,
+					 &output_input, &output_result);
+		return print_results_format(format, &output_input,
+					    &output_result);
+	}
+
+	print_results_fixed(&fixed_input, &fixed_result);
+
+	return 0;
+}
+
+int prepare_arguments(struct vacation_args *args)
+{
+	args->policy = find_policy(args->policies, args->policy_id);
+	if (!args->policy) {
+		fprintf(stderr, "Error: Unknown policy ID: %d\n", args->policy_id);
+		return 1;
+	}
+
+	/* Validate against the policy's annual hours options */
+	if (args->annual_hours_set &&
+	    !policy_is_valid_annual_hours(args->policy, args->annual_hours,
+					  &args->annual_days)) {
+		fprintf(stderr, "Error: Invalid annual vacation hours (%d).\n",
+			args->annual_hours);
+		print_policy_options(args->policy);
+		return 1;
+	}
+
+	if (args->num_years > 1 &&
+	    (args->fixed_point || args->output_format == OUTPUT_FORMAT_BIN)) {
+		fprintf(stderr,
+			"Error: --years supports neither --fixed-point nor --format bin.\n");
+		return 1;
+	}
+
+	/* A run projects one way; the other modes print plain result rows */
+	if (args->sweep_set && (args->timeline || args->num_years > 1)) {
+		fprintf(stderr,
+			"Error: --sweep cannot be combined with --timeline or --years.\n");
+		return 1;
+	}
+
+	if (args->sweep_set &&
+	    (args->batch_file || args->snapshot_file || args->previous_file ||
+	     args->serve_socket)) {
+		fprintf(stderr,
+			"Error: --sweep supports neither --batch, --snapshot, --previous nor --serve.\n");
+		return 1;
+	}
+
+	if (args->timeline && args->num_years > 1) {
+		fprintf(stderr,
+			"Error: --timeline cannot be combined with --years.\n");
+		return 1;
+	}
+
+	if (args->timeline &&
+	    (args->batch_file || args->snapshot_file || args->previous_file ||
+	     args->serve_socket)) {
+		fprintf(stderr,
+			"Error: --timeline supports neither --batch, --snapshot, --previous nor --serve.\n");
+		return 1;
+	}
+
+	/* Every line is a run of its own; the modes apply to whole runs */
+	if (args->stdin_lines &&
+	    (args->batch_file || args->snapshot_file || args->previous_file ||
+	     args->serve_socket)) {
+		fprintf(stderr,
+			"Error: --stdin-lines supports neither --batch, --snapshot, --previous nor --serve.\n");
+		return 1;
+	}
+
+	/* Block I/O streams on the calling thread */
+	if (args->io_backend != IO_BACKEND_STDIO &&
+	    (args->num_threads > 1 || args->pipeline)) {
+		fprintf(stderr, "Error: --io supports neither --threads nor --pipeline.\n");
+		return 1;
+	}
+
+	if (args->snapshot_output && !args->batch_file) {
+		fprintf(stderr, "Error: --write-snapshot requires --batch.\n");
+		return 1;
+	}
+
+	if (args->snapshot_file && args->fixed_point) {
+		fprintf(stderr, "Error: --snapshot does not support --fixed-point.\n");
+		return 1;
+	}
+
+	/* Snapshots are mapped and run on the calling thread */
+	if (args->snapshot_file &&
+	    (args->num_threads > 1 || args->pipeline ||
+	     args->io_backend != IO_BACKEND_STDIO)) {
+		fprintf(stderr,
+			"Error: --snapshot supports neither --threads, --pipeline nor --io.\n");
+		return 1;
+	}
+
+	if (args->journal_file && !args->previous_file) {
+		fprintf(stderr, "Error: --journal requires --previous.\n");
+		return 1;
+	}
+
+	/* The prior results are merged on the calling thread */
+	if (args->previous_file &&
+	    (args->batch_file || args->num_threads > 1 || args->pipeline ||
+	     args->io_backend != IO_BACKEND_STDIO)) {
+		fprintf(stderr,
+			"Error: --previous supports neither --batch, --threads, --pipeline nor --io.\n");
+		return 1;
+	}
+
+	/* The refreshed file is the next run's --previous */
+	if (args->previous_file &&
+	    (args->output_format != OUTPUT_FORMAT_BIN || args->fixed_point)) {
+		fprintf(stderr,
+			"Error: --previous requires --format bin and does not support --fixed-point.\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+int run_vacation(struct vacation_args *args, const struct date *today)
+{
+	struct vacation_input input;
+	struct vacation_result result;
+	int remaining_working_days;
+	int max_accum_days;
 
 	/* Validate arguments */
-	if (validate_arguments(&args) != 0)
+	if (validate_arguments(args) != 0)
 		return 1;
 
 	/* Validate annual days range */
-	if (validate_annual_days(args.annual_days) != 0)
+	if (policy_validate_annual_days(args->policy, args->annual_days) != 0)
 		return 1;
 
 	/* Calculate max accumulated days based on special accum flag */
-	max_accum_days = calculate_max_accum(args.annual_days, args.special_accum);
+	max_accum_days = policy_max_accum(args->policy, args->annual_days,
+					  args->special_accum);
 
 	/* Get current hours interactively if not provided */
-	if (!args.current_hours_set) {
-		if (prompt_current_hours(&args.current_hours) != 0)
+	if (!args->current_hours_set) {
+		if (prompt_current_hours(&args->current_hours) != 0)
 			return 1;
 	}
 
 	/* Prepare calculation input */
-	input.annual_days = args.annual_days;
+	input.annual_days = args->annual_days;
 	input.max_accum_days = max_accum_days;
-	input.current_hours = args.current_hours;
-	input.current_month = get_current_month();
-	input.current_year = get_current_year();
-	input.vacation_extra = args.vacation_extra;
-	input.week_start = args.week_start;
+	input.current_hours = args->current_hours;
+	input.current_month = today->month;
+	input.current_year = today->year;
+	input.vacation_extra = args->vacation_extra;
+	input.week_start = args->week_start;
+	input.holidays = args->holidays;
+	input.policy = args->policy;
+
+	/* Scenario sweep: the extra days come from the sweep grid */
+	if (args->sweep_set) {
+		if (args->vacation_extra_set) {
+			fprintf(stderr,
+				"Error: --vacation-extra cannot be combined with --sweep.\n");
+			return 1;
+		}
+		return run_sweep(args, &input);
+	}
+
+	if (args->sweep.month_first != 0) {
+		fprintf(stderr, "Error: --sweep-months requires --sweep.\n");
+		return 1;
+	}
 
 	/* Validate vacation days against working days from start of previous month */
-	if (args.vacation_extra_set) {
-		remaining_working_days = calculate_working_days_from_prev_month(
-			input.current_month, input.current_year, input.week_start);
-		if (validate_vacation_days(args.vacation_extra,
+	if (args->vacation_extra_set) {
+		remaining_working_days = calendar_working_days_from_prev_month(
+			input.holidays, input.current_month, input.current_year,
+			input.week_start);
+		if (validate_vacation_days(args->vacation_extra,
 					   remaining_working_days) != 0)
 			return 1;
 	}
 
+	/* Timeline: balance at the end of every remaining month */
+	if (args->timeline)
+		return run_timeline(args, &input);
+
+	if (args->plan_set) {
+		fprintf(stderr, "Error: --plan requires --timeline.\n");
+		return 1;
+	}
+
+	/* Multi-year projection with carry-over */
+	if (args->num_years > 1)
+		return run_projection(args, &input);
+
+	/* Fixed-point mode: exact calculation in centi-hours */
+	if (args->fixed_point)
+		return run_fixed_point(&input, args->output_format);
+
 	/* Perform calculations */
 	calculate_vacation(&input, &result);
 
 	/* Print results */
+	if (args->output_format != OUTPUT_FORMAT_TEXT)
+		return print_results_format(args->output_format, &input, &result);
+
 	print_results(&input, &result);
 
 	return 0;
 }
-#endif /* TEST_BUILD */
@@ -0,0 +1,318 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "vacation.h"
+
+/*
+ * Machine-readable result formats (--format jsonl and --format bin).
+ */
+
+/*
+ * JSON Lines
+ */
+
+static char *put_json_text(char *p, const char *text)
+{
+	size_t len = strlen(text);
+
+	memcpy(p, text, len);
+	return p + len;
+}
+
+/* Quoted JSON string; control characters are written as \u escapes */
+static char *put_json_string(char *p, const char *str)
+{
+	static const char hex[] = "0123456789abcdef";
+	const unsigned char *s = (const unsigned char *)str;
+
+	*p++ = '"';
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\') {
+			*p++ = '\\';
+			*p++ = (char)*s;
+		} else if (*s < 0x20) {
+			p = put_json_text(p, "\\u00");
+			*p++ = hex[*s >> 4];
+			*p++ = hex[*s & 0xf];
+		} else {
+			*p++ = (char)*s;
+		}
+	}
+	*p++ = '"';
+
+	return p;
+}
+
+static char *put_json_int(char *p, const char *name, int value)
+{
+	return p + sprintf(p, ",\"%s\":%d", name, value);
+}
+
+/* Numbers as in the text output; JSON has no infinity or NaN */
+static char *put_json_double(char *p, const char *name, double value)
+{
+	int n;
+
+	p += sprintf(p, ",\"%s\":", name);
+	if (!isfinite(value))
+		return put_json_text(p, "null");
+
+	n = format_double_value(p, RESULT_MAX_VALUE, value);
+	return (n > 0) ? p + n : p;
+}
+
+size_t format_result_json(char *buf, const char *id,
+			  const struct vacation_input *input,
+			  const struct vacation_result *result)
+{
+	char *p = buf;
+
+	*p++ = '{';
+	if (id) {
+		p = put_json_text(p, "\"id\":");
+		p = put_json_string(p, id);
+		*p++ = ',';
+	}
+	p += sprintf(p, "\"annual_days\":%d", input->annual_days);
+	p = put_json_int(p, "max_accum_days", input->max_accum_days);
+	p = put_json_double(p, "current_hours", input->current_hours);
+	p = put_json_int(p, "current_month", input->current_month);
+	p = put_json_int(p, "current_year", input->current_year);
+	p = put_json_double(p, "vacation_extra", input->vacation_extra);
+	p = put_json_int(p, "week_start", input->week_start);
+	p = put_json_int(p, "remaining_months", result->remaining_months);
+	p = put_json_double(p, "monthly_hours", result->monthly_hours);
+	p = put_json_double(p, "additional_hours", result->additional_hours);
+	p = put_json_double(p, "additional_days", result->additional_days);
+	p = put_json_double(p, "total_hours", result->total_hours);
+	p = put_json_double(p, "total_days", result->total_days);
+	p = put_json_double(p, "excess_days", result->excess_days);
+	p = put_json_int(p, "working_days_remaining",
+			 result->working_days_remaining);
+	*p++ = '}';
+	*p++ = '\n';
+	*p = '\0';
+
+	return p - buf;
+}
+
+size_t format_timeline_json(char *buf, const struct vacation_input *input,
+			    const struct vacation_timeline *timeline, int month)
+{
+	char *p = buf;
+
+	p += sprintf(p, "{\"month\":%d", month);
+	p = put_json_int(p, "current_year", input->current_year);
+	p = put_json_double(p, "planned_days", timeline->planned_days[month - 1]);
+	p = put_json_double(p, "balance_hours",
+			    timeline->balance_hours[month - 1]);
+	p = put_json_double(p, "balance_days", timeline->balance_days[month - 1]);
+	*p++ = '}';
+	*p++ = '\n';
+	*p = '\0';
+
+	return p - buf;
+}
+
+size_t format_projection_json(char *buf, const char *id,
+			      const struct vacation_year_result *year)
+{
+	char *p = buf;
+
+	*p++ = '{';
+	if (id) {
+		p = put_json_text(p, "\"id\":");
+		p = put_json_string(p, id);
+		*p++ = ',';
+	}
+	p += sprintf(p, "\"year\":%d", year->year);
+	p = put_json_double(p, "total_hours", year->total_hours);
+	p = put_json_double(p, "total_days", year->total_days);
+	p = put_json_double(p, "excess_days", year->excess_days);
+	*p++ = '}';
+	*p++ = '\n';
+	*p = '\0';
+
+	return p - buf;
+}
+
+/*
+ * Binary records, explicitly little-endian so files are portable
+ */
+
+static unsigned char *put_le32(unsigned char *p, uint32_t value)
+{
+	p[0] = (unsigned char)value;
+	p[1] = (unsigned char)(value >> 8);
+	p[2] = (unsigned char)(value >> 16);
+	p[3] = (unsigned char)(value >> 24);
+	return p + 4;
+}
+
+static unsigned char *put_le64(unsigned char *p, uint64_t value)
+{
+	p = put_le32(p, (uint32_t)value);
+	return put_le32(p, (uint32_t)(value >> 32));
+}
+
+static unsigned char *put_le_double(unsigned char *p, double value)
+{
+	uint64_t bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+	return put_le64(p, bits);
+}
+
+static uint32_t get_le32(const unsigned char *p)
+{
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+	       (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static double get_le_double(const unsigned char *p)
+{
+	uint64_t bits = get_le32(p) | (uint64_t)get_le32(p + 4) << 32;
+	double value;
+
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+void encode_result_header(unsigned char *buf)
+{
+	memcpy(buf, RESULT_FILE_MAGIC, 8);
+	put_le32(buf + 8, RESULT_FILE_VERSION);
+	put_le32(buf + 12, RESULT_RECORD_SIZE);
+}
+
+int decode_result_header(const unsigned char *buf)
+{
+	return memcmp(buf, RESULT_FILE_MAGIC, 8) != 0 ||
+	       get_le32(buf + 8) != RESULT_FILE_VERSION ||
+	       get_le32(buf + 12) != RESULT_RECORD_SIZE;
+}
+
+void encode_result_record(unsigned char *buf, const char *id,
+			  const struct vacation_input *input,
+			  const struct vacation_result *result)
+{
+	unsigned char *p = buf;
+	size_t id_len = id ? strlen(id) : 0;
+
+	if (id_len > BATCH_MAX_ID)
+		id_len = BATCH_MAX_ID;
+	memset(p, 0, BATCH_MAX_ID + 1);
+	if (id_len)
+		memcpy(p, id, id_len);
+	p += BATCH_MAX_ID + 1;
+
+	p = put_le32(p, (uint32_t)input->annual_days);
+	p = put_le32(p, (uint32_t)input->max_accum_days);
+	p = put_le32(p, (uint32_t)input->current_month);
+	p = put_le32(p, (uint32_t)input->current_year);
+	p = put_le32(p, (uint32_t)input->week_start);
+	p = put_le32(p, (uint32_t)result->remaining_months);
+	p = put_le32(p, (uint32_t)result->working_days_remaining);
+	p = put_le32(p, 0);
+	p = put_le_double(p, input->current_hours);
+	p = put_le_double(p, input->vacation_extra);
+	p = put_le_double(p, result->monthly_hours);
+	p = put_le_double(p, result->additional_hours);
+	p = put_le_double(p, result->additional_days);
+	p = put_le_double(p, result->total_hours);
+	p = put_le_double(p, result->total_days);
+	put_le_double(p, result->excess_days);
+}
+
+void decode_result_record(const unsigned char *buf, struct result_record *record)
+{
+	const unsigned char *p = buf + BATCH_MAX_ID + 1;
+
+	memcpy(record->id, buf, BATCH_MAX_ID + 1);
+	record->id[BATCH_MAX_ID] = '\0';
+
+	record->annual_days = (int32_t)get_le32(p);
+	record->max_accum_days = (int32_t)get_le32(p + 4);
+	record->current_month = (int32_t)get_le32(p + 8);
+	record->current_year = (int32_t)get_le32(p + 12);
+	record->week_start = (int32_t)get_le32(p + 16);
+	record->remaining_months = (int32_t)get_le32(p + 20);
+	record->working_days_remaining = (int32_t)get_le32(p + 24);
+	record->reserved = (int32_t)get_le32(p + 28);
+	p += 32;
+	record->current_hours = get_le_double(p);
+	record->vacation_extra = get_le_double(p + 8);
+	record->monthly_hours = get_le_double(p + 16);
+	record->additional_hours = get_le_double(p + 24);
+	record->additional_days = get_le_double(p + 32);
+	record->total_hours = get_le_double(p + 40);
+	record->total_days = get_le_double(p + 48);
+	record->excess_days = get_le_double(p + 56);
+}
+
+/*
+ * Fixed-point results in the machine-readable formats
+ */
+
+void fixed_to_vacation_result(const struct vacation_fixed_input *fixed_input,
+			      const struct vacation_fixed_result *fixed_result,
+			      struct vacation_input *input,
+			      struct vacation_result *result)
+{
+	input->annual_days = fixed_input->annual_days;
+	input->max_accum_days = fixed_input->max_accum_days;
+	input->current_hours = fixed_input->current_centi_hours /
+		(double)CENTI_PER_UNIT;
+	input->current_month = fixed_input->current_month;
+	input->current_year = fixed_input->current_year;
+	input->vacation_extra = centi_hours_to_centi_days(
+		fixed_input->vacation_extra_centi_hours) / (double)CENTI_PER_UNIT;
+	input->week_start = fixed_input->week_start;
+	input->holidays = fixed_input->holidays;
+	input->policy = fixed_input->policy;
+
+	result->remaining_months = fixed_result->remaining_months;
+	result->monthly_hours = fixed_result->monthly_centi_hours /
+		(double)CENTI_PER_UNIT;
+	result->additional_hours = fixed_result->additional_centi_hours /
+		(double)CENTI_PER_UNIT;
+	result->additional_days = centi_hours_to_centi_days(
+		fixed_result->additional_centi_hours) / (double)CENTI_PER_UNIT;
+	result->total_hours = fixed_result->total_centi_hours /
+		(double)CENTI_PER_UNIT;
+	result->total_days = centi_hours_to_centi_days(
+		fixed_result->total_centi_hours) / (double)CENTI_PER_UNIT;
+	result->excess_days = centi_hours_to_centi_days(
+		fixed_result->excess_centi_hours) / (double)CENTI_PER_UNIT;
+	result->working_days_remaining = fixed_result->working_days_remaining;
+}
+
+int parse_output_format(const char *str, int *format)
+{
+	if (strcmp(str, "text") == 0)
+		*format = OUTPUT_FORMAT_TEXT;
+	else if (strcmp(str, "jsonl") == 0)
+		*format = OUTPUT_FORMAT_JSONL;
+	else if (strcmp(str, "bin") == 0)
+		*format = OUTPUT_FORMAT_BIN;
+	else
+		return 1;
+
+	return 0;
+}
+
+int set_binary_output(FILE *stream)
+{
+#ifdef _WIN32
+	return _setmode(_fileno(stream), _O_BINARY) == -1;
+#else
+	(void)stream;
+	return 0;
+#endif
+}
@@ -0,0 +1,416 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vacation.h"
+
+/*
+ * Accrual policies (--policy-file).
+ *
+ * A policy is compiled once into direct-indexed tables, so validating an
+ * allowance or looking up its hours or maximum accumulation is one array
+ * access. A NULL policy is the built-in one.
+ */
+
+/* Longest accepted policy file line */
+#define POLICY_LINE		256
+
+/* Built-in policy: VALID_ANNUAL_DAYS/HOURS, max accumulation 36 or days * 2 */
+static const struct vacation_policy default_policy = {
+	0,			/* id */
+	MIN_MAX_ACCUM_DAYS,	/* max_accum_days */
+	18,			/* special_accum_from */
+	2,			/* special_accum_factor */
+	{
+		[126] = 15, [135] = 16, [143] = 17, [152] = 18, [159] = 19,
+		[168] = 20, [177] = 21, [185] = 22, [194] = 23, [202] = 24
+	},
+	{
+		[15] = 126, [16] = 135, [17] = 143, [18] = 152, [19] = 159,
+		[20] = 168, [21] = 177, [22] = 185, [23] = 194, [24] = 202
+	},
+	{
+		{
+			[15] = 36, [16] = 36, [17] = 36, [18] = 36, [19] = 36,
+			[20] = 36, [21] = 36, [22] = 36, [23] = 36, [24] = 36
+		},
+		{
+			[15] = 36, [16] = 36, [17] = 36, [18] = 36, [19] = 38,
+			[20] = 40, [21] = 42, [22] = 44, [23] = 46, [24] = 48
+		}
+	}
+};
+
+static const struct vacation_policy *policy_or_default(
+	const struct vacation_policy *policy)
+{
+	return policy ? policy : &default_policy;
+}
+
+/* Maximum accumulation by the policy rule */
+static int policy_rule_max_accum(const struct vacation_policy *policy,
+				 int annual_days, int special_accum)
+{
+	if (!special_accum || annual_days < policy->special_accum_from)
+		return policy->max_accum_days;
+
+	return annual_days * policy->special_accum_factor;
+}
+
+int compile_policy(const struct policy_rules *rules,
+		   struct vacation_policy *policy)
+{
+	int i;
+
+	if (rules->num_options < 1 || rules->num_options > POLICY_MAX_OPTIONS ||
+	    rules->max_accum_days < 1 ||
+	    rules->special_accum_from < 1 ||
+	    rules->special_accum_factor < 1 ||
+	    (long)(POLICY_MAX_DAYS - 1) * rules->special_accum_factor > UINT16_MAX ||
+	    rules->max_accum_days > UINT16_MAX)
+		return 1;
+
+	memset(policy, 0, sizeof(*policy));
+	policy->id = rules->id;
+	policy->max_accum_days = rules->max_accum_days;
+	policy->special_accum_from = rules->special_accum_from;
+	policy->special_accum_factor = rules->special_accum_factor;
+
+	for (i = 0; i < rules->num_options; i++) {
+		int days = rules->days[i];
+		int hours = rules->hours[i];
+
+		/* Each days and hours value names exactly one option */
+		if (days < 1 || days >= POLICY_MAX_DAYS ||
+		    hours < 1 || hours >= POLICY_MAX_HOURS ||
+		    policy->days_to_hours[days] != 0 ||
+		    policy->hours_to_days[hours] != 0)
+			return 1;
+
+		policy->hours_to_days[hours] = (uint8_t)days;
+		policy->days_to_hours[days] = (uint16_t)hours;
+		policy->max_accum[0][days] = (uint16_t)policy_rule_max_accum(
+			policy, days, 0);
+		policy->max_accum[1][days] = (uint16_t)policy_rule_max_accum(
+			policy, days, 1);
+	}
+
+	return 0;
+}
+
+int policy_is_valid_annual_hours(const struct vacation_policy *policy,
+				 int hours, int *days_out)
+{
+	int days;
+
+	policy = policy_or_default(policy);
+	if (hours < 0 || hours >= POLICY_MAX_HOURS)
+		return 0;
+
+	days = policy->hours_to_days[hours];
+	if (days == 0)
+		return 0;
+
+	if (days_out)
+		*days_out = days;
+	return 1;
+}
+
+int policy_is_valid_annual_days(const struct vacation_policy *policy,
+				int annual_days)
+{
+	policy = policy_or_default(policy);
+
+	return annual_days >= 0 && annual_days < POLICY_MAX_DAYS &&
+	       policy->days_to_hours[annual_days] != 0;
+}
+
+int policy_annual_hours_for_days(const struct vacation_policy *policy,
+				 int days)
+{
+	policy = policy_or_default(policy);
+	if (policy_is_valid_annual_days(policy, days))
+		return policy->days_to_hours[days];
+
+	/* Fallback: calculate from WORK_DAY_HOURS */
+	return (int)(days * WORK_DAY_HOURS);
+}
+
+int policy_max_accum(const struct vacation_policy *policy,
+		     int annual_days, int special_accum)
+{
+	policy = policy_or_default(policy);
+	if (policy_is_valid_annual_days(policy, annual_days))
+		return policy->max_accum[special_accum != 0][annual_days];
+
+	return policy_rule_max_accum(policy, annual_days, special_accum);
+}
+
+void print_policy_options(const struct vacation_policy *policy)
+{
+	int days;
+
+	policy = policy_or_default(policy);
+	fprintf(stderr, "\nValid annual vacation options:\n");
+	for (days = 1; days < POLICY_MAX_DAYS; days++) {
+		if (policy->days_to_hours[days] != 0)
+			fprintf(stderr, "  %d days or %d hours\n", days,
+				policy->days_to_hours[days]);
+	}
+	fprintf(stderr, "\nPlease consult your pay slip for your annual vacation allowance.\n");
+}
+
+int policy_validate_annual_days(const struct vacation_policy *policy,
+				int annual_days)
+{
+	struct validation_error error;
+
+	if (check_annual_days(policy, annual_days, &error) != VALIDATION_OK) {
+		print_validation_error(&error);
+		print_policy_options(policy);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Policy sets
+ */
+
+const struct vacation_policy *find_policy(const struct policy_set *set,
+					  int id)
+{
+	if (id == 0)
+		return &default_policy;
+
+	if (!set || id < 0 || id > POLICY_MAX_ID)
+		return NULL;
+
+	return set->policies[id];
+}
+
+void free_policy_set(struct policy_set *set)
+{
+	int id;
+
+	for (id = 0; id <= POLICY_MAX_ID; id++) {
+		free(set->policies[id]);
+		set->policies[id] = NULL;
+	}
+}
+
+/* Skip spaces and tabs */
+static const char *skip_blanks(const char *p)
+{
+	while (*p == ' ' || *p == '\t')
+		p++;
+	return p;
+}
+
+/* Length of a line without its trailing whitespace and comment */
+static size_t policy_line_length(const char *line)
+{
+	size_t len = strcspn(line, "#\r\n");
+
+	while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t'))
+		len--;
+	return len;
+}
+
+/* Parse "<n>" or "<n> <m>" spanning the rest of a line */
+static int parse_policy_values(const char *p, size_t len, int *values,
+			       int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		size_t n;
+
+		n = strcspn(p, " \t");
+		if (n > len)
+			n = len;
+		if (n == 0 || parse_integer_span(p, n, &values[i]) != 0)
+			return 1;
+
+		p += n;
+		len -= n;
+		while (len > 0 && (*p == ' ' || *p == '\t')) {
+			p++;
+			len--;
+		}
+	}
+
+	return len != 0;
+}
+
+/* Compile the section in rules into the set */
+static int add_policy(struct policy_set *set, const struct policy_rules *rules,
+		      const char *path)
+{
+	struct vacation_policy *policy;
+
+	policy = malloc(sizeof(*policy));
+	if (!policy) {
+		fprintf(stderr, "Error: Out of memory.\n");
+		return 1;
+	}
+
+	if (compile_policy(rules, policy) != 0) {
+		fprintf(stderr,
+			"Error: %s: Invalid policy %d (options must be unique days below %d and hours below %d).\n",
+			path, rules->id, POLICY_MAX_DAYS, POLICY_MAX_HOURS);
+		free(policy);
+		return 1;
+	}
+
+	set->policies[rules->id] = policy;
+	return 0;
+}
+
+/* Start a section with the built-in rule, so files only list differences */
+static void init_policy_rules(struct policy_rules *rules, int id)
+{
+	rules->id = id;
+	rules->num_options = 0;
+	rules->max_accum_days = default_policy.max_accum_days;
+	rules->special_accum_from = default_policy.special_accum_from;
+	rules->special_accum_factor = default_policy.special_accum_factor;
+}
+
+/* Apply one "key = value" line to the current section */
+static int parse_policy_setting(struct policy_rules *rules, const char *p,
+				size_t len)
+{
+	static const char *const keys[] = {
+		"max_accum_days", "special_accum_from", "special_accum_factor",
+		"option"
+	};
+	const char *eq = memchr(p, '=', len);
+	size_t key_len;
+	int values[2];
+	int k;
+
+	if (!eq)
+		return 1;
+
+	key_len = eq - p;
+	while (key_len > 0 && (p[key_len - 1] == ' ' || p[key_len - 1] == '\t'))
+		key_len--;
+
+	for (k = 0; k < 4; k++) {
+		if (strlen(keys[k]) == key_len &&
+		    memcmp(p, keys[k], key_len) == 0)
+			break;
+	}
+
+	len -= eq + 1 - p;
+	p = skip_blanks(eq + 1);
+	len -= p - (eq + 1);
+
+	if (k == 3) {
+		if (rules->num_options == POLICY_MAX_OPTIONS ||
+		    parse_policy_values(p, len, values, 2) != 0)
+			return 1;
+		rules->days[rules->num_options] = values[0];
+		rules->hours[rules->num_options] = values[1];
+		rules->num_options++;
+		return 0;
+	}
+
+	if (k == 4 || parse_policy_values(p, len, values, 1) != 0)
+		return 1;
+
+	if (k == 0)
+		rules->max_accum_days = values[0];
+	else if (k == 1)
+		rules->special_accum_from = values[0];
+	else
+		rules->special_accum_factor = values[0];
+
+	return 0;
+}
+
+int load_policy_file(const char *path, struct policy_set *set)
+{
+	char line[POLICY_LINE + 2];	/* Room for newline and NUL */
+	struct policy_rules rules;
+	unsigned long line_number = 0;
+	int in_section = 0;
+	FILE *in;
+	int ret = 0;
+
+	memset(set, 0, sizeof(*set));
+
+	in = fopen(path, "r");
+	if (!in) {
+		fprintf(stderr, "Error: Cannot open policy file: %s\n", path);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), in) != NULL) {
+		const char *p = skip_blanks(line);
+		size_t len = strlen(line);
+		int id;
+
+		line_number++;
+
+		/* Reject over-long lines rather than reading their tail as a line */
+		if (len > 0 && line[len - 1] != '\n' && !feof(in)) {
+			fprintf(stderr, "Error: %s:%lu: Line too long (max %d characters).\n",
+				path, line_number, POLICY_LINE);
+			ret = 1;
+			break;
+		}
+
+		len = policy_line_length(p);
+		if (len == 0)
+			continue;
+
+		if (*p != '[') {
+			if (!in_section || parse_policy_setting(&rules, p, len) != 0) {
+				fprintf(stderr, "Error: %s:%lu: Invalid policy setting.\n",
+					path, line_number);
+				ret = 1;
+				break;
+			}
+			continue;
+		}
+
+		/* "[policy <id>]" starts a new section */
+		if (len < 9 || p[len - 1] != ']' ||
+		    strncmp(p, "[policy", 7) != 0 ||
+		    (p[7] != ' ' && p[7] != '\t') ||
+		    parse_integer_span(p + 7, len - 8, &id) != 0 ||
+		    id < 1 || id > POLICY_MAX_ID) {
+			fprintf(stderr,
+				"Error: %s:%lu: Invalid policy section (expected [policy <1-%d>]).\n",
+				path, line_number, POLICY_MAX_ID);
+			ret = 1;
+			break;
+		}
+
+		if (in_section && add_policy(set, &rules, path) != 0) {
+			ret = 1;
+			break;
+		}
+
+		if (set->policies[id]) {
+			fprintf(stderr, "Error: %s:%lu: Policy %d is defined twice.\n",
+				path, line_number, id);
+			ret = 1;
+			break;
+		}
+		init_policy_rules(&rules, id);
+		in_section = 1;
+	}
+
+	fclose(in);
+
+	if (ret == 0 && in_section)
+		ret = add_policy(set, &rules, path);
+
+	if (ret != 0)
+		free_policy_set(set);
+	return ret;
+}
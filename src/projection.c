@@ -0,0 +1,86 @@
+#include <stdio.h>
+
+#include "vacation.h"
+
+/*
+ * Multi-year projection (--years).
+ *
+ * At the end of every year the balance above the maximum accumulation is
+ * deducted and the rest carries over. A full year then adds twelve monthly
+ * credits, computed in closed form as in calculate_vacation, so the first
+ * year is bit-identical to the single-year result.
+ */
+
+void calculate_next_year(const struct vacation_year_result *prev,
+			 int annual_days, int max_accum_days,
+			 struct vacation_year_result *next)
+{
+	double carry_hours = (prev->excess_days > 0) ?
+		days_to_hours(max_accum_days) : prev->total_hours;
+
+	next->year = prev->year + 1;
+	next->total_hours = calculate_total_hours(carry_hours,
+		calculate_additional_hours(MONTHS_PER_YEAR,
+					   calculate_monthly_hours(annual_days)));
+	next->total_days = hours_to_days(next->total_hours);
+	next->excess_days = calculate_excess_days(next->total_days,
+						  max_accum_days);
+}
+
+void calculate_vacation_projection(const struct vacation_input *input,
+				   const struct vacation_result *result,
+				   int num_years,
+				   struct vacation_year_result *years)
+{
+	int y;
+
+	years[0].year = input->current_year;
+	years[0].total_hours = result->total_hours;
+	years[0].total_days = result->total_days;
+	years[0].excess_days = result->excess_days;
+
+	for (y = 1; y < num_years; y++)
+		calculate_next_year(&years[y - 1], input->annual_days,
+				    input->max_accum_days, &years[y]);
+}
+
+int run_projection(const struct vacation_args *args,
+		   const struct vacation_input *input)
+{
+	struct vacation_year_result years[MAX_PROJECTION_YEARS];
+	struct vacation_result result;
+	char buf[RESULT_MAX_JSON];
+	char value[4][RESULT_MAX_VALUE];
+	int y;
+
+	calculate_vacation(input, &result);
+	calculate_vacation_projection(input, &result, args->num_years, years);
+
+	if (args->output_format == OUTPUT_FORMAT_JSONL) {
+		for (y = 0; y < args->num_years; y++)
+			fwrite(buf, 1, format_projection_json(buf, NULL, &years[y]),
+			       stdout);
+		return 0;
+	}
+
+	print_results(input, &result);
+
+	printf("\nProjection with carry-over (capped at %d days):\n",
+	       input->max_accum_days);
+	printf("%4s %12s %12s %12s %13s\n", "Year", "Total hours", "Total days",
+	       "Excess days", "Carried days");
+	for (y = 0; y < args->num_years; y++) {
+		format_double_value(value[0], sizeof(value[0]),
+				    years[y].total_hours);
+		format_double_value(value[1], sizeof(value[1]),
+				    years[y].total_days);
+		format_double_value(value[2], sizeof(value[2]),
+				    years[y].excess_days);
+		format_double_value(value[3], sizeof(value[3]),
+				    years[y].total_days - years[y].excess_days);
+		printf("%4d %12s %12s %12s %13s\n", years[y].year, value[0],
+		       value[1], value[2], value[3]);
+	}
+
+	return 0;
+}
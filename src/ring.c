@@ -0,0 +1,68 @@
+#include <stdlib.h>
+
+#include "vacation.h"
+
+/*
+ * Single-producer/single-consumer ring of pointers.
+ *
+ * The producer only writes tail and the consumer only writes head, so no
+ * lock is needed: a slot is published by the release store of the index
+ * that follows it and claimed by the acquire load on the other side.
+ * The indexes run freely and are masked into the power-of-two slot array.
+ */
+
+#if defined(__GNUC__)
+#define ring_load_acquire(p)		__atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define ring_store_release(p, v)	__atomic_store_n(p, v, __ATOMIC_RELEASE)
+#else
+/* MSVC: volatile accesses have acquire and release semantics */
+#define ring_load_acquire(p)		(*(volatile size_t *)(p))
+#define ring_store_release(p, v)	(*(volatile size_t *)(p) = (v))
+#endif
+
+int spsc_ring_init(struct spsc_ring *ring, size_t capacity)
+{
+	size_t slots = 1;
+
+	while (slots < capacity)
+		slots *= 2;
+
+	ring->slots = malloc(slots * sizeof(*ring->slots));
+	if (!ring->slots)
+		return 1;
+	ring->mask = slots - 1;
+	ring->head = 0;
+	ring->tail = 0;
+	return 0;
+}
+
+void spsc_ring_destroy(struct spsc_ring *ring)
+{
+	free(ring->slots);
+	ring->slots = NULL;
+}
+
+int spsc_ring_push(struct spsc_ring *ring, void *item)
+{
+	size_t tail = ring->tail;
+
+	if (tail - ring_load_acquire(&ring->head) > ring->mask)
+		return 1;
+
+	ring->slots[tail & ring->mask] = item;
+	ring_store_release(&ring->tail, tail + 1);
+	return 0;
+}
+
+void *spsc_ring_pop(struct spsc_ring *ring)
+{
+	size_t head = ring->head;
+	void *item;
+
+	if (head == ring_load_acquire(&ring->tail))
+		return NULL;
+
+	item = ring->slots[head & ring->mask];
+	ring_store_release(&ring->head, head + 1);
+	return item;
+}
@@ -0,0 +1,429 @@
+#ifdef __linux__
+#define _GNU_SOURCE	/* accept4 */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "vacation.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define SERVE_MAX_EVENTS	64
+#define SERVE_BACKLOG		128
+#define SERVE_BATCH		64	/* Requests read per client per wakeup */
+
+/* Per-client connection state */
+struct serve_client {
+	struct serve_client *prev;	/* Connected clients, closed at shutdown */
+	struct serve_client *next;
+	int fd;
+	size_t in_len;		/* Bytes of a partial request in in_buf */
+	size_t out_pos;		/* Bytes of out_buf already written */
+	size_t out_len;		/* Bytes of out_buf to write */
+	unsigned char in_buf[SERVE_BATCH * sizeof(struct vacation_request)];
+	unsigned char out_buf[SERVE_BATCH * sizeof(struct vacation_response)];
+};
+
+/* Current date, refreshed at midnight instead of on every request */
+struct serve_clock {
+	time_t expires;
+	int month;
+	int year;
+};
+
+static volatile sig_atomic_t serve_stop;
+
+static void serve_signal_handler(int sig)
+{
+	(void)sig;
+	serve_stop = 1;
+}
+
+static void refresh_clock(struct serve_clock *clock)
+{
+	time_t now = time(NULL);
+	struct tm local_time;
+
+	if (now < clock->expires)
+		return;
+
+	localtime_r(&now, &local_time);
+	clock->month = local_time.tm_mon + 1;
+	clock->year = local_time.tm_year + 1900;
+	clock->expires = next_local_midnight(now);
+}
+
+/*
+ * Remove a socket file left behind by a daemon that did not shut down,
+ * i.e. one nobody accepts connections on. Other files are left for bind
+ * to report.
+ * Returns: 0 if the path is free to bind or not a socket, 1 if in use
+ */
+static int remove_stale_socket(const struct sockaddr_un *addr)
+{
+	struct stat st;
+	int fd;
+	int ret;
+
+	if (lstat(addr->sun_path, &st) != 0 || !S_ISSOCK(st.st_mode))
+		return 0;
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return 0;
+	ret = connect(fd, (const struct sockaddr *)addr, sizeof(*addr));
+	close(fd);
+	if (ret == 0)
+		return 1;
+
+	if (errno == ECONNREFUSED)
+		unlink(addr->sun_path);
+	return 0;
+}
+
+static int set_nonblocking(int fd)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+
+	if (flags < 0)
+		return -1;
+
+	return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void close_client(int epoll_fd, struct serve_client **clients,
+			 struct serve_client *client)
+{
+	if (client->prev)
+		client->prev->next = client->next;
+	else
+		*clients = client->next;
+	if (client->next)
+		client->next->prev = client->prev;
+
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+	close(client->fd);
+	free(client);
+}
+
+/*
+ * Write pending responses.
+ * Returns: 0 if all were written, 1 if the socket is full, -1 on error
+ */
+static int flush_client(struct serve_client *client)
+{
+	while (client->out_pos < client->out_len) {
+		ssize_t n = write(client->fd, client->out_buf + client->out_pos,
+				  client->out_len - client->out_pos);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return 1;
+			return -1;
+		}
+		client->out_pos += n;
+	}
+
+	client->out_pos = 0;
+	client->out_len = 0;
+	return 0;
+}
+
+/*
+ * Read and answer requests until the socket is drained or responses back up.
+ * Returns: 0 to keep the client, -1 to close it
+ */
+static int serve_client(int epoll_fd, struct serve_client *client,
+			const struct vacation_context *context)
+{
+	struct epoll_event event;
+	int pending;
+
+	for (;;) {
+		size_t num_requests, i;
+		ssize_t n;
+
+		pending = flush_client(client);
+		if (pending != 0)
+			break;
+
+		n = read(client->fd, client->in_buf + client->in_len,
+			 sizeof(client->in_buf) - client->in_len);
+		if (n == 0)
+			return -1;	/* Client closed the connection */
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return 0;
+			return -1;
+		}
+		client->in_len += n;
+
+		num_requests = client->in_len / sizeof(struct vacation_request);
+		for (i = 0; i < num_requests; i++) {
+			struct vacation_request request;
+			struct vacation_response response;
+
+			memcpy(&request, client->in_buf + i * sizeof(request),
+			       sizeof(request));
+			vacation_evaluate(context, &request, &response);
+			memcpy(client->out_buf + client->out_len, &response,
+			       sizeof(response));
+			client->out_len += sizeof(response);
+		}
+
+		/* Keep a partial request for the next read */
+		client->in_len -= num_requests * sizeof(struct vacation_request);
+		memmove(client->in_buf,
+			client->in_buf + num_requests * sizeof(struct vacation_request),
+			client->in_len);
+	}
+
+	if (pending < 0)
+		return -1;
+
+	/* Socket is full: wait until it is writable before reading more */
+	event.events = EPOLLOUT;
+	event.data.ptr = client;
+	return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client->fd, &event);
+}
+
+static void accept_clients(int epoll_fd, int listen_fd,
+			   struct serve_client **clients)
+{
+	struct epoll_event event;
+	struct serve_client *client;
+	int fd;
+
+	for (;;) {
+		fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				perror("Error: accept");
+			return;
+		}
+
+		client = malloc(sizeof(*client));
+		if (!client) {
+			close(fd);
+			continue;
+		}
+		client->fd = fd;
+		client->in_len = 0;
+		client->out_pos = 0;
+		client->out_len = 0;
+
+		event.events = EPOLLIN;
+		event.data.ptr = client;
+		if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+			close(fd);
+			free(client);
+			continue;
+		}
+
+		client->prev = NULL;
+		client->next = *clients;
+		if (*clients)
+			(*clients)->prev = client;
+		*clients = client;
+	}
+}
+
+static int open_listen_socket(const char *socket_path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Error: Socket path too long: %s\n", socket_path);
+		return -1;
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		perror("Error: socket");
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, socket_path);
+
+	if (remove_stale_socket(&addr) != 0) {
+		fprintf(stderr, "Error: Socket %s is in use.\n", socket_path);
+		close(fd);
+		return -1;
+	}
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		fprintf(stderr, "Error: Cannot bind socket %s: %s\n",
+			socket_path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	if (listen(fd, SERVE_BACKLOG) != 0 || set_nonblocking(fd) != 0) {
+		perror("Error: listen");
+		close(fd);
+		unlink(socket_path);
+		return -1;
+	}
+
+	return fd;
+}
+
+int run_server(const char *socket_path,
+	       const struct vacation_args *defaults)
+{
+	struct epoll_event events[SERVE_MAX_EVENTS];
+	struct epoll_event event;
+	struct serve_clock clock = { 0, 0, 0 };
+	struct serve_client *clients = NULL;
+	struct vacation_context context;
+	struct sigaction action;
+	int listen_fd, epoll_fd;
+	int ret = 0;
+	int i, n;
+
+	if (defaults->as_of_set) {
+		clock.month = defaults->as_of.month;
+		clock.year = defaults->as_of.year;
+	}
+
+	/* A signal of an earlier run in this process does not stop this one */
+	serve_stop = 0;
+
+	context.holidays = defaults->holidays;
+	context.policies = defaults->policies;
+	context.policy = defaults->policy;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = serve_signal_handler;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	listen_fd = open_listen_socket(socket_path);
+	if (listen_fd < 0)
+		return 1;
+
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd < 0) {
+		perror("Error: epoll_create1");
+		close(listen_fd);
+		unlink(socket_path);
+		return 1;
+	}
+
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;	/* NULL marks the listening socket */
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+
+	while (!serve_stop) {
+		n = epoll_wait(epoll_fd, events, SERVE_MAX_EVENTS, -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("Error: epoll_wait");
+			ret = 1;
+			break;
+		}
+
+		if (!defaults->as_of_set)
+			refresh_clock(&clock);
+		context.month = clock.month;
+		context.year = clock.year;
+
+		for (i = 0; i < n; i++) {
+			struct serve_client *client = events[i].data.ptr;
+
+			if (!client) {
+				accept_clients(epoll_fd, listen_fd, &clients);
+				continue;
+			}
+
+			if (events[i].events & EPOLLOUT) {
+				int pending = flush_client(client);
+
+				if (pending < 0) {
+					close_client(epoll_fd, &clients, client);
+				} else if (pending == 0) {
+					/* Resume reading once the backlog is written */
+					event.events = EPOLLIN;
+					event.data.ptr = client;
+					epoll_ctl(epoll_fd, EPOLL_CTL_MOD,
+						  client->fd, &event);
+				}
+				continue;
+			}
+
+			if (serve_client(epoll_fd, client, &context) != 0)
+				close_client(epoll_fd, &clients, client);
+		}
+	}
+
+	while (clients)
+		close_client(epoll_fd, &clients, clients);
+	close(epoll_fd);
+	close(listen_fd);
+	unlink(socket_path);
+	return ret;
+}
+
+#endif /* __linux__ */
+
+time_t next_local_midnight(time_t now)
+{
+	struct tm local_time;
+	time_t midnight;
+
+#ifdef _WIN32
+	if (localtime_s(&local_time, &now) != 0)
+		return now + 60 * 60;
+#else
+	if (!localtime_r(&now, &local_time))
+		return now + 60 * 60;
+#endif
+
+	/* Days are 23 or 25 hours long at DST changes */
+	local_time.tm_mday++;
+	local_time.tm_hour = 0;
+	local_time.tm_min = 0;
+	local_time.tm_sec = 0;
+	local_time.tm_isdst = -1;
+	midnight = mktime(&local_time);
+	if (midnight == (time_t)-1 || midnight <= now)
+		midnight = now + 60 * 60;
+
+	return midnight;
+}
+
+#ifndef __linux__
+
+int run_server(const char *socket_path,
+	       const struct vacation_args *defaults)
+{
+	(void)socket_path;
+	(void)defaults;
+	fprintf(stderr, "Error: --serve is only supported on Linux.\n");
+	return 1;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,432 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "vacation.h"
+
+/*
+ * Columnar employee snapshot (--write-snapshot, --snapshot).
+ *
+ * The converter parses an employee file once and writes its columns; runs
+ * map the snapshot read-only and hand the columns to the batch kernel in
+ * place, so loading costs a page table setup instead of parsing.
+ */
+
+/* Column sizes, in the file order */
+#define SNAPSHOT_ID_SIZE	(BATCH_MAX_ID + 1)
+#define SNAPSHOT_NUM_COLUMNS	6
+
+static const size_t snapshot_column_sizes[SNAPSHOT_NUM_COLUMNS] = {
+	SNAPSHOT_ID_SIZE, sizeof(double), sizeof(double),
+	sizeof(int32_t), sizeof(int32_t), sizeof(int32_t)
+};
+
+static int is_little_endian(void)
+{
+	const uint16_t probe = 1;
+
+	return *(const unsigned char *)&probe == 1;
+}
+
+static size_t align8(size_t offset)
+{
+	return (offset + 7) & ~(size_t)7;
+}
+
+/* Column offsets and total file size for count employees */
+static size_t snapshot_layout(size_t count,
+			      size_t offsets[SNAPSHOT_NUM_COLUMNS])
+{
+	size_t offset = SNAPSHOT_HEADER_SIZE;
+	int c;
+
+	for (c = 0; c < SNAPSHOT_NUM_COLUMNS; c++) {
+		offsets[c] = offset;
+		offset = align8(offset + count * snapshot_column_sizes[c]);
+	}
+
+	return offset;
+}
+
+/*
+ * Reading
+ */
+
+#ifdef _WIN32
+static void *map_file(const char *path, size_t *size)
+{
+	HANDLE file, mapping;
+	LARGE_INTEGER file_size;
+	void *map = NULL;
+
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+			   OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	if (GetFileSizeEx(file, &file_size) &&
+	    (unsigned long long)file_size.QuadPart <= (size_t)-1) {
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0,
+					     NULL);
+		if (mapping) {
+			map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+			*size = (size_t)file_size.QuadPart;
+		}
+	}
+
+	CloseHandle(file);
+	return map;
+}
+
+static void unmap_file(void *map, size_t size)
+{
+	(void)size;
+	UnmapViewOfFile(map);
+}
+#else
+static void *map_file(const char *path, size_t *size)
+{
+	struct stat st;
+	void *map = NULL;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) == 0 && st.st_size > 0 &&
+	    (unsigned long long)st.st_size <= (size_t)-1) {
+		map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd,
+			   0);
+		if (map == MAP_FAILED)
+			map = NULL;
+		else
+			*size = (size_t)st.st_size;
+	}
+
+	close(fd);
+	return map;
+}
+
+static void unmap_file(void *map, size_t size)
+{
+	munmap(map, size);
+}
+#endif
+
+int open_snapshot(const char *path, struct vacation_snapshot *snapshot)
+{
+	size_t offsets[SNAPSHOT_NUM_COLUMNS];
+	const unsigned char *base;
+	uint32_t version = 0, header_size = 0;
+	uint64_t count = 0;
+
+	memset(snapshot, 0, sizeof(*snapshot));
+
+	if (!is_little_endian() || sizeof(int) != sizeof(int32_t)) {
+		fprintf(stderr, "Error: Snapshots need a little-endian host with 32-bit int.\n");
+		return 1;
+	}
+
+	snapshot->map = map_file(path, &snapshot->map_size);
+	if (!snapshot->map) {
+		fprintf(stderr, "Error: Cannot map snapshot file: %s\n", path);
+		return 1;
+	}
+	base = snapshot->map;
+
+	if (snapshot->map_size >= SNAPSHOT_HEADER_SIZE) {
+		memcpy(&version, base + 8, sizeof(version));
+		memcpy(&header_size, base + 12, sizeof(header_size));
+		memcpy(&count, base + 16, sizeof(count));
+	}
+
+	/* Bound count first, so the layout cannot overflow */
+	if (snapshot->map_size < SNAPSHOT_HEADER_SIZE ||
+	    memcmp(base, SNAPSHOT_MAGIC, 8) != 0 ||
+	    version != SNAPSHOT_VERSION ||
+	    header_size != SNAPSHOT_HEADER_SIZE ||
+	    count > snapshot->map_size / SNAPSHOT_ID_SIZE ||
+	    snapshot_layout((size_t)count, offsets) != snapshot->map_size) {
+		fprintf(stderr, "Error: Invalid snapshot file: %s\n", path);
+		close_snapshot(snapshot);
+		return 1;
+	}
+
+	snapshot->count = (size_t)count;
+	snapshot->id = (const char (*)[BATCH_MAX_ID + 1])(base + offsets[0]);
+	snapshot->current_hours = (const double *)(base + offsets[1]);
+	snapshot->vacation_extra = (const double *)(base + offsets[2]);
+	snapshot->annual_days = (const int *)(base + offsets[3]);
+	snapshot->max_accum_days = (const int *)(base + offsets[4]);
+	snapshot->week_start = (const int *)(base + offsets[5]);
+
+	return 0;
+}
+
+void close_snapshot(struct vacation_snapshot *snapshot)
+{
+	if (snapshot->map)
+		unmap_file(snapshot->map, snapshot->map_size);
+	memset(snapshot, 0, sizeof(*snapshot));
+}
+
+/*
+ * Conversion
+ */
+
+/* Columns of the converted records, grown as records are added */
+struct snapshot_columns {
+	size_t count;
+	size_t capacity;
+	char (*id)[BATCH_MAX_ID + 1];
+	double *current_hours;
+	double *vacation_extra;
+	int32_t *annual_days;
+	int32_t *max_accum_days;
+	int32_t *week_start;
+};
+
+static int grow_column(void **column, size_t capacity, size_t size)
+{
+	void *grown = realloc(*column, capacity * size);
+
+	if (!grown)
+		return 1;
+	*column = grown;
+	return 0;
+}
+
+static int reserve_snapshot_row(struct snapshot_columns *columns)
+{
+	size_t capacity;
+
+	if (columns->count < columns->capacity)
+		return 0;
+
+	capacity = columns->capacity ? columns->capacity * 2 : 4096;
+	if (grow_column((void **)&columns->id, capacity, SNAPSHOT_ID_SIZE) ||
+	    grow_column((void **)&columns->current_hours, capacity,
+			sizeof(double)) ||
+	    grow_column((void **)&columns->vacation_extra, capacity,
+			sizeof(double)) ||
+	    grow_column((void **)&columns->annual_days, capacity,
+			sizeof(int32_t)) ||
+	    grow_column((void **)&columns->max_accum_days, capacity,
+			sizeof(int32_t)) ||
+	    grow_column((void **)&columns->week_start, capacity,
+			sizeof(int32_t)))
+		return 1;
+
+	columns->capacity = capacity;
+	return 0;
+}
+
+static void free_snapshot_columns(struct snapshot_columns *columns)
+{
+	free(columns->id);
+	free(columns->current_hours);
+	free(columns->vacation_extra);
+	free(columns->annual_days);
+	free(columns->max_accum_days);
+	free(columns->week_start);
+}
+
+/* Check the date-independent fields of a parsed record */
+static int check_snapshot_record(struct batch_record *record)
+{
+	const struct vacation_args *args = &record->args;
+	struct validation_error *error = &record->error;
+
+	if (check_arguments(args, error) != VALIDATION_OK ||
+	    check_annual_days(args->policy, args->annual_days,
+			      error) != VALIDATION_OK)
+		return error->code;
+
+	if (args->vacation_extra < 0)
+		return set_validation_error(error, VALIDATION_EXTRA_NEGATIVE,
+					    0, 0);
+
+	if (strlen(record->id) > BATCH_MAX_ID)
+		return set_validation_error(error, VALIDATION_ID_LENGTH, 0,
+					    BATCH_MAX_ID);
+
+	return VALIDATION_OK;
+}
+
+static void add_snapshot_row(struct snapshot_columns *columns,
+			     const struct batch_record *record)
+{
+	const struct vacation_args *args = &record->args;
+	size_t i = columns->count++;
+
+	/* NUL-padded, so files are reproducible */
+	memset(columns->id[i], 0, SNAPSHOT_ID_SIZE);
+	memcpy(columns->id[i], record->id, strlen(record->id));
+	columns->current_hours[i] = args->current_hours;
+	columns->vacation_extra[i] = args->vacation_extra;
+	columns->annual_days[i] = args->annual_days;
+	columns->max_accum_days[i] = policy_max_accum(args->policy,
+						      args->annual_days,
+						      args->special_accum);
+	columns->week_start[i] = args->week_start;
+}
+
+/* Parse the employee file into columns */
+static int read_snapshot_columns(FILE *in, const struct vacation_args *defaults,
+				 struct snapshot_columns *columns,
+				 unsigned long *num_rejected)
+{
+	char line[BATCH_MAX_LINE + 2];	/* Room for newline and NUL */
+	struct batch_record record;
+	unsigned long line_number = 0;
+	char message[VALIDATION_MAX_MESSAGE];
+
+	while (fgets(line, sizeof(line), in) != NULL) {
+		size_t len = strlen(line);
+
+		line_number++;
+
+		if (len > 0 && line[len - 1] != '\n' && !feof(in)) {
+			int c;
+
+			while ((c = fgetc(in)) != EOF && c != '\n')
+				;
+			set_validation_error(&record.error,
+					     VALIDATION_RECORD_LENGTH, 0,
+					     BATCH_MAX_LINE);
+		} else if (is_batch_skipped_line(line, line_number)) {
+			continue;
+		} else {
+			record.args = *defaults;
+			if (parse_batch_record(line, &record) == 0 &&
+			    check_snapshot_record(&record) == VALIDATION_OK) {
+				if (reserve_snapshot_row(columns) != 0) {
+					fprintf(stderr, "Error: Out of memory.\n");
+					return 1;
+				}
+				add_snapshot_row(columns, &record);
+				continue;
+			}
+		}
+
+		format_validation_error(message, sizeof(message), &record.error);
+		fprintf(stderr, "Error: %s:%lu: %s. Record skipped.\n",
+			defaults->batch_file, line_number, message);
+		(*num_rejected)++;
+	}
+
+	return 0;
+}
+
+/* Write a column, padded to the next column's offset */
+static int write_snapshot_column(FILE *out, const void *column, size_t size)
+{
+	static const char padding[8];
+
+	if (size > 0 && fwrite(column, 1, size, out) != size)
+		return 1;
+
+	size = align8(size) - size;
+	return size > 0 && fwrite(padding, 1, size, out) != size;
+}
+
+static int write_snapshot_file(const char *path,
+			       const struct snapshot_columns *columns)
+{
+	unsigned char header[SNAPSHOT_HEADER_SIZE] = { 0 };
+	const void *data[SNAPSHOT_NUM_COLUMNS];
+	uint32_t version = SNAPSHOT_VERSION;
+	uint32_t header_size = SNAPSHOT_HEADER_SIZE;
+	uint64_t count = columns->count;
+	FILE *out;
+	int ret = 0;
+	int c;
+
+	data[0] = columns->id;
+	data[1] = columns->current_hours;
+	data[2] = columns->vacation_extra;
+	data[3] = columns->annual_days;
+	data[4] = columns->max_accum_days;
+	data[5] = columns->week_start;
+
+	memcpy(header, SNAPSHOT_MAGIC, 8);
+	memcpy(header + 8, &version, sizeof(version));
+	memcpy(header + 12, &header_size, sizeof(header_size));
+	memcpy(header + 16, &count, sizeof(count));
+
+	out = fopen(path, "wb");
+	if (!out) {
+		fprintf(stderr, "Error: Cannot create snapshot file: %s\n", path);
+		return 1;
+	}
+
+	if (fwrite(header, 1, sizeof(header), out) != sizeof(header))
+		ret = 1;
+	for (c = 0; c < SNAPSHOT_NUM_COLUMNS && ret == 0; c++)
+		ret = write_snapshot_column(out, data[c], columns->count *
+					    snapshot_column_sizes[c]);
+
+	if (fclose(out) != 0)
+		ret = 1;
+	if (ret != 0)
+		fprintf(stderr, "Error: Cannot write snapshot file: %s\n", path);
+	return ret;
+}
+
+int write_snapshot(const struct vacation_args *defaults, const char *path)
+{
+	struct snapshot_columns columns;
+	unsigned long num_rejected = 0;
+	FILE *in;
+	int ret;
+
+	if (!is_little_endian() || sizeof(int) != sizeof(int32_t)) {
+		fprintf(stderr, "Error: Snapshots need a little-endian host with 32-bit int.\n");
+		return 1;
+	}
+
+	if (strcmp(defaults->batch_file, "-") == 0) {
+		in = stdin;
+	} else {
+		in = fopen(defaults->batch_file, "r");
+		if (!in) {
+			fprintf(stderr, "Error: Cannot open batch file: %s\n",
+				defaults->batch_file);
+			return 1;
+		}
+	}
+
+	memset(&columns, 0, sizeof(columns));
+	ret = read_snapshot_columns(in, defaults, &columns, &num_rejected);
+
+	if (ferror(in)) {
+		fprintf(stderr, "Error: Failed to read batch file: %s\n",
+			defaults->batch_file);
+		ret = 1;
+	}
+
+	if (in != stdin)
+		fclose(in);
+
+	if (ret == 0)
+		ret = write_snapshot_file(path, &columns);
+
+	if (num_rejected > 0) {
+		fprintf(stderr, "Error: %lu record(s) rejected.\n", num_rejected);
+		ret = 1;
+	}
+
+	free_snapshot_columns(&columns);
+	return ret;
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vacation.h"
+
+/*
+ * Stdin lines mode (--stdin-lines).
+ *
+ * Every input line holds options as on the command line ("-d 20 -c 150.5
+ * -v 3") and goes through the same parse_arguments, prepare_arguments and
+ * run_vacation steps as a single run, inside one process. Holidays and
+ * policies are loaded once; errors only skip their line.
+ */
+
+static int is_blank_char(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+int split_argument_line(char *line, char **argv, int max_args)
+{
+	char *p = line;
+	int argc = 0;
+
+	for (;;) {
+		while (is_blank_char(*p))
+			p++;
+		if (*p == '\0')
+			break;
+
+		if (argc == max_args)
+			return -1;
+		argv[argc++] = p;
+
+		while (*p != '\0' && !is_blank_char(*p))
+			p++;
+		if (*p == '\0')
+			break;
+		*p++ = '\0';
+	}
+
+	return argc;
+}
+
+static int is_blank_or_comment_line(const char *line)
+{
+	while (is_blank_char(*line))
+		line++;
+
+	return *line == '\0' || *line == '#';
+}
+
+/*
+ * Run the options of one line on top of the defaults.
+ * Returns: 0 on success, non-zero if the line was rejected
+ */
+static int process_argument_line(char *line,
+				 const struct vacation_args *defaults,
+				 const struct date *today)
+{
+	char program_name[] = "stdin";	/* argv[0], for parse_arguments */
+	char *argv[LINE_MAX_ARGS + 1];
+	struct vacation_args args = *defaults;
+	struct date date = *today;
+	int argc;
+
+	argv[0] = program_name;
+	argc = split_argument_line(line, argv + 1, LINE_MAX_ARGS);
+	if (argc < 0) {
+		fprintf(stderr, "Error: Too many arguments (max %d).\n",
+			LINE_MAX_ARGS);
+		return 1;
+	}
+
+	/* A line's annual allowance overrides the command-line default */
+	args.annual_days_set = 0;
+	args.annual_hours_set = 0;
+	if (parse_arguments(argc + 1, argv, &args) != 0)
+		return 1;
+	if (!args.annual_days_set && !args.annual_hours_set) {
+		args.annual_days = defaults->annual_days;
+		args.annual_hours = defaults->annual_hours;
+		args.annual_days_set = defaults->annual_days_set;
+		args.annual_hours_set = defaults->annual_hours_set;
+	}
+
+	/* Files and modes are set up once for the whole run */
+	if (args.help || args.batch_file != defaults->batch_file ||
+	    args.serve_socket != defaults->serve_socket ||
+	    args.holidays_file != defaults->holidays_file ||
+	    args.policy_file != defaults->policy_file ||
+	    args.snapshot_file != defaults->snapshot_file ||
+	    args.snapshot_output != defaults->snapshot_output ||
+	    args.previous_file != defaults->previous_file ||
+	    args.journal_file != defaults->journal_file) {
+		fprintf(stderr,
+			"Error: --help, --batch, --serve, --holidays, --policy-file and the snapshot and delta options cannot be given on a line.\n");
+		return 1;
+	}
+
+	if (prepare_arguments(&args) != 0)
+		return 1;
+
+	/* stdin is the input: there is nothing to prompt with */
+	if (!args.current_hours_set) {
+		fprintf(stderr,
+			"Error: Current hours (-c) must be specified on every line.\n");
+		return 1;
+	}
+
+	if (args.output_format == OUTPUT_FORMAT_BIN) {
+		fprintf(stderr,
+			"Error: --stdin-lines supports the text and jsonl formats.\n");
+		return 1;
+	}
+
+	if (args.as_of_set)
+		date = args.as_of;
+
+	return run_vacation(&args, &date);
+}
+
+int run_stdin_lines(const struct vacation_args *defaults,
+		    const struct date *today, FILE *in)
+{
+	char line[BATCH_MAX_LINE + 2];	/* Room for newline and NUL */
+	unsigned long line_number = 0;
+	unsigned long num_rejected = 0;
+	int ret = 0;
+
+	while (fgets(line, sizeof(line), in) != NULL) {
+		size_t len = strlen(line);
+
+		line_number++;
+
+		/* Reject over-long lines and skip the rest of the line */
+		if (len > 0 && line[len - 1] != '\n' && !feof(in)) {
+			int c;
+
+			while ((c = fgetc(in)) != EOF && c != '\n')
+				;
+			fprintf(stderr, "Error: stdin:%lu: Line too long (max %d characters).\n",
+				line_number, BATCH_MAX_LINE);
+			num_rejected++;
+			continue;
+		}
+
+		if (is_blank_or_comment_line(line))
+			continue;
+
+		if (process_argument_line(line, defaults, today) != 0) {
+			fprintf(stderr, "Error: stdin:%lu: Line skipped.\n",
+				line_number);
+			num_rejected++;
+		}
+	}
+
+	if (ferror(in)) {
+		fprintf(stderr, "Error: Failed to read stdin.\n");
+		ret = 1;
+	}
+
+	if (num_rejected > 0) {
+		fprintf(stderr, "Error: %lu line(s) rejected.\n", num_rejected);
+		ret = 1;
+	}
+
+	if (fflush(stdout) != 0)
+		ret = 1;
+	return ret;
+}
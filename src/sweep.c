@@ -0,0 +1,401 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vacation.h"
+
+/*
+ * Scenario sweep (--sweep): one employee projected over a grid of extra
+ * vacation days and current months.
+ *
+ * The grid is evaluated month-major in blocks of BATCH_BLOCK_SIZE points
+ * with the batch kernels. The calendar is only needed for the working days
+ * remaining, which depend on the month alone, so it is consulted once per
+ * month rather than once per point.
+ */
+
+/*
+ * Range parsing
+ */
+
+int parse_sweep_extra(const char *str, struct vacation_sweep *sweep)
+{
+	const char *first_end = strchr(str, ':');
+	const char *last_end;
+	double first, last, step = 1.0;
+
+	if (!first_end)
+		return 1;
+
+	last_end = strchr(first_end + 1, ':');
+	if (parse_number_span(str, first_end - str, &first) != 0)
+		return 1;
+
+	if (last_end) {
+		if (parse_number_span(first_end + 1, last_end - first_end - 1,
+				      &last) != 0 ||
+		    parse_number(last_end + 1, &step) != 0)
+			return 1;
+	} else if (parse_number(first_end + 1, &last) != 0) {
+		return 1;
+	}
+
+	if (!(first >= 0) || !(last >= first) || !(step > 0))
+		return 1;
+
+	/* Also rejects steps too small for the point count to be computed */
+	if ((last - first) / step >= MAX_SWEEP_POINTS)
+		return 1;
+
+	sweep->extra_first = first;
+	sweep->extra_last = last;
+	sweep->extra_step = step;
+	return 0;
+}
+
+int parse_sweep_months(const char *str, struct vacation_sweep *sweep)
+{
+	const char *dash = strchr(str, '-');
+	int first, last;
+
+	if (dash) {
+		if (parse_integer_span(str, dash - str, &first) != 0 ||
+		    parse_integer(dash + 1, &last) != 0)
+			return 1;
+	} else {
+		if (parse_integer(str, &first) != 0)
+			return 1;
+		last = first;
+	}
+
+	if (first < 1 || last > 12 || last < first)
+		return 1;
+
+	sweep->month_first = first;
+	sweep->month_last = last;
+	return 0;
+}
+
+int sweep_num_extras(const struct vacation_sweep *sweep)
+{
+	/* Tolerate steps that do not divide the range exactly in binary */
+	return (int)floor((sweep->extra_last - sweep->extra_first) /
+			  sweep->extra_step + 1e-9) + 1;
+}
+
+double sweep_extra_value(const struct vacation_sweep *sweep, int index)
+{
+	/* Computed from the index so that rounding does not accumulate */
+	return sweep->extra_first + index * sweep->extra_step;
+}
+
+/*
+ * Grid evaluation
+ */
+
+void calculate_vacation_sweep(const struct vacation_input *base,
+			      const struct vacation_sweep *sweep,
+			      struct vacation_result *results)
+{
+	int annual_days[BATCH_BLOCK_SIZE];
+	int max_accum_days[BATCH_BLOCK_SIZE];
+	double current_hours[BATCH_BLOCK_SIZE];
+	double vacation_extra[BATCH_BLOCK_SIZE];
+	int current_month[BATCH_BLOCK_SIZE];
+	double monthly_hours[BATCH_BLOCK_SIZE];
+	double additional_hours[BATCH_BLOCK_SIZE];
+	double additional_days[BATCH_BLOCK_SIZE];
+	double total_hours[BATCH_BLOCK_SIZE];
+	double total_days[BATCH_BLOCK_SIZE];
+	double excess_days[BATCH_BLOCK_SIZE];
+	struct vacation_batch_input in = {
+		annual_days, max_accum_days, current_hours, vacation_extra,
+		current_month
+	};
+	struct vacation_batch_result out = {
+		monthly_hours, additional_hours, additional_days, total_hours,
+		total_days, excess_days
+	};
+	int working_days_remaining[13];
+	int num_extras = sweep_num_extras(sweep);
+	int num_points = num_extras *
+		(sweep->month_last - sweep->month_first + 1);
+	int first, i, month;
+
+	for (month = sweep->month_first; month <= sweep->month_last; month++)
+		working_days_remaining[month] = calendar_remaining_working_days(
+			base->holidays, month, base->current_year,
+			base->week_start);
+
+	for (i = 0; i < BATCH_BLOCK_SIZE; i++) {
+		annual_days[i] = base->annual_days;
+		max_accum_days[i] = base->max_accum_days;
+		current_hours[i] = base->current_hours;
+	}
+
+	for (first = 0; first < num_points; first += BATCH_BLOCK_SIZE) {
+		int count = num_points - first;
+
+		if (count > BATCH_BLOCK_SIZE)
+			count = BATCH_BLOCK_SIZE;
+
+		for (i = 0; i < count; i++) {
+			current_month[i] = sweep->month_first +
+				(first + i) / num_extras;
+			vacation_extra[i] = sweep_extra_value(sweep,
+							      (first + i) % num_extras);
+		}
+
+		calculate_vacation_batch(&in, &out, count);
+
+		for (i = 0; i < count; i++) {
+			struct vacation_result *result = &results[first + i];
+
+			result->remaining_months =
+				calculate_remaining_months(current_month[i]);
+			result->monthly_hours = monthly_hours[i];
+			result->additional_hours = additional_hours[i];
+			result->additional_days = additional_days[i];
+			result->total_hours = total_hours[i];
+			result->total_days = total_days[i];
+			result->excess_days = excess_days[i];
+			result->working_days_remaining =
+				working_days_remaining[current_month[i]];
+		}
+	}
+}
+
+void calculate_vacation_sweep_fixed(const struct vacation_fixed_input *base,
+				    const struct vacation_sweep *sweep,
+				    struct vacation_fixed_result *results)
+{
+	int annual_days[BATCH_BLOCK_SIZE];
+	int max_accum_days[BATCH_BLOCK_SIZE];
+	int64_t current_centi_hours[BATCH_BLOCK_SIZE];
+	int64_t vacation_extra_centi_hours[BATCH_BLOCK_SIZE];
+	int current_month[BATCH_BLOCK_SIZE];
+	int64_t monthly_centi_hours[BATCH_BLOCK_SIZE];
+	int64_t additional_centi_hours[BATCH_BLOCK_SIZE];
+	int64_t total_centi_hours[BATCH_BLOCK_SIZE];
+	int64_t excess_centi_hours[BATCH_BLOCK_SIZE];
+	struct vacation_batch_fixed_input in = {
+		annual_days, max_accum_days, current_centi_hours,
+		vacation_extra_centi_hours, current_month
+	};
+	struct vacation_batch_fixed_result out = {
+		monthly_centi_hours, additional_centi_hours, total_centi_hours,
+		excess_centi_hours
+	};
+	int working_days_remaining[13];
+	int num_extras = sweep_num_extras(sweep);
+	int num_points = num_extras *
+		(sweep->month_last - sweep->month_first + 1);
+	int first, i, month;
+
+	for (month = sweep->month_first; month <= sweep->month_last; month++)
+		working_days_remaining[month] = calendar_remaining_working_days(
+			base->holidays, month, base->current_year,
+			base->week_start);
+
+	for (i = 0; i < BATCH_BLOCK_SIZE; i++) {
+		annual_days[i] = base->annual_days;
+		max_accum_days[i] = base->max_accum_days;
+		current_centi_hours[i] = base->current_centi_hours;
+	}
+
+	for (first = 0; first < num_points; first += BATCH_BLOCK_SIZE) {
+		int count = num_points - first;
+
+		if (count > BATCH_BLOCK_SIZE)
+			count = BATCH_BLOCK_SIZE;
+
+		/* Extras are validated against the working days, always in range */
+		for (i = 0; i < count; i++) {
+			current_month[i] = sweep->month_first +
+				(first + i) / num_extras;
+			days_to_centi_hours(sweep_extra_value(sweep,
+							      (first + i) % num_extras),
+					    &vacation_extra_centi_hours[i]);
+		}
+
+		calculate_vacation_batch_fixed(&in, &out, count);
+
+		for (i = 0; i < count; i++) {
+			struct vacation_fixed_result *result = &results[first + i];
+
+			result->remaining_months =
+				calculate_remaining_months(current_month[i]);
+			result->monthly_centi_hours = monthly_centi_hours[i];
+			result->additional_centi_hours = additional_centi_hours[i];
+			result->total_centi_hours = total_centi_hours[i];
+			result->excess_centi_hours = excess_centi_hours[i];
+			result->working_days_remaining =
+				working_days_remaining[current_month[i]];
+		}
+	}
+}
+
+/*
+ * Output
+ */
+
+static void print_sweep_header(const struct vacation_input *input)
+{
+	char max_hours[RESULT_MAX_VALUE];
+	char current_hours[RESULT_MAX_VALUE];
+
+	format_double_value(max_hours, sizeof(max_hours),
+			    days_to_hours(input->max_accum_days));
+	format_double_value(current_hours, sizeof(current_hours),
+			    input->current_hours);
+
+	printf("=== Vacation Days Calculator: Sweep ===\n\n");
+	printf("Annual vacation: %d hours (%d days)\n",
+	       policy_annual_hours_for_days(input->policy, input->annual_days),
+	       input->annual_days);
+	printf("Maximum accumulation: %s hours (%d days)\n", max_hours,
+	       input->max_accum_days);
+	printf("Current accumulated hours: %s\n\n", current_hours);
+	printf("Expected by the end of %d:\n", input->current_year);
+	printf("%5s %12s %12s %12s\n", "Month", "Extra days", "Total days",
+	       "Excess days");
+}
+
+static void print_sweep_row(const struct vacation_input *input,
+			    const struct vacation_result *result)
+{
+	char extra[RESULT_MAX_VALUE];
+	char total[RESULT_MAX_VALUE];
+	char excess[RESULT_MAX_VALUE];
+
+	format_double_value(extra, sizeof(extra), input->vacation_extra);
+	format_double_value(total, sizeof(total), result->total_days);
+	format_double_value(excess, sizeof(excess), result->excess_days);
+
+	printf("%5d %12s %12s %12s\n", input->current_month, extra, total,
+	       excess);
+}
+
+/* One grid point as a table row, JSON line or binary record */
+static void print_sweep_point(int format, const struct vacation_input *input,
+			      const struct vacation_result *result)
+{
+	unsigned char record[RESULT_RECORD_SIZE];
+	char buf[RESULT_MAX_JSON];
+
+	switch (format) {
+	case OUTPUT_FORMAT_JSONL:
+		fwrite(buf, 1, format_result_json(buf, NULL, input, result),
+		       stdout);
+		break;
+	case OUTPUT_FORMAT_BIN:
+		encode_result_record(record, NULL, input, result);
+		fwrite(record, 1, sizeof(record), stdout);
+		break;
+	default:
+		print_sweep_row(input, result);
+		break;
+	}
+}
+
+int run_sweep(const struct vacation_args *args,
+	      const struct vacation_input *input)
+{
+	struct vacation_sweep sweep = args->sweep;
+	struct vacation_fixed_input fixed_input;
+	struct vacation_fixed_result *fixed_results = NULL;
+	struct vacation_result *results;
+	struct vacation_input point = *input;
+	int num_extras, num_points, i;
+
+	/* Default: from the current month to the end of the year */
+	if (sweep.month_first == 0) {
+		sweep.month_first = input->current_month;
+		sweep.month_last = 12;
+	}
+
+	num_extras = sweep_num_extras(&sweep);
+	num_points = num_extras * (sweep.month_last - sweep.month_first + 1);
+	if (num_points > MAX_SWEEP_POINTS) {
+		fprintf(stderr, "Error: Sweep has more than %d points.\n",
+			MAX_SWEEP_POINTS);
+		return 1;
+	}
+
+	/* The limit on extra days only shrinks as the year goes on */
+	if (validate_vacation_days(sweep_extra_value(&sweep, num_extras - 1),
+				   calendar_working_days_from_prev_month(
+					   input->holidays, sweep.month_last,
+					   input->current_year,
+					   input->week_start)) != 0)
+		return 1;
+
+	if (args->fixed_point) {
+		if (hours_to_centi_hours(input->current_hours,
+					 &fixed_input.current_centi_hours) != 0) {
+			fprintf(stderr,
+				"Error: Current hours out of range for fixed-point mode.\n");
+			return 1;
+		}
+		fixed_input.annual_days = input->annual_days;
+		fixed_input.max_accum_days = input->max_accum_days;
+		fixed_input.current_month = input->current_month;
+		fixed_input.current_year = input->current_year;
+		fixed_input.vacation_extra_centi_hours = 0;
+		fixed_input.week_start = input->week_start;
+		fixed_input.holidays = input->holidays;
+		fixed_input.policy = input->policy;
+	}
+
+	results = malloc(num_points * sizeof(*results));
+	if (args->fixed_point)
+		fixed_results = malloc(num_points * sizeof(*fixed_results));
+	if (!results || (args->fixed_point && !fixed_results)) {
+		fprintf(stderr, "Error: Out of memory.\n");
+		free(results);
+		free(fixed_results);
+		return 1;
+	}
+
+	if (args->fixed_point)
+		calculate_vacation_sweep_fixed(&fixed_input, &sweep, fixed_results);
+	else
+		calculate_vacation_sweep(input, &sweep, results);
+
+	if (args->output_format == OUTPUT_FORMAT_BIN) {
+		unsigned char header[RESULT_HEADER_SIZE];
+
+		if (set_binary_output(stdout) != 0) {
+			fprintf(stderr, "Error: Cannot write binary output.\n");
+			free(results);
+			free(fixed_results);
+			return 1;
+		}
+		encode_result_header(header);
+		fwrite(header, 1, sizeof(header), stdout);
+	} else if (args->output_format == OUTPUT_FORMAT_TEXT) {
+		print_sweep_header(input);
+	}
+
+	for (i = 0; i < num_points; i++) {
+		int month = sweep.month_first + i / num_extras;
+		double extra = sweep_extra_value(&sweep, i % num_extras);
+
+		if (args->fixed_point) {
+			fixed_input.current_month = month;
+			days_to_centi_hours(extra,
+					    &fixed_input.vacation_extra_centi_hours);
+			fixed_to_vacation_result(&fixed_input, &fixed_results[i],
+						 &point, &results[i]);
+		} else {
+			point.current_month = month;
+			point.vacation_extra = extra;
+		}
+		print_sweep_point(args->output_format, &point, &results[i]);
+	}
+
+	free(results);
+	free(fixed_results);
+	return 0;
+}
@@ -1,8 +1,32 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L	/* dup, dup2, fileno, setenv */
+#endif
+
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
+#ifdef _WIN32
+#include <io.h>
+#define dup	_dup
+#define dup2	_dup2
+#define close	_close
+#define fileno	_fileno
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#define TEST_SERVER	/* run_server is tested on a thread */
+#endif
+
 #include "vacation.h"
 
 /* Test framework macros */
@@ -68,6 +92,91 @@ static int tests_failed = 0;
 		} \
 	} while (0)
 
+/* Deterministic pseudo-random numbers for randomized tests */
+static unsigned int test_rand_state = 12345;
+
+static unsigned int test_rand(void)
+{
+	test_rand_state = test_rand_state * 1103515245u + 12345u;
+	return (test_rand_state >> 16) & 0x7fff;
+}
+
+/* Bitwise comparison of doubles */
+static int same_double(double a, double b)
+{
+	return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+/*
+ * Send stdout or stderr to a file, for the run modes that print their
+ * results and diagnostics.
+ * Returns: the descriptor to pass to restore_stream, or -1 on error
+ */
+static int redirect_stream(FILE *stream, const char *path)
+{
+	FILE *file;
+	int saved;
+
+	file = fopen(path, "wb");
+	if (!file)
+		return -1;
+
+	fflush(stream);
+	saved = dup(fileno(stream));
+	if (saved >= 0 && dup2(fileno(file), fileno(stream)) < 0) {
+		close(saved);
+		saved = -1;
+	}
+	fclose(file);
+	return saved;
+}
+
+static void restore_stream(FILE *stream, int saved)
+{
+	fflush(stream);
+	dup2(saved, fileno(stream));
+	close(saved);
+}
+
+/* Read a whole file; returns its length, or -1 if it does not fit */
+static long read_test_file(const char *path, char *buf, size_t size)
+{
+	FILE *file;
+	size_t len;
+
+	file = fopen(path, "rb");
+	if (!file)
+		return -1;
+
+	len = fread(buf, 1, size, file);
+	fclose(file);
+	return len < size ? (long)len : -1;
+}
+
+/* Compare two files byte for byte; returns 1 if they are identical */
+static int same_test_files(const char *path_a, const char *path_b)
+{
+	char buf_a[4096], buf_b[4096];
+	FILE *a, *b;
+	size_t len_a, len_b;
+	int same = 0;
+
+	a = fopen(path_a, "rb");
+	b = fopen(path_b, "rb");
+	if (a && b) {
+		do {
+			len_a = fread(buf_a, 1, sizeof(buf_a), a);
+			len_b = fread(buf_b, 1, sizeof(buf_b), b);
+			same = len_a == len_b && memcmp(buf_a, buf_b, len_a) == 0;
+		} while (same && len_a == sizeof(buf_a));
+	}
+	if (a)
+		fclose(a);
+	if (b)
+		fclose(b);
+	return same;
+}
+
 /*
  * Test: parse_integer
  */
@@ -219,6 +328,125 @@ static void test_parse_number_empty_rejected(void)
 	TEST_PASS();
 }
 
+static void test_parse_number_forms(void)
+{
+	double value;
+
+	TEST_START("parse_number with sign and bare decimal point");
+	ASSERT_INT_EQ(0, parse_number("+7", &value));
+	ASSERT_DOUBLE_EQ(7.0, value);
+	ASSERT_INT_EQ(0, parse_number(".5", &value));
+	ASSERT_DOUBLE_EQ(0.5, value);
+	ASSERT_INT_EQ(0, parse_number("5.", &value));
+	ASSERT_DOUBLE_EQ(5.0, value);
+	ASSERT_INT_EQ(0, parse_number("000150.50", &value));
+	ASSERT_DOUBLE_EQ(150.5, value);
+	TEST_PASS();
+}
+
+static void test_parse_number_malformed_rejected(void)
+{
+	double value;
+
+	TEST_START("parse_number rejects malformed numbers");
+	ASSERT_INT_EQ(1, parse_number(".", &value));
+	ASSERT_INT_EQ(1, parse_number("-", &value));
+	ASSERT_INT_EQ(1, parse_number("1.2.3", &value));
+	ASSERT_INT_EQ(1, parse_number("12,5", &value));
+	ASSERT_INT_EQ(1, parse_number("1 2", &value));
+	ASSERT_INT_EQ(1, parse_number("- 1", &value));
+	TEST_PASS();
+}
+
+static void test_parse_number_span_not_terminated(void)
+{
+	const char *record = "150.5,2.5";
+	double value;
+	int int_value;
+
+	TEST_START("parse_number_span and parse_integer_span on unterminated spans");
+	ASSERT_INT_EQ(0, parse_number_span(record, 5, &value));
+	ASSERT_DOUBLE_EQ(150.5, value);
+	ASSERT_INT_EQ(0, parse_number_span(record + 6, 3, &value));
+	ASSERT_DOUBLE_EQ(2.5, value);
+	ASSERT_INT_EQ(0, parse_integer_span(record, 3, &int_value));
+	ASSERT_INT_EQ(150, int_value);
+	ASSERT_INT_EQ(1, parse_integer_span(record, 5, &int_value));
+	ASSERT_INT_EQ(1, parse_number_span(record, 0, &value));
+	TEST_PASS();
+}
+
+static void test_parse_number_matches_strtod(void)
+{
+	static const char *samples[] = {
+		"0.1", "0.3", "201.6", "8.4", "302.4", "1.005", "123456.789",
+		"9007199254740993", "0.000000000000000000000001",
+		"12345678901234567890.5", "-0", "-0.0", "99999999999999999999"
+	};
+	char buf[64];
+	double value;
+	size_t i;
+	int n;
+
+	TEST_START("parse_number matches strtod bit for bit");
+	for (i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+		ASSERT_INT_EQ(0, parse_number(samples[i], &value));
+		ASSERT_TRUE(same_double(strtod(samples[i], NULL), value));
+	}
+
+	for (n = 0; n < 100000; n++) {
+		snprintf(buf, sizeof(buf), "%u.%0*u", test_rand() % 100000,
+			 (int)(test_rand() % 5) + 1, test_rand() % 10000);
+		ASSERT_INT_EQ(0, parse_number(buf, &value));
+		ASSERT_TRUE(same_double(strtod(buf, NULL), value));
+	}
+	TEST_PASS();
+}
+
+static void test_parse_number_long(void)
+{
+	char buf[512];
+	double value;
+
+	TEST_START("parse_number accepts numbers of any length");
+	/* 1 followed by 300 zeros: 301 digits */
+	buf[0] = '1';
+	memset(buf + 1, '0', 300);
+	buf[301] = '\0';
+	ASSERT_INT_EQ(0, parse_number(buf, &value));
+	ASSERT_TRUE(same_double(strtod(buf, NULL), value));
+
+	/* 0.1 spelled with 400 significant digits still rounds to 0.1 */
+	memcpy(buf, "0.1000000000000000055511151231257827", 36);
+	memset(buf + 36, '0', 400);
+	buf[436] = '\0';
+	ASSERT_INT_EQ(0, parse_number(buf, &value));
+	ASSERT_TRUE(same_double(0.1, value));
+
+	buf[436] = 'x';
+	buf[437] = '\0';
+	ASSERT_INT_EQ(1, parse_number(buf, &value));
+	TEST_PASS();
+}
+
+static void test_parse_integer_range(void)
+{
+	int value;
+
+	TEST_START("parse_integer range limits and sign");
+	ASSERT_INT_EQ(0, parse_integer("2147483647", &value));
+	ASSERT_INT_EQ(2147483647, value);
+	ASSERT_INT_EQ(0, parse_integer("-2147483647", &value));
+	ASSERT_INT_EQ(-2147483647, value);
+	ASSERT_INT_EQ(1, parse_integer("2147483648", &value));
+	ASSERT_INT_EQ(1, parse_integer("-2147483648", &value));
+	ASSERT_INT_EQ(1, parse_integer("99999999999999999999", &value));
+	ASSERT_INT_EQ(0, parse_integer("+12", &value));
+	ASSERT_INT_EQ(12, value);
+	ASSERT_INT_EQ(1, parse_integer("-", &value));
+	TEST_PASS();
+}
+
 /*
  * Test: is_leap_year
  */
@@ -426,6 +654,56 @@ static void test_working_days_invalid_month(void)
 	TEST_PASS();
 }
 
+/* Reference implementation: count working days one day at a time */
+static int count_working_days_by_day(int month, int year, int week_start)
+{
+	int total_days = days_in_month(month, year);
+	int working_days = 0;
+	int day;
+	int dow;
+
+	for (day = 1; day <= total_days; day++) {
+		dow = day_of_week(day, month, year);
+		if (week_start == WEEK_START_SUNDAY) {
+			if (dow >= 0 && dow <= 4)
+				working_days++;
+		} else {
+			if (dow >= 1 && dow <= 5)
+				working_days++;
+		}
+	}
+
+	return working_days;
+}
+
+static void test_working_days_full_cycle(void)
+{
+	int year, month;
+
+	TEST_START("calculate_working_days matches day loop for a 400-year cycle");
+	for (year = 2000; year < 2400; year++) {
+		for (month = 1; month <= 12; month++) {
+			ASSERT_INT_EQ(count_working_days_by_day(month, year, WEEK_START_SUNDAY),
+				      calculate_working_days(month, year, WEEK_START_SUNDAY));
+			ASSERT_INT_EQ(count_working_days_by_day(month, year, WEEK_START_MONDAY),
+				      calculate_working_days(month, year, WEEK_START_MONDAY));
+		}
+	}
+	TEST_PASS();
+}
+
+static void test_working_days_cycle_wraparound(void)
+{
+	TEST_START("calculate_working_days repeats every 400 years");
+	ASSERT_INT_EQ(calculate_working_days(2, 2024, WEEK_START_SUNDAY),
+		      calculate_working_days(2, 1624, WEEK_START_SUNDAY));
+	ASSERT_INT_EQ(calculate_working_days(12, 1999, WEEK_START_MONDAY),
+		      calculate_working_days(12, 2399, WEEK_START_MONDAY));
+	ASSERT_INT_EQ(count_working_days_by_day(3, 1900, WEEK_START_MONDAY),
+		      calculate_working_days(3, 1900, WEEK_START_MONDAY));
+	TEST_PASS();
+}
+
 /*
  * Test: calculate_remaining_working_days
  */
@@ -530,6 +808,323 @@ static void test_working_days_from_prev_month_monday_start(void)
 	TEST_PASS();
 }
 
+/*
+ * Test: working_days_between
+ */
+
+static void next_date(struct date *d)
+{
+	if (d->day < days_in_month(d->month, d->year)) {
+		d->day++;
+	} else if (d->month < 12) {
+		d->month++;
+		d->day = 1;
+	} else {
+		d->year++;
+		d->month = 1;
+		d->day = 1;
+	}
+}
+
+static int date_cmp(struct date a, struct date b)
+{
+	if (a.year != b.year)
+		return a.year - b.year;
+	if (a.month != b.month)
+		return a.month - b.month;
+	return a.day - b.day;
+}
+
+/* Reference implementation: count working days one day at a time */
+static int count_working_days_between_by_day(struct date a, struct date b,
+					     int week_start)
+{
+	int working_days = 0;
+	int dow;
+
+	for (; date_cmp(a, b) <= 0; next_date(&a)) {
+		dow = day_of_week(a.day, a.month, a.year);
+		if (week_start == WEEK_START_SUNDAY) {
+			if (dow >= 0 && dow <= 4)
+				working_days++;
+		} else {
+			if (dow >= 1 && dow <= 5)
+				working_days++;
+		}
+	}
+
+	return working_days;
+}
+
+static void test_working_days_between_leave_period(void)
+{
+	struct date a = { 2024, 12, 12 };
+	struct date b = { 2024, 12, 27 };
+
+	TEST_START("working_days_between December 12-27, 2024");
+	/* Thu 12 .. Fri 27: Sun-Thu weeks give 1 + 5 + 5, Mon-Fri weeks 2 + 5 + 5 */
+	ASSERT_INT_EQ(11, working_days_between(a, b, WEEK_START_SUNDAY));
+	ASSERT_INT_EQ(12, working_days_between(a, b, WEEK_START_MONDAY));
+	TEST_PASS();
+}
+
+static void test_working_days_between_single_day(void)
+{
+	struct date friday = { 2024, 12, 13 };
+	struct date saturday = { 2024, 12, 14 };
+
+	TEST_START("working_days_between single day");
+	ASSERT_INT_EQ(0, working_days_between(friday, friday, WEEK_START_SUNDAY));
+	ASSERT_INT_EQ(1, working_days_between(friday, friday, WEEK_START_MONDAY));
+	ASSERT_INT_EQ(0, working_days_between(saturday, saturday, WEEK_START_SUNDAY));
+	ASSERT_INT_EQ(0, working_days_between(saturday, saturday, WEEK_START_MONDAY));
+	TEST_PASS();
+}
+
+static void test_working_days_between_reversed(void)
+{
+	struct date a = { 2025, 3, 10 };
+	struct date b = { 2025, 3, 9 };
+
+	TEST_START("working_days_between returns 0 for reversed range");
+	ASSERT_INT_EQ(0, working_days_between(a, b, WEEK_START_SUNDAY));
+	TEST_PASS();
+}
+
+static void test_working_days_between_matches_day_loop(void)
+{
+	struct date a = { 2023, 1, 1 };
+	struct date end = { 2025, 12, 31 };
+	struct date b;
+	int i;
+
+	TEST_START("working_days_between matches day loop (2023-2025, ranges up to 60 days)");
+	for (; date_cmp(a, end) <= 0; next_date(&a)) {
+		b = a;
+		for (i = 0; i < 60; i++) {
+			ASSERT_INT_EQ(count_working_days_between_by_day(a, b, WEEK_START_SUNDAY),
+				      working_days_between(a, b, WEEK_START_SUNDAY));
+			ASSERT_INT_EQ(count_working_days_between_by_day(a, b, WEEK_START_MONDAY),
+				      working_days_between(a, b, WEEK_START_MONDAY));
+			next_date(&b);
+		}
+	}
+	TEST_PASS();
+}
+
+static void test_working_days_between_month_ranges(void)
+{
+	struct date a, b;
+	int ws;
+
+	TEST_START("working_days_between matches day loop for all month ranges (1999-2001)");
+	for (ws = WEEK_START_SUNDAY; ws <= WEEK_START_MONDAY; ws++) {
+		for (a.year = 1999; a.year <= 2001; a.year++) {
+			for (a.month = 1, a.day = 1; a.month <= 12; a.month++) {
+				for (b.year = a.year; b.year <= 2001; b.year++) {
+					for (b.month = 1; b.month <= 12; b.month++) {
+						b.day = days_in_month(b.month, b.year);
+						ASSERT_INT_EQ(count_working_days_between_by_day(a, b, ws),
+							      working_days_between(a, b, ws));
+					}
+				}
+			}
+		}
+	}
+	TEST_PASS();
+}
+
+static void test_remaining_working_days_full_cycle(void)
+{
+	int year, month, m, expected;
+
+	TEST_START("calculate_remaining_working_days matches month sums for a 400-year cycle");
+	for (year = 2000; year < 2400; year++) {
+		for (month = 1; month <= 12; month++) {
+			expected = 0;
+			for (m = month; m <= 12; m++)
+				expected += count_working_days_by_day(m, year, WEEK_START_MONDAY);
+			ASSERT_INT_EQ(expected,
+				      calculate_remaining_working_days(month, year, WEEK_START_MONDAY));
+			expected += (month == 1) ?
+				count_working_days_by_day(12, year - 1, WEEK_START_MONDAY) :
+				count_working_days_by_day(month - 1, year, WEEK_START_MONDAY);
+			ASSERT_INT_EQ(expected,
+				      calculate_working_days_from_prev_month(month, year, WEEK_START_MONDAY));
+		}
+	}
+	TEST_PASS();
+}
+
+/*
+ * Test: holiday calendars
+ */
+
+static int is_listed_holiday(const struct date *dates, size_t count,
+			     struct date d)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		if (date_cmp(dates[i], d) == 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+static void test_holiday_calendar_month(void)
+{
+	/* Wednesday December 25 and Saturday December 28, 2024 */
+	struct date dates[] = { { 2024, 12, 25 }, { 2024, 12, 28 } };
+	struct holiday_calendar calendar;
+
+	TEST_START("calendar_working_days skips holidays on working days only");
+	ASSERT_INT_EQ(0, init_holiday_calendar(&calendar, dates, 2));
+	ASSERT_INT_EQ(22, calendar_working_days(&calendar, 12, 2024, WEEK_START_SUNDAY));
+	ASSERT_INT_EQ(21, calendar_working_days(&calendar, 12, 2024, WEEK_START_MONDAY));
+	ASSERT_INT_EQ(calculate_working_days(11, 2024, WEEK_START_SUNDAY),
+		      calendar_working_days(&calendar, 11, 2024, WEEK_START_SUNDAY));
+	ASSERT_INT_EQ(calculate_working_days(12, 2025, WEEK_START_SUNDAY),
+		      calendar_working_days(&calendar, 12, 2025, WEEK_START_SUNDAY));
+	free_holiday_calendar(&calendar);
+	TEST_PASS();
+}
+
+static void test_holiday_calendar_empty(void)
+{
+	struct holiday_calendar calendar;
+
+	TEST_START("empty holiday calendar counts weekends only");
+	ASSERT_INT_EQ(0, init_holiday_calendar(&calendar, NULL, 0));
+	ASSERT_INT_EQ(calculate_remaining_working_days(3, 2025, WEEK_START_MONDAY),
+		      calendar_remaining_working_days(&calendar, 3, 2025,
+						      WEEK_START_MONDAY));
+	ASSERT_INT_EQ(calculate_working_days_from_prev_month(1, 2025, WEEK_START_SUNDAY),
+		      calendar_working_days_from_prev_month(NULL, 1, 2025,
+							    WEEK_START_SUNDAY));
+	free_holiday_calendar(&calendar);
+	TEST_PASS();
+}
+
+static void test_holiday_calendar_invalid(void)
+{
+	struct date invalid[] = { { 2025, 2, 29 } };
+	struct date span[] = { { 1000, 1, 1 }, { 3000, 1, 1 } };
+	struct holiday_calendar calendar;
+
+	TEST_START("init_holiday_calendar rejects invalid dates and long spans");
+	ASSERT_INT_EQ(HOLIDAY_ERR_DATE,
+		      init_holiday_calendar(&calendar, invalid, 1));
+	ASSERT_INT_EQ(HOLIDAY_ERR_SPAN,
+		      init_holiday_calendar(&calendar, span, 2));
+	TEST_PASS();
+}
+
+static void test_holiday_calendar_matches_day_loop(void)
+{
+	struct date dates[120];
+	struct holiday_calendar calendar;
+	struct date a = { 2022, 11, 1 };
+	int i, ws;
+
+	TEST_START("calendar_working_days_between matches a day-by-day count");
+	for (i = 0; i < 120; i++) {
+		dates[i].year = 2023 + (int)(test_rand() % 3);
+		dates[i].month = 1 + (int)(test_rand() % 12);
+		dates[i].day = 1 + (int)(test_rand() % 28);
+	}
+	ASSERT_INT_EQ(0, init_holiday_calendar(&calendar, dates, 120));
+
+	/* Ranges starting every 3rd day, some of them outside the calendar */
+	for (; a.year < 2026 || a.month < 3; next_date(&a), next_date(&a),
+	     next_date(&a)) {
+		struct date b = a;
+		int expected[2] = { 0, 0 };
+		int length;
+
+		for (length = 0; length < 400; length++) {
+			for (ws = WEEK_START_SUNDAY; ws <= WEEK_START_MONDAY; ws++) {
+				int dow = day_of_week(b.day, b.month, b.year);
+				int working = (ws == WEEK_START_SUNDAY) ?
+					dow <= 4 : (dow >= 1 && dow <= 5);
+
+				if (working && !is_listed_holiday(dates, 120, b))
+					expected[ws]++;
+			}
+			if (length % 37 == 0) {
+				ASSERT_INT_EQ(expected[0], calendar_working_days_between(
+					&calendar, a, b, WEEK_START_SUNDAY));
+				ASSERT_INT_EQ(expected[1], calendar_working_days_between(
+					&calendar, a, b, WEEK_START_MONDAY));
+			}
+			next_date(&b);
+		}
+		ASSERT_INT_EQ(0, calendar_working_days_between(&calendar, b, a,
+							       WEEK_START_SUNDAY));
+	}
+	free_holiday_calendar(&calendar);
+	TEST_PASS();
+}
+
+static void test_holiday_calendar_vacation(void)
+{
+	struct date dates[] = { { 2024, 12, 25 } };
+	struct holiday_calendar calendar;
+	struct vacation_input input;
+	struct vacation_result result;
+
+	TEST_START("calculate_vacation excludes holidays from remaining working days");
+	ASSERT_INT_EQ(0, init_holiday_calendar(&calendar, dates, 1));
+	input.annual_days = 24;
+	input.max_accum_days = 36;
+	input.current_hours = 0.0;
+	input.current_month = 12;
+	input.current_year = 2024;
+	input.vacation_extra = 0.0;
+	input.week_start = WEEK_START_SUNDAY;
+	input.holidays = &calendar;
+
+	calculate_vacation(&input, &result);
+
+	ASSERT_INT_EQ(22, result.working_days_remaining);
+	ASSERT_INT_EQ(calculate_working_days_from_prev_month(12, 2024, WEEK_START_SUNDAY) - 1,
+		      calendar_working_days_from_prev_month(&calendar, 12, 2024,
+							    WEEK_START_SUNDAY));
+	free_holiday_calendar(&calendar);
+	TEST_PASS();
+}
+
+static void test_load_holiday_calendar(void)
+{
+	const char *path = "test_holidays.tmp";
+	struct holiday_calendar calendar;
+	FILE *file;
+
+	TEST_START("load_holiday_calendar reads dates, descriptions and comments");
+	file = fopen(path, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs("# Company holidays\n\n2024-12-25 Christmas Day\n"
+	      "  2024-12-26,Boxing Day\n2024-12-28\n", file);
+	fclose(file);
+
+	ASSERT_INT_EQ(0, load_holiday_calendar(path, &calendar));
+	ASSERT_INT_EQ(2024, calendar.first_year);
+	ASSERT_INT_EQ(1, calendar.num_years);
+	ASSERT_INT_EQ(21, calendar_working_days(&calendar, 12, 2024, WEEK_START_SUNDAY));
+	free_holiday_calendar(&calendar);
+
+	file = fopen(path, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs("2024-12-25\n2024-13-01\n", file);
+	fclose(file);
+	ASSERT_INT_EQ(1, load_holiday_calendar(path, &calendar));
+
+	remove(path);
+	ASSERT_INT_EQ(1, load_holiday_calendar(path, &calendar));
+	TEST_PASS();
+}
+
 /*
  * Test: validate_vacation_days
  */
@@ -660,6 +1255,74 @@ static void test_validate_annual_days_very_large(void)
 	TEST_PASS();
 }
 
+/*
+ * Test: structured validation errors
+ */
+
+static void test_check_vacation_days_errors(void)
+{
+	struct validation_error error;
+
+	TEST_START("check_vacation_days stores codes and values");
+	ASSERT_INT_EQ(VALIDATION_OK, check_vacation_days(5.0, 250, &error));
+	ASSERT_INT_EQ(VALIDATION_EXTRA_NEGATIVE,
+		      check_vacation_days(-0.5, 250, &error));
+	ASSERT_INT_EQ(VALIDATION_EXTRA_NEGATIVE, error.code);
+	ASSERT_INT_EQ(VALIDATION_EXTRA_RANGE,
+		      check_vacation_days(251.0, 250, &error));
+	ASSERT_DOUBLE_EQ(251.0, error.number);
+	ASSERT_INT_EQ(250, error.limit);
+	TEST_PASS();
+}
+
+static void test_check_arguments_errors(void)
+{
+	struct vacation_args args;
+	struct validation_error error;
+
+	TEST_START("check_arguments and check_annual_days store codes");
+	init_vacation_args(&args);
+	ASSERT_INT_EQ(VALIDATION_ANNUAL_MISSING, check_arguments(&args, &error));
+
+	args.annual_days_set = 1;
+	ASSERT_INT_EQ(VALIDATION_OK, check_arguments(&args, &error));
+
+	args.annual_hours_set = 1;
+	ASSERT_INT_EQ(VALIDATION_ANNUAL_BOTH, check_arguments(&args, &error));
+
+	ASSERT_INT_EQ(VALIDATION_OK, check_annual_days(NULL, 20, &error));
+	ASSERT_INT_EQ(VALIDATION_ANNUAL_DAYS, check_annual_days(NULL, 25, &error));
+	ASSERT_INT_EQ(25, error.value);
+	TEST_PASS();
+}
+
+static void test_format_validation_error(void)
+{
+	struct validation_error error;
+	char buf[VALIDATION_MAX_MESSAGE];
+	char long_text[] = "0123456789012345678901234567890123456789";
+
+	TEST_START("format_validation_error renders every code");
+	check_vacation_days(251.0, 250, &error);
+	format_validation_error(buf, sizeof(buf), &error);
+	ASSERT_TRUE(strcmp(buf, "Extra vacation days consumption (251.0) cannot exceed working days from start of previous month (250)") == 0);
+
+	set_validation_error(&error, VALIDATION_ID_LENGTH, 0, BATCH_MAX_ID);
+	format_validation_error(buf, sizeof(buf), &error);
+	ASSERT_TRUE(strcmp(buf, "Employee ID too long (max 31 characters)") == 0);
+
+	/* Field text is truncated to VALIDATION_MAX_TEXT characters */
+	set_validation_text(&error, VALIDATION_WEEK_START_FORMAT, long_text);
+	ASSERT_INT_EQ(VALIDATION_MAX_TEXT, (int)strlen(error.text));
+	format_validation_error(buf, sizeof(buf), &error);
+	ASSERT_TRUE(strncmp(buf, "Invalid week start: 0123", 24) == 0);
+
+	for (error.code = 0; error.code < VALIDATION_NUM_CODES; error.code++)
+		ASSERT_TRUE(format_validation_error(buf, sizeof(buf), &error) <
+			    VALIDATION_MAX_MESSAGE);
+	TEST_PASS();
+}
+
 /*
  * Test: calculate_max_accum - normal case (always 36)
  */
@@ -731,6 +1394,139 @@ static void test_max_accum_special_24_days(void)
 	TEST_PASS();
 }
 
+/*
+ * Test: accrual policies
+ */
+
+static void test_compile_policy_builtin(void)
+{
+	struct policy_rules rules;
+	struct vacation_policy policy;
+	int i;
+
+	TEST_START("compile_policy of the built-in options matches the built-in policy");
+	rules.id = 0;
+	rules.num_options = NUM_VALID_ANNUAL_OPTIONS;
+	for (i = 0; i < NUM_VALID_ANNUAL_OPTIONS; i++) {
+		rules.days[i] = VALID_ANNUAL_DAYS[i];
+		rules.hours[i] = VALID_ANNUAL_HOURS[i];
+	}
+	rules.max_accum_days = MIN_MAX_ACCUM_DAYS;
+	rules.special_accum_from = 18;
+	rules.special_accum_factor = 2;
+
+	ASSERT_INT_EQ(0, compile_policy(&rules, &policy));
+	ASSERT_TRUE(memcmp(&policy, find_policy(NULL, 0), sizeof(policy)) == 0);
+
+	/* Duplicate days are rejected */
+	rules.days[1] = rules.days[0];
+	ASSERT_INT_EQ(1, compile_policy(&rules, &policy));
+	TEST_PASS();
+}
+
+static void test_policy_lookups(void)
+{
+	int days;
+
+	TEST_START("policy lookups match the built-in functions");
+	for (days = -1; days <= POLICY_MAX_DAYS; days++) {
+		ASSERT_INT_EQ(is_valid_annual_days(days),
+			      policy_is_valid_annual_days(NULL, days));
+		ASSERT_INT_EQ(calculate_max_accum(days, 1),
+			      policy_max_accum(NULL, days, 1));
+	}
+	ASSERT_INT_EQ(202, policy_annual_hours_for_days(NULL, 24));
+	ASSERT_INT_EQ(210, policy_annual_hours_for_days(NULL, 25));
+	ASSERT_INT_EQ(1, policy_is_valid_annual_hours(NULL, 126, &days));
+	ASSERT_INT_EQ(15, days);
+	ASSERT_INT_EQ(0, policy_is_valid_annual_hours(NULL, POLICY_MAX_HOURS, NULL));
+	ASSERT_INT_EQ(0, policy_is_valid_annual_hours(NULL, -1, NULL));
+	TEST_PASS();
+}
+
+static void test_load_policy_file(void)
+{
+	const char *path = "test_policies.tmp";
+	const struct vacation_policy *policy;
+	struct policy_set set;
+	char long_line[256];
+	FILE *file;
+	int days;
+
+	TEST_START("load_policy_file reads sections, settings and comments");
+	file = fopen(path, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs("# Subsidiaries\n\n[policy 2]\noption = 20 170 # 8.5 h days\n"
+	      "option = 25 212\nmax_accum_days = 40\n"
+	      "special_accum_from = 25\nspecial_accum_factor = 3\n\n"
+	      "[policy 7]\n  option=15 126\n", file);
+	fclose(file);
+
+	ASSERT_INT_EQ(0, load_policy_file(path, &set));
+	policy = find_policy(&set, 2);
+	ASSERT_TRUE(policy != NULL);
+	ASSERT_INT_EQ(2, policy->id);
+	ASSERT_INT_EQ(1, policy_is_valid_annual_hours(policy, 212, &days));
+	ASSERT_INT_EQ(25, days);
+	ASSERT_INT_EQ(0, policy_is_valid_annual_hours(policy, 202, NULL));
+	ASSERT_INT_EQ(0, policy_is_valid_annual_days(policy, 24));
+	ASSERT_INT_EQ(170, policy_annual_hours_for_days(policy, 20));
+	ASSERT_INT_EQ(40, policy_max_accum(policy, 25, 0));
+	ASSERT_INT_EQ(40, policy_max_accum(policy, 20, 1));
+	ASSERT_INT_EQ(75, policy_max_accum(policy, 25, 1));
+
+	/* Unset rules default to the built-in ones */
+	policy = find_policy(&set, 7);
+	ASSERT_TRUE(policy != NULL);
+	ASSERT_INT_EQ(36, policy_max_accum(policy, 15, 1));
+	ASSERT_TRUE(find_policy(&set, 3) == NULL);
+	ASSERT_TRUE(find_policy(&set, POLICY_MAX_ID + 1) == NULL);
+	ASSERT_TRUE(find_policy(&set, 0) == find_policy(NULL, 0));
+	free_policy_set(&set);
+
+	file = fopen(path, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs("[policy 2]\noption = 20 170\n[policy 2]\noption = 21 178\n", file);
+	fclose(file);
+	ASSERT_INT_EQ(1, load_policy_file(path, &set));
+
+	file = fopen(path, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs("option = 20 170\n", file);
+	fclose(file);
+	ASSERT_INT_EQ(1, load_policy_file(path, &set));
+
+	file = fopen(path, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs("[policy 1]\noption = 20 170 5\n", file);
+	fclose(file);
+	ASSERT_INT_EQ(1, load_policy_file(path, &set));
+
+	/* A comment of the longest accepted length, then one a byte longer
+	 * whose tail must not be read as a setting */
+	memset(long_line, '#', sizeof(long_line));
+	file = fopen(path, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs("[policy 1]\n", file);
+	fwrite(long_line, 1, 256, file);
+	fputs("\noption = 20 170\n", file);
+	fclose(file);
+	ASSERT_INT_EQ(0, load_policy_file(path, &set));
+	free_policy_set(&set);
+
+	file = fopen(path, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs("[policy 1]\n", file);
+	fwrite(long_line, 1, 255, file);
+	fputs("option = 20 170\n", file);
+	fclose(file);
+	ASSERT_INT_EQ(1, load_policy_file(path, &set));
+
+	remove(path);
+	ASSERT_INT_EQ(1, load_policy_file(path, &set));
+	TEST_PASS();
+}
+
 /*
  * Test: hours_to_days
  */
@@ -1072,6 +1868,7 @@ static void test_calculate_vacation_full_year_january(void)
 	input.current_year = 2025;
 	input.vacation_extra = 0.0;
 	input.week_start = WEEK_START_SUNDAY;
+	input.holidays = NULL;
 
 	calculate_vacation(&input, &result);
 
@@ -1095,6 +1892,7 @@ static void test_calculate_vacation_december_excess(void)
 	input.current_year = 2024;
 	input.vacation_extra = 0.0;
 	input.week_start = WEEK_START_SUNDAY;
+	input.holidays = NULL;
 
 	calculate_vacation(&input, &result);
 
@@ -1118,6 +1916,7 @@ static void test_calculate_vacation_with_vacation_extra(void)
 	input.current_year = 2024;
 	input.vacation_extra = 5.0;	/* Extra 5 days */
 	input.week_start = WEEK_START_SUNDAY;
+	input.holidays = NULL;
 
 	calculate_vacation(&input, &result);
 
@@ -1140,6 +1939,7 @@ static void test_calculate_vacation_with_half_day_vacation(void)
 	input.current_year = 2024;
 	input.vacation_extra = 2.5;	/* Extra 2.5 days */
 	input.week_start = WEEK_START_SUNDAY;
+	input.holidays = NULL;
 
 	calculate_vacation(&input, &result);
 
@@ -1161,6 +1961,7 @@ static void test_calculate_vacation_vacation_prevents_excess(void)
 	input.current_year = 2024;
 	input.vacation_extra = 6.0;	/* Extra enough to avoid excess */
 	input.week_start = WEEK_START_SUNDAY;
+	input.holidays = NULL;
 
 	calculate_vacation(&input, &result);
 
@@ -1183,6 +1984,7 @@ static void test_calculate_vacation_remaining_days_sunday(void)
 	input.current_year = 2024;
 	input.vacation_extra = 0.0;
 	input.week_start = WEEK_START_SUNDAY;
+	input.holidays = NULL;
 
 	calculate_vacation(&input, &result);
 
@@ -1203,6 +2005,7 @@ static void test_calculate_vacation_remaining_days_monday(void)
 	input.current_year = 2024;
 	input.vacation_extra = 0.0;
 	input.week_start = WEEK_START_MONDAY;
+	input.holidays = NULL;
 
 	calculate_vacation(&input, &result);
 
@@ -1211,77 +2014,1895 @@ static void test_calculate_vacation_remaining_days_monday(void)
 }
 
 /*
- * Test: init_vacation_args
+ * Test: calculate_vacation_batch
  */
 
-static void test_init_vacation_args(void)
+#define BATCH_TEST_SIZE 1003	/* Not a multiple of the SIMD width */
+
+static void test_calculate_vacation_batch_bit_identical(void)
 {
-	struct vacation_args args;
+	static int annual_days[BATCH_TEST_SIZE];
+	static int max_accum_days[BATCH_TEST_SIZE];
+	static double current_hours[BATCH_TEST_SIZE];
+	static double vacation_extra[BATCH_TEST_SIZE];
+	static int current_month[BATCH_TEST_SIZE];
+	static double results[2][6][BATCH_TEST_SIZE];
+	struct vacation_batch_input in;
+	struct vacation_batch_result out[2];
+	struct vacation_input input;
+	struct vacation_result result;
+	int i, k;
+
+	TEST_START("calculate_vacation_batch bit-identical to calculate_vacation");
+	for (i = 0; i < BATCH_TEST_SIZE; i++) {
+		annual_days[i] = MIN_ANNUAL_DAYS + (int)(test_rand() % 10);
+		max_accum_days[i] = calculate_max_accum(annual_days[i], i % 2);
+		current_hours[i] = (double)(test_rand() % 50000) / 100.0;
+		vacation_extra[i] = (double)(test_rand() % 40) / 2.0;
+		current_month[i] = (int)(test_rand() % 14);	/* 0 and 13 invalid */
+	}
 
-	TEST_START("init_vacation_args sets defaults");
-	init_vacation_args(&args);
+	in.annual_days = annual_days;
+	in.max_accum_days = max_accum_days;
+	in.current_hours = current_hours;
+	in.vacation_extra = vacation_extra;
+	in.current_month = current_month;
+	for (k = 0; k < 2; k++) {
+		out[k].monthly_hours = results[k][0];
+		out[k].additional_hours = results[k][1];
+		out[k].additional_days = results[k][2];
+		out[k].total_hours = results[k][3];
+		out[k].total_days = results[k][4];
+		out[k].excess_days = results[k][5];
+	}
 
-	ASSERT_INT_EQ(0, args.annual_days);	/* No default - must be set */
-	ASSERT_DOUBLE_EQ(0.0, args.current_hours);
-	ASSERT_INT_EQ(0, args.annual_days_set);
-	ASSERT_INT_EQ(0, args.annual_hours_set);
-	ASSERT_INT_EQ(0, args.current_hours_set);
-	ASSERT_DOUBLE_EQ(0.0, args.vacation_extra);
-	ASSERT_INT_EQ(0, args.vacation_extra_set);
+	calculate_vacation_batch(&in, &out[0], BATCH_TEST_SIZE);
+	calculate_vacation_batch_scalar(&in, &out[1], BATCH_TEST_SIZE);
+
+	for (i = 0; i < BATCH_TEST_SIZE; i++) {
+		input.annual_days = annual_days[i];
+		input.max_accum_days = max_accum_days[i];
+		input.current_hours = current_hours[i];
+		input.current_month = current_month[i];
+		input.current_year = 2025;
+		input.vacation_extra = vacation_extra[i];
+		input.week_start = WEEK_START_SUNDAY;
+		input.holidays = NULL;
+		calculate_vacation(&input, &result);
+
+		for (k = 0; k < 2; k++) {
+			ASSERT_TRUE(same_double(result.monthly_hours, out[k].monthly_hours[i]));
+			ASSERT_TRUE(same_double(result.additional_hours, out[k].additional_hours[i]));
+			ASSERT_TRUE(same_double(result.additional_days, out[k].additional_days[i]));
+			ASSERT_TRUE(same_double(result.total_hours, out[k].total_hours[i]));
+			ASSERT_TRUE(same_double(result.total_days, out[k].total_days[i]));
+			ASSERT_TRUE(same_double(result.excess_days, out[k].excess_days[i]));
+		}
+	}
+	TEST_PASS();
+}
+
+static void test_calculate_vacation_batch_empty(void)
+{
+	struct vacation_batch_input in = { NULL, NULL, NULL, NULL, NULL };
+	struct vacation_batch_result out = { NULL, NULL, NULL, NULL, NULL, NULL };
+
+	TEST_START("calculate_vacation_batch with zero records");
+	calculate_vacation_batch(&in, &out, 0);
+	TEST_PASS();
+}
+
+/*
+ * Test: fixed-point mode
+ */
+
+static void test_centi_hours_conversions(void)
+{
+	int64_t centi_hours;
+
+	TEST_START("hours_to_centi_hours and days_to_centi_hours");
+	ASSERT_INT_EQ(0, hours_to_centi_hours(201.6, &centi_hours));
+	ASSERT_INT_EQ(20160, (int)centi_hours);
+	ASSERT_INT_EQ(0, hours_to_centi_hours(-0.07, &centi_hours));
+	ASSERT_INT_EQ(-7, (int)centi_hours);
+	ASSERT_INT_EQ(0, days_to_centi_hours(2.5, &centi_hours));
+	ASSERT_INT_EQ(2100, (int)centi_hours);
+	ASSERT_INT_EQ(1, hours_to_centi_hours(2 * MAX_FIXED_HOURS, &centi_hours));
+	ASSERT_INT_EQ(1, hours_to_centi_hours(NAN, &centi_hours));
+	ASSERT_INT_EQ(1, days_to_centi_hours(MAX_FIXED_HOURS, &centi_hours));
+	TEST_PASS();
+}
+
+static void test_centi_hours_to_centi_days(void)
+{
+	TEST_START("centi_hours_to_centi_days rounds half away from zero");
+	ASSERT_INT_EQ(100, (int)centi_hours_to_centi_days(WORK_DAY_CENTI_HOURS));
+	ASSERT_INT_EQ(2400, (int)centi_hours_to_centi_days(20160));
+	ASSERT_INT_EQ(3, (int)centi_hours_to_centi_days(21));	/* 0.025 */
+	ASSERT_INT_EQ(-3, (int)centi_hours_to_centi_days(-21));
+	ASSERT_INT_EQ(2, (int)centi_hours_to_centi_days(20));	/* 0.0238 */
+	ASSERT_INT_EQ(0, (int)centi_hours_to_centi_days(0));
+	TEST_PASS();
+}
+
+static void test_format_centi_value(void)
+{
+	char fixed[32], floating[32];
+	int value;
+
+	TEST_START("format_centi_value matches format_double_value");
+	for (value = -100000; value <= 100000; value++) {
+		ASSERT_INT_EQ(format_double_value(floating, sizeof(floating),
+						  value / 100.0),
+			      format_centi_value(fixed, sizeof(fixed), value));
+		ASSERT_TRUE(strcmp(floating, fixed) == 0);
+	}
+	ASSERT_INT_EQ(-1, format_centi_value(fixed, 4, 12345));
+	TEST_PASS();
+}
+
+static void test_calculate_vacation_fixed_exact(void)
+{
+	struct vacation_fixed_input input;
+	struct vacation_fixed_result result;
+
+	TEST_START("calculate_vacation_fixed is exact in centi-hours");
+	input.annual_days = 24;
+	input.max_accum_days = 36;
+	input.current_centi_hours = 10030;	/* 100.3 hours */
+	input.current_month = 1;
+	input.current_year = 2025;
+	input.vacation_extra_centi_hours = 0;
+	input.week_start = WEEK_START_SUNDAY;
+	input.holidays = NULL;
+
+	calculate_vacation_fixed(&input, &result);
+
+	ASSERT_INT_EQ(12, result.remaining_months);
+	ASSERT_INT_EQ(1680, (int)result.monthly_centi_hours);
+	ASSERT_INT_EQ(20160, (int)result.additional_centi_hours);
+	ASSERT_INT_EQ(30190, (int)result.total_centi_hours);
+	ASSERT_INT_EQ(0, (int)result.excess_centi_hours);
+	ASSERT_INT_EQ(3594, (int)centi_hours_to_centi_days(result.total_centi_hours));
+	TEST_PASS();
+}
+
+static void test_calculate_vacation_fixed_matches_double(void)
+{
+	struct vacation_input input;
+	struct vacation_result result;
+	struct vacation_fixed_input fixed_input;
+	struct vacation_fixed_result fixed_result;
+
+	TEST_START("calculate_vacation_fixed matches calculate_vacation (December excess)");
+	input.annual_days = 24;
+	input.max_accum_days = 36;
+	input.current_hours = 336.0;
+	input.current_month = 12;
+	input.current_year = 2025;
+	input.vacation_extra = 0.5;
+	input.week_start = WEEK_START_MONDAY;
+	input.holidays = NULL;
+	calculate_vacation(&input, &result);
+
+	fixed_input.annual_days = input.annual_days;
+	fixed_input.max_accum_days = input.max_accum_days;
+	fixed_input.current_centi_hours = 33600;
+	fixed_input.current_month = input.current_month;
+	fixed_input.current_year = input.current_year;
+	fixed_input.vacation_extra_centi_hours = 420;
+	fixed_input.week_start = input.week_start;
+	fixed_input.holidays = NULL;
+	calculate_vacation_fixed(&fixed_input, &fixed_result);
+
+	ASSERT_INT_EQ(result.remaining_months, fixed_result.remaining_months);
+	ASSERT_INT_EQ(result.working_days_remaining,
+		      fixed_result.working_days_remaining);
+	ASSERT_DOUBLE_EQ(result.total_hours,
+			 fixed_result.total_centi_hours / 100.0);
+	ASSERT_DOUBLE_EQ(days_to_hours(result.excess_days),
+			 fixed_result.excess_centi_hours / 100.0);
+	ASSERT_INT_EQ(4620, (int)fixed_result.excess_centi_hours);
+	TEST_PASS();
+}
+
+static void test_calculate_vacation_batch_fixed(void)
+{
+	static int annual_days[BATCH_TEST_SIZE];
+	static int max_accum_days[BATCH_TEST_SIZE];
+	static int64_t current_centi_hours[BATCH_TEST_SIZE];
+	static int64_t vacation_extra_centi_hours[BATCH_TEST_SIZE];
+	static int current_month[BATCH_TEST_SIZE];
+	static int64_t results[4][BATCH_TEST_SIZE];
+	struct vacation_batch_fixed_input in;
+	struct vacation_batch_fixed_result out;
+	struct vacation_fixed_input input;
+	struct vacation_fixed_result result;
+	int i;
+
+	TEST_START("calculate_vacation_batch_fixed matches calculate_vacation_fixed");
+	for (i = 0; i < BATCH_TEST_SIZE; i++) {
+		annual_days[i] = MIN_ANNUAL_DAYS + (int)(test_rand() % 10);
+		max_accum_days[i] = calculate_max_accum(annual_days[i], i % 2);
+		current_centi_hours[i] = (int64_t)(test_rand() % 50000);
+		vacation_extra_centi_hours[i] = (int64_t)(test_rand() % 40) * 420;
+		current_month[i] = (int)(test_rand() % 14);	/* 0 and 13 invalid */
+	}
+
+	in.annual_days = annual_days;
+	in.max_accum_days = max_accum_days;
+	in.current_centi_hours = current_centi_hours;
+	in.vacation_extra_centi_hours = vacation_extra_centi_hours;
+	in.current_month = current_month;
+	out.monthly_centi_hours = results[0];
+	out.additional_centi_hours = results[1];
+	out.total_centi_hours = results[2];
+	out.excess_centi_hours = results[3];
+
+	calculate_vacation_batch_fixed(&in, &out, BATCH_TEST_SIZE);
+
+	for (i = 0; i < BATCH_TEST_SIZE; i++) {
+		input.annual_days = annual_days[i];
+		input.max_accum_days = max_accum_days[i];
+		input.current_centi_hours = current_centi_hours[i];
+		input.current_month = current_month[i];
+		input.current_year = 2025;
+		input.vacation_extra_centi_hours = vacation_extra_centi_hours[i];
+		input.week_start = WEEK_START_SUNDAY;
+		input.holidays = NULL;
+		calculate_vacation_fixed(&input, &result);
+
+		ASSERT_TRUE(result.monthly_centi_hours == results[0][i]);
+		ASSERT_TRUE(result.additional_centi_hours == results[1][i]);
+		ASSERT_TRUE(result.total_centi_hours == results[2][i]);
+		ASSERT_TRUE(result.excess_centi_hours == results[3][i]);
+	}
+	TEST_PASS();
+}
+
+/*
+ * Test: output formatting
+ */
+
+/* Reference formatter: snprintf "%.2f" with trailing zeros trimmed */
+static int reference_format_value(char *buf, size_t size, double value)
+{
+	int len = snprintf(buf, size, "%.2f", value);
+
+	while (len > 0 && buf[len - 1] == '0')
+		buf[--len] = '\0';
+	if (len > 0 && buf[len - 1] == '.')
+		buf[--len] = '\0';
+
+	return len;
+}
+
+static int format_matches_reference(double value)
+{
+	char expected[400], actual[400];
+	int expected_len, actual_len;
+
+	expected_len = reference_format_value(expected, sizeof(expected), value);
+	actual_len = format_double_value(actual, sizeof(actual), value);
+
+	return expected_len == actual_len && strcmp(expected, actual) == 0;
+}
+
+static void test_format_double_value_special(void)
+{
+	char buf[8];
+
+	TEST_START("format_double_value special values and ties");
+	ASSERT_TRUE(format_matches_reference(0.0));
+	ASSERT_TRUE(format_matches_reference(-0.0));
+	ASSERT_TRUE(format_matches_reference(-0.001));
+	ASSERT_TRUE(format_matches_reference(0.125));	/* Exact tie, to even */
+	ASSERT_TRUE(format_matches_reference(0.375));
+	ASSERT_TRUE(format_matches_reference(2.675));	/* Just below the tie */
+	ASSERT_TRUE(format_matches_reference(1.005));
+	ASSERT_TRUE(format_matches_reference(201.6));
+	ASSERT_TRUE(format_matches_reference(9999999999999.995));
+	ASSERT_TRUE(format_matches_reference(1e13));
+	ASSERT_TRUE(format_matches_reference(-1e300));
+	ASSERT_TRUE(format_matches_reference(INFINITY));
+	ASSERT_TRUE(format_matches_reference(NAN));
+	ASSERT_INT_EQ(-1, format_double_value(buf, sizeof(buf), 12345.67));
+	ASSERT_INT_EQ(7, format_double_value(buf, sizeof(buf), 1234.67));
+	TEST_PASS();
+}
+
+static void test_format_double_value_matches_snprintf(void)
+{
+	int i;
+
+	TEST_START("format_double_value matches snprintf for random values");
+	for (i = 0; i < 300000; i++) {
+		/* Random magnitudes from 1e-4 to 1e14 */
+		double mantissa = (double)test_rand() * 32768.0 + test_rand();
+		double value = mantissa / 1073741824.0 *
+			pow(10.0, (int)(test_rand() % 19) - 4);
+
+		if (i & 1)
+			value = -value;
+		ASSERT_TRUE(format_matches_reference(value));
+	}
+
+	/* Every multiple of 1/8 (exact ties) and of 1/1000 up to 10 */
+	for (i = 0; i <= 80; i++)
+		ASSERT_TRUE(format_matches_reference(i / 8.0));
+	for (i = 0; i <= 10000; i++)
+		ASSERT_TRUE(format_matches_reference(i / 1000.0));
+	TEST_PASS();
+}
+
+/* Reference renderer: the printf sequence of the original print_results */
+static void reference_format_results(char *buf, size_t size,
+				     const struct vacation_input *input,
+				     const struct vacation_result *result)
+{
+	static const char *months[] = {
+		"January", "February", "March", "April", "May", "June", "July",
+		"August", "September", "October", "November", "December"
+	};
+	char v[7][400];
+	size_t len;
+
+	reference_format_value(v[0], sizeof(v[0]), days_to_hours(input->max_accum_days));
+	reference_format_value(v[1], sizeof(v[1]), input->current_hours);
+	reference_format_value(v[2], sizeof(v[2]), result->additional_days);
+	reference_format_value(v[3], sizeof(v[3]), result->additional_hours);
+	reference_format_value(v[4], sizeof(v[4]), result->total_hours);
+	reference_format_value(v[5], sizeof(v[5]), result->total_days);
+	reference_format_value(v[6], sizeof(v[6]), days_to_hours(result->excess_days));
+
+	len = snprintf(buf, size,
+		       "=== Vacation Days Calculator ===\n\n"
+		       "Annual vacation: %d hours (%d days)\n"
+		       "Maximum accumulation: %s hours (%d days)\n"
+		       "Current accumulated hours: %s\n\n"
+		       "Current month: %s (%d)\n"
+		       "Remaining working days in %d: %d\n",
+		       get_annual_hours_for_days(input->annual_days),
+		       input->annual_days, v[0], input->max_accum_days, v[1],
+		       months[input->current_month - 1], input->current_month,
+		       input->current_year, result->working_days_remaining);
+	if (input->vacation_extra > 0) {
+		char extra[400];
+
+		reference_format_value(extra, sizeof(extra), input->vacation_extra);
+		len += snprintf(buf + len, size - len,
+				"Extra vacation days consumption: %s\n", extra);
+	}
+	len += snprintf(buf + len, size - len,
+			"\nAdditional vacation expected by the end of %d: %s days (%s hours)\n",
+			input->current_year, v[2], v[3]);
+	len += snprintf(buf + len, size - len,
+			"Total accumulated vacation expected by the end of %d: %s hours (%s days)\n",
+			input->current_year, v[4], v[5]);
+	reference_format_value(v[0], sizeof(v[0]), result->excess_days);
+	snprintf(buf + len, size - len,
+		 "Vacation to be deducted at the end of %d (exceeding max): %s hours (%s days)\n",
+		 input->current_year, v[6], v[0]);
+}
+
+static void test_format_results_matches_printf(void)
+{
+	static char expected[RESULTS_MAX_TEXT], actual[RESULTS_MAX_TEXT];
+	struct vacation_input input;
+	struct vacation_result result;
+	size_t len;
+	int i;
+
+	TEST_START("format_results matches the printf rendering");
+	for (i = 0; i < 2000; i++) {
+		input.annual_days = MIN_ANNUAL_DAYS + (int)(test_rand() % 10);
+		input.max_accum_days = calculate_max_accum(input.annual_days, i % 2);
+		input.current_hours = (double)((int)(test_rand() % 60000) - 10000) / 100.0;
+		input.current_month = 1 + (int)(test_rand() % 12);
+		input.current_year = 2000 + (int)(test_rand() % 50);
+		input.vacation_extra = (double)(test_rand() % 8) / 2.0;
+		input.week_start = i % 2;
+		input.holidays = NULL;
+		input.policy = NULL;
+		if (i == 0)
+			input.current_hours = -1e300;	/* snprintf fallback */
+
+		calculate_vacation(&input, &result);
+		reference_format_results(expected, sizeof(expected), &input, &result);
+		len = format_results(actual, &input, &result);
+
+		ASSERT_INT_EQ((int)strlen(expected), (int)len);
+		ASSERT_TRUE(strcmp(expected, actual) == 0);
+	}
+	TEST_PASS();
+}
+
+static void set_sample_result(struct vacation_input *input,
+			      struct vacation_result *result)
+{
+	input->annual_days = 18;
+	input->max_accum_days = 36;
+	input->current_hours = 100.5;
+	input->current_month = 10;
+	input->current_year = 2026;
+	input->vacation_extra = 1.5;
+	input->week_start = WEEK_START_MONDAY;
+	input->holidays = NULL;
+
+	result->remaining_months = 3;
+	result->monthly_hours = 12.6;
+	result->additional_hours = 37.8;
+	result->additional_days = 4.5;
+	result->total_hours = 125.7;
+	result->total_days = 14.964285714285714;
+	result->excess_days = -1.0 / 3.0;
+	result->working_days_remaining = 66;
+}
+
+static void test_format_result_json(void)
+{
+	static const char expected[] =
+		"{\"id\":\"a\\\"b\\\\c\\u0001\","
+		"\"annual_days\":18,\"max_accum_days\":36,"
+		"\"current_hours\":100.5,\"current_month\":10,"
+		"\"current_year\":2026,\"vacation_extra\":1.5,"
+		"\"week_start\":1,\"remaining_months\":3,"
+		"\"monthly_hours\":12.6,\"additional_hours\":37.8,"
+		"\"additional_days\":4.5,\"total_hours\":125.7,"
+		"\"total_days\":14.96,\"excess_days\":-0.33,"
+		"\"working_days_remaining\":66}\n";
+	char buf[RESULT_MAX_JSON];
+	struct vacation_input input;
+	struct vacation_result result;
+	size_t len;
+
+	TEST_START("format_result_json escapes the ID and writes every field");
+	set_sample_result(&input, &result);
+
+	len = format_result_json(buf, "a\"b\\c\001", &input, &result);
+	ASSERT_INT_EQ((int)strlen(expected), (int)len);
+	ASSERT_TRUE(strcmp(expected, buf) == 0);
+
+	/* No ID member without an ID; JSON has no infinity */
+	result.excess_days = INFINITY;
+	len = format_result_json(buf, NULL, &input, &result);
+	ASSERT_TRUE(strncmp(buf, "{\"annual_days\":18,", 18) == 0);
+	ASSERT_TRUE(strstr(buf, "\"excess_days\":null,") != NULL);
+	ASSERT_INT_EQ('\n', buf[len - 1]);
+	TEST_PASS();
+}
+
+static void test_result_record_round_trip(void)
+{
+	unsigned char header[RESULT_HEADER_SIZE];
+	unsigned char buf[RESULT_RECORD_SIZE];
+	struct vacation_input input;
+	struct vacation_result result;
+	struct result_record record;
+
+	TEST_START("Binary result header and records round trip");
+	ASSERT_INT_EQ(RESULT_HEADER_SIZE, (int)sizeof(struct result_file_header));
+	ASSERT_INT_EQ(RESULT_RECORD_SIZE, (int)sizeof(struct result_record));
+	ASSERT_INT_EQ(32, (int)offsetof(struct result_record, annual_days));
+	ASSERT_INT_EQ(64, (int)offsetof(struct result_record, current_hours));
+
+	encode_result_header(header);
+	ASSERT_TRUE(memcmp(header, "VACRES01\001\0\0\0\200\0\0\0", 16) == 0);
+	ASSERT_INT_EQ(0, decode_result_header(header));
+	header[12] = 64;
+	ASSERT_TRUE(decode_result_header(header) != 0);
+
+	set_sample_result(&input, &result);
+	encode_result_record(buf, "E1", &input, &result);
+
+	/* Little-endian regardless of the host */
+	ASSERT_TRUE(memcmp(buf, "E1\0\0", 4) == 0);
+	ASSERT_INT_EQ(18, buf[32]);
+	ASSERT_INT_EQ(0, buf[33]);
+	ASSERT_INT_EQ(0xea, buf[44]);	/* 2026 */
+	ASSERT_INT_EQ(0x07, buf[45]);
+
+	decode_result_record(buf, &record);
+	ASSERT_TRUE(strcmp(record.id, "E1") == 0);
+	ASSERT_INT_EQ(18, record.annual_days);
+	ASSERT_INT_EQ(36, record.max_accum_days);
+	ASSERT_INT_EQ(10, record.current_month);
+	ASSERT_INT_EQ(2026, record.current_year);
+	ASSERT_INT_EQ(WEEK_START_MONDAY, record.week_start);
+	ASSERT_INT_EQ(3, record.remaining_months);
+	ASSERT_INT_EQ(66, record.working_days_remaining);
+	ASSERT_INT_EQ(0, record.reserved);
+	/* Full precision, unlike the text formats */
+	ASSERT_TRUE(record.current_hours == input.current_hours);
+	ASSERT_TRUE(record.vacation_extra == input.vacation_extra);
+	ASSERT_TRUE(record.monthly_hours == result.monthly_hours);
+	ASSERT_TRUE(record.additional_hours == result.additional_hours);
+	ASSERT_TRUE(record.additional_days == result.additional_days);
+	ASSERT_TRUE(record.total_hours == result.total_hours);
+	ASSERT_TRUE(record.total_days == result.total_days);
+	ASSERT_TRUE(record.excess_days == result.excess_days);
+
+	/* Long IDs are truncated, no ID is an empty string */
+	encode_result_record(buf, "0123456789012345678901234567890123", &input,
+			     &result);
+	decode_result_record(buf, &record);
+	ASSERT_INT_EQ(BATCH_MAX_ID, (int)strlen(record.id));
+	encode_result_record(buf, NULL, &input, &result);
+	decode_result_record(buf, &record);
+	ASSERT_INT_EQ(0, (int)strlen(record.id));
+	TEST_PASS();
+}
+
+static void test_parse_output_format(void)
+{
+	int format = -1;
+
+	TEST_START("parse_output_format accepts text, jsonl and bin");
+	ASSERT_INT_EQ(0, parse_output_format("text", &format));
+	ASSERT_INT_EQ(OUTPUT_FORMAT_TEXT, format);
+	ASSERT_INT_EQ(0, parse_output_format("jsonl", &format));
+	ASSERT_INT_EQ(OUTPUT_FORMAT_JSONL, format);
+	ASSERT_INT_EQ(0, parse_output_format("bin", &format));
+	ASSERT_INT_EQ(OUTPUT_FORMAT_BIN, format);
+	ASSERT_TRUE(parse_output_format("json", &format) != 0);
+	ASSERT_TRUE(parse_output_format("", &format) != 0);
+	TEST_PASS();
+}
+
+static void test_parse_io_backend(void)
+{
+	int backend = -1;
+
+	TEST_START("parse_io_backend accepts stdio, pread and uring");
+	ASSERT_INT_EQ(0, parse_io_backend("stdio", &backend));
+	ASSERT_INT_EQ(IO_BACKEND_STDIO, backend);
+	ASSERT_INT_EQ(0, parse_io_backend("pread", &backend));
+	ASSERT_INT_EQ(IO_BACKEND_PREAD, backend);
+	ASSERT_INT_EQ(0, parse_io_backend("uring", &backend));
+	ASSERT_INT_EQ(IO_BACKEND_URING, backend);
+	ASSERT_TRUE(parse_io_backend("io_uring", &backend) != 0);
+	ASSERT_TRUE(parse_io_backend("", &backend) != 0);
+	TEST_PASS();
+}
+
+/*
+ * Test: scenario sweep
+ */
+
+static void test_parse_sweep_ranges(void)
+{
+	struct vacation_sweep sweep;
+
+	TEST_START("parse_sweep_extra and parse_sweep_months");
+	memset(&sweep, 0, sizeof(sweep));
+	ASSERT_INT_EQ(0, parse_sweep_extra("0:10:2.5", &sweep));
+	ASSERT_DOUBLE_EQ(0.0, sweep.extra_first);
+	ASSERT_DOUBLE_EQ(10.0, sweep.extra_last);
+	ASSERT_DOUBLE_EQ(2.5, sweep.extra_step);
+	ASSERT_INT_EQ(5, sweep_num_extras(&sweep));
+	ASSERT_DOUBLE_EQ(7.5, sweep_extra_value(&sweep, 3));
+
+	ASSERT_INT_EQ(0, parse_sweep_extra("1.5:4", &sweep));
+	ASSERT_DOUBLE_EQ(1.0, sweep.extra_step);
+	ASSERT_INT_EQ(3, sweep_num_extras(&sweep));
+
+	/* 0.1 is inexact in binary; the last value must still be included */
+	ASSERT_INT_EQ(0, parse_sweep_extra("0:1:0.1", &sweep));
+	ASSERT_INT_EQ(11, sweep_num_extras(&sweep));
+
+	ASSERT_TRUE(parse_sweep_extra("5", &sweep) != 0);
+	ASSERT_TRUE(parse_sweep_extra("5:1", &sweep) != 0);
+	ASSERT_TRUE(parse_sweep_extra("-1:1", &sweep) != 0);
+	ASSERT_TRUE(parse_sweep_extra("0:1:0", &sweep) != 0);
+	ASSERT_TRUE(parse_sweep_extra("0:1:2:3", &sweep) != 0);
+	ASSERT_TRUE(parse_sweep_extra("0:100:0.0001", &sweep) != 0);
+
+	ASSERT_INT_EQ(0, parse_sweep_months("3-11", &sweep));
+	ASSERT_INT_EQ(3, sweep.month_first);
+	ASSERT_INT_EQ(11, sweep.month_last);
+	ASSERT_INT_EQ(0, parse_sweep_months("7", &sweep));
+	ASSERT_INT_EQ(7, sweep.month_first);
+	ASSERT_INT_EQ(7, sweep.month_last);
+	ASSERT_TRUE(parse_sweep_months("0-3", &sweep) != 0);
+	ASSERT_TRUE(parse_sweep_months("5-13", &sweep) != 0);
+	ASSERT_TRUE(parse_sweep_months("9-2", &sweep) != 0);
+	TEST_PASS();
+}
+
+static void test_calculate_vacation_sweep(void)
+{
+	static struct vacation_result results[600];
+	struct vacation_sweep sweep = { 0.0, 24.95, 0.5, 1, 12 };
+	struct vacation_input input;
+	struct vacation_result expected;
+	int num_extras = sweep_num_extras(&sweep);
+	int i;
+
+	TEST_START("calculate_vacation_sweep matches calculate_vacation");
+	input.annual_days = 21;
+	input.max_accum_days = 42;
+	input.current_hours = 287.3;
+	input.current_month = 10;
+	input.current_year = 2025;
+	input.vacation_extra = 0.0;
+	input.week_start = WEEK_START_MONDAY;
+	input.holidays = NULL;
+
+	/* 600 points: more than two kernel blocks */
+	ASSERT_INT_EQ(50, num_extras);
+	calculate_vacation_sweep(&input, &sweep, results);
+
+	for (i = 0; i < num_extras * 12; i++) {
+		input.current_month = 1 + i / num_extras;
+		input.vacation_extra = sweep_extra_value(&sweep, i % num_extras);
+		calculate_vacation(&input, &expected);
+
+		ASSERT_INT_EQ(expected.remaining_months, results[i].remaining_months);
+		ASSERT_INT_EQ(expected.working_days_remaining,
+			      results[i].working_days_remaining);
+		ASSERT_TRUE(expected.total_hours == results[i].total_hours);
+		ASSERT_TRUE(expected.total_days == results[i].total_days);
+		ASSERT_TRUE(expected.excess_days == results[i].excess_days);
+	}
+	TEST_PASS();
+}
+
+static void test_calculate_vacation_sweep_fixed(void)
+{
+	static struct vacation_fixed_result results[300];
+	struct vacation_sweep sweep = { 1.0, 30.0, 0.5, 8, 12 };
+	struct vacation_fixed_input input;
+	struct vacation_fixed_result expected;
+	int num_extras = sweep_num_extras(&sweep);
+	int i;
+
+	TEST_START("calculate_vacation_sweep_fixed matches calculate_vacation_fixed");
+	input.annual_days = 17;
+	input.max_accum_days = 36;
+	input.current_centi_hours = 25013;
+	input.current_month = 8;
+	input.current_year = 2024;
+	input.vacation_extra_centi_hours = 0;
+	input.week_start = WEEK_START_SUNDAY;
+	input.holidays = NULL;
+
+	ASSERT_INT_EQ(59, num_extras);
+	calculate_vacation_sweep_fixed(&input, &sweep, results);
+
+	for (i = 0; i < num_extras * 5; i++) {
+		input.current_month = 8 + i / num_extras;
+		days_to_centi_hours(sweep_extra_value(&sweep, i % num_extras),
+				    &input.vacation_extra_centi_hours);
+		calculate_vacation_fixed(&input, &expected);
+
+		ASSERT_INT_EQ(expected.remaining_months, results[i].remaining_months);
+		ASSERT_INT_EQ(expected.working_days_remaining,
+			      results[i].working_days_remaining);
+		ASSERT_TRUE(expected.total_centi_hours ==
+			    results[i].total_centi_hours);
+		ASSERT_TRUE(expected.excess_centi_hours ==
+			    results[i].excess_centi_hours);
+	}
+	TEST_PASS();
+}
+
+/*
+ * Test: timeline
+ */
+
+static void test_parse_vacation_plan(void)
+{
+	double plan[MONTHS_PER_YEAR];
+
+	TEST_START("parse_vacation_plan parses month:days lists");
+	ASSERT_INT_EQ(0, parse_vacation_plan("11:3,12:5.5,11:1", plan));
+	ASSERT_DOUBLE_EQ(0.0, plan[9]);
+	ASSERT_DOUBLE_EQ(4.0, plan[10]);
+	ASSERT_DOUBLE_EQ(5.5, plan[11]);
+
+	ASSERT_INT_EQ(0, parse_vacation_plan("1:0", plan));
+	ASSERT_DOUBLE_EQ(0.0, plan[10]);
+
+	ASSERT_TRUE(parse_vacation_plan("", plan) != 0);
+	ASSERT_TRUE(parse_vacation_plan("11", plan) != 0);
+	ASSERT_TRUE(parse_vacation_plan("13:1", plan) != 0);
+	ASSERT_TRUE(parse_vacation_plan("0:1", plan) != 0);
+	ASSERT_TRUE(parse_vacation_plan("5:-1", plan) != 0);
+	ASSERT_TRUE(parse_vacation_plan("5:1,", plan) != 0);
+	ASSERT_TRUE(parse_vacation_plan("5:1,6", plan) != 0);
+	TEST_PASS();
+}
+
+static void test_calculate_vacation_timeline(void)
+{
+	double plan[MONTHS_PER_YEAR] = { 0 };
+	struct vacation_input input;
+	struct vacation_result result;
+	struct vacation_timeline timeline;
+	int month;
+
+	TEST_START("calculate_vacation_timeline matches the year-end total");
+	input.annual_days = 22;
+	input.max_accum_days = 44;
+	input.current_hours = 301.37;
+	input.current_year = 2025;
+	input.vacation_extra = 3.5;
+	input.week_start = WEEK_START_SUNDAY;
+	input.holidays = NULL;
+
+	for (month = 1; month <= MONTHS_PER_YEAR; month++) {
+		input.current_month = month;
+		calculate_vacation(&input, &result);
+		calculate_vacation_timeline(&input, NULL, &timeline);
+
+		ASSERT_INT_EQ(month, timeline.first_month);
+		ASSERT_TRUE(timeline.balance_hours[11] == result.total_hours);
+		ASSERT_TRUE(timeline.balance_days[11] == result.total_days);
+		ASSERT_TRUE(timeline.excess_days == result.excess_days);
+		if (month > 1)
+			ASSERT_DOUBLE_EQ(0.0, timeline.balance_hours[month - 2]);
+	}
+
+	/* Planned days are deducted from their month on */
+	input.current_month = 9;
+	plan[9] = 2.0;
+	plan[11] = 1.5;
+	calculate_vacation_timeline(&input, plan, &timeline);
+	ASSERT_DOUBLE_EQ(301.37 + 15.4 - 29.4, timeline.balance_hours[8]);
+	ASSERT_DOUBLE_EQ(301.37 + 30.8 - 29.4 - 16.8, timeline.balance_hours[9]);
+	ASSERT_DOUBLE_EQ(301.37 + 46.2 - 29.4 - 16.8, timeline.balance_hours[10]);
+	ASSERT_DOUBLE_EQ(301.37 + 61.6 - 29.4 - 29.4, timeline.balance_hours[11]);
+	ASSERT_DOUBLE_EQ(2.0, timeline.planned_days[9]);
+	ASSERT_DOUBLE_EQ((301.37 + 30.8 - 29.4 - 16.8) / 8.4,
+			 timeline.balance_days[9]);
+	TEST_PASS();
+}
+
+static void test_calculate_vacation_timeline_fixed(void)
+{
+	int64_t plan[MONTHS_PER_YEAR] = { 0 };
+	struct vacation_fixed_input input;
+	struct vacation_fixed_result result;
+	struct vacation_fixed_timeline timeline;
+	int month;
+
+	TEST_START("calculate_vacation_timeline_fixed is exact");
+	input.annual_days = 15;
+	input.max_accum_days = 36;
+	input.current_centi_hours = 29913;
+	input.current_year = 2025;
+	input.vacation_extra_centi_hours = 420;
+	input.week_start = WEEK_START_MONDAY;
+	input.holidays = NULL;
+
+	for (month = 1; month <= MONTHS_PER_YEAR; month++) {
+		input.current_month = month;
+		calculate_vacation_fixed(&input, &result);
+		calculate_vacation_timeline_fixed(&input, NULL, &timeline);
+
+		ASSERT_TRUE(timeline.balance_centi_hours[11] ==
+			    result.total_centi_hours);
+		ASSERT_TRUE(timeline.excess_centi_hours ==
+			    result.excess_centi_hours);
+	}
+
+	input.current_month = 11;
+	plan[11] = 840;
+	calculate_vacation_timeline_fixed(&input, plan, &timeline);
+	ASSERT_TRUE(timeline.balance_centi_hours[10] == 29913 - 420 + 1050);
+	ASSERT_TRUE(timeline.balance_centi_hours[11] == 29913 - 420 + 2100 - 840);
+	ASSERT_TRUE(timeline.excess_centi_hours == 30753 - 30240);
+	TEST_PASS();
+}
+
+/*
+ * Test: multi-year projection
+ */
+
+static void test_calculate_vacation_projection(void)
+{
+	struct vacation_year_result years[MAX_PROJECTION_YEARS];
+	struct vacation_input input;
+	struct vacation_result result;
+
+	TEST_START("calculate_vacation_projection carries over the capped balance");
+	input.annual_days = 18;
+	input.max_accum_days = 36;
+	input.current_hours = 100.0;
+	input.current_month = 10;
+	input.current_year = 2025;
+	input.vacation_extra = 0.0;
+	input.week_start = WEEK_START_SUNDAY;
+	input.holidays = NULL;
+
+	calculate_vacation(&input, &result);
+	calculate_vacation_projection(&input, &result, 4, years);
+
+	/* First year is the single-year result */
+	ASSERT_INT_EQ(2025, years[0].year);
+	ASSERT_TRUE(years[0].total_hours == result.total_hours);
+	ASSERT_TRUE(years[0].excess_days == result.excess_days);
+
+	/* 137.8 + 151.2 = 289 hours: below the cap, all carried over */
+	ASSERT_INT_EQ(2026, years[1].year);
+	ASSERT_DOUBLE_EQ(289.0, years[1].total_hours);
+	ASSERT_DOUBLE_EQ(0.0, years[1].excess_days);
+
+	/* 440.2 hours: 16.40 days above the cap of 36 */
+	ASSERT_DOUBLE_EQ(440.2, years[2].total_hours);
+	ASSERT_DOUBLE_EQ(440.2 / 8.4 - 36.0, years[2].excess_days);
+
+	/* Then 36 days carried over plus a full year, every year */
+	ASSERT_INT_EQ(2028, years[3].year);
+	ASSERT_DOUBLE_EQ(302.4 + 151.2, years[3].total_hours);
+	ASSERT_DOUBLE_EQ(18.0, years[3].excess_days);
+	TEST_PASS();
+}
+
+/*
+ * Test: init_vacation_args
+ */
+
+static void test_init_vacation_args(void)
+{
+	struct vacation_args args;
+
+	TEST_START("init_vacation_args sets defaults");
+	init_vacation_args(&args);
+
+	ASSERT_INT_EQ(0, args.annual_days);	/* No default - must be set */
+	ASSERT_DOUBLE_EQ(0.0, args.current_hours);
+	ASSERT_INT_EQ(0, args.annual_days_set);
+	ASSERT_INT_EQ(0, args.annual_hours_set);
+	ASSERT_INT_EQ(0, args.current_hours_set);
+	ASSERT_DOUBLE_EQ(0.0, args.vacation_extra);
+	ASSERT_INT_EQ(0, args.vacation_extra_set);
 	ASSERT_INT_EQ(WEEK_START_SUNDAY, args.week_start);
 	ASSERT_INT_EQ(0, args.special_accum);
+	ASSERT_TRUE(args.batch_file == NULL);
+	ASSERT_INT_EQ(1, args.num_threads);
+	ASSERT_INT_EQ(IO_BACKEND_STDIO, args.io_backend);
+	ASSERT_TRUE(args.serve_socket == NULL);
+	ASSERT_INT_EQ(0, args.fixed_point);
+	ASSERT_TRUE(args.holidays_file == NULL);
+	ASSERT_TRUE(args.holidays == NULL);
+	ASSERT_INT_EQ(OUTPUT_FORMAT_TEXT, args.output_format);
+	ASSERT_INT_EQ(0, args.sweep_set);
+	ASSERT_INT_EQ(0, args.sweep.month_first);
+	ASSERT_INT_EQ(0, args.timeline);
+	ASSERT_INT_EQ(0, args.plan_set);
+	ASSERT_DOUBLE_EQ(0.0, args.planned_days[11]);
+	ASSERT_INT_EQ(1, args.num_years);
+	ASSERT_INT_EQ(0, args.policy_id);
+	ASSERT_TRUE(args.policy_file == NULL);
+	ASSERT_TRUE(args.policies == NULL);
+	ASSERT_TRUE(args.policy == NULL);
+	ASSERT_INT_EQ(0, args.as_of_set);
+	ASSERT_INT_EQ(0, args.stdin_lines);
+	ASSERT_INT_EQ(0, args.help);
+	TEST_PASS();
+}
+
+/*
+ * Test: validate_arguments
+ */
+
+static void test_validate_args_neither_set(void)
+{
+	struct vacation_args args;
+
+	TEST_START("validate_arguments with neither annual option set returns error");
+	init_vacation_args(&args);
+
+	ASSERT_INT_EQ(1, validate_arguments(&args));
+	TEST_PASS();
+}
+
+static void test_validate_args_days_only(void)
+{
+	struct vacation_args args;
+
+	TEST_START("validate_arguments with only annual-days set");
+	init_vacation_args(&args);
+	args.annual_days_set = 1;
+
+	ASSERT_INT_EQ(0, validate_arguments(&args));
+	TEST_PASS();
+}
+
+static void test_validate_args_hours_only(void)
+{
+	struct vacation_args args;
+
+	TEST_START("validate_arguments with only annual-hours set");
+	init_vacation_args(&args);
+	args.annual_hours_set = 1;
+
+	ASSERT_INT_EQ(0, validate_arguments(&args));
+	TEST_PASS();
+}
+
+static void test_validate_args_both_set(void)
+{
+	struct vacation_args args;
+
+	TEST_START("validate_arguments with both annual options set");
+	init_vacation_args(&args);
+	args.annual_days_set = 1;
+	args.annual_hours_set = 1;
+
+	ASSERT_INT_EQ(1, validate_arguments(&args));
+	TEST_PASS();
+}
+
+/*
+ * Test: parse_arguments
+ */
+
+static void test_parse_arguments_help(void)
+{
+	struct vacation_args args;
+	char program[] = "vacation_calculator";
+	char help[] = "--help";
+	char days[] = "-d";
+	char bad[] = "x";
+	char *argv[] = { program, help, days, bad };
+
+	TEST_START("parse_arguments sets help instead of exiting");
+	init_vacation_args(&args);
+
+	/* Parsing stops at --help, so the bad value is not reached */
+	ASSERT_INT_EQ(0, parse_arguments(4, argv, &args));
+	ASSERT_INT_EQ(1, args.help);
+	ASSERT_INT_EQ(0, args.annual_days_set);
+	TEST_PASS();
+}
+
+static void test_parse_arguments_line(void)
+{
+	struct vacation_args args;
+	char line[] = "  -d 20\t-c 150.5 -v 3 -L\n";
+	char *argv[LINE_MAX_ARGS + 1];
+	int argc;
+
+	TEST_START("parse_arguments on a split stdin line");
+	argv[0] = line;	/* Any program name */
+	argc = split_argument_line(line, argv + 1, LINE_MAX_ARGS);
+	ASSERT_INT_EQ(7, argc);
+	ASSERT_TRUE(strcmp(argv[1], "-d") == 0);
+	ASSERT_TRUE(strcmp(argv[7], "-L") == 0);
+
+	init_vacation_args(&args);
+	ASSERT_INT_EQ(0, parse_arguments(argc + 1, argv, &args));
+	ASSERT_INT_EQ(20, args.annual_days);
+	ASSERT_DOUBLE_EQ(150.5, args.current_hours);
+	ASSERT_DOUBLE_EQ(3.0, args.vacation_extra);
+	ASSERT_INT_EQ(1, args.stdin_lines);
+	TEST_PASS();
+}
+
+/* Parse and prepare a command line; returns the first non-zero status */
+static int prepare_argument_line(const char *text)
+{
+	struct vacation_args args;
+	char line[BATCH_MAX_LINE + 1];
+	char *argv[LINE_MAX_ARGS + 1];
+	int argc;
+
+	strcpy(line, text);
+	argv[0] = line;	/* Any program name */
+	argc = split_argument_line(line, argv + 1, LINE_MAX_ARGS);
+	init_vacation_args(&args);
+	if (parse_arguments(argc + 1, argv, &args) != 0)
+		return 1;
+
+	return prepare_arguments(&args);
+}
+
+static void test_prepare_arguments_sweep_modes(void)
+{
+	TEST_START("prepare_arguments rejects --sweep with other modes");
+	ASSERT_INT_EQ(0, prepare_argument_line("-d 20 -c 10 -w 0:2"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-d 20 -c 10 -w 0:2 -t"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-d 20 -c 10 -w 0:2 -y 3"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-b emp.csv -w 0:2"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-Z emp.snp -w 0:2"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-R prev.bin -f bin -w 0:2"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-S vacation.sock -w 0:2"));
+	TEST_PASS();
+}
+
+static void test_prepare_arguments_timeline_modes(void)
+{
+	TEST_START("prepare_arguments rejects --timeline with other modes");
+	ASSERT_INT_EQ(0, prepare_argument_line("-d 20 -c 10 -t -p 7:2"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-d 20 -c 10 -t -y 3"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-d 20 -c 10 -t -p 7:2 -y 2"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-b emp.csv -t"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-Z emp.snp -t"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-R prev.bin -f bin -t"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-S vacation.sock -t"));
+	TEST_PASS();
+}
+
+static void test_prepare_arguments_stdin_lines_modes(void)
+{
+	TEST_START("prepare_arguments rejects --stdin-lines with other modes");
+	ASSERT_INT_EQ(0, prepare_argument_line("-L -d 20 -f jsonl"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-L -b emp.csv"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-L -Z emp.snp"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-L -R prev.bin -f bin"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-L -S vacation.sock"));
+	TEST_PASS();
+}
+
+static void test_prepare_arguments_previous_modes(void)
+{
+	TEST_START("prepare_arguments rejects --previous with batch, parallel and block I/O");
+	ASSERT_INT_EQ(0, prepare_argument_line("-R prev.bin -f bin -T 1"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-R prev.bin -f bin -b emp.csv"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-R prev.bin -f bin -T 4"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-R prev.bin -f bin -Q"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-R prev.bin -f bin -U pread"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-R prev.bin -f bin -U uring"));
+	TEST_PASS();
+}
+
+static void test_prepare_arguments_snapshot_modes(void)
+{
+	TEST_START("prepare_arguments rejects --snapshot with parallel and block I/O");
+	ASSERT_INT_EQ(0, prepare_argument_line("-Z emp.snp -T 1"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-Z emp.snp -T 4"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-Z emp.snp -Q"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-Z emp.snp -U pread"));
+	ASSERT_INT_EQ(1, prepare_argument_line("-Z emp.snp -U uring"));
+	TEST_PASS();
+}
+
+static void test_split_argument_line_limits(void)
+{
+	char empty[] = " \t\r\n";
+	char many[] = "a b c";
+	char *argv[2];
+
+	TEST_START("split_argument_line handles blank and over-long lines");
+	ASSERT_INT_EQ(0, split_argument_line(empty, argv, 2));
+	ASSERT_INT_EQ(-1, split_argument_line(many, argv, 2));
+	TEST_PASS();
+}
+
+static void test_run_stdin_lines_rejects(void)
+{
+	const char *path = "test_lines.tmp";
+	struct vacation_args defaults;
+	struct date today = { 2024, 12, 2 };
+	FILE *file;
+
+	TEST_START("run_stdin_lines reports invalid lines and continues");
+	init_vacation_args(&defaults);
+	ASSERT_INT_EQ(0, prepare_arguments(&defaults));
+
+	file = fopen(path, "w+");
+	ASSERT_TRUE(file != NULL);
+	fputs("# comment\n\n", file);
+	rewind(file);
+	ASSERT_INT_EQ(0, run_stdin_lines(&defaults, &today, file));
+
+	rewind(file);
+	fputs("-d 25 -c 1\n-d 20\n-d 20 -c 1 -b x\n-d 20 -c 1 -f bin\n-h\n", file);
+	rewind(file);
+	ASSERT_INT_EQ(1, run_stdin_lines(&defaults, &today, file));
+	fclose(file);
+	remove(path);
+	TEST_PASS();
+}
+
+/*
+ * Test: parse_batch_record
+ */
+
+static void test_batch_record_all_fields(void)
+{
+	struct batch_record record;
+	char line[] = "E100, 20, , 150.5, 2.5, monday, 1\n";
+
+	TEST_START("parse_batch_record with all fields");
+	init_vacation_args(&record.args);
+
+	ASSERT_INT_EQ(0, parse_batch_record(line, &record));
+	ASSERT_TRUE(strcmp(record.id, "E100") == 0);
+	ASSERT_INT_EQ(20, record.args.annual_days);
+	ASSERT_INT_EQ(1, record.args.annual_days_set);
+	ASSERT_INT_EQ(0, record.args.annual_hours_set);
+	ASSERT_DOUBLE_EQ(150.5, record.args.current_hours);
+	ASSERT_DOUBLE_EQ(2.5, record.args.vacation_extra);
+	ASSERT_INT_EQ(1, record.args.vacation_extra_set);
+	ASSERT_INT_EQ(WEEK_START_MONDAY, record.args.week_start);
+	ASSERT_INT_EQ(1, record.args.special_accum);
+	TEST_PASS();
+}
+
+static void test_batch_record_annual_hours(void)
+{
+	struct batch_record record;
+	char line[] = "E101,,202,100";
+
+	TEST_START("parse_batch_record with annual hours");
+	init_vacation_args(&record.args);
+
+	ASSERT_INT_EQ(0, parse_batch_record(line, &record));
+	ASSERT_INT_EQ(24, record.args.annual_days);
+	ASSERT_INT_EQ(0, record.args.annual_days_set);
+	ASSERT_INT_EQ(1, record.args.annual_hours_set);
+	ASSERT_DOUBLE_EQ(100.0, record.args.current_hours);
+	TEST_PASS();
+}
+
+static void test_batch_record_defaults(void)
+{
+	struct batch_record record;
+	char line[] = "E102,,,80";
+
+	TEST_START("parse_batch_record keeps defaults for empty fields");
+	init_vacation_args(&record.args);
+	record.args.annual_days = 18;
+	record.args.annual_days_set = 1;
+	record.args.week_start = WEEK_START_MONDAY;
+
+	ASSERT_INT_EQ(0, parse_batch_record(line, &record));
+	ASSERT_INT_EQ(18, record.args.annual_days);
+	ASSERT_INT_EQ(1, record.args.annual_days_set);
+	ASSERT_INT_EQ(WEEK_START_MONDAY, record.args.week_start);
+	ASSERT_INT_EQ(0, record.args.vacation_extra_set);
+	TEST_PASS();
+}
+
+static void test_batch_record_policy(void)
+{
+	struct batch_record record;
+	struct policy_set set;
+	struct policy_rules rules = { 4, 1, { 20 }, { 170 }, 40, 18, 2 };
+	struct vacation_policy policy;
+	char line[] = "E107,,,100,,,,4";
+	char builtin[] = "E108,,,100";
+	char unknown[] = "E109,,,100,,,,5";
+
+	TEST_START("parse_batch_record converts annual hours with the record policy");
+	ASSERT_INT_EQ(0, compile_policy(&rules, &policy));
+	memset(&set, 0, sizeof(set));
+	set.policies[4] = &policy;
+	init_vacation_args(&record.args);
+	record.args.policies = &set;
+	record.args.annual_hours = 170;
+	record.args.annual_hours_set = 1;
+
+	ASSERT_INT_EQ(0, parse_batch_record(line, &record));
+	ASSERT_INT_EQ(4, record.args.policy_id);
+	ASSERT_TRUE(record.args.policy == &policy);
+	ASSERT_INT_EQ(20, record.args.annual_days);
+
+	/* 170 hours is not a built-in option */
+	init_vacation_args(&record.args);
+	record.args.policies = &set;
+	record.args.annual_hours = 170;
+	record.args.annual_hours_set = 1;
+	ASSERT_INT_EQ(VALIDATION_ANNUAL_HOURS,
+		      parse_batch_record(builtin, &record));
+	ASSERT_INT_EQ(170, record.error.value);
+	ASSERT_INT_EQ(VALIDATION_POLICY, parse_batch_record(unknown, &record));
+	ASSERT_TRUE(strcmp(record.error.text, "5") == 0);
+	TEST_PASS();
+}
+
+static void test_batch_record_too_few_fields(void)
+{
+	struct batch_record record;
+	char line[] = "E103,20";
+
+	TEST_START("parse_batch_record rejects too few fields");
+	init_vacation_args(&record.args);
+
+	ASSERT_INT_EQ(VALIDATION_TOO_FEW_FIELDS,
+		      parse_batch_record(line, &record));
+	ASSERT_INT_EQ(4, record.error.limit);
+	TEST_PASS();
+}
+
+static void test_batch_record_too_many_fields(void)
+{
+	struct batch_record record;
+	char line[] = "E104,20,,100,0,0,0,0,extra";
+
+	TEST_START("parse_batch_record rejects too many fields");
+	init_vacation_args(&record.args);
+
+	ASSERT_INT_EQ(VALIDATION_TOO_MANY_FIELDS,
+		      parse_batch_record(line, &record));
+	ASSERT_INT_EQ(BATCH_NUM_FIELDS, record.error.limit);
+	TEST_PASS();
+}
+
+static void test_batch_record_missing_current_hours(void)
+{
+	struct batch_record record;
+	char line[] = "E105,20,, ,1";
+
+	TEST_START("parse_batch_record rejects missing current hours");
+	init_vacation_args(&record.args);
+
+	ASSERT_INT_EQ(VALIDATION_CURRENT_HOURS_FORMAT,
+		      parse_batch_record(line, &record));
+	ASSERT_TRUE(strcmp(record.error.text, "") == 0);
+	TEST_PASS();
+}
+
+static void test_batch_record_invalid_week_start(void)
+{
+	struct batch_record record;
+	char line[] = "E106,20,,100,0,friday";
+
+	TEST_START("parse_batch_record rejects invalid week start");
+	init_vacation_args(&record.args);
+
+	ASSERT_INT_EQ(VALIDATION_WEEK_START_FORMAT,
+		      parse_batch_record(line, &record));
+	ASSERT_TRUE(strcmp(record.error.text, "friday") == 0);
+	TEST_PASS();
+}
+
+/*
+ * Test: parse_journal_record
+ */
+
+static void test_journal_record_fields(void)
+{
+	struct journal_record record;
+	char line[] = " E100 , 150.5, 2.5\n";
+	char no_extra[] = "E101,80";
+
+	TEST_START("parse_journal_record with and without extra days");
+	ASSERT_INT_EQ(0, parse_journal_record(line, &record));
+	ASSERT_TRUE(strcmp(record.id, "E100") == 0);
+	ASSERT_DOUBLE_EQ(150.5, record.current_hours);
+	ASSERT_DOUBLE_EQ(2.5, record.vacation_extra);
+	ASSERT_INT_EQ(1, record.vacation_extra_set);
+
+	ASSERT_INT_EQ(0, parse_journal_record(no_extra, &record));
+	ASSERT_TRUE(strcmp(record.id, "E101") == 0);
+	ASSERT_DOUBLE_EQ(80.0, record.current_hours);
+	ASSERT_INT_EQ(0, record.vacation_extra_set);
+	TEST_PASS();
+}
+
+static void test_journal_record_errors(void)
+{
+	struct journal_record record;
+	char too_few[] = "E100";
+	char too_many[] = "E100,1,2,3";
+	char hours[] = "E100,abc";
+	char negative[] = "E100,1,-1";
+	char long_id[] = "E123456789012345678901234567890123,1";
+
+	TEST_START("parse_journal_record rejects invalid records");
+	ASSERT_INT_EQ(VALIDATION_TOO_FEW_FIELDS,
+		      parse_journal_record(too_few, &record));
+	ASSERT_INT_EQ(VALIDATION_TOO_MANY_FIELDS,
+		      parse_journal_record(too_many, &record));
+	ASSERT_INT_EQ(VALIDATION_CURRENT_HOURS_FORMAT,
+		      parse_journal_record(hours, &record));
+	ASSERT_TRUE(strcmp(record.error.text, "abc") == 0);
+	ASSERT_INT_EQ(VALIDATION_EXTRA_NEGATIVE,
+		      parse_journal_record(negative, &record));
+	ASSERT_INT_EQ(VALIDATION_ID_LENGTH,
+		      parse_journal_record(long_id, &record));
+	TEST_PASS();
+}
+
+/*
+ * Test: vacation_evaluate
+ */
+
+static void init_test_context(struct vacation_context *context)
+{
+	memset(context, 0, sizeof(*context));
+	context->month = 12;
+	context->year = 2024;
+}
+
+static void init_serve_request(struct vacation_request *request)
+{
+	memset(request, 0, sizeof(*request));
+	request->annual_days = 24;
+	request->current_hours = days_to_hours(40.0);
+	request->vacation_extra = 6.0;
+	request->week_start = WEEK_START_SUNDAY;
+}
+
+static void test_serve_request_valid(void)
+{
+	struct vacation_request request;
+	struct vacation_response response;
+	struct vacation_context context;
+
+	TEST_START("vacation_evaluate with valid request");
+	init_test_context(&context);
+	init_serve_request(&request);
+
+	ASSERT_INT_EQ(VACATION_OK,
+		      vacation_evaluate(&context, &request, &response));
+
+	/* 40 + 2 - 6 = 36 days (at limit) */
+	ASSERT_INT_EQ(VACATION_OK, response.status);
+	ASSERT_INT_EQ(24, response.annual_days);
+	ASSERT_INT_EQ(36, response.max_accum_days);
+	ASSERT_INT_EQ(1, response.remaining_months);
+	ASSERT_INT_EQ(23, response.working_days_remaining);
+	ASSERT_DOUBLE_EQ(36.0, response.total_days);
+	ASSERT_DOUBLE_EQ(0.0, response.excess_days);
+	TEST_PASS();
+}
+
+static void test_serve_request_annual_hours(void)
+{
+	struct vacation_request request;
+	struct vacation_response response;
+	struct vacation_context context;
+
+	TEST_START("vacation_evaluate with annual hours and special accum");
+	init_test_context(&context);
+	init_serve_request(&request);
+	request.annual_days = 0;
+	request.annual_hours = 202;
+	request.special_accum = 1;
+
+	vacation_evaluate(&context, &request, &response);
+
+	ASSERT_INT_EQ(VACATION_OK, response.status);
+	ASSERT_INT_EQ(24, response.annual_days);
+	ASSERT_INT_EQ(48, response.max_accum_days);
+	TEST_PASS();
+}
+
+static void test_serve_request_errors(void)
+{
+	struct vacation_request request;
+	struct vacation_response response;
+	struct vacation_context context;
+
+	TEST_START("vacation_evaluate reports errors");
+	init_test_context(&context);
+	init_serve_request(&request);
+	request.annual_hours = 202;
+	vacation_evaluate(&context, &request, &response);
+	ASSERT_INT_EQ(VACATION_ERR_ANNUAL_OPTION, response.status);
+
+	init_serve_request(&request);
+	request.annual_days = 25;
+	vacation_evaluate(&context, &request, &response);
+	ASSERT_INT_EQ(VACATION_ERR_ANNUAL_DAYS, response.status);
+
+	init_serve_request(&request);
+	request.annual_days = 0;
+	request.annual_hours = 200;
+	vacation_evaluate(&context, &request, &response);
+	ASSERT_INT_EQ(VACATION_ERR_ANNUAL_HOURS, response.status);
+
+	init_serve_request(&request);
+	request.vacation_extra = -1.0;
+	vacation_evaluate(&context, &request, &response);
+	ASSERT_INT_EQ(VACATION_ERR_VACATION_EXTRA, response.status);
+
+	init_serve_request(&request);
+	request.vacation_extra = NAN;
+	vacation_evaluate(&context, &request, &response);
+	ASSERT_INT_EQ(VACATION_ERR_VACATION_EXTRA, response.status);
+
+	init_serve_request(&request);
+	request.week_start = 2;
+	vacation_evaluate(&context, &request, &response);
+	ASSERT_INT_EQ(VACATION_ERR_WEEK_START, response.status);
+
+	init_serve_request(&request);
+	request.policy_id = 3;
+	vacation_evaluate(&context, &request, &response);
+	ASSERT_INT_EQ(VACATION_ERR_POLICY, response.status);
+
+	init_serve_request(&request);
+	request.current_hours = INFINITY;
+	vacation_evaluate(&context, &request, &response);
+	ASSERT_INT_EQ(VACATION_ERR_CURRENT_HOURS, response.status);
+
+	init_serve_request(&request);
+	context.month = 13;
+	ASSERT_INT_EQ(VACATION_ERR_DATE,
+		      vacation_evaluate(&context, &request, &response));
+	ASSERT_INT_EQ(VACATION_ERR_DATE, response.status);
+	TEST_PASS();
+}
+
+static void test_vacation_strerror(void)
+{
+	int status;
+
+	TEST_START("vacation_strerror describes every status");
+	ASSERT_INT_EQ(VACATION_ABI_VERSION, vacation_abi_version());
+	for (status = 0; status < VACATION_NUM_STATUS; status++)
+		ASSERT_TRUE(strcmp(vacation_strerror(status),
+				   "Unknown status") != 0);
+	ASSERT_TRUE(strcmp(vacation_strerror(-1), "Unknown status") == 0);
+	ASSERT_TRUE(strcmp(vacation_strerror(VACATION_NUM_STATUS),
+			   "Unknown status") == 0);
+	TEST_PASS();
+}
+
+#define EVALUATE_TEST_TASKS 512
+
+struct evaluate_test_job {
+	const struct vacation_context *context;
+	struct vacation_response responses[EVALUATE_TEST_TASKS];
+};
+
+static void evaluate_test_task(void *arg, size_t task, int worker)
+{
+	struct evaluate_test_job *job = arg;
+	struct vacation_request request;
+
+	(void)worker;
+	init_serve_request(&request);
+	request.current_hours = (double)task;
+	vacation_evaluate(job->context, &request, &job->responses[task]);
+}
+
+static void evaluate_test_consume(void *arg, size_t task)
+{
+	(void)arg;
+	(void)task;
+}
+
+static void test_vacation_evaluate_shared_context(void)
+{
+	static struct evaluate_test_job job;
+	struct vacation_context context;
+	struct vacation_request request;
+	struct vacation_response expected;
+	size_t task;
+
+	TEST_START("vacation_evaluate shares one context between threads");
+	init_test_context(&context);
+	job.context = &context;
+
+	ASSERT_INT_EQ(0, run_parallel_ordered(EVALUATE_TEST_TASKS, 8,
+					      evaluate_test_task,
+					      evaluate_test_consume, &job));
+
+	for (task = 0; task < EVALUATE_TEST_TASKS; task++) {
+		init_serve_request(&request);
+		request.current_hours = (double)task;
+		vacation_evaluate(&context, &request, &expected);
+		ASSERT_TRUE(memcmp(&expected, &job.responses[task],
+				   sizeof(expected)) == 0);
+	}
+	TEST_PASS();
+}
+
+#ifdef TEST_SERVER
+
+/*
+ * Test: run_server
+ */
+
+#define SERVE_TEST_SOCKET	"test_serve.sock.tmp"
+
+struct serve_test_server {
+	struct vacation_args args;
+	pthread_t thread;
+	int status;
+};
+
+static void *serve_test_main(void *arg)
+{
+	struct serve_test_server *server = arg;
+
+	server->status = run_server(SERVE_TEST_SOCKET, &server->args);
+	return NULL;
+}
+
+static void serve_test_address(struct sockaddr_un *addr)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	strcpy(addr->sun_path, SERVE_TEST_SOCKET);
+}
+
+static void serve_test_sleep(long ms)
+{
+	struct timespec delay;
+
+	delay.tv_sec = 0;
+	delay.tv_nsec = ms * 1000000L;
+	nanosleep(&delay, NULL);
+}
+
+/* Connect once; returns the socket, or -1 */
+static int serve_test_connect(void)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	serve_test_address(&addr);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd >= 0 &&
+	    connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		close(fd);
+		fd = -1;
+	}
+	return fd;
+}
+
+/* Connect, waiting up to five seconds for the server to listen */
+static int serve_test_client(void)
+{
+	int tries;
+	int fd = -1;
+
+	for (tries = 0; tries < 500 && fd < 0; tries++) {
+		fd = serve_test_connect();
+		if (fd < 0)
+			serve_test_sleep(10);
+	}
+	return fd;
+}
+
+static int serve_test_write(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+
+	while (len > 0) {
+		ssize_t n = write(fd, p, len);
+
+		if (n <= 0)
+			return 1;
+		p += n;
+		len -= (size_t)n;
+	}
+	return 0;
+}
+
+static int serve_test_read(int fd, void *buf, size_t len)
+{
+	char *p = buf;
+
+	while (len > 0) {
+		ssize_t n = read(fd, p, len);
+
+		if (n <= 0)
+			return 1;
+		p += n;
+		len -= (size_t)n;
+	}
+	return 0;
+}
+
+/* A socket file nobody listens on, as a crashed daemon leaves it */
+static int make_stale_socket(void)
+{
+	struct sockaddr_un addr;
+	int fd;
+	int ret;
+
+	serve_test_address(&addr);
+	remove(SERVE_TEST_SOCKET);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return 1;
+	ret = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+	close(fd);
+	return ret != 0;
+}
+
+static void test_run_server_clients(void)
+{
+	static struct serve_test_server server;
+	struct vacation_context context;
+	struct vacation_request requests[3];
+	struct vacation_response expected[3];
+	struct vacation_response responses[3];
+	int clients[2];
+	int i;
+
+	TEST_START("run_server answers concurrent clients and shuts down");
+	ASSERT_INT_EQ(0, make_stale_socket());
+
+	init_vacation_args(&server.args);
+	server.args.as_of.year = 2024;
+	server.args.as_of.month = 12;
+	server.args.as_of.day = 1;
+	server.args.as_of_set = 1;
+	ASSERT_INT_EQ(0, pthread_create(&server.thread, NULL, serve_test_main,
+					&server));
+
+	init_test_context(&context);
+	for (i = 0; i < 3; i++) {
+		init_serve_request(&requests[i]);
+		requests[i].current_hours = 100.0 + i;
+		vacation_evaluate(&context, &requests[i], &expected[i]);
+	}
+	requests[2].annual_days = 14;	/* Invalid: answered with an error */
+	vacation_evaluate(&context, &requests[2], &expected[2]);
+
+	/* The stale socket is replaced, so both clients get through */
+	clients[0] = serve_test_client();
+	clients[1] = serve_test_client();
+	ASSERT_TRUE(clients[0] >= 0);
+	ASSERT_TRUE(clients[1] >= 0);
+
+	/* A second daemon finds the socket in use */
+	ASSERT_INT_EQ(1, run_server(SERVE_TEST_SOCKET, &server.args));
+
+	/* One request split across two writes, two requests in one */
+	ASSERT_INT_EQ(0, serve_test_write(clients[0], &requests[0], 10));
+	serve_test_sleep(20);
+	ASSERT_INT_EQ(0, serve_test_write(clients[0],
+					  (const char *)&requests[0] + 10,
+					  sizeof(requests[0]) - 10));
+	ASSERT_INT_EQ(0, serve_test_write(clients[1], &requests[1],
+					  2 * sizeof(requests[1])));
+
+	ASSERT_INT_EQ(0, serve_test_read(clients[0], &responses[0],
+					 sizeof(responses[0])));
+	ASSERT_INT_EQ(0, serve_test_read(clients[1], &responses[1],
+					 2 * sizeof(responses[1])));
+	for (i = 0; i < 3; i++)
+		ASSERT_TRUE(memcmp(&expected[i], &responses[i],
+				   sizeof(expected[i])) == 0);
+	ASSERT_INT_EQ(VACATION_ERR_ANNUAL_DAYS, responses[2].status);
+	close(clients[0]);
+	close(clients[1]);
+
+	/* SIGTERM, then a connection to wake epoll_wait if it was missed */
+	pthread_kill(server.thread, SIGTERM);
+	clients[0] = serve_test_connect();
+	if (clients[0] >= 0)
+		close(clients[0]);
+	pthread_join(server.thread, NULL);
+	ASSERT_INT_EQ(0, server.status);
+	ASSERT_TRUE(access(SERVE_TEST_SOCKET, F_OK) != 0);
 	TEST_PASS();
 }
 
+/* Local time in a zone with DST changes on the last Sundays of March/October */
+static time_t serve_test_time(int year, int month, int day, int hour, int min)
+{
+	struct tm tm;
+
+	memset(&tm, 0, sizeof(tm));
+	tm.tm_year = year - 1900;
+	tm.tm_mon = month - 1;
+	tm.tm_mday = day;
+	tm.tm_hour = hour;
+	tm.tm_min = min;
+	tm.tm_isdst = -1;
+	return mktime(&tm);
+}
+
+static void test_next_local_midnight(void)
+{
+	char saved_tz[64] = "";
+	const char *tz = getenv("TZ");
+	long hour = 60 * 60;
+
+	TEST_START("next_local_midnight skips to the next day, also at DST changes");
+	if (tz)
+		snprintf(saved_tz, sizeof(saved_tz), "%s", tz);
+	setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+	tzset();
+
+	ASSERT_TRUE(next_local_midnight(serve_test_time(2025, 6, 10, 15, 30)) ==
+		    serve_test_time(2025, 6, 11, 0, 0));
+	ASSERT_INT_EQ((int)(8 * hour + 30 * 60),
+		      (int)(serve_test_time(2025, 6, 11, 0, 0) -
+			    serve_test_time(2025, 6, 10, 15, 30)));
+
+	/* 23 and 25 hour days */
+	ASSERT_INT_EQ((int)(22 * hour),
+		      (int)(next_local_midnight(serve_test_time(2025, 3, 30, 1, 0)) -
+			    serve_test_time(2025, 3, 30, 1, 0)));
+	ASSERT_INT_EQ((int)(24 * hour),
+		      (int)(next_local_midnight(serve_test_time(2025, 10, 26, 1, 0)) -
+			    serve_test_time(2025, 10, 26, 1, 0)));
+
+	/* Across the year-end, one minute before midnight */
+	ASSERT_TRUE(next_local_midnight(serve_test_time(2025, 12, 31, 23, 59)) ==
+		    serve_test_time(2026, 1, 1, 0, 0));
+
+	if (tz)
+		setenv("TZ", saved_tz, 1);
+	else
+		unsetenv("TZ");
+	tzset();
+	TEST_PASS();
+}
+
+#endif /* TEST_SERVER */
+
 /*
- * Test: validate_arguments
+ * Test: run_parallel_ordered
  */
 
-static void test_validate_args_neither_set(void)
+#define POOL_TEST_TASKS 1000
+
+struct pool_test_state {
+	int ran[POOL_TEST_TASKS];
+	int worker[POOL_TEST_TASKS];
+	size_t next_consumed;
+	int out_of_order;
+};
+
+static void pool_test_run(void *arg, size_t task, int worker)
 {
-	struct vacation_args args;
+	struct pool_test_state *state = arg;
 
-	TEST_START("validate_arguments with neither annual option set returns error");
-	init_vacation_args(&args);
+	state->ran[task]++;
+	state->worker[task] = worker;
+}
 
-	ASSERT_INT_EQ(1, validate_arguments(&args));
+static void pool_test_consume(void *arg, size_t task)
+{
+	struct pool_test_state *state = arg;
+
+	if (task != state->next_consumed || state->ran[task] != 1)
+		state->out_of_order = 1;
+	state->next_consumed++;
+}
+
+static void test_parallel_ordered_threads(void)
+{
+	static struct pool_test_state state;
+
+	TEST_START("run_parallel_ordered runs every task once and consumes in order");
+	memset(&state, 0, sizeof(state));
+
+	ASSERT_INT_EQ(0, run_parallel_ordered(POOL_TEST_TASKS, 8, pool_test_run,
+					      pool_test_consume, &state));
+	ASSERT_INT_EQ(POOL_TEST_TASKS, (int)state.next_consumed);
+	ASSERT_INT_EQ(0, state.out_of_order);
 	TEST_PASS();
 }
 
-static void test_validate_args_days_only(void)
+static void test_parallel_ordered_more_threads_than_tasks(void)
 {
-	struct vacation_args args;
+	static struct pool_test_state state;
 
-	TEST_START("validate_arguments with only annual-days set");
-	init_vacation_args(&args);
-	args.annual_days_set = 1;
+	TEST_START("run_parallel_ordered with more threads than tasks");
+	memset(&state, 0, sizeof(state));
 
-	ASSERT_INT_EQ(0, validate_arguments(&args));
+	ASSERT_INT_EQ(0, run_parallel_ordered(3, 16, pool_test_run,
+					      pool_test_consume, &state));
+	ASSERT_INT_EQ(3, (int)state.next_consumed);
+	ASSERT_INT_EQ(0, state.out_of_order);
+
+	/* Only as many workers as tasks are started */
+	ASSERT_TRUE(state.worker[0] >= 0 && state.worker[0] < 3);
+	ASSERT_TRUE(state.worker[1] >= 0 && state.worker[1] < 3);
+	ASSERT_TRUE(state.worker[2] >= 0 && state.worker[2] < 3);
 	TEST_PASS();
 }
 
-static void test_validate_args_hours_only(void)
+/*
+ * Test: spsc_ring
+ */
+
+static void test_spsc_ring_order(void)
 {
-	struct vacation_args args;
+	struct spsc_ring ring;
+	int items[8];
+	int i;
 
-	TEST_START("validate_arguments with only annual-hours set");
-	init_vacation_args(&args);
-	args.annual_hours_set = 1;
+	TEST_START("spsc_ring pops items in push order across wrap-around");
+	ASSERT_INT_EQ(0, spsc_ring_init(&ring, 3));
+	ASSERT_TRUE(spsc_ring_pop(&ring) == NULL);
+
+	/* Two rounds through the four slots */
+	for (i = 0; i < 8; i++) {
+		ASSERT_INT_EQ(0, spsc_ring_push(&ring, &items[i]));
+		if (i % 2 == 1) {
+			ASSERT_TRUE(spsc_ring_pop(&ring) == &items[i - 1]);
+			ASSERT_TRUE(spsc_ring_pop(&ring) == &items[i]);
+		}
+	}
+	ASSERT_TRUE(spsc_ring_pop(&ring) == NULL);
+	spsc_ring_destroy(&ring);
+	TEST_PASS();
+}
 
-	ASSERT_INT_EQ(0, validate_arguments(&args));
+static void test_spsc_ring_full(void)
+{
+	struct spsc_ring ring;
+	int items[5];
+	int i;
+
+	TEST_START("spsc_ring rejects pushes when full");
+	ASSERT_INT_EQ(0, spsc_ring_init(&ring, 4));
+	for (i = 0; i < 4; i++)
+		ASSERT_INT_EQ(0, spsc_ring_push(&ring, &items[i]));
+	ASSERT_TRUE(spsc_ring_push(&ring, &items[4]) != 0);
+
+	ASSERT_TRUE(spsc_ring_pop(&ring) == &items[0]);
+	ASSERT_INT_EQ(0, spsc_ring_push(&ring, &items[4]));
+	for (i = 1; i < 5; i++)
+		ASSERT_TRUE(spsc_ring_pop(&ring) == &items[i]);
+	spsc_ring_destroy(&ring);
 	TEST_PASS();
 }
 
-static void test_validate_args_both_set(void)
+/*
+ * Test: arena allocator
+ */
+
+static void test_arena_alloc_aligned(void)
+{
+	struct arena arena;
+	unsigned char *a;
+	unsigned char *b;
+
+	TEST_START("arena_alloc returns aligned, non-overlapping memory");
+	arena_init(&arena, 1024);
+	a = arena_alloc(&arena, 1);
+	b = arena_alloc(&arena, 3);
+	ASSERT_TRUE(a != NULL && b != NULL);
+	ASSERT_INT_EQ(0, (int)((uintptr_t)a % ARENA_ALIGN));
+	ASSERT_INT_EQ(0, (int)((uintptr_t)b % ARENA_ALIGN));
+	ASSERT_TRUE(b >= a + 1);
+	ASSERT_INT_EQ(2, (int)arena.allocations);
+	ASSERT_INT_EQ(2 * ARENA_ALIGN, (int)arena.bytes);
+	ASSERT_INT_EQ(1024, (int)arena.reserved);
+	arena_release(&arena);
+	ASSERT_INT_EQ(0, (int)arena.reserved);
+	TEST_PASS();
+}
+
+static void test_arena_reset_reuses_blocks(void)
 {
-	struct vacation_args args;
+	struct arena arena;
+	size_t reserved;
+	void *first;
+	int round;
+	int i;
 
-	TEST_START("validate_arguments with both annual options set");
-	init_vacation_args(&args);
-	args.annual_days_set = 1;
-	args.annual_hours_set = 1;
+	TEST_START("arena_reset reuses blocks without growing");
+	arena_init(&arena, 1024);
+	first = arena_alloc(&arena, 100);
+	for (i = 1; i < 30; i++)
+		ASSERT_TRUE(arena_alloc(&arena, 100) != NULL);
+	reserved = arena.reserved;
+	ASSERT_TRUE(reserved >= 30 * 100);
+
+	for (round = 0; round < 3; round++) {
+		arena_reset(&arena);
+		ASSERT_TRUE(arena_alloc(&arena, 100) == first);
+		for (i = 1; i < 30; i++)
+			ASSERT_TRUE(arena_alloc(&arena, 100) != NULL);
+		ASSERT_INT_EQ((int)reserved, (int)arena.reserved);
+	}
+	ASSERT_INT_EQ(4 * 30, (int)arena.allocations);
+	arena_release(&arena);
+	TEST_PASS();
+}
 
-	ASSERT_INT_EQ(1, validate_arguments(&args));
+static void test_arena_large_alloc(void)
+{
+	struct arena arena;
+	unsigned char *big;
+
+	TEST_START("arena_alloc serves requests larger than a block");
+	arena_init(&arena, 256);
+	ASSERT_TRUE(arena_alloc(&arena, 16) != NULL);
+	big = arena_alloc(&arena, 4000);
+	ASSERT_TRUE(big != NULL);
+	memset(big, 0xff, 4000);
+	ASSERT_TRUE(arena.reserved >= 256 + 4000);
+	ASSERT_TRUE(arena_alloc(&arena, (size_t)-1) == NULL);
+	arena_release(&arena);
 	TEST_PASS();
 }
 
@@ -1311,6 +3932,717 @@ static void test_get_current_year_valid_range(void)
 	TEST_PASS();
 }
 
+static void test_get_current_date_matches(void)
+{
+	struct date today;
+
+	TEST_START("get_current_date matches get_current_month and year");
+	ASSERT_INT_EQ(0, get_current_date(&today));
+
+	ASSERT_INT_EQ(get_current_month(), today.month);
+	ASSERT_INT_EQ(get_current_year(), today.year);
+	ASSERT_TRUE(today.day >= 1 &&
+		    today.day <= days_in_month(today.month, today.year));
+	TEST_PASS();
+}
+
+static void test_parse_date(void)
+{
+	struct date d;
+
+	TEST_START("parse_date accepts YYYY-MM-DD dates only");
+	ASSERT_INT_EQ(0, parse_date("2024-02-29", &d));
+	ASSERT_INT_EQ(2024, d.year);
+	ASSERT_INT_EQ(2, d.month);
+	ASSERT_INT_EQ(29, d.day);
+	ASSERT_INT_EQ(1, parse_date("2025-02-29", &d));
+	ASSERT_INT_EQ(1, parse_date("2025-13-01", &d));
+	ASSERT_INT_EQ(1, parse_date("2025-1-01", &d));
+	ASSERT_INT_EQ(1, parse_date("2025-01-1 ", &d));
+	ASSERT_INT_EQ(1, parse_date("+025-01-01", &d));
+	ASSERT_INT_EQ(1, parse_date("2025-01-01T00", &d));
+	ASSERT_INT_EQ(1, parse_date("", &d));
+	TEST_PASS();
+}
+
+/*
+ * Test: run_batch
+ */
+
+/* Longer than a binary record's ID, and too long for one block of them */
+#define LONG_ID_LENGTH		200
+#define LONG_ID_RECORDS		300
+
+static void test_run_batch_long_ids(void)
+{
+	const char *csv_path = "test_batch_ids.csv.tmp";
+	const char *out_path = "test_batch_ids.out.tmp";
+	static char out[128 * 1024];
+	char id[LONG_ID_LENGTH + 1];
+	struct vacation_args defaults;
+	char *row;
+	long len;
+	int status;
+	int saved;
+	int i;
+	FILE *file;
+
+	TEST_START("run_batch passes long IDs through text and rejects them in bin");
+	file = fopen(csv_path, "w");
+	ASSERT_TRUE(file != NULL);
+	memset(id, 'x', LONG_ID_LENGTH);
+	id[LONG_ID_LENGTH] = '\0';
+	for (i = 0; i < LONG_ID_RECORDS; i++) {
+		sprintf(id, "E%03d", i);
+		id[4] = 'x';
+		fprintf(file, "%s,20,,100\n", id);
+	}
+	fclose(file);
+
+	init_vacation_args(&defaults);
+	defaults.batch_file = csv_path;
+	ASSERT_INT_EQ(0, prepare_arguments(&defaults));
+	saved = redirect_stream(stdout, out_path);
+	ASSERT_TRUE(saved >= 0);
+	status = run_batch(&defaults, 6, 2025);
+	restore_stream(stdout, saved);
+	ASSERT_INT_EQ(0, status);
+
+	/* The header, then every record in input order */
+	len = read_test_file(out_path, out, sizeof(out));
+	ASSERT_TRUE(len > 0);
+	row = strchr(out, '\n') + 1;
+	for (i = 0; i < LONG_ID_RECORDS; i++) {
+		sprintf(id, "E%03d", i);
+		id[4] = 'x';
+		ASSERT_TRUE(strncmp(row, id, LONG_ID_LENGTH) == 0);
+		ASSERT_TRUE(row[LONG_ID_LENGTH] == ',');
+		row = strchr(row, '\n') + 1;
+	}
+	ASSERT_TRUE(row == out + len);
+
+	/* A binary record has room for 31 characters only */
+	file = fopen(csv_path, "w");
+	ASSERT_TRUE(file != NULL);
+	fprintf(file, "E1,20,,100\n%s,20,,100\n", id);
+	fclose(file);
+	defaults.output_format = OUTPUT_FORMAT_BIN;
+	saved = redirect_stream(stdout, out_path);
+	ASSERT_TRUE(saved >= 0);
+	status = run_batch(&defaults, 6, 2025);
+	restore_stream(stdout, saved);
+	ASSERT_INT_EQ(1, status);
+	ASSERT_INT_EQ(RESULT_HEADER_SIZE + RESULT_RECORD_SIZE,
+		      (int)read_test_file(out_path, out, sizeof(out)));
+
+	remove(csv_path);
+	remove(out_path);
+	TEST_PASS();
+}
+
+/* Records of the batch mode comparisons, enough for three block I/O blocks */
+#define MODE_TEST_RECORDS	40000
+
+/*
+ * Write the input of the batch mode comparisons: valid and rejected records,
+ * comments and a header, a long valid line across the first block I/O
+ * boundary, an over-long one across the second and one over a megabyte.
+ * Returns: 0 on success, non-zero on error
+ */
+static int write_batch_mode_csv(const char *path)
+{
+	static const char *departments[] = {
+		"HEADQUARTERS-FINANCE-AND-PAYROLL", "SUBSIDIARY-B-WAREHOUSE",
+		"SUBSIDIARY-C-CUSTOMER-SERVICE", "RESEARCH"
+	};
+	char long_id[BATCH_MAX_LINE + 200];
+	long offset;
+	int valid_long = 0, over_long = 0;
+	FILE *file;
+	int i, k;
+
+	file = fopen(path, "w");
+	if (!file)
+		return 1;
+
+	memset(long_id, 'L', sizeof(long_id) - 1);
+	long_id[sizeof(long_id) - 1] = '\0';
+	offset = fprintf(file, "id,annual_days,annual_hours,current_hours,vacation_extra,week_start,special_accum,policy\n");
+	for (i = 0; i < MODE_TEST_RECORDS; i++) {
+		if (!valid_long && offset > ASYNC_IO_BLOCK_SIZE - 500) {
+			offset += fprintf(file, "%.*s,20,,100\n", 900, long_id);
+			valid_long = 1;
+		}
+		if (!over_long && offset > 2 * ASYNC_IO_BLOCK_SIZE - 500) {
+			offset += fprintf(file, "%s,20,,100\n", long_id);
+			over_long = 1;
+
+			/* Longer than the input window of --threads 4 */
+			for (k = 0; k < 1200; k++)
+				offset += fprintf(file, "%s", long_id);
+			offset += fprintf(file, ",20,,100\n");
+		}
+		if (i % 1000 == 999)
+			offset += fprintf(file, "# %d\n", i);
+
+		if (i % 97 == 13)
+			offset += fprintf(file, "E%06d,99,,10\n", i);
+		else if (i % 97 == 41)
+			offset += fprintf(file, "E%06d,20,,10,,friday\n", i);
+		else
+			offset += fprintf(file, "EMPLOYEE-%06d-%s,%d,,%d.%02d,%s,%s,%d\n",
+					  i, departments[i % 4],
+					  15 + i % 10, i * 7919 % 300, i % 100,
+					  i % 5 == 0 ? "1.5" : "",
+					  i % 3 == 0 ? "monday" : "", i % 2);
+	}
+
+	if (fclose(file) != 0 || !valid_long || !over_long)
+		return 1;
+	return 0;
+}
+
+/*
+ * Run a batch with stdout and stderr sent to files.
+ * Returns: the status of run_batch, or -1 if the streams cannot be
+ *          redirected
+ */
+static int run_batch_captured(const struct vacation_args *args,
+			      const char *out_path, const char *err_path)
+{
+	int saved_out, saved_err;
+	int status;
+
+	saved_out = redirect_stream(stdout, out_path);
+	if (saved_out < 0)
+		return -1;
+	saved_err = redirect_stream(stderr, err_path);
+	if (saved_err < 0) {
+		restore_stream(stdout, saved_out);
+		return -1;
+	}
+
+	status = run_batch(args, 6, 2025);
+	restore_stream(stderr, saved_err);
+	restore_stream(stdout, saved_out);
+	return status;
+}
+
+/*
+ * Run the batch mode comparison input serially and in another mode, in
+ * text, JSON Lines and fixed-point text.
+ * Returns: 0 if both runs fail with the same status and print the same
+ *          bytes to stdout and stderr, non-zero otherwise
+ */
+static int compare_batch_mode(int num_threads, int pipeline, int io_backend)
+{
+	static const int formats[][2] = {
+		{ OUTPUT_FORMAT_TEXT, 0 },
+		{ OUTPUT_FORMAT_JSONL, 0 },
+		{ OUTPUT_FORMAT_TEXT, 1 }
+	};
+	const char *csv_path = "test_batch_modes.csv.tmp";
+	struct vacation_args serial, args;
+	size_t i;
+	int ret = 1;
+
+	if (write_batch_mode_csv(csv_path) != 0)
+		goto out;
+
+	for (i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+		int status;
+
+		init_vacation_args(&serial);
+		serial.batch_file = csv_path;
+		serial.output_format = formats[i][0];
+		serial.fixed_point = formats[i][1];
+		args = serial;
+		args.num_threads = num_threads;
+		args.pipeline = pipeline;
+		args.io_backend = io_backend;
+		if (prepare_arguments(&serial) != 0 ||
+		    prepare_arguments(&args) != 0)
+			goto out;
+
+		/* Every run rejects records */
+		status = run_batch_captured(&serial, "test_batch_serial.out.tmp",
+					    "test_batch_serial.err.tmp");
+		if (status != 1 ||
+		    run_batch_captured(&args, "test_batch_mode.out.tmp",
+				       "test_batch_mode.err.tmp") != status)
+			goto out;
+
+		if (!same_test_files("test_batch_serial.out.tmp",
+				     "test_batch_mode.out.tmp") ||
+		    !same_test_files("test_batch_serial.err.tmp",
+				     "test_batch_mode.err.tmp"))
+			goto out;
+	}
+	ret = 0;
+out:
+	remove(csv_path);
+	remove("test_batch_serial.out.tmp");
+	remove("test_batch_serial.err.tmp");
+	remove("test_batch_mode.out.tmp");
+	remove("test_batch_mode.err.tmp");
+	return ret;
+}
+
+static void test_run_batch_pipeline_matches_serial(void)
+{
+	TEST_START("run_batch with --pipeline prints the bytes of a serial run");
+	ASSERT_INT_EQ(0, compare_batch_mode(3, 1, IO_BACKEND_STDIO));
+	ASSERT_INT_EQ(0, compare_batch_mode(1, 1, IO_BACKEND_STDIO));
+	TEST_PASS();
+}
+
+static void test_run_batch_threads_match_serial(void)
+{
+	TEST_START("run_batch with --threads prints the bytes of a serial run");
+	ASSERT_INT_EQ(0, compare_batch_mode(4, 0, IO_BACKEND_STDIO));
+	TEST_PASS();
+}
+
+static void test_run_batch_io_matches_serial(void)
+{
+	TEST_START("run_batch with --io prints the bytes of a serial run");
+	ASSERT_INT_EQ(0, compare_batch_mode(1, 0, IO_BACKEND_PREAD));
+	ASSERT_INT_EQ(0, compare_batch_mode(1, 0, IO_BACKEND_URING));
+	TEST_PASS();
+}
+
+/*
+ * Test: snapshots
+ */
+
+static void test_snapshot_round_trip(void)
+{
+	const char *csv_path = "test_snapshot.csv.tmp";
+	const char *path = "test_snapshot.tmp";
+	struct vacation_args defaults;
+	struct vacation_snapshot snapshot;
+	FILE *file;
+
+	TEST_START("write_snapshot stores resolved records in columns");
+	init_vacation_args(&defaults);
+	defaults.batch_file = csv_path;
+	ASSERT_INT_EQ(0, prepare_arguments(&defaults));
+
+	file = fopen(csv_path, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs("id,annual_days,annual_hours,current_hours,vacation_extra,week_start,special_accum,policy\n"
+	      "E100,20,,150.5,2.5,monday,1\n"
+	      "# comment\n"
+	      "E101,,202,100\n", file);
+	fclose(file);
+
+	ASSERT_INT_EQ(0, write_snapshot(&defaults, path));
+	ASSERT_INT_EQ(0, open_snapshot(path, &snapshot));
+	ASSERT_INT_EQ(2, (int)snapshot.count);
+	ASSERT_TRUE(strcmp(snapshot.id[0], "E100") == 0);
+	ASSERT_TRUE(strcmp(snapshot.id[1], "E101") == 0);
+	ASSERT_INT_EQ(20, snapshot.annual_days[0]);
+	ASSERT_INT_EQ(40, snapshot.max_accum_days[0]);
+	ASSERT_DOUBLE_EQ(150.5, snapshot.current_hours[0]);
+	ASSERT_DOUBLE_EQ(2.5, snapshot.vacation_extra[0]);
+	ASSERT_INT_EQ(WEEK_START_MONDAY, snapshot.week_start[0]);
+	ASSERT_INT_EQ(24, snapshot.annual_days[1]);
+	ASSERT_INT_EQ(36, snapshot.max_accum_days[1]);
+	ASSERT_DOUBLE_EQ(100.0, snapshot.current_hours[1]);
+	ASSERT_INT_EQ(WEEK_START_SUNDAY, snapshot.week_start[1]);
+	close_snapshot(&snapshot);
+
+	remove(csv_path);
+	remove(path);
+	TEST_PASS();
+}
+
+static void test_snapshot_matches_batch(void)
+{
+	const char *csv_path = "test_snapshot.csv.tmp";
+	const char *path = "test_snapshot.tmp";
+	const char *batch_out = "test_snapshot_batch.out.tmp";
+	const char *snapshot_out = "test_snapshot_run.out.tmp";
+	static char expected[4096];
+	static char actual[4096];
+	struct vacation_args defaults;
+	long expected_len;
+	long actual_len;
+	int batch_status;
+	int snapshot_status;
+	int saved;
+	FILE *file;
+
+	TEST_START("run_snapshot prints the rows of run_batch");
+	init_vacation_args(&defaults);
+	defaults.batch_file = csv_path;
+	ASSERT_INT_EQ(0, prepare_arguments(&defaults));
+
+	/* E102 takes more extra days than there are working days since May */
+	file = fopen(csv_path, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs("id,annual_days,annual_hours,current_hours,vacation_extra,week_start,special_accum,policy\n"
+	      "E100,20,,150.5,2.5,monday,1\n"
+	      "E101,,202,100\n"
+	      "E102,18,,90,200,sunday\n"
+	      "E103,24,,310.2,,sunday\n", file);
+	fclose(file);
+	ASSERT_INT_EQ(0, write_snapshot(&defaults, path));
+
+	saved = redirect_stream(stdout, batch_out);
+	ASSERT_TRUE(saved >= 0);
+	batch_status = run_batch(&defaults, 6, 2025);
+	restore_stream(stdout, saved);
+
+	defaults.batch_file = NULL;
+	defaults.snapshot_file = path;
+	saved = redirect_stream(stdout, snapshot_out);
+	ASSERT_TRUE(saved >= 0);
+	snapshot_status = run_snapshot(&defaults, 6, 2025);
+	restore_stream(stdout, saved);
+
+	ASSERT_INT_EQ(1, batch_status);
+	ASSERT_INT_EQ(batch_status, snapshot_status);
+	expected_len = read_test_file(batch_out, expected, sizeof(expected));
+	actual_len = read_test_file(snapshot_out, actual, sizeof(actual));
+	ASSERT_TRUE(expected_len > 0);
+	ASSERT_TRUE(strstr(expected, "E103,") != NULL);
+	ASSERT_TRUE(strstr(expected, "E102,") == NULL);
+	ASSERT_TRUE(actual_len == expected_len);
+	ASSERT_TRUE(memcmp(actual, expected, (size_t)actual_len) == 0);
+
+	remove(csv_path);
+	remove(path);
+	remove(batch_out);
+	remove(snapshot_out);
+	TEST_PASS();
+}
+
+static void test_snapshot_rejects_invalid_files(void)
+{
+	const char *path = "test_snapshot.tmp";
+	struct vacation_snapshot snapshot;
+	char header[SNAPSHOT_HEADER_SIZE];
+	FILE *file;
+
+	TEST_START("open_snapshot rejects foreign and truncated files");
+	memset(header, 0, sizeof(header));
+	memcpy(header, "VACRES01", 8);
+	file = fopen(path, "wb");
+	ASSERT_TRUE(file != NULL);
+	fwrite(header, 1, sizeof(header), file);
+	fclose(file);
+	ASSERT_INT_EQ(1, open_snapshot(path, &snapshot));
+
+	/* A valid header announcing one record, without its columns */
+	memcpy(header, SNAPSHOT_MAGIC, 8);
+	header[8] = SNAPSHOT_VERSION;
+	header[12] = SNAPSHOT_HEADER_SIZE;
+	header[16] = 1;
+	file = fopen(path, "wb");
+	ASSERT_TRUE(file != NULL);
+	fwrite(header, 1, sizeof(header), file);
+	fclose(file);
+	ASSERT_INT_EQ(1, open_snapshot(path, &snapshot));
+
+	remove(path);
+	TEST_PASS();
+}
+
+/*
+ * Test: delta reprojection
+ */
+
+#define DELTA_PRIOR_PATH	"test_delta_prior.tmp"
+#define DELTA_JOURNAL_PATH	"test_delta_journal.tmp"
+#define DELTA_OUTPUT_PATH	"test_delta_out.tmp"
+#define DELTA_RECORDS		3
+
+/* E102 uses more extra days than July leaves, but not more than June */
+static const char delta_prior_csv[] =
+	"id,annual_days,annual_hours,current_hours,vacation_extra,week_start\n"
+	"E100,20,,150.5,2.5,monday\n"
+	"E101,,202,100\n"
+	"E102,18,,90,160,sunday\n";
+
+static int write_test_text(const char *path, const char *text)
+{
+	FILE *file;
+
+	file = fopen(path, "w");
+	if (!file)
+		return 1;
+	fputs(text, file);
+	return fclose(file) != 0;
+}
+
+/*
+ * Write the June 2025 --format bin results of delta_prior_csv to
+ * DELTA_PRIOR_PATH and read them into prior.
+ * Returns: 0 on success, non-zero on error
+ */
+static int write_delta_prior(char *prior, size_t size)
+{
+	const char *csv_path = "test_delta_prior.csv.tmp";
+	struct vacation_args defaults;
+	int status;
+	int saved;
+
+	if (write_test_text(csv_path, delta_prior_csv) != 0)
+		return 1;
+
+	init_vacation_args(&defaults);
+	defaults.batch_file = csv_path;
+	defaults.output_format = OUTPUT_FORMAT_BIN;
+	if (prepare_arguments(&defaults) != 0)
+		return 1;
+
+	saved = redirect_stream(stdout, DELTA_PRIOR_PATH);
+	if (saved < 0)
+		return 1;
+	status = run_batch(&defaults, 6, 2025);
+	restore_stream(stdout, saved);
+	remove(csv_path);
+
+	if (status != 0 ||
+	    read_test_file(DELTA_PRIOR_PATH, prior, size) !=
+	    RESULT_HEADER_SIZE + DELTA_RECORDS * RESULT_RECORD_SIZE)
+		return 1;
+	return 0;
+}
+
+/*
+ * Refresh DELTA_PRIOR_PATH with a journal in a month of 2025 and read the
+ * output into out (length in out_len).
+ * Returns: the status of run_delta, or -1 if it could not be run
+ */
+static int run_test_delta(const char *journal, int month, char *out,
+			  size_t size, long *out_len)
+{
+	struct vacation_args defaults;
+	int status;
+	int saved;
+
+	if (write_test_text(DELTA_JOURNAL_PATH, journal) != 0)
+		return -1;
+
+	init_vacation_args(&defaults);
+	defaults.previous_file = DELTA_PRIOR_PATH;
+	defaults.journal_file = DELTA_JOURNAL_PATH;
+	defaults.output_format = OUTPUT_FORMAT_BIN;
+	if (prepare_arguments(&defaults) != 0)
+		return -1;
+
+	saved = redirect_stream(stdout, DELTA_OUTPUT_PATH);
+	if (saved < 0)
+		return -1;
+	status = run_delta(&defaults, month, 2025);
+	restore_stream(stdout, saved);
+
+	*out_len = read_test_file(DELTA_OUTPUT_PATH, out, size);
+	return status;
+}
+
+static const char *delta_record(const char *buf, int i)
+{
+	return buf + RESULT_HEADER_SIZE + (size_t)i * RESULT_RECORD_SIZE;
+}
+
+static void remove_delta_files(void)
+{
+	remove(DELTA_PRIOR_PATH);
+	remove(DELTA_JOURNAL_PATH);
+	remove(DELTA_OUTPUT_PATH);
+}
+
+static void test_delta_later_line_replaces_earlier(void)
+{
+	static char prior[4096];
+	static char out[4096];
+	struct result_record record;
+	long len;
+
+	TEST_START("run_delta merges the last journal line of an ID");
+	ASSERT_INT_EQ(0, write_delta_prior(prior, sizeof(prior)));
+	ASSERT_INT_EQ(0, run_test_delta("id,current_hours,vacation_extra\n"
+					 "E100,100,3\n"
+					 "E101,50,4\n"
+					 "E100,120,\n", 6, out, sizeof(out),
+					 &len));
+	ASSERT_INT_EQ(RESULT_HEADER_SIZE + DELTA_RECORDS * RESULT_RECORD_SIZE,
+		      (int)len);
+
+	/* The extra days of line 2 are dropped with it */
+	decode_result_record((const unsigned char *)delta_record(out, 0),
+			     &record);
+	ASSERT_TRUE(strcmp(record.id, "E100") == 0);
+	ASSERT_DOUBLE_EQ(120.0, record.current_hours);
+	ASSERT_DOUBLE_EQ(2.5, record.vacation_extra);
+
+	decode_result_record((const unsigned char *)delta_record(out, 1),
+			     &record);
+	ASSERT_TRUE(strcmp(record.id, "E101") == 0);
+	ASSERT_DOUBLE_EQ(50.0, record.current_hours);
+	ASSERT_DOUBLE_EQ(4.0, record.vacation_extra);
+
+	remove_delta_files();
+	TEST_PASS();
+}
+
+static void test_delta_copies_unchanged_records(void)
+{
+	static char prior[4096];
+	static char out[4096];
+	long len;
+
+	TEST_START("run_delta copies records without changes byte for byte");
+	ASSERT_INT_EQ(0, write_delta_prior(prior, sizeof(prior)));
+	ASSERT_INT_EQ(0, run_test_delta("E101,50\n", 6, out, sizeof(out),
+					 &len));
+	ASSERT_INT_EQ(RESULT_HEADER_SIZE + DELTA_RECORDS * RESULT_RECORD_SIZE,
+		      (int)len);
+	ASSERT_TRUE(memcmp(out, prior, RESULT_HEADER_SIZE) == 0);
+	ASSERT_TRUE(memcmp(delta_record(out, 0), delta_record(prior, 0),
+			   RESULT_RECORD_SIZE) == 0);
+	ASSERT_TRUE(memcmp(delta_record(out, 1), delta_record(prior, 1),
+			   RESULT_RECORD_SIZE) != 0);
+	ASSERT_TRUE(memcmp(delta_record(out, 2), delta_record(prior, 2),
+			   RESULT_RECORD_SIZE) == 0);
+
+	remove_delta_files();
+	TEST_PASS();
+}
+
+static void test_delta_rejects_unknown_id(void)
+{
+	static char prior[4096];
+	static char out[4096];
+	long len;
+
+	TEST_START("run_delta rejects IDs missing from the prior results");
+	ASSERT_INT_EQ(0, write_delta_prior(prior, sizeof(prior)));
+	ASSERT_INT_EQ(1, run_test_delta("E999,10\n", 6, out, sizeof(out),
+					 &len));
+
+	/* The prior results are still written */
+	ASSERT_INT_EQ(RESULT_HEADER_SIZE + DELTA_RECORDS * RESULT_RECORD_SIZE,
+		      (int)len);
+	ASSERT_TRUE(memcmp(out, prior, (size_t)len) == 0);
+
+	remove_delta_files();
+	TEST_PASS();
+}
+
+static void test_delta_month_rollover(void)
+{
+	static char prior[4096];
+	static char out[4096];
+	struct result_record record;
+	struct vacation_input input;
+	struct vacation_result result;
+	long len;
+	int i;
+
+	TEST_START("run_delta recalculates every record in a new month");
+	ASSERT_INT_EQ(0, write_delta_prior(prior, sizeof(prior)));
+
+	/* E102 is rejected: its 160 extra days exceed July's limit */
+	ASSERT_INT_EQ(1, run_test_delta("id,current_hours,vacation_extra\n",
+					 7, out, sizeof(out), &len));
+	ASSERT_INT_EQ(RESULT_HEADER_SIZE + DELTA_RECORDS * RESULT_RECORD_SIZE,
+		      (int)len);
+
+	for (i = 0; i < 2; i++) {
+		decode_result_record((const unsigned char *)delta_record(out, i),
+				     &record);
+		ASSERT_INT_EQ(7, (int)record.current_month);
+
+		memset(&input, 0, sizeof(input));
+		input.annual_days = record.annual_days;
+		input.max_accum_days = record.max_accum_days;
+		input.current_hours = record.current_hours;
+		input.current_month = 7;
+		input.current_year = 2025;
+		input.vacation_extra = record.vacation_extra;
+		input.week_start = record.week_start;
+		calculate_vacation(&input, &result);
+		ASSERT_DOUBLE_EQ(result.total_hours, record.total_hours);
+		ASSERT_DOUBLE_EQ(result.excess_days, record.excess_days);
+	}
+
+	ASSERT_TRUE(memcmp(delta_record(out, 2), delta_record(prior, 2),
+			   RESULT_RECORD_SIZE) == 0);
+
+	remove_delta_files();
+	TEST_PASS();
+}
+
+/*
+ * Test: async_file
+ */
+
+/* Two and a half blocks, so reads and writes wrap around the buffers */
+#define BLOCK_IO_TEST_SIZE	(ASYNC_IO_BLOCK_SIZE * 5 / 2 + 17)
+
+static void test_async_file_round_trip(void)
+{
+	static const int backends[] = { IO_BACKEND_PREAD, IO_BACKEND_URING };
+	const char *path = "test_block_io.tmp";
+	static char data[BLOCK_IO_TEST_SIZE];
+	static char copy[BLOCK_IO_TEST_SIZE + 3];
+	struct async_file *file;
+	size_t done, chunk, len;
+	char *block;
+	FILE *stream;
+	int status;
+	int i;
+
+	TEST_START("async_file writes and reads back blocks with pread and io_uring");
+	for (len = 0; len < sizeof(data); len++)
+		data[len] = (char)(len * 31 + len / 4096);
+
+	for (i = 0; i < 2; i++) {
+		/* Writes of growing sizes, between stdio writes */
+		stream = fopen(path, "wb");
+		ASSERT_TRUE(stream != NULL);
+		fputs("header\n", stream);
+		fflush(stream);
+		file = async_file_open(stream, backends[i], 1);
+		ASSERT_TRUE(file != NULL);
+		for (done = 0, chunk = 1; done < sizeof(data); chunk = chunk * 3 + 1) {
+			len = sizeof(data) - done < chunk ? sizeof(data) - done : chunk;
+			ASSERT_INT_EQ(0, async_file_write(file, data + done, len));
+			done += len;
+		}
+		ASSERT_INT_EQ(0, async_file_close(file));
+		fputs("end", stream);
+		fclose(stream);
+
+		/* Read back from after the header */
+		stream = fopen(path, "rb");
+		ASSERT_TRUE(stream != NULL);
+		fseek(stream, 7, SEEK_SET);
+		file = async_file_open(stream, backends[i], 0);
+		ASSERT_TRUE(file != NULL);
+		done = 0;
+		while ((status = async_file_read(file, &block, &len)) == 1) {
+			ASSERT_TRUE(len <= sizeof(copy) - done);
+			memcpy(copy + done, block, len);
+			done += len;
+		}
+		ASSERT_INT_EQ(0, status);
+		ASSERT_INT_EQ(0, async_file_read(file, &block, &len));
+		ASSERT_INT_EQ(0, async_file_close(file));
+		fclose(stream);
+		remove(path);
+
+		ASSERT_INT_EQ((int)sizeof(copy), (int)done);
+		ASSERT_TRUE(memcmp(data, copy, sizeof(data)) == 0);
+		ASSERT_TRUE(memcmp(copy + sizeof(data), "end", 3) == 0);
+	}
+	TEST_PASS();
+}
+
 /*
  * Test suites
  */
@@ -1327,6 +4659,7 @@ static void run_parse_integer_tests(void)
 	test_parse_integer_mixed_rejected();
 	test_parse_integer_empty_rejected();
 	test_parse_integer_whitespace_only_rejected();
+	test_parse_integer_range();
 }
 
 static void run_parse_number_tests(void)
@@ -1338,6 +4671,11 @@ static void run_parse_number_tests(void)
 	test_parse_number_with_whitespace();
 	test_parse_number_text_rejected();
 	test_parse_number_empty_rejected();
+	test_parse_number_forms();
+	test_parse_number_malformed_rejected();
+	test_parse_number_span_not_terminated();
+	test_parse_number_matches_strtod();
+	test_parse_number_long();
 }
 
 static void run_leap_year_tests(void)
@@ -1381,6 +4719,8 @@ static void run_working_days_tests(void)
 	test_working_days_january_2025_sunday();
 	test_working_days_january_2025_monday();
 	test_working_days_invalid_month();
+	test_working_days_full_cycle();
+	test_working_days_cycle_wraparound();
 }
 
 static void run_remaining_working_days_tests(void)
@@ -1402,6 +4742,28 @@ static void run_working_days_from_prev_month_tests(void)
 	test_working_days_from_prev_month_monday_start();
 }
 
+static void run_working_days_between_tests(void)
+{
+	printf("\n[Working Days Between Dates]\n");
+	test_working_days_between_leave_period();
+	test_working_days_between_single_day();
+	test_working_days_between_reversed();
+	test_working_days_between_matches_day_loop();
+	test_working_days_between_month_ranges();
+	test_remaining_working_days_full_cycle();
+}
+
+static void run_holiday_calendar_tests(void)
+{
+	printf("\n[Holiday Calendars]\n");
+	test_holiday_calendar_month();
+	test_holiday_calendar_empty();
+	test_holiday_calendar_invalid();
+	test_holiday_calendar_matches_day_loop();
+	test_holiday_calendar_vacation();
+	test_load_holiday_calendar();
+}
+
 static void run_validate_vacation_days_tests(void)
 {
 	printf("\n[Validate Vacation Days]\n");
@@ -1429,6 +4791,14 @@ static void run_validate_annual_days_tests(void)
 	test_validate_annual_days_very_large();
 }
 
+static void run_validation_error_tests(void)
+{
+	printf("\n[Validation Errors]\n");
+	test_check_vacation_days_errors();
+	test_check_arguments_errors();
+	test_format_validation_error();
+}
+
 static void run_max_accum_tests(void)
 {
 	printf("\n[Max Accumulated Days - Normal Case]\n");
@@ -1444,6 +4814,14 @@ static void run_max_accum_tests(void)
 	test_max_accum_special_24_days();
 }
 
+static void run_policy_tests(void)
+{
+	printf("\n[Accrual Policies]\n");
+	test_compile_policy_builtin();
+	test_policy_lookups();
+	test_load_policy_file();
+}
+
 static void run_conversion_tests(void)
 {
 	printf("\n[Conversion Functions]\n");
@@ -1524,6 +4902,53 @@ static void run_integration_tests(void)
 	test_calculate_vacation_vacation_prevents_excess();
 	test_calculate_vacation_remaining_days_sunday();
 	test_calculate_vacation_remaining_days_monday();
+	test_calculate_vacation_batch_bit_identical();
+	test_calculate_vacation_batch_empty();
+}
+
+static void run_fixed_point_tests(void)
+{
+	printf("\n[Fixed-Point Mode]\n");
+	test_centi_hours_conversions();
+	test_centi_hours_to_centi_days();
+	test_format_centi_value();
+	test_calculate_vacation_fixed_exact();
+	test_calculate_vacation_fixed_matches_double();
+	test_calculate_vacation_batch_fixed();
+}
+
+static void run_output_tests(void)
+{
+	printf("\n[Output Formatting]\n");
+	test_format_double_value_special();
+	test_format_double_value_matches_snprintf();
+	test_format_results_matches_printf();
+	test_format_result_json();
+	test_result_record_round_trip();
+	test_parse_output_format();
+	test_parse_io_backend();
+}
+
+static void run_sweep_tests(void)
+{
+	printf("\n[Scenario Sweep]\n");
+	test_parse_sweep_ranges();
+	test_calculate_vacation_sweep();
+	test_calculate_vacation_sweep_fixed();
+}
+
+static void run_timeline_tests(void)
+{
+	printf("\n[Timeline]\n");
+	test_parse_vacation_plan();
+	test_calculate_vacation_timeline();
+	test_calculate_vacation_timeline_fixed();
+}
+
+static void run_projection_tests(void)
+{
+	printf("\n[Multi-Year Projection]\n");
+	test_calculate_vacation_projection();
 }
 
 static void run_args_tests(void)
@@ -1534,6 +4959,88 @@ static void run_args_tests(void)
 	test_validate_args_days_only();
 	test_validate_args_hours_only();
 	test_validate_args_both_set();
+	test_parse_arguments_help();
+	test_parse_arguments_line();
+	test_split_argument_line_limits();
+	test_prepare_arguments_sweep_modes();
+	test_prepare_arguments_timeline_modes();
+	test_prepare_arguments_snapshot_modes();
+	test_prepare_arguments_previous_modes();
+	test_prepare_arguments_stdin_lines_modes();
+	test_run_stdin_lines_rejects();
+}
+
+static void run_batch_record_tests(void)
+{
+	printf("\n[Batch Record Parsing]\n");
+	test_batch_record_all_fields();
+	test_batch_record_annual_hours();
+	test_batch_record_defaults();
+	test_batch_record_policy();
+	test_batch_record_too_few_fields();
+	test_batch_record_too_many_fields();
+	test_batch_record_missing_current_hours();
+	test_batch_record_invalid_week_start();
+	test_journal_record_fields();
+	test_journal_record_errors();
+}
+
+static void run_batch_tests(void)
+{
+	printf("\n[Batch Runs]\n");
+	test_run_batch_long_ids();
+	test_run_batch_pipeline_matches_serial();
+	test_run_batch_threads_match_serial();
+	test_run_batch_io_matches_serial();
+}
+
+static void run_snapshot_tests(void)
+{
+	printf("\n[Snapshots]\n");
+	test_snapshot_round_trip();
+	test_snapshot_matches_batch();
+	test_snapshot_rejects_invalid_files();
+}
+
+static void run_delta_tests(void)
+{
+	printf("\n[Delta Reprojection]\n");
+	test_delta_later_line_replaces_earlier();
+	test_delta_copies_unchanged_records();
+	test_delta_rejects_unknown_id();
+	test_delta_month_rollover();
+}
+
+static void run_block_io_tests(void)
+{
+	printf("\n[Block I/O]\n");
+	test_async_file_round_trip();
+}
+
+static void run_serve_tests(void)
+{
+	printf("\n[Library Requests]\n");
+	test_serve_request_valid();
+	test_serve_request_annual_hours();
+	test_serve_request_errors();
+	test_vacation_strerror();
+	test_vacation_evaluate_shared_context();
+#ifdef TEST_SERVER
+	test_run_server_clients();
+	test_next_local_midnight();
+#endif
+}
+
+static void run_thread_pool_tests(void)
+{
+	printf("\n[Thread Pool]\n");
+	test_parallel_ordered_threads();
+	test_parallel_ordered_more_threads_than_tasks();
+	test_spsc_ring_order();
+	test_spsc_ring_full();
+	test_arena_alloc_aligned();
+	test_arena_reset_reuses_blocks();
+	test_arena_large_alloc();
 }
 
 static void run_time_tests(void)
@@ -1541,6 +5048,8 @@ static void run_time_tests(void)
 	printf("\n[Time Functions]\n");
 	test_get_current_month_valid_range();
 	test_get_current_year_valid_range();
+	test_get_current_date_matches();
+	test_parse_date();
 }
 
 int main(void)
@@ -1555,9 +5064,13 @@ int main(void)
 	run_working_days_tests();
 	run_remaining_working_days_tests();
 	run_working_days_from_prev_month_tests();
+	run_working_days_between_tests();
+	run_holiday_calendar_tests();
 	run_validate_vacation_days_tests();
 	run_validate_annual_days_tests();
+	run_validation_error_tests();
 	run_max_accum_tests();
+	run_policy_tests();
 	run_conversion_tests();
 	run_remaining_months_tests();
 	run_monthly_hours_tests();
@@ -1565,7 +5078,19 @@ int main(void)
 	run_total_hours_tests();
 	run_excess_days_tests();
 	run_integration_tests();
+	run_fixed_point_tests();
+	run_output_tests();
+	run_sweep_tests();
+	run_timeline_tests();
+	run_projection_tests();
 	run_args_tests();
+	run_batch_record_tests();
+	run_batch_tests();
+	run_snapshot_tests();
+	run_delta_tests();
+	run_block_io_tests();
+	run_serve_tests();
+	run_thread_pool_tests();
 	run_time_tests();
 
 	printf("\n========================================\n");
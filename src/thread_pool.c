@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "vacation.h"
+
+/*
+ * Work-stealing thread pool with in-order completion.
+ *
+ * Tasks are numbered 0..num_tasks-1 and initially split into one contiguous
+ * range per worker. A worker takes tasks from the front of its own range and,
+ * once it runs dry, steals from the back of another worker's range, so busy
+ * workers keep their cache-friendly sequential order while idle ones pick up
+ * the tail. The calling thread waits for tasks in index order and hands each
+ * one to the consumer, which preserves the output order.
+ */
+
+#ifdef HAVE_PTHREAD
+
+#include <pthread.h>
+
+/* Remaining tasks [head, tail) owned by one worker */
+struct work_queue {
+	pthread_mutex_t lock;
+	size_t head;
+	size_t tail;
+};
+
+struct work_pool {
+	struct work_queue *queues;
+	int num_threads;
+	size_t num_tasks;
+	void (*run)(void *arg, size_t task, int worker);
+	void *arg;
+
+	/* Completion state, protected by done_lock */
+	pthread_mutex_t done_lock;
+	pthread_cond_t done_cond;
+	unsigned char *done;
+};
+
+struct worker {
+	struct work_pool *pool;
+	int index;
+};
+
+static int take_own_task(struct work_queue *queue, size_t *task)
+{
+	int found = 0;
+
+	pthread_mutex_lock(&queue->lock);
+	if (queue->head < queue->tail) {
+		*task = queue->head++;
+		found = 1;
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	return found;
+}
+
+static int steal_task(struct work_queue *queue, size_t *task)
+{
+	int found = 0;
+
+	pthread_mutex_lock(&queue->lock);
+	if (queue->head < queue->tail) {
+		*task = --queue->tail;
+		found = 1;
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	return found;
+}
+
+static int find_task(struct work_pool *pool, int self, size_t *task)
+{
+	int i;
+
+	if (take_own_task(&pool->queues[self], task))
+		return 1;
+
+	for (i = 1; i < pool->num_threads; i++) {
+		int victim = (self + i) % pool->num_threads;
+
+		if (steal_task(&pool->queues[victim], task))
+			return 1;
+	}
+
+	return 0;
+}
+
+static void *worker_main(void *arg)
+{
+	struct worker *worker = arg;
+	struct work_pool *pool = worker->pool;
+	size_t task;
+
+	while (find_task(pool, worker->index, &task)) {
+		pool->run(pool->arg, task, worker->index);
+
+		pthread_mutex_lock(&pool->done_lock);
+		pool->done[task] = 1;
+		pthread_cond_broadcast(&pool->done_cond);
+		pthread_mutex_unlock(&pool->done_lock);
+	}
+
+	return NULL;
+}
+
+int run_parallel_ordered(size_t num_tasks, int num_threads,
+			 void (*run)(void *arg, size_t task, int worker),
+			 void (*consume)(void *arg, size_t task),
+			 void *arg)
+{
+	struct work_pool pool;
+	struct worker *workers;
+	pthread_t *threads;
+	int num_started = 0;
+	size_t task;
+	int i;
+	int ret = 0;
+
+	if (num_threads > (int)num_tasks)
+		num_threads = (int)num_tasks;
+
+	if (num_threads <= 1) {
+		for (task = 0; task < num_tasks; task++) {
+			run(arg, task, 0);
+			consume(arg, task);
+		}
+		return 0;
+	}
+
+	pool.queues = calloc(num_threads, sizeof(*pool.queues));
+	pool.done = calloc(num_tasks, sizeof(*pool.done));
+	workers = calloc(num_threads, sizeof(*workers));
+	threads = calloc(num_threads, sizeof(*threads));
+	if (!pool.queues || !pool.done || !workers || !threads) {
+		fprintf(stderr, "Error: Out of memory.\n");
+		ret = 1;
+		goto out;
+	}
+
+	pool.num_threads = num_threads;
+	pool.num_tasks = num_tasks;
+	pool.run = run;
+	pool.arg = arg;
+	pthread_mutex_init(&pool.done_lock, NULL);
+	pthread_cond_init(&pool.done_cond, NULL);
+
+	for (i = 0; i < num_threads; i++) {
+		pthread_mutex_init(&pool.queues[i].lock, NULL);
+		pool.queues[i].head = num_tasks * i / num_threads;
+		pool.queues[i].tail = num_tasks * (i + 1) / num_threads;
+	}
+
+	for (i = 0; i < num_threads; i++) {
+		workers[i].pool = &pool;
+		workers[i].index = i;
+		if (pthread_create(&threads[i], NULL, worker_main, &workers[i]) != 0)
+			break;
+		num_started++;
+	}
+
+	if (num_started == 0) {
+		/* No worker could be started: run everything on this thread */
+		workers[0].index = 0;
+		worker_main(&workers[0]);
+	} else if (num_started < num_threads) {
+		/* Tasks of workers that failed to start are stolen by the others */
+		fprintf(stderr, "Warning: Started only %d of %d threads.\n",
+			num_started, num_threads);
+	}
+
+	/* Hand completed tasks to the consumer in order */
+	for (task = 0; task < num_tasks; task++) {
+		pthread_mutex_lock(&pool.done_lock);
+		while (!pool.done[task])
+			pthread_cond_wait(&pool.done_cond, &pool.done_lock);
+		pthread_mutex_unlock(&pool.done_lock);
+
+		consume(arg, task);
+	}
+
+	for (i = 0; i < num_started; i++)
+		pthread_join(threads[i], NULL);
+
+	for (i = 0; i < num_threads; i++)
+		pthread_mutex_destroy(&pool.queues[i].lock);
+	pthread_cond_destroy(&pool.done_cond);
+	pthread_mutex_destroy(&pool.done_lock);
+
+out:
+	free(threads);
+	free(workers);
+	free(pool.done);
+	free(pool.queues);
+	return ret;
+}
+
+#else /* !HAVE_PTHREAD */
+
+int run_parallel_ordered(size_t num_tasks, int num_threads,
+			 void (*run)(void *arg, size_t task, int worker),
+			 void (*consume)(void *arg, size_t task),
+			 void *arg)
+{
+	size_t task;
+
+	(void)num_threads;	/* No thread support: run on the calling thread */
+
+	for (task = 0; task < num_tasks; task++) {
+		run(arg, task, 0);
+		consume(arg, task);
+	}
+
+	return 0;
+}
+
+#endif /* HAVE_PTHREAD */
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vacation.h"
+
+/*
+ * Month-by-month balance timeline (--timeline).
+ *
+ * The balance at the end of month m is the current balance plus the credit
+ * of the months up to m, minus the extra days (counted against the current
+ * month) and the days planned up to m. The planned days are accumulated in a
+ * single prefix-sum pass. The credit is the monthly credit times the number
+ * of months, computed as in calculate_vacation, so the December entry equals
+ * the year-end total exactly when nothing is planned.
+ */
+
+int parse_vacation_plan(const char *str, double *planned_days)
+{
+	const char *p = str;
+	double plan[MONTHS_PER_YEAR] = { 0 };
+	int i;
+
+	for (;;) {
+		const char *colon = strchr(p, ':');
+		const char *end = strchr(p, ',');
+		double days;
+		int month;
+
+		if (!end)
+			end = p + strlen(p);
+		if (!colon || colon > end)
+			return 1;
+
+		if (parse_integer_span(p, colon - p, &month) != 0 ||
+		    parse_number_span(colon + 1, end - colon - 1, &days) != 0)
+			return 1;
+		if (month < 1 || month > MONTHS_PER_YEAR || !(days >= 0))
+			return 1;
+
+		plan[month - 1] += days;
+
+		if (*end == '\0')
+			break;
+		p = end + 1;
+	}
+
+	for (i = 0; i < MONTHS_PER_YEAR; i++)
+		planned_days[i] = plan[i];
+
+	return 0;
+}
+
+void calculate_vacation_timeline(const struct vacation_input *input,
+				 const double *planned_days,
+				 struct vacation_timeline *timeline)
+{
+	double monthly_hours = calculate_monthly_hours(input->annual_days);
+	double extra_hours = days_to_hours(input->vacation_extra);
+	double planned_hours = 0.0;
+	int first = input->current_month - 1;
+	int m;
+
+	memset(timeline, 0, sizeof(*timeline));
+	timeline->first_month = input->current_month;
+
+	for (m = first; m < MONTHS_PER_YEAR; m++) {
+		double planned = planned_days ? planned_days[m] : 0.0;
+		double hours;
+
+		planned_hours += days_to_hours(planned);
+		hours = calculate_total_hours(input->current_hours,
+					      calculate_additional_hours(m - first + 1,
+									 monthly_hours));
+		hours -= extra_hours;
+		hours -= planned_hours;
+
+		timeline->planned_days[m] = planned;
+		timeline->balance_hours[m] = hours;
+		timeline->balance_days[m] = hours_to_days(hours);
+	}
+
+	timeline->excess_days = calculate_excess_days(
+		timeline->balance_days[MONTHS_PER_YEAR - 1], input->max_accum_days);
+}
+
+void calculate_vacation_timeline_fixed(const struct vacation_fixed_input *input,
+				       const int64_t *planned_centi_hours,
+				       struct vacation_fixed_timeline *timeline)
+{
+	int64_t monthly = (int64_t)input->annual_days * WORK_DAY_CENTI_HOURS /
+		MONTHS_PER_YEAR;
+	int64_t balance = input->current_centi_hours -
+		input->vacation_extra_centi_hours;
+	int64_t excess;
+	int m;
+
+	memset(timeline, 0, sizeof(*timeline));
+	timeline->first_month = input->current_month;
+
+	/* Integer sums are exact, so the prefix sum carries the balance */
+	for (m = input->current_month - 1; m < MONTHS_PER_YEAR; m++) {
+		int64_t planned = planned_centi_hours ? planned_centi_hours[m] : 0;
+
+		balance += monthly - planned;
+		timeline->planned_centi_hours[m] = planned;
+		timeline->balance_centi_hours[m] = balance;
+	}
+
+	excess = balance - (int64_t)input->max_accum_days * WORK_DAY_CENTI_HOURS;
+	timeline->excess_centi_hours = (excess > 0) ? excess : 0;
+}
+
+/*
+ * Output
+ */
+
+/* Fixed-point timelines are printed through the floating-point form */
+static void fixed_to_vacation_timeline(const struct vacation_fixed_timeline *fixed,
+				       struct vacation_timeline *timeline)
+{
+	int m;
+
+	memset(timeline, 0, sizeof(*timeline));
+	timeline->first_month = fixed->first_month;
+	for (m = fixed->first_month - 1; m < MONTHS_PER_YEAR; m++) {
+		timeline->planned_days[m] = centi_hours_to_centi_days(
+			fixed->planned_centi_hours[m]) / (double)CENTI_PER_UNIT;
+		timeline->balance_hours[m] = fixed->balance_centi_hours[m] /
+			(double)CENTI_PER_UNIT;
+		timeline->balance_days[m] = centi_hours_to_centi_days(
+			fixed->balance_centi_hours[m]) / (double)CENTI_PER_UNIT;
+	}
+	timeline->excess_days = centi_hours_to_centi_days(
+		fixed->excess_centi_hours) / (double)CENTI_PER_UNIT;
+}
+
+static void print_timeline_text(const struct vacation_input *input,
+				const struct vacation_timeline *timeline)
+{
+	char value[4][RESULT_MAX_VALUE];
+	int m;
+
+	format_double_value(value[0], sizeof(value[0]),
+			    days_to_hours(input->max_accum_days));
+	format_double_value(value[1], sizeof(value[1]), input->current_hours);
+
+	printf("=== Vacation Days Calculator: Timeline ===\n\n");
+	printf("Annual vacation: %d hours (%d days)\n",
+	       policy_annual_hours_for_days(input->policy,
+					    input->annual_days),
+	       input->annual_days);
+	printf("Maximum accumulation: %s hours (%d days)\n", value[0],
+	       input->max_accum_days);
+	printf("Current accumulated hours: %s\n", value[1]);
+	if (input->vacation_extra > 0) {
+		format_double_value(value[0], sizeof(value[0]),
+				    input->vacation_extra);
+		printf("Extra vacation days consumption: %s\n", value[0]);
+	}
+
+	printf("\nProjected balance at the end of each month of %d:\n",
+	       input->current_year);
+	printf("%5s %13s %14s %13s\n", "Month", "Planned days", "Balance hours",
+	       "Balance days");
+	for (m = timeline->first_month - 1; m < MONTHS_PER_YEAR; m++) {
+		format_double_value(value[0], sizeof(value[0]),
+				    timeline->planned_days[m]);
+		format_double_value(value[1], sizeof(value[1]),
+				    timeline->balance_hours[m]);
+		format_double_value(value[2], sizeof(value[2]),
+				    timeline->balance_days[m]);
+		printf("%5d %13s %14s %13s\n", m + 1, value[0], value[1],
+		       value[2]);
+	}
+
+	format_double_value(value[2], sizeof(value[2]),
+			    days_to_hours(timeline->excess_days));
+	format_double_value(value[3], sizeof(value[3]), timeline->excess_days);
+	printf("\nVacation to be deducted at the end of %d (exceeding max): %s hours (%s days)\n",
+	       input->current_year, value[2], value[3]);
+}
+
+static int validate_vacation_plan(const struct vacation_input *input,
+				  const double *planned_days)
+{
+	int m;
+
+	for (m = 0; m < MONTHS_PER_YEAR; m++) {
+		int working_days;
+
+		if (planned_days[m] == 0)
+			continue;
+
+		if (m + 1 < input->current_month) {
+			fprintf(stderr,
+				"Error: Planned vacation in month %d is before the current month.\n",
+				m + 1);
+			return 1;
+		}
+
+		working_days = calendar_working_days(input->holidays, m + 1,
+						     input->current_year,
+						     input->week_start);
+		if (planned_days[m] > working_days) {
+			fprintf(stderr,
+				"Error: Planned vacation days in month %d (%.1f) exceed its working days (%d).\n",
+				m + 1, planned_days[m], working_days);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int run_timeline(const struct vacation_args *args,
+		 const struct vacation_input *input)
+{
+	struct vacation_timeline timeline;
+	char buf[RESULT_MAX_JSON];
+	int m;
+
+	if (args->output_format == OUTPUT_FORMAT_BIN) {
+		fprintf(stderr,
+			"Error: --timeline supports the text and jsonl formats.\n");
+		return 1;
+	}
+
+	if (validate_vacation_plan(input, args->planned_days) != 0)
+		return 1;
+
+	if (args->fixed_point) {
+		struct vacation_fixed_input fixed_input;
+		struct vacation_fixed_timeline fixed_timeline;
+		int64_t planned[MONTHS_PER_YEAR];
+
+		if (hours_to_centi_hours(input->current_hours,
+					 &fixed_input.current_centi_hours) != 0) {
+			fprintf(stderr,
+				"Error: Current hours out of range for fixed-point mode.\n");
+			return 1;
+		}
+
+		/* Days are bounded by the validation above: always in range */
+		days_to_centi_hours(input->vacation_extra,
+				    &fixed_input.vacation_extra_centi_hours);
+		for (m = 0; m < MONTHS_PER_YEAR; m++)
+			days_to_centi_hours(args->planned_days[m], &planned[m]);
+
+		fixed_input.annual_days = input->annual_days;
+		fixed_input.max_accum_days = input->max_accum_days;
+		fixed_input.current_month = input->current_month;
+		fixed_input.current_year = input->current_year;
+		fixed_input.week_start = input->week_start;
+		fixed_input.holidays = input->holidays;
+		fixed_input.policy = input->policy;
+
+		calculate_vacation_timeline_fixed(&fixed_input, planned,
+						  &fixed_timeline);
+		fixed_to_vacation_timeline(&fixed_timeline, &timeline);
+	} else {
+		calculate_vacation_timeline(input, args->planned_days, &timeline);
+	}
+
+	if (args->output_format == OUTPUT_FORMAT_TEXT) {
+		print_timeline_text(input, &timeline);
+		return 0;
+	}
+
+	for (m = timeline.first_month; m <= MONTHS_PER_YEAR; m++)
+		fwrite(buf, 1, format_timeline_json(buf, input, &timeline, m),
+		       stdout);
+
+	return 0;
+}
@@ -1,6 +1,13 @@
 #ifndef VACATION_H
 #define VACATION_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "vacation_api.h"
+
 /* Constants */
 #define WORK_DAY_HOURS		8.4
 #define MONTHS_PER_YEAR		12
@@ -13,13 +20,86 @@
 #define MAX_ANNUAL_DAYS		24
 #define NUM_VALID_ANNUAL_OPTIONS 10
 
+/* Fixed-point mode: amounts in hundredths of an hour (centi-hours) */
+#define CENTI_PER_UNIT		100	/* Centi-hours per hour, centi-days per day */
+#define WORK_DAY_CENTI_HOURS	840	/* WORK_DAY_HOURS in centi-hours */
+#define MAX_FIXED_HOURS		1e12	/* Largest amount accepted in fixed point */
+
+/* Batch mode limits */
+#define BATCH_MAX_LINE		1024	/* Longest accepted input record */
+#define BATCH_NUM_FIELDS	8	/* Fields per input record */
+#define BATCH_BLOCK_SIZE	256	/* Records computed per kernel call */
+#define BATCH_MAX_ID		31	/* Longest ID of binary records and snapshots */
+#define BATCH_MAX_ROW		512	/* Longest formatted result row */
+#define RESULTS_MAX_TEXT	4096	/* Longest print_results output */
+
+/* Change journal (--journal): id,current_hours[,vacation_extra] */
+#define JOURNAL_FIELD_ID		0
+#define JOURNAL_FIELD_CURRENT_HOURS	1
+#define JOURNAL_FIELD_VACATION_EXTRA	2
+#define JOURNAL_NUM_FIELDS		3
+
+#define MAX_SWEEP_POINTS	100000	/* Largest --sweep grid */
+#define MAX_PROJECTION_YEARS	10	/* Longest --years projection */
+
+/* Output formats (--format) */
+#define OUTPUT_FORMAT_TEXT	0	/* Human-readable text (CSV in batch mode) */
+#define OUTPUT_FORMAT_JSONL	1	/* One JSON object per line */
+#define OUTPUT_FORMAT_BIN	2	/* Header, then fixed-size records */
+
+/* Batch file I/O backends (--io) */
+#define IO_BACKEND_STDIO	0	/* Buffered stdio streams */
+#define IO_BACKEND_PREAD	1	/* Large blocks with pread and pwrite */
+#define IO_BACKEND_URING	2	/* Large blocks in flight with io_uring */
+
+#define ASYNC_IO_BLOCK_SIZE	(1024 * 1024)	/* Bytes per read or write */
+#define ASYNC_IO_DEPTH		4	/* Blocks per file */
+
+#define RESULT_MAX_VALUE	320	/* Longest formatted number, with NUL */
+#define RESULT_MAX_JSON		4096	/* Longest JSON result line */
+#define RESULT_FILE_MAGIC	"VACRES01"	/* 8 bytes, no NUL */
+#define RESULT_FILE_VERSION	1
+#define RESULT_HEADER_SIZE	16
+#define RESULT_RECORD_SIZE	128
+#define SNAPSHOT_MAGIC		"VACSNP01"	/* 8 bytes, no NUL */
+#define SNAPSHOT_VERSION	1
+#define SNAPSHOT_HEADER_SIZE	64
+#define MAX_THREADS		256	/* Upper limit for --threads */
+#define LINE_MAX_ARGS		64	/* Most options and values per stdin line */
+
+/* Accrual policies (--policy-file) */
+#define POLICY_MAX_OPTIONS	32	/* Annual options per policy */
+#define POLICY_MAX_DAYS		64	/* Annual days are below this */
+#define POLICY_MAX_HOURS	1024	/* Annual hours are below this */
+
 /* Valid annual vacation options (days and corresponding hours) */
 extern const int VALID_ANNUAL_DAYS[NUM_VALID_ANNUAL_OPTIONS];
 extern const int VALID_ANNUAL_HOURS[NUM_VALID_ANNUAL_OPTIONS];
 
-/* Week start options */
-#define WEEK_START_SUNDAY	0
-#define WEEK_START_MONDAY	1
+/*
+ * Accrual policy compiled into direct-indexed tables, so every lookup is a
+ * single array access. Zero entries mark invalid annual days or hours.
+ */
+struct vacation_policy {
+	int id;			/* 1-POLICY_MAX_ID, 0 for the built-in policy */
+	int max_accum_days;	/* Maximum accumulation */
+	int special_accum_from;	/* Special accum applies from these annual days */
+	int special_accum_factor;	/* Special accum: annual days times this */
+	uint8_t hours_to_days[POLICY_MAX_HOURS];	/* Annual hours -> days */
+	uint16_t days_to_hours[POLICY_MAX_DAYS];	/* Annual days -> hours */
+	uint16_t max_accum[2][POLICY_MAX_DAYS];	/* Per special accum, days */
+};
+
+/* Policy file section before compilation */
+struct policy_rules {
+	int id;
+	int num_options;
+	int days[POLICY_MAX_OPTIONS];	/* Annual options: days... */
+	int hours[POLICY_MAX_OPTIONS];	/* ...and corresponding hours */
+	int max_accum_days;
+	int special_accum_from;
+	int special_accum_factor;
+};
 
 /* Structure to hold calculation inputs */
 struct vacation_input {
@@ -30,6 +110,8 @@ struct vacation_input {
 	int current_year;	/* e.g., 2025 */
 	double vacation_extra;	/* Extra vacation days consumption (X or X.5) */
 	int week_start;		/* WEEK_START_SUNDAY or WEEK_START_MONDAY */
+	const struct holiday_calendar *holidays;	/* Public holidays, or NULL */
+	const struct vacation_policy *policy;	/* Accrual policy, or NULL */
 };
 
 /* Structure to hold calculation results */
@@ -44,10 +126,216 @@ struct vacation_result {
 	int working_days_remaining;	/* Remaining working days this year */
 };
 
+/*
+ * Fixed-point calculation inputs: struct vacation_input with amounts in
+ * centi-hours. 1 day is exactly WORK_DAY_CENTI_HOURS and the monthly accrual
+ * is exactly annual_days * 70, so all results are exact.
+ */
+struct vacation_fixed_input {
+	int annual_days;
+	int max_accum_days;
+	int64_t current_centi_hours;
+	int current_month;
+	int current_year;
+	int64_t vacation_extra_centi_hours;	/* Extra vacation days in centi-hours */
+	int week_start;
+	const struct holiday_calendar *holidays;	/* Public holidays, or NULL */
+	const struct vacation_policy *policy;	/* Accrual policy, or NULL */
+};
+
+/*
+ * Fixed-point calculation results in centi-hours.
+ * Days are derived with centi_hours_to_centi_days.
+ */
+struct vacation_fixed_result {
+	int remaining_months;
+	int64_t monthly_centi_hours;
+	int64_t additional_centi_hours;
+	int64_t total_centi_hours;
+	int64_t excess_centi_hours;	/* 0 if under the maximum */
+	int working_days_remaining;
+};
+
+/*
+ * Structure-of-arrays calculation inputs for a batch of employees.
+ * Each member points to an array with one element per employee.
+ */
+struct vacation_batch_input {
+	const int *annual_days;
+	const int *max_accum_days;
+	const double *current_hours;
+	const double *vacation_extra;
+	const int *current_month;
+};
+
+/*
+ * Structure-of-arrays calculation results for a batch of employees.
+ * Fields match struct vacation_result.
+ */
+struct vacation_batch_result {
+	double *monthly_hours;
+	double *additional_hours;
+	double *additional_days;
+	double *total_hours;
+	double *total_days;
+	double *excess_days;
+};
+
+/* Structure-of-arrays fixed-point inputs, fields match vacation_fixed_input */
+struct vacation_batch_fixed_input {
+	const int *annual_days;
+	const int *max_accum_days;
+	const int64_t *current_centi_hours;
+	const int64_t *vacation_extra_centi_hours;
+	const int *current_month;
+};
+
+/* Structure-of-arrays fixed-point results, fields match vacation_fixed_result */
+struct vacation_batch_fixed_result {
+	int64_t *monthly_centi_hours;
+	int64_t *additional_centi_hours;
+	int64_t *total_centi_hours;
+	int64_t *excess_centi_hours;
+};
+
+/*
+ * Binary result file (--format bin): a RESULT_HEADER_SIZE-byte header
+ * followed by RESULT_RECORD_SIZE-byte records, all little-endian.
+ * On little-endian hosts the file can be mapped and read as an array of
+ * these structures after the header.
+ */
+struct result_file_header {
+	char magic[8];		/* RESULT_FILE_MAGIC */
+	uint32_t version;	/* RESULT_FILE_VERSION */
+	uint32_t record_size;	/* RESULT_RECORD_SIZE */
+};
+
+/* One binary result: the fields of vacation_input and vacation_result */
+struct result_record {
+	char id[BATCH_MAX_ID + 1];	/* Employee ID, NUL-padded ("" if none) */
+	int32_t annual_days;
+	int32_t max_accum_days;
+	int32_t current_month;
+	int32_t current_year;
+	int32_t week_start;
+	int32_t remaining_months;
+	int32_t working_days_remaining;
+	int32_t reserved;	/* Zero, keeps the doubles aligned */
+	double current_hours;
+	double vacation_extra;
+	double monthly_hours;
+	double additional_hours;
+	double additional_days;
+	double total_hours;
+	double total_days;
+	double excess_days;
+};
+
+/* Arena allocator */
+#define ARENA_ALIGN		16	/* Alignment of every allocation */
+#define ARENA_BLOCK_SIZE	(256 * 1024)	/* Default block size */
+
+struct arena_block;
+
+/*
+ * Bump allocator over a chain of blocks, freed all at once. The counters
+ * cover the arena's whole life, across resets.
+ */
+struct arena {
+	struct arena_block *first;
+	struct arena_block *current;	/* Block allocations come from */
+	size_t block_size;	/* Size of new blocks (larger on demand) */
+	size_t bytes;		/* Bytes allocated, after alignment */
+	size_t allocations;	/* Number of allocations */
+	size_t reserved;	/* Bytes of the blocks held */
+};
+
+/* Block reader or writer of a file (--io), see async_file_open */
+struct async_file;
+
+/* Keeps the two indexes of a ring on separate cache lines */
+#define SPSC_RING_CACHE_LINE	64
+
+/*
+ * Lock-free single-producer/single-consumer ring of pointers. One thread
+ * pushes and one other thread pops; head and tail only grow and are masked
+ * into the slot array.
+ */
+struct spsc_ring {
+	void **slots;		/* Power-of-two number of slots */
+	size_t mask;		/* Slots - 1 */
+	size_t head;		/* Next slot to pop, written by the consumer */
+	char pad[SPSC_RING_CACHE_LINE];
+	size_t tail;		/* Next slot to push, written by the producer */
+};
+
+/*
+ * Columnar employee snapshot (--write-snapshot, --snapshot): a
+ * SNAPSHOT_HEADER_SIZE-byte header (SNAPSHOT_MAGIC, uint32 version, uint32
+ * header size, uint64 number of employees, zero padding) followed by one
+ * column per field, in this order, each starting at a multiple of 8 bytes:
+ * id (char[BATCH_MAX_ID + 1], NUL-padded), current_hours and vacation_extra
+ * (double), annual_days, max_accum_days and week_start (int32). All values
+ * are little-endian, so on little-endian hosts the columns are used in place.
+ */
+struct vacation_snapshot {
+	size_t count;		/* Number of employees */
+	const char (*id)[BATCH_MAX_ID + 1];
+	const double *current_hours;
+	const double *vacation_extra;
+	const int *annual_days;
+	const int *max_accum_days;	/* Resolved with the record's policy */
+	const int *week_start;
+	void *map;		/* Read-only mapping of the file */
+	size_t map_size;
+};
+
+/*
+ * Scenario sweep grid (--sweep): every extra days value from extra_first to
+ * extra_last in steps of extra_step, for every month from month_first to
+ * month_last.
+ */
+struct vacation_sweep {
+	double extra_first;
+	double extra_last;
+	double extra_step;
+	int month_first;	/* 0: from the current month */
+	int month_last;		/* Through December if month_first is 0 */
+};
+
+/*
+ * Projected balance at the end of every month of the current year
+ * (--timeline). Entries before first_month are zero.
+ */
+struct vacation_timeline {
+	int first_month;	/* Current month (1-12) */
+	double planned_days[MONTHS_PER_YEAR];	/* Planned consumption */
+	double balance_hours[MONTHS_PER_YEAR];	/* Balance at month end */
+	double balance_days[MONTHS_PER_YEAR];
+	double excess_days;	/* Deducted at year end (exceeding max) */
+};
+
+/* Fixed-point timeline, amounts in centi-hours */
+struct vacation_fixed_timeline {
+	int first_month;	/* Current month (1-12) */
+	int64_t planned_centi_hours[MONTHS_PER_YEAR];
+	int64_t balance_centi_hours[MONTHS_PER_YEAR];
+	int64_t excess_centi_hours;
+};
+
+/* Year-end balance of one year of a multi-year projection (--years) */
+struct vacation_year_result {
+	int year;
+	double total_hours;	/* Balance at the end of the year */
+	double total_days;
+	double excess_days;	/* Deducted; the rest carries over */
+};
+
 /* Structure to hold parsed arguments */
 struct vacation_args {
 	int annual_days;	/* Must be integer (15-24) */
 	double current_hours;	/* May be floating point */
+	int annual_hours;	/* Converted to annual_days with the policy */
 	int annual_days_set;
 	int annual_hours_set;
 	int current_hours_set;
@@ -55,6 +343,88 @@ struct vacation_args {
 	int vacation_extra_set;
 	int week_start;		/* WEEK_START_SUNDAY or WEEK_START_MONDAY */
 	int special_accum;	/* If set, use special max accum calculation */
+	const char *batch_file;	/* Batch input file ("-" for stdin), or NULL */
+	int num_threads;	/* Worker threads for batch mode */
+	int pipeline;		/* Stream batch mode through pipeline stages */
+	int memory_stats;	/* Report bulk run memory use on stderr */
+	int io_backend;		/* IO_BACKEND_* of batch mode */
+	const char *serve_socket;	/* Daemon socket path, or NULL */
+	const char *snapshot_file;	/* Snapshot to calculate, or NULL */
+	const char *snapshot_output;	/* Snapshot to write, or NULL */
+	const char *previous_file;	/* Prior bin results to refresh, or NULL */
+	const char *journal_file;	/* Changed employee records, or NULL */
+	int fixed_point;	/* If set, calculate in exact centi-hours */
+	const char *holidays_file;	/* Public holidays file, or NULL */
+	const struct holiday_calendar *holidays;	/* Loaded holidays, or NULL */
+	int output_format;	/* OUTPUT_FORMAT_* */
+	int sweep_set;		/* If set, run a scenario sweep */
+	struct vacation_sweep sweep;	/* Sweep grid */
+	int timeline;		/* If set, print the month-by-month balance */
+	int plan_set;
+	double planned_days[MONTHS_PER_YEAR];	/* Planned days per month */
+	int num_years;		/* Years to project (1: current year only) */
+	const char *policy_file;	/* Accrual policies file, or NULL */
+	int policy_id;		/* Policy of the calculation (0: built in) */
+	const struct policy_set *policies;	/* Loaded policies, or NULL */
+	const struct vacation_policy *policy;	/* Policy for policy_id, or NULL */
+	int as_of_set;		/* If set, calculate as of as_of, not today */
+	struct date as_of;
+	int stdin_lines;	/* If set, read one set of options per line */
+	int help;		/* Set by -h/--help */
+};
+
+/* Validation error codes (struct validation_error) */
+#define VALIDATION_OK			0
+#define VALIDATION_ANNUAL_MISSING	1	/* Neither annual days nor hours */
+#define VALIDATION_ANNUAL_BOTH		2	/* Both annual days and hours */
+#define VALIDATION_ANNUAL_DAYS		3	/* value: invalid annual days */
+#define VALIDATION_ANNUAL_HOURS		4	/* value: invalid annual hours */
+#define VALIDATION_EXTRA_NEGATIVE	5	/* Negative extra vacation days */
+#define VALIDATION_EXTRA_RANGE		6	/* number: extra days above limit */
+#define VALIDATION_ID_LENGTH		7	/* limit: longest employee ID */
+#define VALIDATION_FIXED_RANGE		8	/* Current hours beyond fixed point */
+#define VALIDATION_RECORD_LENGTH	9	/* limit: longest record */
+#define VALIDATION_TOO_MANY_FIELDS	10	/* limit: most fields */
+#define VALIDATION_TOO_FEW_FIELDS	11	/* limit: fewest fields */
+#define VALIDATION_POLICY		12	/* text: unknown policy ID */
+#define VALIDATION_ANNUAL_DAYS_FORMAT	13	/* text: annual days field */
+#define VALIDATION_ANNUAL_HOURS_FORMAT	14	/* text: annual hours field */
+#define VALIDATION_CURRENT_HOURS_FORMAT	15	/* text: current hours field */
+#define VALIDATION_EXTRA_FORMAT		16	/* text: extra days field */
+#define VALIDATION_WEEK_START_FORMAT	17	/* text: week start field */
+#define VALIDATION_SPECIAL_ACCUM_FORMAT	18	/* text: special accum field */
+#define VALIDATION_UNKNOWN_ID		19	/* text: ID not in prior results */
+#define VALIDATION_NUM_CODES		20
+
+#define VALIDATION_MAX_TEXT	32	/* Field text kept in an error */
+#define VALIDATION_MAX_MESSAGE	160	/* Longest rendered message */
+
+/*
+ * Why an input was rejected: a code and the values its message refers to,
+ * rendered by format_validation_error.
+ */
+struct validation_error {
+	int code;		/* VALIDATION_* */
+	int value;		/* Offending integer */
+	int limit;		/* Limit that was exceeded */
+	double number;		/* Offending number */
+	char text[VALIDATION_MAX_TEXT + 1];	/* Offending field, truncated */
+};
+
+/* Structure to hold one parsed batch input record */
+struct batch_record {
+	const char *id;		/* Employee ID (points into the input line) */
+	struct vacation_args args;	/* Record fields as parsed arguments */
+	struct validation_error error;	/* Set when parsing fails */
+};
+
+/* Structure to hold one parsed change journal record */
+struct journal_record {
+	const char *id;		/* Employee ID (points into the input line) */
+	double current_hours;	/* New current hours */
+	double vacation_extra;	/* New extra vacation days, if set */
+	int vacation_extra_set;	/* Zero keeps the prior extra vacation days */
+	struct validation_error error;	/* Set when parsing fails */
 };
 
 /*
@@ -64,20 +434,36 @@ double hours_to_days(double hours);
 double days_to_hours(double days);
 
 /*
- * Check if a string represents a valid integer.
- * str: string to check
- * value: pointer to store the integer value
- * Returns: 0 on success, non-zero on error
+ * Convert hours to centi-hours, rounded to the nearest hundredth.
+ * hours: amount in hours (at most MAX_FIXED_HOURS in magnitude)
+ * centi_hours: pointer to store the amount in centi-hours
+ * Returns: 0 on success, non-zero if out of range
+ */
+int hours_to_centi_hours(double hours, int64_t *centi_hours);
+
+/*
+ * Convert days to centi-hours, rounded to the nearest centi-hour.
+ * days: amount in days (at most MAX_FIXED_HOURS hours in magnitude)
+ * centi_hours: pointer to store the amount in centi-hours
+ * Returns: 0 on success, non-zero if out of range
  */
-int parse_integer(const char *str, int *value);
+int days_to_centi_hours(double days, int64_t *centi_hours);
 
 /*
- * Check if a string represents a valid number (integer or float).
- * str: string to check
- * value: pointer to store the value
+ * Convert centi-hours to hundredths of a day.
+ * Computed in integers, rounded half away from zero.
+ * centi_hours: amount in centi-hours
+ * Returns: amount in centi-days
+ */
+int64_t centi_hours_to_centi_days(int64_t centi_hours);
+
+/*
+ * Get the current local date from system time, with the reentrant
+ * localtime_r, so a run can take one snapshot and share it with its threads.
+ * today: pointer to store the date
  * Returns: 0 on success, non-zero on error
  */
-int parse_number(const char *str, double *value);
+int get_current_date(struct date *today);
 
 /*
  * Get current month from system time.
@@ -92,55 +478,73 @@ int get_current_month(void);
 int get_current_year(void);
 
 /*
- * Check if a year is a leap year.
- * year: the year to check
- * Returns: 1 if leap year, 0 otherwise
+ * Accrual policy functions
+ * A NULL policy is the built-in one (VALID_ANNUAL_DAYS/VALID_ANNUAL_HOURS).
  */
-int is_leap_year(int year);
 
 /*
- * Get the number of days in a month.
- * month: month number (1-12)
- * year: year (for leap year calculation)
- * Returns: number of days in the month (28-31), or 0 for invalid month
+ * Compile policy rules into lookup tables.
+ * rules: annual options and maximum accumulation rule
+ * policy: structure to store the compiled policy
+ * Returns: 0 on success, non-zero on out of range or duplicate options
  */
-int days_in_month(int month, int year);
+int compile_policy(const struct policy_rules *rules,
+		   struct vacation_policy *policy);
 
 /*
- * Get the day of week for a given date (Zeller's congruence).
- * day: day of month (1-31)
- * month: month (1-12)
- * year: year (e.g., 2025)
- * Returns: day of week (0=Sunday, 1=Monday, ..., 6=Saturday)
+ * Check if annual hours are an option of a policy.
+ * policy: accrual policy, or NULL
+ * hours: annual hours to check
+ * days_out: pointer to store the corresponding days if valid, or NULL
+ * Returns: 1 if valid, 0 otherwise
  */
-int day_of_week(int day, int month, int year);
+int policy_is_valid_annual_hours(const struct vacation_policy *policy,
+				 int hours, int *days_out);
 
 /*
- * Calculate the number of working days in a month.
- * month: month number (1-12)
- * year: year (e.g., 2025)
- * week_start: WEEK_START_SUNDAY or WEEK_START_MONDAY
- * Returns: number of working days
+ * Check if annual days are an option of a policy.
+ * policy: accrual policy, or NULL
+ * annual_days: annual vacation days to check
+ * Returns: 1 if valid, 0 otherwise
  */
-int calculate_working_days(int month, int year, int week_start);
+int policy_is_valid_annual_days(const struct vacation_policy *policy,
+				int annual_days);
 
 /*
- * Calculate the remaining working days from current month to end of year.
- * current_month: current month (1-12)
- * year: year (e.g., 2025)
- * week_start: WEEK_START_SUNDAY or WEEK_START_MONDAY
- * Returns: total remaining working days
+ * Validate annual days against a policy, printing the valid options on error.
+ * policy: accrual policy, or NULL
+ * annual_days: annual vacation days to validate
+ * Returns: 0 on success, non-zero on error
  */
-int calculate_remaining_working_days(int current_month, int year, int week_start);
+int policy_validate_annual_days(const struct vacation_policy *policy,
+				int annual_days);
 
 /*
- * Calculate working days from the start of the previous month to end of year.
- * current_month: current month (1-12)
- * year: year (e.g., 2025)
- * week_start: WEEK_START_SUNDAY or WEEK_START_MONDAY
- * Returns: total working days from previous month start to year end
+ * Get the annual hours of a policy option.
+ * policy: accrual policy, or NULL
+ * days: annual vacation days
+ * Returns: annual hours of the option, or days * 8.4 truncated if the days
+ *          are not an option
  */
-int calculate_working_days_from_prev_month(int current_month, int year, int week_start);
+int policy_annual_hours_for_days(const struct vacation_policy *policy,
+				 int days);
+
+/*
+ * Get the maximum accumulation of a policy.
+ * policy: accrual policy, or NULL
+ * annual_days: annual vacation days
+ * special_accum: 1 if special accumulation, 0 otherwise
+ * Returns: maximum accumulated days
+ */
+int policy_max_accum(const struct vacation_policy *policy,
+		     int annual_days, int special_accum);
+
+/*
+ * Print the valid annual options of a policy to stderr, as
+ * print_valid_annual_options.
+ * policy: accrual policy, or NULL
+ */
+void print_policy_options(const struct vacation_policy *policy);
 
 /*
  * Calculate remaining months in the year (including current month).
@@ -188,6 +592,50 @@ double calculate_excess_days(double total_days, int max_accum_days);
 void calculate_vacation(const struct vacation_input *input,
 			struct vacation_result *result);
 
+/*
+ * Perform all vacation calculations in fixed point.
+ * Same formulas as calculate_vacation, computed exactly in centi-hours.
+ * input: calculation inputs
+ * result: structure to store results
+ */
+void calculate_vacation_fixed(const struct vacation_fixed_input *input,
+			      struct vacation_fixed_result *result);
+
+/*
+ * Perform the vacation calculations for a batch of employees.
+ * Uses AVX2 or SSE2 when available; results are bit-identical to
+ * calculate_vacation. Remaining working days are not computed, as they only
+ * depend on the calendar (see calculate_remaining_working_days).
+ * in: structure-of-arrays calculation inputs
+ * out: structure-of-arrays results
+ * count: number of employees
+ */
+void calculate_vacation_batch(const struct vacation_batch_input *in,
+			      struct vacation_batch_result *out,
+			      size_t count);
+
+/*
+ * Scalar reference implementation of calculate_vacation_batch.
+ * in: structure-of-arrays calculation inputs
+ * out: structure-of-arrays results
+ * count: number of employees
+ */
+void calculate_vacation_batch_scalar(const struct vacation_batch_input *in,
+				     struct vacation_batch_result *out,
+				     size_t count);
+
+/*
+ * Perform the fixed-point vacation calculations for a batch of employees.
+ * A branch-free integer loop that the compiler vectorizes; results are
+ * identical to calculate_vacation_fixed.
+ * in: structure-of-arrays calculation inputs
+ * out: structure-of-arrays results
+ * count: number of employees
+ */
+void calculate_vacation_batch_fixed(const struct vacation_batch_fixed_input *in,
+				    struct vacation_batch_fixed_result *out,
+				    size_t count);
+
 /*
  * Initialize vacation_args with default values.
  * args: structure to initialize
@@ -202,14 +650,23 @@ void init_vacation_args(struct vacation_args *args);
 int validate_arguments(const struct vacation_args *args);
 
 /*
- * Validate annual days are within allowed range.
+ * Validate annual days are within allowed range (built-in policy).
  * annual_days: annual vacation days to validate
  * Returns: 0 on success, non-zero on error
  */
 int validate_annual_days(int annual_days);
 
 /*
- * Calculate maximum accumulated days based on annual days and special accum flag.
+ * Check if annual days value is valid (built-in policy, without printing
+ * errors).
+ * annual_days: annual vacation days to check
+ * Returns: 1 if valid, 0 otherwise
+ */
+int is_valid_annual_days(int annual_days);
+
+/*
+ * Calculate maximum accumulated days based on annual days and special accum
+ * flag, with the built-in policy.
  * Normal case: always returns 36
  * Special accum:
  *   For 15-17 annual days: returns 36
@@ -227,13 +684,21 @@ int calculate_max_accum(int annual_days, int special_accum);
 void print_valid_annual_options(void);
 
 /*
- * Check if annual hours value is valid.
+ * Check if annual hours value is valid (built-in policy).
  * hours: annual hours to check
  * days_out: pointer to store the corresponding days if valid
  * Returns: 1 if valid, 0 otherwise
  */
 int is_valid_annual_hours(int hours, int *days_out);
 
+/*
+ * Get the annual hours corresponding to annual days (built-in policy).
+ * days: annual vacation days
+ * Returns: annual hours from the valid options table, or days * 8.4
+ *          truncated if the days are not a valid option
+ */
+int get_annual_hours_for_days(int days);
+
 /*
  * Validate planned vacation days.
  * vacation_days: vacation days planned till end of year
@@ -243,13 +708,430 @@ int is_valid_annual_hours(int hours, int *days_out);
 int validate_vacation_days(double vacation_days, int remaining_working_days);
 
 /*
- * Print calculation results.
+ * Validation functions
+ *
+ * The check_* functions validate without printing: on error they fill in
+ * a validation_error and return its code, which callers render with
+ * format_validation_error. The validate_* functions above print the same
+ * errors to stderr.
+ */
+
+/*
+ * Record an error with integer values.
+ * error: structure to fill in
+ * code: VALIDATION_* code
+ * value: offending integer, or 0
+ * limit: exceeded limit, or 0
+ * Returns: code
+ */
+int set_validation_error(struct validation_error *error, int code,
+			 int value, int limit);
+
+/*
+ * Record an error about a field, keeping up to VALIDATION_MAX_TEXT
+ * characters of its text.
+ * error: structure to fill in
+ * code: VALIDATION_* code
+ * text: offending field
+ * Returns: code
+ */
+int set_validation_text(struct validation_error *error, int code,
+			const char *text);
+
+/*
+ * Check that exactly one of annual days and annual hours is set.
+ * args: parsed arguments to check
+ * error: structure to store the error
+ * Returns: VALIDATION_OK, or the error code
+ */
+int check_arguments(const struct vacation_args *args,
+		    struct validation_error *error);
+
+/*
+ * Check that annual days are an option of a policy.
+ * policy: accrual policy, or NULL
+ * annual_days: annual vacation days to check
+ * error: structure to store the error
+ * Returns: VALIDATION_OK, or the error code
+ */
+int check_annual_days(const struct vacation_policy *policy, int annual_days,
+		      struct validation_error *error);
+
+/*
+ * Check extra vacation days against the working days available.
+ * vacation_days: extra vacation days
+ * max_working_days: working days from the start of the previous month
+ * error: structure to store the error
+ * Returns: VALIDATION_OK, or the error code
+ */
+int check_vacation_days(double vacation_days, int max_working_days,
+			struct validation_error *error);
+
+/*
+ * Render the message of an error, without the "Error: " prefix and the
+ * final period.
+ * buf: output buffer
+ * size: size of the output buffer (VALIDATION_MAX_MESSAGE); longer messages
+ *       are truncated
+ * error: error to render
+ * Returns: length of the message, as snprintf
+ */
+int format_validation_error(char *buf, size_t size,
+			    const struct validation_error *error);
+
+/*
+ * Print an error to stderr as "Error: <message>.".
+ * error: error to print
+ */
+void print_validation_error(const struct validation_error *error);
+
+/*
+ * Print calculation results, rendered by format_results and written to
+ * stdout with a single call.
  * input: calculation inputs
  * result: calculation results
  */
 void print_results(const struct vacation_input *input,
 		   const struct vacation_result *result);
 
+/*
+ * Format a number with up to 2 decimal places, trailing zeros removed.
+ * Same text as snprintf "%.2f" followed by trimming, without calling
+ * snprintf for values below 1e13.
+ * buf: output buffer
+ * size: size of the output buffer
+ * value: number to format
+ * Returns: length of the formatted text, or -1 if it does not fit
+ */
+int format_double_value(char *buf, size_t size, double value);
+
+/*
+ * Render the print_results text into a buffer.
+ * buf: output buffer, at least RESULTS_MAX_TEXT bytes
+ * input: calculation inputs
+ * result: calculation results
+ * Returns: length of the text (NUL-terminated)
+ */
+size_t format_results(char *buf, const struct vacation_input *input,
+		      const struct vacation_result *result);
+
+/*
+ * Render the print_results_fixed text into a buffer.
+ * buf: output buffer, at least RESULTS_MAX_TEXT bytes
+ * input: calculation inputs
+ * result: calculation results
+ * Returns: length of the text (NUL-terminated)
+ */
+size_t format_results_fixed(char *buf, const struct vacation_fixed_input *input,
+			    const struct vacation_fixed_result *result);
+
+/*
+ * Print fixed-point calculation results, rendered by format_results_fixed.
+ * input: calculation inputs
+ * result: calculation results
+ */
+void print_results_fixed(const struct vacation_fixed_input *input,
+			 const struct vacation_fixed_result *result);
+
+/*
+ * Format a fixed-point amount in hundredths, trailing zeros removed.
+ * Produces the same text as format_double_value(value / 100.0).
+ * buf: output buffer
+ * size: size of the output buffer
+ * value: amount in hundredths (centi-hours or centi-days)
+ * Returns: length of the formatted text, or -1 if it does not fit
+ */
+int format_centi_value(char *buf, size_t size, int64_t value);
+
+/*
+ * Print a number with up to 2 decimal places, trailing zeros removed.
+ * stream: output stream
+ * value: number to print
+ */
+void fprint_double_value(FILE *stream, double value);
+
+/*
+ * Scenario sweep functions
+ */
+
+/*
+ * Parse a sweep range of extra vacation days: "first:last[:step]", with a
+ * default step of 1 day.
+ * str: range string
+ * sweep: sweep to store extra_first, extra_last and extra_step in
+ * Returns: 0 on success, non-zero on error
+ */
+int parse_sweep_extra(const char *str, struct vacation_sweep *sweep);
+
+/*
+ * Parse a sweep range of months: "month" or "first-last" (1-12).
+ * str: range string
+ * sweep: sweep to store month_first and month_last in
+ * Returns: 0 on success, non-zero on error
+ */
+int parse_sweep_months(const char *str, struct vacation_sweep *sweep);
+
+/*
+ * Number of extra days values in a sweep.
+ * sweep: sweep grid
+ * Returns: number of values from extra_first to extra_last
+ */
+int sweep_num_extras(const struct vacation_sweep *sweep);
+
+/*
+ * Extra days value of a sweep column.
+ * sweep: sweep grid
+ * index: value index (0 to sweep_num_extras - 1)
+ * Returns: extra vacation days
+ */
+double sweep_extra_value(const struct vacation_sweep *sweep, int index);
+
+/*
+ * Evaluate a sweep grid for one employee with the batch kernel.
+ * Points are ordered by month, then by extra days; point i has month
+ * month_first + i / sweep_num_extras and extra days index
+ * i % sweep_num_extras.
+ * base: employee inputs (vacation_extra and current_month are ignored)
+ * sweep: sweep grid with months set
+ * results: array with one result per grid point
+ */
+void calculate_vacation_sweep(const struct vacation_input *base,
+			      const struct vacation_sweep *sweep,
+			      struct vacation_result *results);
+
+/*
+ * Fixed-point version of calculate_vacation_sweep, with the extra days
+ * converted to centi-hours.
+ * base: employee inputs (vacation_extra_centi_hours and current_month are
+ *       ignored)
+ * sweep: sweep grid with months set
+ * results: array with one result per grid point
+ */
+void calculate_vacation_sweep_fixed(const struct vacation_fixed_input *base,
+				    const struct vacation_sweep *sweep,
+				    struct vacation_fixed_result *results);
+
+/*
+ * Run a scenario sweep and print one row (or record) per grid point.
+ * args: parsed arguments with the sweep grid and output format
+ * input: employee inputs for the current month
+ * Returns: 0 on success, non-zero on error
+ */
+int run_sweep(const struct vacation_args *args,
+	      const struct vacation_input *input);
+
+/*
+ * Timeline functions
+ */
+
+/*
+ * Parse planned vacation days per month: "month:days[,month:days...]".
+ * Days given for the same month add up.
+ * str: plan string
+ * planned_days: array of MONTHS_PER_YEAR entries to store the plan in
+ * Returns: 0 on success, non-zero on error
+ */
+int parse_vacation_plan(const char *str, double *planned_days);
+
+/*
+ * Project the balance at the end of every remaining month of the year.
+ * The extra days are deducted in the current month, planned days in their
+ * month. The December balance equals calculate_vacation's total with no
+ * days planned.
+ * input: calculation inputs
+ * planned_days: planned days per month (MONTHS_PER_YEAR entries), or NULL
+ * timeline: structure to store the timeline
+ */
+void calculate_vacation_timeline(const struct vacation_input *input,
+				 const double *planned_days,
+				 struct vacation_timeline *timeline);
+
+/*
+ * Fixed-point version of calculate_vacation_timeline.
+ * input: fixed-point calculation inputs
+ * planned_centi_hours: planned centi-hours per month, or NULL
+ * timeline: structure to store the timeline
+ */
+void calculate_vacation_timeline_fixed(const struct vacation_fixed_input *input,
+				       const int64_t *planned_centi_hours,
+				       struct vacation_fixed_timeline *timeline);
+
+/*
+ * Print the month-by-month timeline as a table or as JSON lines.
+ * args: parsed arguments with the plan and output format
+ * input: calculation inputs
+ * Returns: 0 on success, non-zero on error
+ */
+int run_timeline(const struct vacation_args *args,
+		 const struct vacation_input *input);
+
+/*
+ * Multi-year projection functions
+ */
+
+/*
+ * Project one more year: carry over the balance capped at the maximum
+ * accumulation and add a full year of monthly credits.
+ * prev: previous year-end
+ * annual_days: annual vacation days
+ * max_accum_days: maximum accumulation in days
+ * next: structure to store the next year-end
+ */
+void calculate_next_year(const struct vacation_year_result *prev,
+			 int annual_days, int max_accum_days,
+			 struct vacation_year_result *next);
+
+/*
+ * Project year-end balances, starting with the current year.
+ * input: calculation inputs
+ * result: calculate_vacation result for input (the first year)
+ * num_years: number of years (1 to MAX_PROJECTION_YEARS)
+ * years: array of num_years entries to store the year-ends
+ */
+void calculate_vacation_projection(const struct vacation_input *input,
+				   const struct vacation_result *result,
+				   int num_years,
+				   struct vacation_year_result *years);
+
+/*
+ * Print the results followed by the multi-year projection, or one JSON
+ * line per year.
+ * args: parsed arguments with the number of years and output format
+ * input: calculation inputs
+ * Returns: 0 on success, non-zero on error
+ */
+int run_projection(const struct vacation_args *args,
+		   const struct vacation_input *input);
+
+/*
+ * Machine-readable output functions
+ */
+
+/*
+ * Parse an output format name: "text", "jsonl" or "bin".
+ * str: format name
+ * format: pointer to store the OUTPUT_FORMAT_* value
+ * Returns: 0 on success, non-zero on error
+ */
+int parse_output_format(const char *str, int *format);
+
+/*
+ * Format one result as a JSON object followed by a newline. Numbers are
+ * written as in the text output (up to 2 decimals); infinity and NaN as null.
+ * buf: output buffer, at least RESULT_MAX_JSON bytes plus six per character
+ *      of id (control characters are escaped)
+ * id: employee ID, or NULL to omit the "id" member
+ * input: calculation inputs
+ * result: calculation results
+ * Returns: length of the formatted line
+ */
+size_t format_result_json(char *buf, const char *id,
+			  const struct vacation_input *input,
+			  const struct vacation_result *result);
+
+/*
+ * Format one month of a timeline as a JSON object followed by a newline.
+ * buf: output buffer, at least RESULT_MAX_JSON bytes
+ * input: calculation inputs
+ * timeline: projected timeline
+ * month: month to format (first_month to 12)
+ * Returns: length of the formatted line
+ */
+size_t format_timeline_json(char *buf, const struct vacation_input *input,
+			    const struct vacation_timeline *timeline, int month);
+
+/*
+ * Format one year of a projection as a JSON object followed by a newline.
+ * buf: output buffer, at least RESULT_MAX_JSON bytes plus six per character
+ *      of id (control characters are escaped)
+ * id: employee ID, or NULL to omit the "id" member
+ * year: projected year-end
+ * Returns: length of the formatted line
+ */
+size_t format_projection_json(char *buf, const char *id,
+			      const struct vacation_year_result *year);
+
+/*
+ * Encode the binary result file header.
+ * buf: output buffer, RESULT_HEADER_SIZE bytes
+ */
+void encode_result_header(unsigned char *buf);
+
+/*
+ * Check a binary result file header.
+ * buf: header, RESULT_HEADER_SIZE bytes
+ * Returns: 0 if valid, non-zero on a bad magic, version or record size
+ */
+int decode_result_header(const unsigned char *buf);
+
+/*
+ * Encode one binary result record (struct result_record, little-endian).
+ * buf: output buffer, RESULT_RECORD_SIZE bytes
+ * id: employee ID (truncated to BATCH_MAX_ID characters), or NULL
+ * input: calculation inputs
+ * result: calculation results
+ */
+void encode_result_record(unsigned char *buf, const char *id,
+			  const struct vacation_input *input,
+			  const struct vacation_result *result);
+
+/*
+ * Decode one binary result record into host byte order.
+ * buf: record, RESULT_RECORD_SIZE bytes
+ * record: structure to store the record
+ */
+void decode_result_record(const unsigned char *buf, struct result_record *record);
+
+/*
+ * Convert fixed-point inputs and results to their floating-point structures,
+ * with days rounded to hundredths as in the fixed-point text output.
+ * fixed_input: fixed-point calculation inputs
+ * fixed_result: fixed-point calculation results
+ * input: structure to store the inputs
+ * result: structure to store the results
+ */
+void fixed_to_vacation_result(const struct vacation_fixed_input *fixed_input,
+			      const struct vacation_fixed_result *fixed_result,
+			      struct vacation_input *input,
+			      struct vacation_result *result);
+
+/*
+ * Switch a stream to binary mode (no newline translation on Windows).
+ * stream: output stream
+ * Returns: 0 on success, non-zero on error
+ */
+int set_binary_output(FILE *stream);
+
+/*
+ * Snapshot functions
+ */
+
+/*
+ * Map a snapshot file read-only and point the columns into the mapping.
+ * Concurrent processes share the pages through the page cache.
+ * Only supported on little-endian hosts.
+ * path: snapshot file
+ * snapshot: structure to fill in, released with close_snapshot
+ * Returns: 0 on success, non-zero on error (printed to stderr)
+ */
+int open_snapshot(const char *path, struct vacation_snapshot *snapshot);
+
+/*
+ * Unmap a snapshot opened by open_snapshot.
+ * snapshot: snapshot to release
+ */
+void close_snapshot(struct vacation_snapshot *snapshot);
+
+/*
+ * Convert the employee file of batch mode into a snapshot. Records are
+ * parsed and validated as in batch mode, except for the extra vacation
+ * limit, which depends on the date and is checked when the snapshot runs.
+ * defaults: command-line arguments, with the batch file to convert
+ * path: snapshot file to write
+ * Returns: 0 on success, non-zero on error or if records were rejected
+ */
+int write_snapshot(const struct vacation_args *defaults, const char *path);
+
 /*
  * Print usage information.
  * program_name: name of the program (argv[0])
@@ -257,7 +1139,8 @@ void print_results(const struct vacation_input *input,
 void print_usage(const char *program_name);
 
 /*
- * Parse command-line arguments.
+ * Parse command-line arguments. Errors are reported to stderr; -h/--help
+ * sets args->help and stops parsing. Never exits.
  * argc: argument count
  * argv: argument values
  * args: structure to store parsed arguments
@@ -265,6 +1148,48 @@ void print_usage(const char *program_name);
  */
 int parse_arguments(int argc, char *argv[], struct vacation_args *args);
 
+/*
+ * Resolve the policy ID, convert annual hours to days with the policy and
+ * check option combinations shared by all modes.
+ * args: parsed arguments, with the loaded policies set
+ * Returns: 0 on success, non-zero on error
+ */
+int prepare_arguments(struct vacation_args *args);
+
+/*
+ * Validate prepared arguments, calculate and print the results (or run the
+ * sweep, timeline or projection they ask for).
+ * args: prepared arguments; prompts for the current hours if not set
+ * today: date of the calculation
+ * Returns: 0 on success, non-zero on error
+ */
+int run_vacation(struct vacation_args *args, const struct date *today);
+
+/*
+ * Stdin lines mode functions
+ */
+
+/*
+ * Split a line into whitespace-separated arguments, in place.
+ * line: NUL-terminated line, modified in place (separators become NULs)
+ * argv: array to store the arguments in
+ * max_args: size of argv
+ * Returns: number of arguments, or -1 if there are more than max_args
+ */
+int split_argument_line(char *line, char **argv, int max_args);
+
+/*
+ * Run one calculation per input line. Each line holds options as on the
+ * command line, applied on top of the command-line defaults. Invalid lines
+ * are reported to stderr with their line number and skipped.
+ * defaults: command-line arguments, prepared
+ * today: date of the run (a line's --as-of overrides it)
+ * in: input stream
+ * Returns: 0 if all lines were processed, non-zero otherwise
+ */
+int run_stdin_lines(const struct vacation_args *defaults,
+		    const struct date *today, FILE *in);
+
 /*
  * Prompt user for current accumulated hours.
  * hours: pointer to store the result
@@ -272,4 +1197,277 @@ int parse_arguments(int argc, char *argv[], struct vacation_args *args);
  */
 int prompt_current_hours(double *hours);
 
+/*
+ * Batch processing functions
+ */
+
+/*
+ * Parse one batch input record (CSV) in place.
+ * Record fields: id,annual_days,annual_hours,current_hours,vacation_extra,
+ *                week_start,special_accum,policy
+ * Empty fields keep the values already in record->args, which the caller
+ * initializes with the command-line defaults. Annual hours are converted
+ * with the record's policy, looked up in record->args.policies.
+ * line: NUL-terminated record, modified in place (commas become NULs)
+ * record: structure to store the parsed record
+ * Returns: 0 on success, or the VALIDATION_* code of record->error; nothing
+ *          is printed
+ */
+int parse_batch_record(char *line, struct batch_record *record);
+
+/*
+ * Parse one change journal record (CSV) in place.
+ * Record fields: id,current_hours[,vacation_extra]
+ * line: NUL-terminated record, modified in place (commas become NULs)
+ * record: structure to store the parsed record
+ * Returns: 0 on success, or the VALIDATION_* code of record->error; nothing
+ *          is printed
+ */
+int parse_journal_record(char *line, struct journal_record *record);
+
+/*
+ * Check if a batch input line holds no record: blank lines, comments
+ * starting with '#' and a header line starting with "id," on line 1.
+ * line: NUL-terminated input line
+ * line_number: line number, from 1
+ * Returns: 1 if the line is skipped, 0 if it holds a record
+ */
+int is_batch_skipped_line(const char *line, unsigned long line_number);
+
+/*
+ * Print the CSV header of the batch result rows.
+ * stream: output stream
+ * first_year: current year
+ * num_years: projected years; later years add total and excess days columns
+ */
+void print_batch_header(FILE *stream, int first_year, int num_years);
+
+/*
+ * Format one batch result row (CSV, newline terminated).
+ * buf: output buffer, at least BATCH_MAX_ROW bytes plus the length of id
+ * id: employee ID, of any length
+ * input: calculation inputs
+ * result: calculation results
+ * Returns: length of the formatted row
+ */
+size_t format_batch_result(char *buf, const char *id,
+			   const struct vacation_input *input,
+			   const struct vacation_result *result);
+
+/*
+ * Process a whole batch input file, one result row per employee record.
+ * Invalid records are reported to stderr and skipped. With more than one
+ * thread the file is read in bounded windows of line chunks, each processed
+ * by a work-stealing thread pool; output order is preserved.
+ * With the pipeline option the file is streamed instead: a reader thread
+ * parses blocks of records, threads compute them and the calling thread
+ * formats and writes them, connected by spsc_ring queues. With an I/O
+ * backend other than stdio, the file is read and the results are written
+ * in large blocks through async_file, on the calling thread.
+ * defaults: command-line arguments used for empty record fields
+ * month: current month (1-12)
+ * year: current year (e.g., 2025)
+ * Returns: 0 if all records were processed, non-zero otherwise
+ */
+int run_batch(const struct vacation_args *defaults, int month, int year);
+
+/*
+ * Calculate every employee of a snapshot, with the same output as
+ * run_batch. The columns feed the batch kernel in place, without parsing.
+ * Records outside the extra vacation limit of the date are reported to
+ * stderr and skipped.
+ * defaults: command-line arguments, with the snapshot file
+ * month: current month (1-12)
+ * year: current year (e.g., 2025)
+ * Returns: 0 if all records were processed, non-zero otherwise
+ */
+int run_snapshot(const struct vacation_args *defaults, int month, int year);
+
+/*
+ * Refresh a prior binary result file: records changed by the journal, and
+ * all records if the prior run was in another month, are recalculated from
+ * the inputs stored in the file; all other records are copied unchanged.
+ * The merged file is written to stdout in the same order. Invalid and
+ * unknown journal records are reported to stderr and skipped.
+ * defaults: command-line arguments, with the result and journal files
+ * month: current month (1-12)
+ * year: current year (e.g., 2025)
+ * Returns: 0 if all journal records were applied, non-zero otherwise
+ */
+int run_delta(const struct vacation_args *defaults, int month, int year);
+
+/*
+ * Block I/O functions
+ */
+
+/*
+ * Parse an I/O backend name: "stdio", "pread" or "uring".
+ * str: backend name
+ * backend: pointer to store the IO_BACKEND_* value
+ * Returns: 0 on success, non-zero on error
+ */
+int parse_io_backend(const char *str, int *backend);
+
+/*
+ * Open the file descriptor of a stream for reading or writing in blocks of
+ * ASYNC_IO_BLOCK_SIZE, from its current position. With IO_BACKEND_URING up
+ * to ASYNC_IO_DEPTH blocks are in flight while the caller works; without
+ * io_uring support it falls back to IO_BACKEND_PREAD. Files that cannot
+ * seek, or are opened for appending, keep one block in flight. The stream
+ * must not be used until async_file_close.
+ * stream: stream with no buffered data
+ * backend: IO_BACKEND_PREAD or IO_BACKEND_URING
+ * writing: non-zero to write the file, zero to read it
+ * Returns: the file, or NULL if out of memory or unsupported
+ */
+struct async_file *async_file_open(FILE *stream, int backend, int writing);
+
+/*
+ * Get the backend a file uses, after any fallback.
+ * file: file opened by async_file_open
+ * Returns: IO_BACKEND_PREAD or IO_BACKEND_URING
+ */
+int async_file_backend(const struct async_file *file);
+
+/*
+ * Read the next block of a file opened for reading. The data stays valid,
+ * and may be modified, until the next call.
+ * file: file opened for reading
+ * data: pointer to store the start of the block
+ * len: pointer to store the length of the block
+ * Returns: 1 if a block was read, 0 at end of file, -1 on a read error
+ */
+int async_file_read(struct async_file *file, char **data, size_t *len);
+
+/*
+ * Append data to a file opened for writing. Full blocks are submitted as
+ * they fill up.
+ * file: file opened for writing
+ * data: bytes to write
+ * len: number of bytes
+ * Returns: 0 on success, non-zero if a write failed
+ */
+int async_file_write(struct async_file *file, const char *data, size_t len);
+
+/*
+ * Write the rest of the data, wait for every block in flight and free the
+ * file. A written file descriptor is left positioned after the data. The
+ * stream is not closed.
+ * file: file opened by async_file_open
+ * Returns: 0 on success, non-zero if a write failed
+ */
+int async_file_close(struct async_file *file);
+
+/*
+ * Thread pool functions
+ */
+
+/*
+ * Initialize an empty arena; no memory is allocated until the first call
+ * to arena_alloc.
+ * arena: arena to initialize
+ * block_size: size of the blocks, e.g. ARENA_BLOCK_SIZE
+ */
+void arena_init(struct arena *arena, size_t block_size);
+
+/*
+ * Allocate memory from an arena, aligned to ARENA_ALIGN.
+ * arena: arena to allocate from
+ * size: bytes to allocate
+ * Returns: the memory, or NULL if out of memory
+ */
+void *arena_alloc(struct arena *arena, size_t size);
+
+/*
+ * Release all allocations at once but keep the blocks for reuse.
+ * arena: arena to reset
+ */
+void arena_reset(struct arena *arena);
+
+/*
+ * Free the blocks of an arena; its counters other than reserved are kept.
+ * arena: arena to release
+ */
+void arena_release(struct arena *arena);
+
+/*
+ * Print the counters of an arena to stderr (--memory-stats).
+ * arena: arena to report, before arena_release
+ */
+void print_arena_stats(const struct arena *arena);
+
+/*
+ * Allocate an empty ring.
+ * ring: ring to initialize
+ * capacity: least number of items, rounded up to a power of two
+ * Returns: 0 on success, non-zero if out of memory
+ */
+int spsc_ring_init(struct spsc_ring *ring, size_t capacity);
+
+/*
+ * Free the slots of a ring.
+ * ring: ring initialized by spsc_ring_init
+ */
+void spsc_ring_destroy(struct spsc_ring *ring);
+
+/*
+ * Append an item; called from the producer thread only.
+ * ring: ring to push to
+ * item: non-NULL pointer
+ * Returns: 0 on success, non-zero if the ring is full
+ */
+int spsc_ring_push(struct spsc_ring *ring, void *item);
+
+/*
+ * Remove the oldest item; called from the consumer thread only.
+ * ring: ring to pop from
+ * Returns: the item, or NULL if the ring is empty
+ */
+void *spsc_ring_pop(struct spsc_ring *ring);
+
+/*
+ * Run tasks on a work-stealing thread pool, consuming results in order.
+ * Each worker starts with a contiguous range of tasks and steals from the
+ * end of other workers' ranges once its own range is done. The calling
+ * thread passes each completed task to consume() in task order.
+ * Without thread support, tasks run sequentially on the calling thread.
+ * num_tasks: number of tasks
+ * num_threads: number of worker threads
+ * run: task function, called from worker threads with the index of the
+ *      worker (0 to num_threads - 1), e.g. to use per-worker scratch memory
+ * consume: completion function, called from the calling thread in order
+ * arg: argument passed to run() and consume()
+ * Returns: 0 on success, non-zero on error
+ */
+int run_parallel_ordered(size_t num_tasks, int num_threads,
+			 void (*run)(void *arg, size_t task, int worker),
+			 void (*consume)(void *arg, size_t task),
+			 void *arg);
+
+/*
+ * Daemon mode functions
+ */
+
+/*
+ * Start of the next local day, when the daemon reads the date again.
+ * now: current time
+ * Returns: the next local midnight, or an hour from now if the local
+ *          time cannot be converted
+ */
+time_t next_local_midnight(time_t now);
+
+/*
+ * Serve requests on a Unix domain socket until SIGINT or SIGTERM.
+ * Many clients are handled concurrently with epoll; each client may send
+ * any number of requests and gets one response per request, in order.
+ * The date is refreshed at midnight, or fixed by defaults->as_of.
+ * Only supported on Linux.
+ * socket_path: path of the socket to create
+ * defaults: command-line arguments with the holidays, loaded policies and
+ *           default policy
+ * Returns: 0 on clean shutdown, non-zero on error
+ */
+int run_server(const char *socket_path,
+	       const struct vacation_args *defaults);
+
 #endif /* VACATION_H */
@@ -0,0 +1,370 @@
+#ifndef VACATION_API_H
+#define VACATION_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Public interface of libvacation, the header that is installed: library
+ * requests (vacation_evaluate), the calendar and parsing functions, and the
+ * loaders that build a request context. The command-line, batch and daemon
+ * internals are declared in vacation.h, which includes this header.
+ */
+
+/* Week start options */
+#define WEEK_START_SUNDAY	0
+#define WEEK_START_MONDAY	1
+
+/* Calendar date */
+struct date {
+	int year;	/* e.g., 2025 */
+	int month;	/* 1-12 */
+	int day;	/* 1-31 */
+};
+
+/* Holiday calendar bitsets: one bit per day of the year */
+#define HOLIDAY_YEAR_BITS	366
+#define HOLIDAY_WORDS		((HOLIDAY_YEAR_BITS + 63) / 64)
+
+/* init_holiday_calendar errors */
+#define HOLIDAY_ERR_DATE	1	/* Invalid date */
+#define HOLIDAY_ERR_SPAN	2	/* Dates span too many years */
+#define HOLIDAY_ERR_MEMORY	3	/* Allocation failure */
+
+/*
+ * Public holidays for a range of years. Bit n of a year's set is day n of
+ * the year (0 = January 1). Years outside the range have no holidays.
+ */
+struct holiday_calendar {
+	int first_year;
+	int num_years;	/* 0 for an empty calendar */
+	uint64_t (*holidays)[HOLIDAY_WORDS];		/* Per year */
+	uint64_t (*working_days)[2][HOLIDAY_WORDS];	/* Per year, week start */
+};
+
+/* Accrual policies (--policy-file); compiled policies are opaque here */
+#define POLICY_MAX_ID		255	/* Largest policy ID (0 is built in) */
+
+struct vacation_policy;
+
+/* Policies loaded from a file, indexed by ID */
+struct policy_set {
+	struct vacation_policy *policies[POLICY_MAX_ID + 1];	/* NULL if undefined */
+};
+
+/*
+ * Library requests, answered by vacation_evaluate. The same fixed-size
+ * structures are the daemon mode messages (--serve), exchanged over a local
+ * Unix domain socket in native byte order. Their layout is part of the
+ * library ABI (VACATION_ABI_VERSION): fields are only ever added in place of
+ * the reserved ones.
+ */
+
+/* Library ABI version, bumped on incompatible changes */
+#define VACATION_ABI_VERSION		1
+
+/* Library and daemon status codes */
+#define VACATION_OK			0
+#define VACATION_ERR_ANNUAL_OPTION	1	/* Neither or both annual fields set */
+#define VACATION_ERR_ANNUAL_DAYS	2	/* Invalid annual days */
+#define VACATION_ERR_ANNUAL_HOURS	3	/* Invalid annual hours */
+#define VACATION_ERR_VACATION_EXTRA	4	/* Extra vacation out of range */
+#define VACATION_ERR_WEEK_START		5	/* Invalid week start */
+#define VACATION_ERR_POLICY		6	/* Unknown policy ID */
+#define VACATION_ERR_CURRENT_HOURS	7	/* Current hours not a finite number */
+#define VACATION_ERR_DATE		8	/* Invalid calculation date */
+#define VACATION_NUM_STATUS		9
+
+/* Request: the fields of struct vacation_args */
+struct vacation_request {
+	int32_t annual_days;	/* 0 when annual_hours is used */
+	int32_t annual_hours;	/* 0 when annual_days is used */
+	double current_hours;
+	double vacation_extra;
+	int32_t week_start;	/* WEEK_START_SUNDAY or WEEK_START_MONDAY */
+	int32_t special_accum;	/* If set, use special max accum calculation */
+	int32_t policy_id;	/* 0 for the context's default policy */
+	int32_t reserved;	/* Zero, keeps the size a multiple of 8 */
+};
+
+/* Response: the fields of struct vacation_result */
+struct vacation_response {
+	int32_t status;		/* VACATION_OK or VACATION_ERR_* */
+	int32_t annual_days;
+	int32_t max_accum_days;
+	int32_t current_month;
+	int32_t current_year;
+	int32_t remaining_months;
+	int32_t working_days_remaining;
+	int32_t reserved;	/* Zero, keeps the doubles aligned */
+	double monthly_hours;
+	double additional_hours;
+	double additional_days;
+	double total_hours;
+	double total_days;
+	double excess_days;
+};
+
+/*
+ * Shared, read-only state of library requests: the calendar and policies
+ * are only read, so one context may serve any number of threads at once.
+ */
+struct vacation_context {
+	const struct holiday_calendar *holidays;	/* Public holidays, or NULL */
+	const struct policy_set *policies;	/* Policies by ID, or NULL */
+	const struct vacation_policy *policy;	/* Default policy, NULL for built-in */
+	int month;		/* Calculation month (1-12) */
+	int year;		/* Calculation year (e.g., 2025) */
+};
+
+/*
+ * Parsing functions
+ */
+
+/*
+ * Check if a string represents a valid integer.
+ * str: string to check
+ * value: pointer to store the integer value
+ * Returns: 0 on success, non-zero on error
+ */
+int parse_integer(const char *str, int *value);
+
+/*
+ * Check if a string represents a valid number (integer or float).
+ * str: string to check
+ * value: pointer to store the value
+ * Returns: 0 on success, non-zero on error
+ */
+int parse_number(const char *str, double *value);
+
+/*
+ * Check if a span represents a valid integer: [sign]digits, with optional
+ * surrounding whitespace. The span need not be NUL-terminated.
+ * str: start of the span
+ * len: length of the span
+ * value: pointer to store the integer value
+ * Returns: 0 on success, non-zero on error
+ */
+int parse_integer_span(const char *str, size_t len, int *value);
+
+/*
+ * Check if a span represents a valid decimal number: [sign]digits[.digits],
+ * with optional surrounding whitespace. The decimal point is always '.',
+ * regardless of locale. The span need not be NUL-terminated.
+ * The result is correctly rounded, as with strtod.
+ * str: start of the span
+ * len: length of the span
+ * value: pointer to store the value
+ * Returns: 0 on success, non-zero on error
+ */
+int parse_number_span(const char *str, size_t len, double *value);
+
+/*
+ * Parse a date in YYYY-MM-DD format.
+ * str: date string
+ * d: pointer to store the date
+ * Returns: 0 on success, non-zero on error (including invalid dates)
+ */
+int parse_date(const char *str, struct date *d);
+
+/*
+ * Calendar functions
+ */
+
+/*
+ * Check if a year is a leap year.
+ * year: the year to check
+ * Returns: 1 if leap year, 0 otherwise
+ */
+int is_leap_year(int year);
+
+/*
+ * Get the number of days in a month.
+ * month: month number (1-12)
+ * year: year (for leap year calculation)
+ * Returns: number of days in the month (28-31), or 0 for invalid month
+ */
+int days_in_month(int month, int year);
+
+/*
+ * Get the day of week for a given date (Zeller's congruence).
+ * day: day of month (1-31)
+ * month: month (1-12)
+ * year: year (e.g., 2025)
+ * Returns: day of week (0=Sunday, 1=Monday, ..., 6=Saturday)
+ */
+int day_of_week(int day, int month, int year);
+
+/*
+ * Calculate the number of working days in a month.
+ * month: month number (1-12)
+ * year: year (e.g., 2025)
+ * week_start: WEEK_START_SUNDAY or WEEK_START_MONDAY
+ * Returns: number of working days
+ */
+int calculate_working_days(int month, int year, int week_start);
+
+/*
+ * Calculate the number of working days between two dates, inclusive.
+ * Computed arithmetically from the weekday of the first date and the number
+ * of full weeks in the range, without iterating over days.
+ * a: first date
+ * b: last date
+ * week_start: WEEK_START_SUNDAY or WEEK_START_MONDAY
+ * Returns: number of working days (0 if b is before a)
+ */
+int working_days_between(struct date a, struct date b, int week_start);
+
+/*
+ * Calculate the number of working days between two dates, inclusive,
+ * excluding public holidays. Within the calendar's years this is a popcount
+ * over the year's working day bitset.
+ * calendar: public holidays, or NULL for weekends only
+ * a: first date
+ * b: last date
+ * week_start: WEEK_START_SUNDAY or WEEK_START_MONDAY
+ * Returns: number of working days (0 if b is before a)
+ */
+int calendar_working_days_between(const struct holiday_calendar *calendar,
+				  struct date a, struct date b, int week_start);
+
+/*
+ * Calculate the number of working days in a month, excluding public holidays.
+ * calendar: public holidays, or NULL for weekends only
+ * month: month number (1-12)
+ * year: year (e.g., 2025)
+ * week_start: WEEK_START_SUNDAY or WEEK_START_MONDAY
+ * Returns: number of working days
+ */
+int calendar_working_days(const struct holiday_calendar *calendar,
+			  int month, int year, int week_start);
+
+/*
+ * Calculate the remaining working days from current month to end of year.
+ * current_month: current month (1-12)
+ * year: year (e.g., 2025)
+ * week_start: WEEK_START_SUNDAY or WEEK_START_MONDAY
+ * Returns: total remaining working days
+ */
+int calculate_remaining_working_days(int current_month, int year, int week_start);
+
+/*
+ * Calculate working days from the start of the previous month to end of year.
+ * current_month: current month (1-12)
+ * year: year (e.g., 2025)
+ * week_start: WEEK_START_SUNDAY or WEEK_START_MONDAY
+ * Returns: total working days from previous month start to year end
+ */
+int calculate_working_days_from_prev_month(int current_month, int year, int week_start);
+
+/*
+ * Holiday-aware versions of calculate_remaining_working_days and
+ * calculate_working_days_from_prev_month.
+ * calendar: public holidays, or NULL for weekends only
+ */
+int calendar_remaining_working_days(const struct holiday_calendar *calendar,
+				    int current_month, int year, int week_start);
+int calendar_working_days_from_prev_month(const struct holiday_calendar *calendar,
+					  int current_month, int year,
+					  int week_start);
+
+/*
+ * Holiday calendar functions
+ */
+
+/*
+ * Build a holiday calendar from a list of dates.
+ * The calendar covers the years from the earliest to the latest date.
+ * calendar: structure to initialize (release with free_holiday_calendar)
+ * dates: holiday dates (duplicates and weekend dates are allowed)
+ * count: number of dates
+ * Returns: 0 on success, HOLIDAY_ERR_DATE on an invalid date,
+ *          HOLIDAY_ERR_SPAN if the dates span too many years or
+ *          HOLIDAY_ERR_MEMORY on allocation failure
+ */
+int init_holiday_calendar(struct holiday_calendar *calendar,
+			  const struct date *dates, size_t count);
+
+/*
+ * Load a holiday calendar file: one YYYY-MM-DD date per line, optionally
+ * followed by a description. Blank lines and lines starting with '#' are
+ * ignored.
+ * path: file to load
+ * calendar: structure to initialize (release with free_holiday_calendar)
+ * Returns: 0 on success, non-zero on error
+ */
+int load_holiday_calendar(const char *path, struct holiday_calendar *calendar);
+
+/*
+ * Release the memory of a holiday calendar.
+ * calendar: calendar to release
+ */
+void free_holiday_calendar(struct holiday_calendar *calendar);
+
+/*
+ * Accrual policy files
+ */
+
+/*
+ * Load a policy file: "[policy <id>]" sections (IDs 1-POLICY_MAX_ID), each
+ * with "option = <days> <hours>" lines and optional "max_accum_days",
+ * "special_accum_from" and "special_accum_factor" settings (built-in values
+ * by default). Blank lines and text after '#' are ignored.
+ * path: file to load
+ * set: structure to initialize (release with free_policy_set)
+ * Returns: 0 on success, non-zero on error
+ */
+int load_policy_file(const char *path, struct policy_set *set);
+
+/*
+ * Release the policies of a set.
+ * set: set to release
+ */
+void free_policy_set(struct policy_set *set);
+
+/*
+ * Find a policy by ID.
+ * set: loaded policies, or NULL
+ * id: policy ID (0 for the built-in policy)
+ * Returns: the policy, or NULL if the ID is not defined
+ */
+const struct vacation_policy *find_policy(const struct policy_set *set,
+					  int id);
+
+/*
+ * Library functions
+ *
+ * The calendar, parsing and policy lookup functions above report errors
+ * through their return values and neither print nor exit. None of them
+ * keeps state between calls: they are reentrant, and any number of threads
+ * may call them at once, sharing holiday calendars, policy sets and
+ * contexts as long as nobody modifies those while they are in use. The
+ * loaders (load_holiday_calendar, load_policy_file) write their
+ * diagnostics to stderr.
+ */
+
+/*
+ * Get the ABI version of the library, to compare with VACATION_ABI_VERSION.
+ * Returns: the library ABI version
+ */
+int vacation_abi_version(void);
+
+/*
+ * Validate a request and calculate its results.
+ * context: holidays, policies and date of the calculation
+ * request: request to answer
+ * response: structure to store the response, with the status code
+ * Returns: VACATION_OK, or the VACATION_ERR_* code of an invalid request
+ */
+int vacation_evaluate(const struct vacation_context *context,
+		      const struct vacation_request *request,
+		      struct vacation_response *response);
+
+/*
+ * Describe a status code.
+ * status: VACATION_OK or VACATION_ERR_* code
+ * Returns: static message text, or "Unknown status" for other values
+ */
+const char *vacation_strerror(int status);
+
+#endif /* VACATION_API_H */
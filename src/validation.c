@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vacation.h"
+
+/*
+ * Structured validation errors.
+ *
+ * The check functions only store a code and the offending values, so
+ * validating a valid record costs a few comparisons; messages are rendered
+ * separately, by the command line one at a time and by batch mode in
+ * buffered blocks tagged with the record's line number.
+ */
+
+/* What format_validation_error passes to a message */
+#define ARG_NONE	0
+#define ARG_VALUE	1	/* error->value */
+#define ARG_LIMIT	2	/* error->limit */
+#define ARG_NUMBER	3	/* error->number and error->limit */
+#define ARG_TEXT	4	/* error->text */
+
+static const struct {
+	const char *format;
+	int arg;
+} validation_messages[VALIDATION_NUM_CODES] = {
+	[VALIDATION_OK] = { "No error", ARG_NONE },
+	[VALIDATION_ANNUAL_MISSING] = {
+		"Annual vacation days (-d) or hours (-A) must be specified",
+		ARG_NONE },
+	[VALIDATION_ANNUAL_BOTH] = {
+		"--annual-days (-d) and --annual-hours (-A) are mutually exclusive",
+		ARG_NONE },
+	[VALIDATION_ANNUAL_DAYS] = {
+		"Invalid annual vacation days (%d)", ARG_VALUE },
+	[VALIDATION_ANNUAL_HOURS] = {
+		"Invalid annual vacation hours (%d)", ARG_VALUE },
+	[VALIDATION_EXTRA_NEGATIVE] = {
+		"Extra vacation days consumption cannot be negative",
+		ARG_NONE },
+	[VALIDATION_EXTRA_RANGE] = {
+		"Extra vacation days consumption (%.1f) cannot exceed working days from start of previous month (%d)",
+		ARG_NUMBER },
+	[VALIDATION_ID_LENGTH] = {
+		"Employee ID too long (max %d characters)", ARG_LIMIT },
+	[VALIDATION_FIXED_RANGE] = {
+		"Current hours out of range for fixed-point mode", ARG_NONE },
+	[VALIDATION_RECORD_LENGTH] = {
+		"Record too long (max %d characters)", ARG_LIMIT },
+	[VALIDATION_TOO_MANY_FIELDS] = {
+		"Too many fields (expected at most %d)", ARG_LIMIT },
+	[VALIDATION_TOO_FEW_FIELDS] = {
+		"Too few fields (expected at least %d)", ARG_LIMIT },
+	[VALIDATION_POLICY] = { "Unknown policy ID: %s", ARG_TEXT },
+	[VALIDATION_ANNUAL_DAYS_FORMAT] = {
+		"Annual days must be an integer: %s", ARG_TEXT },
+	[VALIDATION_ANNUAL_HOURS_FORMAT] = {
+		"Annual hours must be an integer: %s", ARG_TEXT },
+	[VALIDATION_CURRENT_HOURS_FORMAT] = {
+		"Invalid number format for current hours: %s", ARG_TEXT },
+	[VALIDATION_EXTRA_FORMAT] = {
+		"Invalid number format for extra vacation days: %s", ARG_TEXT },
+	[VALIDATION_WEEK_START_FORMAT] = {
+		"Invalid week start: %s", ARG_TEXT },
+	[VALIDATION_SPECIAL_ACCUM_FORMAT] = {
+		"Special accum must be 0 or 1: %s", ARG_TEXT },
+	[VALIDATION_UNKNOWN_ID] = {
+		"Employee ID not in the prior results: %s", ARG_TEXT }
+};
+
+int set_validation_error(struct validation_error *error, int code,
+			 int value, int limit)
+{
+	error->code = code;
+	error->value = value;
+	error->limit = limit;
+	error->number = 0.0;
+	error->text[0] = '\0';
+	return code;
+}
+
+int set_validation_text(struct validation_error *error, int code,
+			const char *text)
+{
+	size_t len = strlen(text);
+
+	if (len > VALIDATION_MAX_TEXT)
+		len = VALIDATION_MAX_TEXT;
+
+	set_validation_error(error, code, 0, 0);
+	memcpy(error->text, text, len);
+	error->text[len] = '\0';
+	return code;
+}
+
+int check_arguments(const struct vacation_args *args,
+		    struct validation_error *error)
+{
+	if (!args->annual_days_set && !args->annual_hours_set)
+		return set_validation_error(error, VALIDATION_ANNUAL_MISSING,
+					    0, 0);
+
+	if (args->annual_days_set && args->annual_hours_set)
+		return set_validation_error(error, VALIDATION_ANNUAL_BOTH, 0, 0);
+
+	return VALIDATION_OK;
+}
+
+int check_annual_days(const struct vacation_policy *policy, int annual_days,
+		      struct validation_error *error)
+{
+	if (!policy_is_valid_annual_days(policy, annual_days))
+		return set_validation_error(error, VALIDATION_ANNUAL_DAYS,
+					    annual_days, 0);
+
+	return VALIDATION_OK;
+}
+
+int check_vacation_days(double vacation_days, int max_working_days,
+			struct validation_error *error)
+{
+	if (vacation_days < 0)
+		return set_validation_error(error, VALIDATION_EXTRA_NEGATIVE,
+					    0, 0);
+
+	if (vacation_days > max_working_days) {
+		set_validation_error(error, VALIDATION_EXTRA_RANGE, 0,
+				     max_working_days);
+		error->number = vacation_days;
+		return VALIDATION_EXTRA_RANGE;
+	}
+
+	return VALIDATION_OK;
+}
+
+int format_validation_error(char *buf, size_t size,
+			    const struct validation_error *error)
+{
+	const char *format;
+
+	if (error->code < 0 || error->code >= VALIDATION_NUM_CODES)
+		return snprintf(buf, size, "Unknown validation error (%d)",
+				error->code);
+
+	format = validation_messages[error->code].format;
+	switch (validation_messages[error->code].arg) {
+	case ARG_VALUE:
+		return snprintf(buf, size, format, error->value);
+	case ARG_LIMIT:
+		return snprintf(buf, size, format, error->limit);
+	case ARG_NUMBER:
+		return snprintf(buf, size, format, error->number, error->limit);
+	case ARG_TEXT:
+		return snprintf(buf, size, format, error->text);
+	default:
+		return snprintf(buf, size, "%s", format);
+	}
+}
+
+void print_validation_error(const struct validation_error *error)
+{
+	char message[VALIDATION_MAX_MESSAGE];
+
+	format_validation_error(message, sizeof(message), error);
+	fprintf(stderr, "Error: %s.\n", message);
+}